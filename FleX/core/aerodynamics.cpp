@@ -0,0 +1,185 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "aerodynamics.h"
+#include "parallel.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+
+// per vertex share of the aerodynamic force on a triangle
+inline Vec3 TriangleForce(const Vec3& x0, const Vec3& x1, const Vec3& x2, const Vec3& relativeVelocity, float drag, float lift)
+{
+	Vec3 n = Cross(x1-x0, x2-x0);
+
+	const float twiceArea = Length(n);
+	const float speedSq = LengthSq(relativeVelocity);
+
+	// degenerate triangles and triangles at rest have no load
+	if (twiceArea < 1.e-12f || speedSq < 1.e-12f)
+		return Vec3(0.0f);
+
+	n /= twiceArea;
+
+	const float speed = sqrtf(speedSq);
+	const Vec3 dir = relativeVelocity/speed;
+
+	float cosTheta = Dot(n, dir);
+
+	if (cosTheta < 0.0f)
+	{
+		n = -n;
+		cosTheta = -cosTheta;
+	}
+
+	// 0.5 for the area and 1/3 for each vertex
+	const float scale = -twiceArea*(1.0f/6.0f)*speedSq*cosTheta;
+
+	return scale*(drag*dir + lift*(n - cosTheta*dir));
+}
+
+inline void AccumulateTriangle(int t, const int* indices, const Vec4* positions, const Vec3* velocities, const Vec3& wind, const Vec3* triangleWind, float drag, float lift, Vec3* forces)
+{
+	const int a = indices[t*3+0];
+	const int b = indices[t*3+1];
+	const int c = indices[t*3+2];
+
+	const Vec3 air = triangleWind ? triangleWind[t] : wind;
+	const Vec3 v = (velocities[a] + velocities[b] + velocities[c])*(1.0f/3.0f) - air;
+
+	const Vec3 f = TriangleForce(Vec3(positions[a]), Vec3(positions[b]), Vec3(positions[c]), v, drag, lift);
+
+	forces[a] += f;
+	forces[b] += f;
+	forces[c] += f;
+}
+
+} // anonymous namespace
+
+void CreateTriangleColoring(const int* indices, int numTriangles, int numVertices, TriangleColoring& coloring)
+{
+	// vertex to triangle adjacency
+	vector<int> vertexStarts(numVertices+1, 0);
+
+	for (int i=0; i < numTriangles*3; ++i)
+		vertexStarts[indices[i]+1]++;
+
+	for (int v=0; v < numVertices; ++v)
+		vertexStarts[v+1] += vertexStarts[v];
+
+	vector<int> vertexTriangles(numTriangles*3);
+	vector<int> offsets(vertexStarts.begin(), vertexStarts.end()-1);
+
+	for (int i=0; i < numTriangles*3; ++i)
+		vertexTriangles[offsets[indices[i]]++] = i/3;
+
+	vector<int> colors(numTriangles, -1);
+	vector<int> colorCounts;
+	vector<int> lastUse;
+
+	for (int t=0; t < numTriangles; ++t)
+	{
+		// mark colors taken by already colored neighbors
+		for (int i=0; i < 3; ++i)
+		{
+			const int v = indices[t*3+i];
+
+			for (int j=vertexStarts[v]; j < vertexStarts[v+1]; ++j)
+			{
+				const int color = colors[vertexTriangles[j]];
+
+				if (color >= 0)
+					lastUse[color] = t;
+			}
+		}
+
+		int color = 0;
+		while (color < int(colorCounts.size()) && lastUse[color] == t)
+			++color;
+
+		if (color == int(colorCounts.size()))
+		{
+			colorCounts.push_back(0);
+			lastUse.push_back(-1);
+		}
+
+		colors[t] = color;
+		colorCounts[color]++;
+	}
+
+	const int numColors = int(colorCounts.size());
+
+	coloring.colorStarts.assign(numColors+1, 0);
+	for (int c=0; c < numColors; ++c)
+		coloring.colorStarts[c+1] = coloring.colorStarts[c] + colorCounts[c];
+
+	// triangles keep index order within a color
+	offsets.assign(coloring.colorStarts.begin(), coloring.colorStarts.end()-1);
+	coloring.triangles.resize(numTriangles);
+
+	for (int t=0; t < numTriangles; ++t)
+		coloring.triangles[offsets[colors[t]]++] = t;
+}
+
+void ComputeAerodynamicForces(const TriangleColoring* coloring, const int* indices, int numTriangles, const Vec4* positions, const Vec3* velocities, const Vec3& wind, const Vec3* triangleWind, float drag, float lift, Vec3* forces)
+{
+	if (!coloring)
+	{
+		for (int t=0; t < numTriangles; ++t)
+			AccumulateTriangle(t, indices, positions, velocities, wind, triangleWind, drag, lift, forces);
+
+		return;
+	}
+
+	assert(int(coloring->triangles.size()) == numTriangles);
+
+	const int numColors = int(coloring->colorStarts.size())-1;
+
+	for (int c=0; c < numColors; ++c)
+	{
+		const int* triangles = &coloring->triangles[0] + coloring->colorStarts[c];
+
+		ParallelFor(coloring->colorStarts[c+1]-coloring->colorStarts[c], [&](int begin, int end)
+		{
+			for (int i=begin; i < end; ++i)
+				AccumulateTriangle(triangles[i], indices, positions, velocities, wind, triangleWind, drag, lift, forces);
+		});
+	}
+}
+
+void ApplyAerodynamicForces(const Vec3* forces, const Vec4* particles, Vec3* velocities, int numParticles, float dt)
+{
+	ParallelFor(numParticles, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+			velocities[i] += forces[i]*(particles[i].w*dt);
+	});
+}
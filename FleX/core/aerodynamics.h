@@ -0,0 +1,57 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// triangles grouped so that no two triangles of a color share a vertex, each color can 
+// then scatter forces to its vertices in parallel without atomics
+struct TriangleColoring
+{
+	std::vector<int> triangles;		// triangle indices ordered by color
+	std::vector<int> colorStarts;	// offsets of each color in triangles, numColors+1 entries
+};
+
+// greedy coloring in triangle order, each triangle takes the lowest color unused by its neighbors
+void CreateTriangleColoring(const int* indices, int numTriangles, int numVertices, TriangleColoring& coloring);
+
+// accumulates drag and lift forces on triangles moving relative to the air into their vertices, 
+// the relative velocity is the mean vertex velocity minus triangleWind[t], or minus wind when 
+// triangleWind is NULL, for a triangle of area A with unit normal n and relative velocity v
+//
+//   f = -A |v|^2 cos(theta) (drag v/|v| + lift (n - cos(theta) v/|v|))
+//
+// where n faces along v and cos(theta) = n.v/|v|, so drag scales with the projected area and lift 
+// acts perpendicular to v, one third of f goes to each vertex, when coloring is NULL triangles are 
+// processed serially in index order
+void ComputeAerodynamicForces(const TriangleColoring* coloring, const int* indices, int numTriangles, const Vec4* positions, const Vec3* velocities, const Vec3& wind, const Vec3* triangleWind, float drag, float lift, Vec3* forces);
+
+// integrates forces into the velocities of particles with non-zero inverse mass
+void ApplyAerodynamicForces(const Vec3* forces, const Vec4* particles, Vec3* velocities, int numParticles, float dt);
@@ -0,0 +1,184 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "bending.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	// cotangent of the angle between two vectors
+	inline float Cot(Vec3 a, Vec3 b)
+	{
+		const float s = Length(Cross(a, b));
+		return s > 0.0f ? Dot(a, b)/s : 0.0f;
+	}
+
+	inline uint64_t EdgeKey(int a, int b)
+	{
+		return (uint64_t(min(a, b)) << 32) | uint32_t(max(a, b));
+	}
+
+	struct HalfEdge
+	{
+		uint64_t key;
+		int from;
+		int to;
+		int opposite;
+
+		bool operator < (const HalfEdge& rhs) const { return key < rhs.key; }
+	};
+
+} // anonymous namespace
+
+int CreateBendingConstraints(const Vec4* particles, int numParticles, const int* indices, int numTriangles, std::vector<BendingConstraint>& constraints)
+{
+	// sort half edges so the two sides of an edge are adjacent
+	vector<HalfEdge> halfEdges(numTriangles*3);
+
+	for (int t=0; t < numTriangles; ++t)
+	{
+		for (int e=0; e < 3; ++e)
+		{
+			HalfEdge& h = halfEdges[t*3 + e];
+			h.from = indices[t*3 + e];
+			h.to = indices[t*3 + (e+1)%3];
+			h.opposite = indices[t*3 + (e+2)%3];
+			h.key = EdgeKey(h.from, h.to);
+		}
+	}
+
+	stable_sort(halfEdges.begin(), halfEdges.end());
+
+	const size_t start = constraints.size();
+
+	for (size_t i=0; i < halfEdges.size(); )
+	{
+		size_t j = i+1;
+		while (j < halfEdges.size() && halfEdges[j].key == halfEdges[i].key)
+			++j;
+
+		// interior manifold edges only
+		if (j-i == 2)
+		{
+			const HalfEdge& h = halfEdges[i];
+
+			BendingConstraint c;
+			c.vertices[0] = h.from;
+			c.vertices[1] = h.to;
+			c.vertices[2] = h.opposite;
+			c.vertices[3] = halfEdges[i+1].opposite;
+
+			const Vec3 x0 = Vec3(particles[c.vertices[0]]);
+			const Vec3 x1 = Vec3(particles[c.vertices[1]]);
+			const Vec3 x2 = Vec3(particles[c.vertices[2]]);
+			const Vec3 x3 = Vec3(particles[c.vertices[3]]);
+
+			const Vec3 e0 = x1-x0;
+			const Vec3 e1 = x2-x0;
+			const Vec3 e2 = x3-x0;
+			const Vec3 e3 = x2-x1;
+			const Vec3 e4 = x3-x1;
+
+			const float c01 = Cot(e0, e1);
+			const float c02 = Cot(e0, e2);
+			const float c03 = Cot(-e0, e3);
+			const float c04 = Cot(-e0, e4);
+
+			const float area = 0.5f*(Length(Cross(e0, e1)) + Length(Cross(e0, e2)));
+
+			if (area > 0.0f)
+			{
+				// Q = 3/(A0 + A1) K K^T
+				const float scale = sqrtf(3.0f/area);
+
+				c.k[0] = (c03 + c04)*scale;
+				c.k[1] = (c01 + c02)*scale;
+				c.k[2] = (-c01 - c03)*scale;
+				c.k[3] = (-c02 - c04)*scale;
+
+				c.restAngle = GetDihedralAngle(c, particles);
+
+				constraints.push_back(c);
+			}
+		}
+
+		i = j;
+	}
+
+	return int(constraints.size() - start);
+}
+
+void GetBendingHessian(const BendingConstraint& c, float q[4][4])
+{
+	for (int i=0; i < 4; ++i)
+		for (int j=0; j < 4; ++j)
+			q[i][j] = c.k[i]*c.k[j];
+}
+
+float GetDihedralAngle(const BendingConstraint& c, const Vec4* particles)
+{
+	const Vec3 x0 = Vec3(particles[c.vertices[0]]);
+	const Vec3 x1 = Vec3(particles[c.vertices[1]]);
+	const Vec3 x2 = Vec3(particles[c.vertices[2]]);
+	const Vec3 x3 = Vec3(particles[c.vertices[3]]);
+
+	// normals of (x0, x1, x2) and (x1, x0, x3)
+	const Vec3 n1 = Cross(x1-x0, x2-x0);
+	const Vec3 n2 = Cross(x0-x1, x3-x1);
+	const Vec3 e = SafeNormalize(x1-x0);
+
+	return atan2f(Dot(Cross(n1, n2), e), Dot(n1, n2));
+}
+
+float EvaluateBendingEnergy(const BendingConstraint* constraints, int numConstraints, const Vec4* particles, Vec3* gradients)
+{
+	// accumulate in double, the per edge terms are tiny for fine meshes
+	double energy = 0.0;
+
+	for (int i=0; i < numConstraints; ++i)
+	{
+		const BendingConstraint& c = constraints[i];
+
+		// with Q = k k^T the energy is 1/2 |sum_i k_i x_i|^2
+		Vec3 s(0.0f);
+		for (int v=0; v < 4; ++v)
+			s += c.k[v]*Vec3(particles[c.vertices[v]]);
+
+		energy += 0.5f*Dot(s, s);
+
+		if (gradients)
+		{
+			for (int v=0; v < 4; ++v)
+				gradients[c.vertices[v]] += c.k[v]*s;
+		}
+	}
+
+	return float(energy);
+}
@@ -0,0 +1,59 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// bending data for an interior edge shared by the triangles (v0, v1, v2) and (v1, v0, v3), 
+// v0 and v1 are the edge, v2 and v3 the opposite vertices
+//
+// the isometric bending energy (Bergou et al. 2006) is E = 1/2 sum_ij Q_ij x_i.x_j with the 
+// rank one, cotangent weighted Hessian Q = k k^T stored compactly as the vector k, restAngle 
+// is the signed dihedral angle between the triangle normals for dihedral bending models
+struct BendingConstraint
+{
+	int vertices[4];
+
+	float k[4];
+	float restAngle;
+};
+
+// creates one constraint per manifold interior edge of a triangle mesh in its rest pose, 
+// boundary and non-manifold edges are skipped, returns the number of constraints added
+int CreateBendingConstraints(const Vec4* particles, int numParticles, const int* indices, int numTriangles, std::vector<BendingConstraint>& constraints);
+
+// expands the compact Hessian of a constraint to the full 4x4 block
+void GetBendingHessian(const BendingConstraint& c, float q[4][4]);
+
+// signed dihedral angle of the edge in the current configuration, zero when flat
+float GetDihedralAngle(const BendingConstraint& c, const Vec4* particles);
+
+// total isometric bending energy of the particles, if gradients is not NULL dE/dx is accumulated into it
+float EvaluateBendingEnergy(const BendingConstraint* constraints, int numConstraints, const Vec4* particles, Vec3* gradients);
@@ -35,6 +35,7 @@
 #include <numeric>
 
 #include "maths.h"
+#include "radixsort.h"
 
 class ClothMesh
 {
@@ -214,55 +215,68 @@ public:
 		if (tearable)
 		{
 			// tearable cloth uses a simple bending constraint model that allows easy splitting of vertices and remapping of constraints
-			typedef std::set<Edge> EdgeSet;
-			EdgeSet edges;
+			const int numTris = numIndices/3;
 
-			// build unique edge list
+			mTris.reserve(numTris);
 			for (int i=0; i < numIndices; i += 3)
-			{
 				mTris.push_back(Triangle(indices[i+0], indices[i+1], indices[i+2]));
 
-				const int triIndex = i/3;
+			// pack each half edge as (min vertex, max vertex) into a 64 bit key
+			int vertexBits = 1;
+			while (vertexBits < 32 && (1<<vertexBits) < numVertices)
+				++vertexBits;
 
-				// breaking the rules
-				Edge& e1 = const_cast<Edge&>(*edges.insert(Edge(indices[i+0], indices[i+1])).first);
-				Edge& e2 = const_cast<Edge&>(*edges.insert(Edge(indices[i+1], indices[i+2])).first);
-				Edge& e3 = const_cast<Edge&>(*edges.insert(Edge(indices[i+2], indices[i+0])).first);
+			std::vector<uint64_t> keys(numIndices);
+			std::vector<int> halfEdges(numIndices);
 
-				if (!e1.AddTri(triIndex))
-					return;
-				if (!e2.AddTri(triIndex))
-					return;
-				if (!e3.AddTri(triIndex))
-					return;
+			for (int i=0; i < numIndices; ++i)
+			{
+				const int a = indices[i];
+				const int b = indices[i - i%3 + (i+1)%3];
+
+				keys[i] = (uint64_t(Min(a, b))<<vertexBits) | uint64_t(Max(a, b));
+				halfEdges[i] = i;
 			}
 
-			// flatten set to array
-			mEdges.assign(edges.begin(), edges.end());
+			// stable sort keeps half edges of the same edge in triangle order
+			RadixSort(&keys[0], &halfEdges[0], numIndices, 2*vertexBits);
 
-			// second pass, set edge indices to faces
-			for (int i=0; i < numIndices; i += 3)
-			{
-				int e1 = int(std::lower_bound(mEdges.begin(), mEdges.end(), Edge(indices[i+0], indices[i+1])) - mEdges.begin());
-				int e2 = int(std::lower_bound(mEdges.begin(), mEdges.end(), Edge(indices[i+1], indices[i+2])) - mEdges.begin());
-				int e3 = int(std::lower_bound(mEdges.begin(), mEdges.end(), Edge(indices[i+2], indices[i+0])) - mEdges.begin());
+			// runs of equal keys are the unique edges in the same order as sorting Edge
+			mEdges.reserve(numIndices/2 + 1);
 
+			for (int i=0; i < numIndices; )
+			{
+				int j = i+1;
+				while (j < numIndices && keys[j] == keys[i])
+					++j;
 
-				if (e1 != e2 && e1 != e3 && e2 != e3)
-				{
-					const int triIndex = i/3;
+				const int t1 = halfEdges[i]/3;
+				const int t2 = (j-i == 2) ? halfEdges[i+1]/3 : -1;
 
-					mTris[triIndex].edges[0] = e1;
-					mTris[triIndex].edges[1] = e2;
-					mTris[triIndex].edges[2] = e3;
-				}
-				else
-				{
-					// degenerate tri
+				// non-manifold edge, or degenerate tri referencing the same edge or vertex twice
+				if (j-i > 2 || t1 == t2 || (keys[i]>>vertexBits) == (keys[i]&((uint64_t(1)<<vertexBits)-1)))
 					return;
-				}
+
+				const int edgeIndex = int(mEdges.size());
+
+				Edge edge(indices[halfEdges[i]], indices[halfEdges[i] - halfEdges[i]%3 + (halfEdges[i]+1)%3]);
+				edge.tris[0] = t1;
+				edge.tris[1] = t2;
+
+				mEdges.push_back(edge);
+
+				for (int k=i; k < j; ++k)
+					mTris[halfEdges[k]/3].edges[halfEdges[k]%3] = edgeIndex;
+
+				i = j;
 			}
 
+			BuildVertexTris();
+
+			mConstraintIndices.reserve(4*mEdges.size());
+			mConstraintRestLengths.reserve(2*mEdges.size());
+			mConstraintCoefficients.reserve(2*mEdges.size());
+
 			// generate distance constraints
 			for (size_t i=0; i < mEdges.size(); ++i)
 			{
@@ -330,17 +344,78 @@ public:
 		return index;
 	}
 
-	int IsSingularVertex(int vertex) const
+	// vertex to triangle adjacency, each vertex owns a contiguous range of mVertexTris
+	void BuildVertexTris()
 	{
-		std::vector<int> adjacentTriangles;
+		mVertexTriStarts.assign(mNumVertices, 0);
+		mVertexTriCounts.assign(mNumVertices, 0);
+
+		for (int i=0; i < int(mTris.size()); ++i)
+			for (int v=0; v < 3; ++v)
+				mVertexTriCounts[mTris[i].vertices[v]]++;
+
+		int sum = 0;
+		for (int i=0; i < mNumVertices; ++i)
+		{
+			mVertexTriStarts[i] = sum;
+			sum += mVertexTriCounts[i];
+		}
+
+		mVertexTris.resize(sum);
+		std::fill(mVertexTriCounts.begin(), mVertexTriCounts.end(), 0);
 
-		// gather adjacent triangles
 		for (int i=0; i < int(mTris.size()); ++i)
+			for (int v=0; v < 3; ++v)
+			{
+				const int vertex = mTris[i].vertices[v];
+				mVertexTris[mVertexTriStarts[vertex] + mVertexTriCounts[vertex]++] = i;
+			}
+	}
+
+	// triangles referencing a vertex in increasing order
+	void GetVertexTris(int vertex, std::vector<int>& tris) const
+	{
+		tris.resize(0);
+
+		if (vertex < int(mVertexTriStarts.size()))
+		{
+			const int start = mVertexTriStarts[vertex];
+			tris.assign(mVertexTris.begin() + start, mVertexTris.begin() + start + mVertexTriCounts[vertex]);
+
+			std::sort(tris.begin(), tris.end());
+		}
+	}
+
+	// reassigns a triangle from one vertex to another, vertices created by splitting only ever gain 
+	// triangles while they are the newest vertex so their range can be grown at the end of mVertexTris
+	void MoveVertexTri(int tri, int oldVertex, int newVertex)
+	{
+		int* begin = &mVertexTris[0] + mVertexTriStarts[oldVertex];
+		int* end = begin + mVertexTriCounts[oldVertex];
+
+		int* it = std::find(begin, end, tri);
+		assert(it != end);
+
+		*it = *(end-1);
+		mVertexTriCounts[oldVertex]--;
+
+		if (newVertex >= int(mVertexTriStarts.size()))
 		{
-			if (mTris[i].Contains(vertex))
-				adjacentTriangles.push_back(i);
+			mVertexTriStarts.resize(newVertex+1, int(mVertexTris.size()));
+			mVertexTriCounts.resize(newVertex+1, 0);
 		}
 
+		assert(mVertexTriStarts[newVertex] + mVertexTriCounts[newVertex] == int(mVertexTris.size()));
+
+		mVertexTris.push_back(tri);
+		mVertexTriCounts[newVertex]++;
+	}
+
+	int IsSingularVertex(int vertex) const
+	{
+		std::vector<int> adjacentTriangles;
+		GetVertexTris(vertex, adjacentTriangles);
+
 		// number of identified components
 		int componentCount = 0;
 
@@ -424,13 +499,7 @@ public:
 	int SeparateVertex(int singularVertex, std::vector<TriangleUpdate>& replacements, std::vector<VertexCopy>& copies, int maxCopies)
 	{
 		std::vector<int> adjacentTriangles;
-
-		// gather adjacent triangles
-		for (int i=0; i < int(mTris.size()); ++i)
-		{
-			if (mTris[i].Contains(singularVertex))
-				adjacentTriangles.push_back(i);
-		}
+		GetVertexTris(singularVertex, adjacentTriangles);
 
 		// number of identified components
 		int componentCount = 0;
@@ -474,6 +543,8 @@ public:
 
 				if (singularVertex != newIndex)
 				{
+					MoveVertexTri(t, singularVertex, newIndex);
+
 					// output replacement
 					TriangleUpdate r;
 					r.triangle = t*3 + v;
@@ -568,36 +639,36 @@ public:
 
 		const int newIndex = mNumVertices;
 
+		std::vector<int> vertexTris;
+		GetVertexTris(index, vertexTris);
+
 		// classify all tris attached to the split vertex according 
-		// to which side of the split plane their centroid lies on O(N)
-		for (size_t i = 0; i < mTris.size(); ++i)
+		// to which side of the split plane their centroid lies on
+		for (size_t i = 0; i < vertexTris.size(); ++i)
 		{
-			Triangle& tri = mTris[i];
+			Triangle& tri = mTris[vertexTris[i]];
 
-			if (tri.Contains(index))
-			{
-				const Vec4 centroid = (vertices[tri.vertices[0]] + vertices[tri.vertices[1]] + vertices[tri.vertices[2]]) / 3.0f;
+			const Vec4 centroid = (vertices[tri.vertices[0]] + vertices[tri.vertices[1]] + vertices[tri.vertices[2]]) / 3.0f;
 
-				if (Dot(Vec3(centroid), splitPlane) < w)
-				{
-					tri.side = 1;
+			if (Dot(Vec3(centroid), splitPlane) < w)
+			{
+				tri.side = 1;
 
-					++leftCount;
-				}
-				else
-				{
-					tri.side = 0;
+				++leftCount;
+			}
+			else
+			{
+				tri.side = 0;
 
-					++rightCount;
-				}
+				++rightCount;
+			}
 
-				adjacentTris.push_back(int(i));
-				for (int v=0; v < 3; ++v)
+			adjacentTris.push_back(vertexTris[i]);
+			for (int v=0; v < 3; ++v)
+			{
+				if (std::find(adjacentVertices.begin(), adjacentVertices.end(), tri.vertices[v]) == adjacentVertices.end())
 				{
-					if (std::find(adjacentVertices.begin(), adjacentVertices.end(), tri.vertices[v]) == adjacentVertices.end())
-					{
-						adjacentVertices.push_back(tri.vertices[v]);
-					}
+					adjacentVertices.push_back(tri.vertices[v]);
 				}
 			}
 		}
@@ -617,6 +688,7 @@ public:
 			if (tri.side == 0)
 			{
 				int v = tri.ReplaceVertex(index, newIndex);
+				MoveVertexTri(triIndex, index, newIndex);
 
 				TriangleUpdate update;
 				update.triangle = triIndex*3 + v;
@@ -723,6 +795,10 @@ public:
 
 	std::vector<Edge> mEdges;
 	std::vector<Triangle> mTris;
+
+	std::vector<int> mVertexTriStarts;
+	std::vector<int> mVertexTriCounts;
+	std::vector<int> mVertexTris;
 	
 	int mNumVertices;
 
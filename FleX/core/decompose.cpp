@@ -0,0 +1,723 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "decompose.h"
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include <stdio.h>
+#include <float.h>
+
+#if _WIN32
+#pragma warning(disable: 4996)  // secure io
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+	// RAII wrapper to handle file pointer clean up
+	struct FilePointer
+	{
+		FilePointer(FILE* ptr) : p(ptr) {}
+		~FilePointer() { if (p) fclose(p); }
+
+		operator FILE*() { return p; }
+
+		FILE* p;
+	};
+
+	struct HullFace
+	{
+		int v[3];
+		
+		Vec3 n;
+		float d;
+		float area;
+
+		bool alive;
+
+		vector<int> outside;
+
+		float Distance(const Vec3& p) const { return Dot(n, p) + d; }
+	};
+
+	HullFace MakeFace(const vector<Vec3>& points, int a, int b, int c)
+	{
+		HullFace f;
+		f.v[0] = a;
+		f.v[1] = b;
+		f.v[2] = c;
+
+		Vec3 e = Cross(points[b]-points[a], points[c]-points[a]);
+		
+		f.area = 0.5f*Length(e);
+		f.n = SafeNormalize(e);
+		f.d = -Dot(f.n, points[a]);
+		f.alive = true;
+
+		return f;
+	}
+
+	inline uint64_t EdgeKey(int u, int v)
+	{
+		return (uint64_t(uint32_t(u)) << 32) | uint32_t(v);
+	}
+
+	void AddFaceEdges(const vector<HullFace>& faces, int f, unordered_map<uint64_t, int>& edgeFaces)
+	{
+		for (int e=0; e < 3; ++e)
+			edgeFaces[EdgeKey(faces[f].v[e], faces[f].v[(e+1)%3])] = f;
+	}
+
+	// quickhull style incremental hull, only the face planes are used so we don't need to 
+	// guarantee a manifold result in degenerate configurations, returns false for flat point sets
+	bool BuildHull(const vector<Vec3>& points, vector<HullFace>& faces)
+	{
+		faces.resize(0);
+
+		const int n = int(points.size());
+		if (n < 4)
+			return false;
+
+		Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+		for (int i=0; i < n; ++i)
+		{
+			lower = Min(lower, points[i]);
+			upper = Max(upper, points[i]);
+		}
+
+		const float eps = 1.e-5f*Length(upper-lower);
+
+		// initial simplex from extreme points
+		int a = 0, b = 0;
+		for (int i=1; i < n; ++i)
+		{
+			if (points[i].x < points[a].x) a = i;
+			if (points[i].x > points[b].x) b = i;
+		}
+
+		if (a == b)
+			return false;
+
+		int c = -1;
+		float maxDist = eps;
+		for (int i=0; i < n; ++i)
+		{
+			float d = Length(Cross(points[i]-points[a], points[b]-points[a]));
+			if (d > maxDist)
+			{
+				maxDist = d;
+				c = i;
+			}
+		}
+
+		if (c == -1)
+			return false;
+
+		HullFace base = MakeFace(points, a, b, c);
+
+		int d = -1;
+		maxDist = eps;
+		for (int i=0; i < n; ++i)
+		{
+			float dist = fabsf(base.Distance(points[i]));
+			if (dist > maxDist)
+			{
+				maxDist = dist;
+				d = i;
+			}
+		}
+
+		if (d == -1)
+			return false;
+
+		// orient the tetrahedron outwards
+		if (base.Distance(points[d]) > 0.0f)
+			swap(a, b);
+
+		faces.push_back(MakeFace(points, a, b, c));
+		faces.push_back(MakeFace(points, a, d, b));
+		faces.push_back(MakeFace(points, b, d, c));
+		faces.push_back(MakeFace(points, c, d, a));
+
+		// assign each point to the first face it lies in front of
+		for (int i=0; i < n; ++i)
+		{
+			for (int f=0; f < 4; ++f)
+			{
+				if (faces[f].Distance(points[i]) > eps)
+				{
+					faces[f].outside.push_back(i);
+					break;
+				}
+			}
+		}
+
+		// directed edge -> face map used to walk the hull surface
+		unordered_map<uint64_t, int> edgeFaces;
+
+		for (int f=0; f < 4; ++f)
+			AddFaceEdges(faces, f, edgeFaces);
+
+		vector<int> visible;
+		vector<int> stack;
+		vector<pair<int, int> > horizon;
+		vector<int> orphans;
+		vector<int> marks(faces.size(), 0);
+		
+		int mark = 0;
+		int cursor = 0;
+
+		for (;;)
+		{
+			// faces only receive points when they are created, so we can skip past any face 
+			// that is dead or has no outstanding points
+			while (cursor < int(faces.size()) && (!faces[cursor].alive || faces[cursor].outside.empty()))
+				++cursor;
+
+			if (cursor == int(faces.size()))
+				break;
+
+			const int face = cursor;
+
+			// furthest point becomes the new hull vertex
+			int eye = faces[face].outside[0];
+			float eyeDist = faces[face].Distance(points[eye]);
+
+			for (size_t i=1; i < faces[face].outside.size(); ++i)
+			{
+				float dist = faces[face].Distance(points[faces[face].outside[i]]);
+				if (dist > eyeDist)
+				{
+					eyeDist = dist;
+					eye = faces[face].outside[i];
+				}
+			}
+
+			visible.resize(0);
+			horizon.resize(0);
+			orphans.resize(0);
+
+			// flood the visible region from the seed face so that it stays connected
+			++mark;
+
+			stack.push_back(face);
+			marks[face] = mark;
+
+			while (!stack.empty())
+			{
+				const int f = stack.back();
+				stack.pop_back();
+
+				visible.push_back(f);
+
+				for (int e=0; e < 3; ++e)
+				{
+					const int u = faces[f].v[e];
+					const int v = faces[f].v[(e+1)%3];
+
+					unordered_map<uint64_t, int>::const_iterator it = edgeFaces.find(EdgeKey(v, u));
+
+					const int twin = it == edgeFaces.end() ? -1 : it->second;
+					
+					if (twin != -1 && marks[twin] == mark)
+						continue;
+
+					if (twin != -1 && faces[twin].Distance(points[eye]) > eps)
+					{
+						marks[twin] = mark;
+						stack.push_back(twin);
+					}
+				}
+			}
+
+			// horizon edges are those whose twin is not visible
+			for (size_t i=0; i < visible.size(); ++i)
+			{
+				const HullFace& f = faces[visible[i]];
+
+				for (int e=0; e < 3; ++e)
+				{
+					const int u = f.v[e];
+					const int v = f.v[(e+1)%3];
+
+					unordered_map<uint64_t, int>::const_iterator it = edgeFaces.find(EdgeKey(v, u));
+
+					if (it == edgeFaces.end() || marks[it->second] != mark)
+						horizon.push_back(make_pair(u, v));
+				}
+			}
+
+			for (size_t i=0; i < visible.size(); ++i)
+			{
+				HullFace& f = faces[visible[i]];
+				f.alive = false;
+
+				for (int e=0; e < 3; ++e)
+					edgeFaces.erase(EdgeKey(f.v[e], f.v[(e+1)%3]));
+
+				orphans.insert(orphans.end(), f.outside.begin(), f.outside.end());
+				
+				vector<int>().swap(f.outside);
+			}
+
+			const int firstNew = int(faces.size());
+
+			for (size_t e=0; e < horizon.size(); ++e)
+			{
+				faces.push_back(MakeFace(points, horizon[e].first, horizon[e].second, eye));
+				AddFaceEdges(faces, int(faces.size())-1, edgeFaces);
+			}
+
+			marks.resize(faces.size(), 0);
+
+			// redistribute points of the removed faces, points inside the new hull are dropped
+			for (size_t i=0; i < orphans.size(); ++i)
+			{
+				if (orphans[i] == eye)
+					continue;
+
+				for (int f=firstNew; f < int(faces.size()); ++f)
+				{
+					if (faces[f].Distance(points[orphans[i]]) > eps)
+					{
+						faces[f].outside.push_back(orphans[i]);
+						break;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// build a capped plane set for a point set, normals are taken from the largest hull faces 
+	// plus the 6 axis directions, offsets are set from the support of the points so the result 
+	// always encloses them, the uncapped hull planes are returned in exact (empty for flat sets)
+	void BuildHullPlanes(const vector<Vec3>& points, int maxPlanes, ConvexHull& hull, vector<Vec4>& exact)
+	{
+		exact.resize(0);
+
+		hull.planes.resize(0);
+		hull.lower = Vec3(FLT_MAX);
+		hull.upper = Vec3(-FLT_MAX);
+
+		for (size_t i=0; i < points.size(); ++i)
+		{
+			hull.lower = Min(hull.lower, points[i]);
+			hull.upper = Max(hull.upper, points[i]);
+		}
+
+		vector<HullFace> faces;
+		BuildHull(points, faces);
+
+		// merge faces sharing a plane (triangulated polygons)
+		vector<pair<float, Vec3> > normals;
+		for (size_t f=0; f < faces.size(); ++f)
+		{
+			if (!faces[f].alive || faces[f].area == 0.0f)
+				continue;
+
+			exact.push_back(Vec4(faces[f].n, faces[f].d));
+
+			size_t j=0;
+			for (; j < normals.size(); ++j)
+			{
+				if (Dot(normals[j].second, faces[f].n) > 0.9999f)
+				{
+					normals[j].first += faces[f].area;
+					break;
+				}
+			}
+
+			if (j == normals.size())
+				normals.push_back(make_pair(faces[f].area, faces[f].n));
+		}
+
+		sort(normals.begin(), normals.end(), [](const pair<float, Vec3>& l, const pair<float, Vec3>& r) { return l.first > r.first; });
+
+		const Vec3 axes[6] = { Vec3(1.0f, 0.0f, 0.0f), Vec3(-1.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f), Vec3(0.0f, -1.0f, 0.0f), Vec3(0.0f, 0.0f, 1.0f), Vec3(0.0f, 0.0f, -1.0f) };
+
+		vector<Vec3> dirs;
+		for (size_t j=0; j < normals.size() && int(dirs.size()) < max(maxPlanes, 6)-6; ++j)
+			dirs.push_back(normals[j].second);
+
+		for (int j=0; j < 6; ++j)
+		{
+			size_t k=0;
+			while (k < dirs.size() && Dot(dirs[k], axes[j]) < 0.9999f)
+				++k;
+
+			if (k == dirs.size())
+				dirs.push_back(axes[j]);
+		}
+
+		for (size_t j=0; j < dirs.size(); ++j)
+		{
+			float support = -FLT_MAX;
+			for (size_t i=0; i < points.size(); ++i)
+				support = max(support, Dot(dirs[j], points[i]));
+
+			hull.planes.push_back(Vec4(dirs[j], -support));
+		}
+	}
+
+	// maximum depth of the probe points below the hull boundary
+	float HullConcavity(const vector<Vec3>& probes, const vector<Vec4>& planes)
+	{
+		float concavity = 0.0f;
+
+		for (size_t i=0; i < probes.size(); ++i)
+		{
+			float depth = FLT_MAX;
+			for (size_t j=0; j < planes.size(); ++j)
+			{
+				const Vec4& p = planes[j];
+				depth = min(depth, -(p.x*probes[i].x + p.y*probes[i].y + p.z*probes[i].z + p.w));
+			}
+
+			concavity = max(concavity, depth);
+		}
+
+		return concavity;
+	}
+
+	struct Piece
+	{
+		vector<int> triangles;
+		ConvexHull hull;
+		float concavity;
+	};
+
+	struct Decomposer
+	{
+		const Vec3* vertices;
+		const int* indices;
+		int maxPlanes;
+
+		vector<int> stamps;
+		int stamp;
+
+		vector<Vec3> points;
+		vector<Vec3> probes;
+		vector<Vec4> exact;
+
+		Vec3 Centroid(int t) const
+		{
+			return (vertices[indices[t*3+0]] + vertices[indices[t*3+1]] + vertices[indices[t*3+2]])/3.0f;
+		}
+
+		// gather unique vertices of a piece as hull input, and vertices plus triangle centroids as concavity probes
+		void Gather(const vector<int>& triangles)
+		{
+			points.resize(0);
+			probes.resize(0);
+
+			++stamp;
+
+			for (size_t t=0; t < triangles.size(); ++t)
+			{
+				for (int v=0; v < 3; ++v)
+				{
+					const int i = indices[triangles[t]*3+v];
+					if (stamps[i] != stamp)
+					{
+						stamps[i] = stamp;
+						points.push_back(vertices[i]);
+					}
+				}
+
+				probes.push_back(Centroid(triangles[t]));
+			}
+
+			probes.insert(probes.end(), points.begin(), points.end());
+		}
+
+		void Evaluate(Piece& piece)
+		{
+			Gather(piece.triangles);
+			BuildHullPlanes(points, maxPlanes, piece.hull, exact);
+			
+			// measure against the exact hull so that plane capping alone doesn't cause splits
+			piece.concavity = HullConcavity(probes, exact.empty() ? piece.hull.planes : exact);
+		}
+
+		// try splitting planes at the quartiles of each axis and keep the one with the lowest total concavity
+		bool Split(const Piece& piece, Piece& left, Piece& right)
+		{
+			Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+			for (size_t t=0; t < piece.triangles.size(); ++t)
+			{
+				Vec3 c = Centroid(piece.triangles[t]);
+
+				lower = Min(lower, c);
+				upper = Max(upper, c);
+			}
+
+			float bestCost = FLT_MAX;
+
+			Piece l, r;
+
+			for (int axis=0; axis < 3; ++axis)
+			{
+				if (upper[axis] - lower[axis] <= 0.0f)
+					continue;
+
+				for (int s=1; s <= 3; ++s)
+				{
+					const float split = lower[axis] + (upper[axis]-lower[axis])*0.25f*s;
+
+					l.triangles.resize(0);
+					r.triangles.resize(0);
+
+					for (size_t t=0; t < piece.triangles.size(); ++t)
+					{
+						if (Centroid(piece.triangles[t])[axis] < split)
+							l.triangles.push_back(piece.triangles[t]);
+						else
+							r.triangles.push_back(piece.triangles[t]);
+					}
+
+					if (l.triangles.empty() || r.triangles.empty())
+						continue;
+
+					Evaluate(l);
+					Evaluate(r);
+
+					const float cost = l.concavity + r.concavity;
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+
+						left = l;
+						right = r;
+					}
+				}
+			}
+
+			return bestCost < FLT_MAX;
+		}
+	};
+
+	inline uint64_t Fnv1a(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* p = (const uint8_t*)data;
+		
+		for (size_t i=0; i < size; ++i)
+		{
+			hash ^= p[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	const char kHullMagic[4] = { 'H', 'U', 'L', 'L' };
+	const uint32_t kHullVersion = 1;
+
+	// distinguishes temporary files written by threads of the same process
+	atomic<unsigned int> gHullTempCounter(0);
+
+	bool WriteHulls(FILE* f, uint64_t key, const std::vector<ConvexHull>& hulls)
+	{
+		const uint32_t numHulls = uint32_t(hulls.size());
+
+		if (fwrite(kHullMagic, sizeof(kHullMagic), 1, f) != 1 ||
+			fwrite(&kHullVersion, sizeof(kHullVersion), 1, f) != 1 ||
+			fwrite(&key, sizeof(key), 1, f) != 1 ||
+			fwrite(&numHulls, sizeof(numHulls), 1, f) != 1)
+			return false;
+
+		for (uint32_t i=0; i < numHulls; ++i)
+		{
+			const uint32_t numPlanes = uint32_t(hulls[i].planes.size());
+
+			if (fwrite(&numPlanes, sizeof(numPlanes), 1, f) != 1 ||
+				fwrite(&hulls[i].lower, sizeof(Vec3), 1, f) != 1 ||
+				fwrite(&hulls[i].upper, sizeof(Vec3), 1, f) != 1)
+				return false;
+
+			if (numPlanes && fwrite(&hulls[i].planes[0], sizeof(Vec4), numPlanes, f) != numPlanes)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+int CreateConvexDecomposition(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, int maxHulls, float concavity, int maxPlanes, std::vector<ConvexHull>& hulls)
+{
+	hulls.resize(0);
+
+	const int numTriangles = numTriangleIndices/3;
+	if (numTriangles == 0)
+		return 0;
+
+	Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+	for (int i=0; i < numVertices; ++i)
+	{
+		lower = Min(lower, vertices[i]);
+		upper = Max(upper, vertices[i]);
+	}
+
+	const float tolerance = concavity*Length(upper-lower);
+
+	Decomposer decomposer;
+	decomposer.vertices = vertices;
+	decomposer.indices = indices;
+	decomposer.maxPlanes = maxPlanes;
+	decomposer.stamps.resize(numVertices, 0);
+	decomposer.stamp = 0;
+
+	vector<Piece> pieces(1);
+	for (int t=0; t < numTriangles; ++t)
+		pieces[0].triangles.push_back(t);
+
+	decomposer.Evaluate(pieces[0]);
+
+	// greedily split the most concave piece
+	while (int(pieces.size()) < maxHulls)
+	{
+		int worst = -1;
+		for (int i=0; i < int(pieces.size()); ++i)
+		{
+			if (pieces[i].concavity > tolerance && (worst == -1 || pieces[i].concavity > pieces[worst].concavity))
+				worst = i;
+		}
+
+		if (worst == -1)
+			break;
+
+		Piece left, right;
+		if (!decomposer.Split(pieces[worst], left, right))
+		{
+			// can't be split further (e.g.: single triangle), accept it as is
+			pieces[worst].concavity = 0.0f;
+			continue;
+		}
+
+		pieces[worst] = left;
+		pieces.push_back(right);
+	}
+
+	for (size_t i=0; i < pieces.size(); ++i)
+		hulls.push_back(pieces[i].hull);
+
+	return int(hulls.size());
+}
+
+uint64_t ConvexDecompositionKey(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, int maxHulls, float concavity, int maxPlanes)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	hash = Fnv1a(hash, &kHullVersion, sizeof(kHullVersion));
+	hash = Fnv1a(hash, vertices, sizeof(Vec3)*numVertices);
+	hash = Fnv1a(hash, indices, sizeof(int)*numTriangleIndices);
+	hash = Fnv1a(hash, &maxHulls, sizeof(maxHulls));
+	hash = Fnv1a(hash, &concavity, sizeof(concavity));
+	hash = Fnv1a(hash, &maxPlanes, sizeof(maxPlanes));
+
+	return hash;
+}
+
+bool ConvexDecompositionSave(const char* filename, uint64_t key, const std::vector<ConvexHull>& hulls)
+{
+	// write to a unique temporary file and rename it into place, so a failed write or another 
+	// process never leaves a partial decomposition under the cached name
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", int(getpid()), gHullTempCounter++);
+
+	const string temp = string(filename) + suffix;
+
+	FILE* f = fopen(temp.c_str(), "wb");
+	if (!f)
+		return false;
+
+	bool written = WriteHulls(f, key, hulls);
+
+	// buffered data is only written on close
+	written = fclose(f) == 0 && written;
+
+	if (!written || rename(temp.c_str(), filename) != 0)
+	{
+		remove(temp.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool ConvexDecompositionLoad(const char* filename, uint64_t key, std::vector<ConvexHull>& hulls)
+{
+	FilePointer f = fopen(filename, "rb");
+	if (!f)
+		return false;
+
+	char magic[4];
+	uint32_t version;
+	uint64_t storedKey;
+	uint32_t numHulls;
+
+	if (fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, kHullMagic, sizeof(magic)) != 0)
+		return false;
+
+	if (fread(&version, sizeof(version), 1, f) != 1 || version != kHullVersion)
+		return false;
+
+	if (fread(&storedKey, sizeof(storedKey), 1, f) != 1 || storedKey != key)
+		return false;
+
+	if (fread(&numHulls, sizeof(numHulls), 1, f) != 1)
+		return false;
+
+	hulls.resize(numHulls);
+
+	for (uint32_t i=0; i < numHulls; ++i)
+	{
+		uint32_t numPlanes;
+
+		if (fread(&numPlanes, sizeof(numPlanes), 1, f) != 1 ||
+			fread(&hulls[i].lower, sizeof(Vec3), 1, f) != 1 ||
+			fread(&hulls[i].upper, sizeof(Vec3), 1, f) != 1)
+			return false;
+
+		hulls[i].planes.resize(numPlanes);
+
+		if (numPlanes && fread(&hulls[i].planes[0], sizeof(Vec4), numPlanes, f) != numPlanes)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,57 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// convex piece of an approximate decomposition, stored as planes in the form used by 
+// NvFlexUpdateConvexMesh(), i.e.: points p inside the hull satisfy Dot(n, p) + w <= 0
+struct ConvexHull
+{
+	std::vector<Vec4> planes;
+
+	Vec3 lower;
+	Vec3 upper;
+};
+
+// approximate convex decomposition of a triangle mesh, the mesh is recursively split by axis 
+// aligned planes until the hull of every piece is within concavity (a fraction of the mesh 
+// bounds diagonal) of the piece's surface, or maxHulls pieces have been created, each hull is 
+// limited to maxPlanes planes (at least 6) by keeping the planes of its largest faces and 
+// closing it with the piece's bounds, returns the number of hulls
+int CreateConvexDecomposition(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, int maxHulls, float concavity, int maxPlanes, std::vector<ConvexHull>& hulls);
+
+// hash of the mesh data and decomposition parameters, used to key cached decompositions
+uint64_t ConvexDecompositionKey(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, int maxHulls, float concavity, int maxPlanes);
+
+// save/load a decomposition in a flat binary format, saving writes a temporary file that is renamed into 
+// place and returns false if any write fails, loading fails if the stored key does not match
+bool ConvexDecompositionSave(const char* filename, uint64_t key, const std::vector<ConvexHull>& hulls);
+bool ConvexDecompositionLoad(const char* filename, uint64_t key, std::vector<ConvexHull>& hulls);
@@ -0,0 +1,256 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "hashgrid.h"
+#include "parallel.h"
+#include "radixsort.h"
+
+#include <algorithm>
+#include <float.h>
+#include <limits.h>
+
+using namespace std;
+
+namespace
+{
+	// cell coordinates are packed as 21 bit biased integers
+	const int kCellBias = 1<<20;
+	const int kCellMask = (1<<21)-1;
+
+	inline int FloorToCell(float x, float invCellSize)
+	{
+		return int(Clamp(floorf(x*invCellSize), -float(kCellBias), float(kCellBias-1)));
+	}
+}
+
+uint64_t HashGrid::GetCellKey(int x, int y, int z) const
+{
+	return (uint64_t(x + kCellBias)<<42) | (uint64_t(y + kCellBias)<<21) | uint64_t(z + kCellBias);
+}
+
+uint64_t HashGrid::GetCellKey(const Vec3& p) const
+{
+	return GetCellKey(FloorToCell(p.x, mInvCellSize), FloorToCell(p.y, mInvCellSize), FloorToCell(p.z, mInvCellSize));
+}
+
+uint32_t HashGrid::GetBucket(uint64_t key) const
+{
+	const uint32_t x = uint32_t(key>>42);
+	const uint32_t y = uint32_t(key>>21)&kCellMask;
+	const uint32_t z = uint32_t(key)&kCellMask;
+
+	return ((x*73856093u) ^ (y*19349663u) ^ (z*83492791u))&mTableMask;
+}
+
+template <typename Func>
+void HashGrid::VisitCell(int x, int y, int z, Func func) const
+{
+	if (x < mLower[0] || y < mLower[1] || z < mLower[2] || x > mUpper[0] || y > mUpper[1] || z > mUpper[2])
+		return;
+
+	const uint64_t key = GetCellKey(x, y, z);
+	const uint32_t bucket = GetBucket(key);
+
+	// buckets may be shared between cells
+	for (int i=mBucketStarts[bucket]; i < mBucketStarts[bucket+1]; ++i)
+	{
+		if (mKeys[i] == key)
+			func(i);
+	}
+}
+
+void HashGrid::Build(const Vec3* points, int numPoints, float cellSize)
+{
+	mCellSize = Max(cellSize, FLT_MIN);
+	mInvCellSize = 1.0f/mCellSize;
+
+	uint32_t tableSize = 1;
+	while (tableSize < uint32_t(numPoints))
+		tableSize *= 2;
+
+	mTableMask = tableSize-1;
+
+	vector<uint64_t> keys(numPoints);
+	vector<uint64_t> buckets(numPoints);
+	vector<int> order(numPoints);
+
+	ParallelFor(numPoints, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+		{
+			keys[i] = GetCellKey(points[i]);
+			buckets[i] = GetBucket(keys[i]);
+			order[i] = i;
+		}
+	});
+
+	int bucketBits = 0;
+	while ((1u<<bucketBits) < tableSize)
+		++bucketBits;
+
+	// stable so points within a bucket stay in index order
+	if (numPoints)
+		RadixSort(&buckets[0], &order[0], numPoints, bucketBits);
+
+	mPoints.resize(numPoints);
+	mIndices.resize(numPoints);
+	mKeys.resize(numPoints);
+
+	ParallelFor(numPoints, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+		{
+			mPoints[i] = points[order[i]];
+			mIndices[i] = order[i];
+			mKeys[i] = keys[order[i]];
+		}
+	});
+
+	mBucketStarts.assign(tableSize+1, 0);
+
+	for (int i=0; i < numPoints; ++i)
+		mBucketStarts[buckets[i]+1]++;
+
+	for (uint32_t i=0; i < tableSize; ++i)
+		mBucketStarts[i+1] += mBucketStarts[i];
+
+	mLower[0] = mLower[1] = mLower[2] = INT_MAX;
+	mUpper[0] = mUpper[1] = mUpper[2] = INT_MIN;
+
+	for (int i=0; i < numPoints; ++i)
+	{
+		const int cell[3] = { int(mKeys[i]>>42) - kCellBias, int((mKeys[i]>>21)&kCellMask) - kCellBias, int(mKeys[i]&kCellMask) - kCellBias };
+
+		for (int a=0; a < 3; ++a)
+		{
+			mLower[a] = Min(mLower[a], cell[a]);
+			mUpper[a] = Max(mUpper[a], cell[a]);
+		}
+	}
+}
+
+void HashGrid::QuerySphere(const Vec3& center, float radius, std::vector<int>& indices, bool inclusive) const
+{
+	if (mPoints.empty())
+		return;
+
+	const float radiusSq = radius*radius;
+	const size_t start = indices.size();
+
+	// cells overlapping the sphere bounds, clamped to the occupied range
+	int lower[3], upper[3];
+	for (int a=0; a < 3; ++a)
+	{
+		lower[a] = Max(FloorToCell(center[a]-radius, mInvCellSize), mLower[a]);
+		upper[a] = Min(FloorToCell(center[a]+radius, mInvCellSize), mUpper[a]);
+	}
+
+	for (int z=lower[2]; z <= upper[2]; ++z)
+	{
+		for (int y=lower[1]; y <= upper[1]; ++y)
+		{
+			for (int x=lower[0]; x <= upper[0]; ++x)
+			{
+				VisitCell(x, y, z, [&](int i)
+				{
+					const float dSq = LengthSq(mPoints[i]-center);
+
+					if (dSq < radiusSq || (inclusive && dSq == radiusSq))
+						indices.push_back(mIndices[i]);
+				});
+			}
+		}
+	}
+
+	sort(indices.begin() + start, indices.end());
+}
+
+int HashGrid::QueryNearest(const Vec3& center, int k, int* indices, float* distancesSq) const
+{
+	int count = 0;
+
+	if (mPoints.empty() || k <= 0)
+		return 0;
+
+	int c[3];
+	for (int a=0; a < 3; ++a)
+		c[a] = FloorToCell(center[a], mInvCellSize);
+
+	// insert keeping (distance, index) order, equal distances are resolved by index like a brute force scan
+	auto insert = [&](int i)
+	{
+		const float dSq = LengthSq(mPoints[i]-center);
+		const int index = mIndices[i];
+
+		if (count == k && !(dSq < distancesSq[k-1] || (dSq == distancesSq[k-1] && index < indices[k-1])))
+			return;
+
+		int w = Min(count, k-1);
+		for (; w > 0 && (dSq < distancesSq[w-1] || (dSq == distancesSq[w-1] && index < indices[w-1])); --w)
+		{
+			distancesSq[w] = distancesSq[w-1];
+			indices[w] = indices[w-1];
+		}
+
+		distancesSq[w] = dSq;
+		indices[w] = index;
+
+		count = Min(count+1, k);
+	};
+
+	// visit shells of cells at increasing Chebyshev distance from the center cell
+	for (int r=0; ; ++r)
+	{
+		for (int dz=-r; dz <= r; ++dz)
+		{
+			for (int dy=-r; dy <= r; ++dy)
+			{
+				const bool face = (dz == -r || dz == r || dy == -r || dy == r);
+				const int step = face ? 1 : 2*r;
+
+				for (int dx=-r; dx <= r; dx += Max(step, 1))
+					VisitCell(c[0]+dx, c[1]+dy, c[2]+dz, insert);
+			}
+		}
+
+		// shell covers every occupied cell
+		bool covered = true;
+		for (int a=0; a < 3; ++a)
+			covered &= (c[a]-r <= mLower[a] && c[a]+r >= mUpper[a]);
+
+		if (covered)
+			break;
+
+		// points in further shells are at least r cells away, with a small margin for rounding of cell coordinates
+		const float bound = 0.99f*float(r)*mCellSize;
+
+		if (count == k && distancesSq[k-1] < bound*bound)
+			break;
+	}
+
+	return count;
+}
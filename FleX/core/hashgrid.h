@@ -0,0 +1,79 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// uniform grid over a point cloud with cells stored in a hash table, points are sorted by 
+// cell in parallel so each cell's points are contiguous, queries return original point indices
+class HashGrid
+{
+public:
+
+	HashGrid() : mCellSize(1.0f), mInvCellSize(1.0f), mTableMask(0) {}
+
+	// cellSize should be close to the typical query radius
+	void Build(const Vec3* points, int numPoints, float cellSize);
+
+	// appends indices of points closer than radius to center (or at exactly radius if inclusive), in increasing index order
+	void QuerySphere(const Vec3& center, float radius, std::vector<int>& indices, bool inclusive=false) const;
+
+	// finds the k nearest points to center at any distance ordered by squared distance then index, 
+	// which matches a brute force insertion over points in index order, returns the number found
+	int QueryNearest(const Vec3& center, int k, int* indices, float* distancesSq) const;
+
+	int GetNumPoints() const { return int(mPoints.size()); }
+
+private:
+
+	uint64_t GetCellKey(const Vec3& p) const;
+	uint64_t GetCellKey(int x, int y, int z) const;
+
+	uint32_t GetBucket(uint64_t key) const;
+
+	// visits points in the cell, each cell is visited at most once so points are never reported twice
+	template <typename Func>
+	void VisitCell(int x, int y, int z, Func func) const;
+
+	float mCellSize;
+	float mInvCellSize;
+
+	// range of occupied cells
+	int mLower[3];
+	int mUpper[3];
+
+	uint32_t mTableMask;
+	std::vector<int> mBucketStarts;
+
+	// points sorted by hash bucket
+	std::vector<Vec3> mPoints;
+	std::vector<int> mIndices;
+	std::vector<uint64_t> mKeys;
+};
@@ -0,0 +1,544 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "heightfield.h"
+#include "mesh.h"
+
+#include <vector>
+#include <float.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+	// triangles with a smaller vertical normal component are treated as walls
+	const float kMinNormalY = 0.1f;
+
+	// grid resolution along the longest horizontal axis used by IsHeightField()
+	const int kDetectResolution = 128;
+
+	inline int Clamp(int x, int lower, int upper) { return min(max(lower, x), upper); }
+
+	struct Grid
+	{
+		float lowerX;
+		float lowerZ;
+		float spacing;
+		int width;
+		int depth;
+	};
+
+	Grid MakeGrid(Vec3 lower, Vec3 upper, float spacing)
+	{
+		Grid g;
+		g.lowerX = lower.x;
+		g.lowerZ = lower.z;
+		g.spacing = spacing;
+		g.width = max(2, int(ceilf((upper.x-lower.x)/spacing))+1);
+		g.depth = max(2, int(ceilf((upper.z-lower.z)/spacing))+1);
+
+		return g;
+	}
+
+	void MeshBounds(const Vec3* vertices, int numVertices, Vec3& lower, Vec3& upper)
+	{
+		lower = Vec3(FLT_MAX);
+		upper = Vec3(-FLT_MAX);
+
+		for (int i=0; i < numVertices; ++i)
+		{
+			lower = Min(lower, vertices[i]);
+			upper = Max(upper, vertices[i]);
+		}
+	}
+
+	// +1 if the mesh is wound counter-clockwise (outward normals), -1 otherwise, 
+	// open meshes use the sign of their partial volume which is good enough for terrain
+	float Winding(const Vec3* vertices, const int* indices, int numTriangleIndices)
+	{
+		double volume = 0.0;
+
+		for (int i=0; i < numTriangleIndices; i+=3)
+		{
+			const Vec3& a = vertices[indices[i+0]];
+			const Vec3& b = vertices[indices[i+1]];
+			const Vec3& c = vertices[indices[i+2]];
+
+			volume += Dot(a, Cross(b, c));
+		}
+
+		return volume < 0.0 ? -1.0f : 1.0f;
+	}
+
+	// returns the vertical component of the triangle's unit normal
+	float NormalY(Vec3 a, Vec3 b, Vec3 c, float winding)
+	{
+		Vec3 n = Cross(b-a, c-a)*winding;
+		float l = Length(n);
+
+		return l > 0.0f ? n.y/l : 0.0f;
+	}
+
+	// finds the grid samples covered by the triangle's projection onto the x-z plane along with the triangle's height at each one
+	void RasterizeTriangle(const Grid& g, Vec3 a, Vec3 b, Vec3 c, vector<int>& samples, vector<float>& heights)
+	{
+		samples.resize(0);
+		heights.resize(0);
+
+		const float area = (b.x-a.x)*(c.z-a.z) - (c.x-a.x)*(b.z-a.z);
+		if (fabsf(area) < 1.e-12f)
+			return;
+
+		const float invArea = 1.0f/area;
+		const float invSpacing = 1.0f/g.spacing;
+
+		// inclusive edges so samples on shared edges are covered by both triangles
+		const float eps = 1.e-4f;
+
+		const int x0 = Clamp(int(floorf((min(a.x, min(b.x, c.x))-g.lowerX)*invSpacing)), 0, g.width-1);
+		const int x1 = Clamp(int(ceilf((max(a.x, max(b.x, c.x))-g.lowerX)*invSpacing)), 0, g.width-1);
+		const int z0 = Clamp(int(floorf((min(a.z, min(b.z, c.z))-g.lowerZ)*invSpacing)), 0, g.depth-1);
+		const int z1 = Clamp(int(ceilf((max(a.z, max(b.z, c.z))-g.lowerZ)*invSpacing)), 0, g.depth-1);
+
+		for (int z=z0; z <= z1; ++z)
+		{
+			for (int x=x0; x <= x1; ++x)
+			{
+				const float px = g.lowerX + x*g.spacing;
+				const float pz = g.lowerZ + z*g.spacing;
+
+				const float v = ((px-a.x)*(c.z-a.z) - (c.x-a.x)*(pz-a.z))*invArea;
+				const float w = ((b.x-a.x)*(pz-a.z) - (px-a.x)*(b.z-a.z))*invArea;
+				const float u = 1.0f - v - w;
+
+				if (u >= -eps && v >= -eps && w >= -eps)
+				{
+					samples.push_back(z*g.width + x);
+					heights.push_back(u*a.y + v*b.y + w*c.y);
+				}
+			}
+		}
+	}
+
+	// returns the minimum and maximum height of all upward facing triangles at each sample
+	void RasterizeTop(const Grid& g, const Vec3* vertices, const int* indices, int numTriangleIndices, float winding, vector<float>& lowest, vector<float>& highest)
+	{
+		lowest.assign(g.width*g.depth, FLT_MAX);
+		highest.assign(g.width*g.depth, -FLT_MAX);
+
+		vector<int> samples;
+		vector<float> heights;
+
+		for (int i=0; i < numTriangleIndices; i+=3)
+		{
+			const Vec3 a = vertices[indices[i+0]];
+			const Vec3 b = vertices[indices[i+1]];
+			const Vec3 c = vertices[indices[i+2]];
+
+			if (NormalY(a, b, c, winding) < kMinNormalY)
+				continue;
+
+			RasterizeTriangle(g, a, b, c, samples, heights);
+
+			for (size_t s=0; s < samples.size(); ++s)
+			{
+				lowest[samples[s]] = min(lowest[samples[s]], heights[s]);
+				highest[samples[s]] = max(highest[samples[s]], heights[s]);
+			}
+		}
+	}
+
+	inline float Lerp(float a, float b, float t) { return a + (b-a)*t; }
+
+	// bilinear height and gradient at a point given in world space, positions are clamped to the grid
+	inline float Bilinear(const HeightField& f, float x, float z, float* dhdx, float* dhdz)
+	{
+		const float invSpacing = 1.0f/f.spacing;
+
+		const float gx = min(max((x-f.lower.x)*invSpacing, 0.0f), float(f.width-1));
+		const float gz = min(max((z-f.lower.z)*invSpacing, 0.0f), float(f.depth-1));
+
+		const int ix = min(int(gx), f.width-2);
+		const int iz = min(int(gz), f.depth-2);
+
+		const float tx = gx-ix;
+		const float tz = gz-iz;
+
+		const float* row0 = &f.heights[iz*f.width + ix];
+		const float* row1 = row0 + f.width;
+
+		if (dhdx)
+			*dhdx = Lerp(row0[1]-row0[0], row1[1]-row1[0], tz)*invSpacing;
+		if (dhdz)
+			*dhdz = Lerp(row1[0]-row0[0], row1[1]-row0[1], tx)*invSpacing;
+
+		return Lerp(Lerp(row0[0], row0[1], tx), Lerp(row1[0], row1[1], tx), tz);
+	}
+
+	inline Vec3 SlopeNormal(float dhdx, float dhdz)
+	{
+		return Normalize(Vec3(-dhdx, 1.0f, -dhdz));
+	}
+
+#if defined(__AVX2__)
+
+	// a*b + c, fused when the target has FMA
+	inline __m256 MulAdd8(__m256 a, __m256 b, __m256 c)
+	{
+#if defined(__FMA__)
+		return _mm256_fmadd_ps(a, b, c);
+#else
+		return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+	}
+
+#endif
+
+	// returns true if every sample in the block [x0,x1]x[z0,z1] lies within tolerance of the plane through three of its corners
+	bool IsPlanar(const HeightField& f, int x0, int z0, int x1, int z1, float tolerance)
+	{
+		const float h00 = f.heights[z0*f.width + x0];
+		const float sx = (f.heights[z0*f.width + x1]-h00)/(x1-x0);
+		const float sz = (f.heights[z1*f.width + x0]-h00)/(z1-z0);
+
+		for (int z=z0; z <= z1; ++z)
+		{
+			for (int x=x0; x <= x1; ++x)
+			{
+				const float h = h00 + sx*(x-x0) + sz*(z-z0);
+
+				if (fabsf(f.heights[z*f.width + x]-h) > tolerance)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	struct MeshBuilder
+	{
+		MeshBuilder(const HeightField& f, Mesh* m) : field(f), mesh(m), remap(f.width*f.depth, -1) {}
+
+		uint32_t Vertex(int x, int z)
+		{
+			int& index = remap[z*field.width + x];
+
+			if (index == -1)
+			{
+				index = int(mesh->m_positions.size());
+
+				const float px = field.lower.x + x*field.spacing;
+				const float pz = field.lower.z + z*field.spacing;
+
+				mesh->m_positions.push_back(Point3(px, field.heights[z*field.width + x], pz));
+				mesh->m_normals.push_back(Vector3(field.GetNormal(px, pz)));
+			}
+
+			return uint32_t(index);
+		}
+
+		void Quad(int x0, int z0, int x1, int z1)
+		{
+			const uint32_t a = Vertex(x0, z0);
+			const uint32_t b = Vertex(x1, z0);
+			const uint32_t c = Vertex(x1, z1);
+			const uint32_t d = Vertex(x0, z1);
+
+			// counter-clockwise when viewed from above
+			mesh->m_indices.push_back(a);
+			mesh->m_indices.push_back(d);
+			mesh->m_indices.push_back(c);
+
+			mesh->m_indices.push_back(a);
+			mesh->m_indices.push_back(c);
+			mesh->m_indices.push_back(b);
+		}
+
+		// quadtree subdivision of the cell range [x0,x1)x[z0,z1)
+		void Block(int x0, int z0, int x1, int z1, float tolerance)
+		{
+			if (x1-x0 == 1 && z1-z0 == 1)
+			{
+				Quad(x0, z0, x1, z1);
+				return;
+			}
+
+			if (tolerance > 0.0f && IsPlanar(field, x0, z0, x1, z1, tolerance))
+			{
+				Quad(x0, z0, x1, z1);
+				return;
+			}
+
+			const int mx = (x1-x0 > 1) ? (x0+x1)/2 : x1;
+			const int mz = (z1-z0 > 1) ? (z0+z1)/2 : z1;
+
+			Block(x0, z0, mx, mz, tolerance);
+
+			if (mx < x1)
+				Block(mx, z0, x1, mz, tolerance);
+			if (mz < z1)
+				Block(x0, mz, mx, z1, tolerance);
+			if (mx < x1 && mz < z1)
+				Block(mx, mz, x1, z1, tolerance);
+		}
+
+		const HeightField& field;
+		Mesh* mesh;
+
+		vector<int> remap;
+	};
+
+} // anonymous namespace
+
+float HeightField::GetHeight(float x, float z) const
+{
+	return Bilinear(*this, x, z, NULL, NULL);
+}
+
+Vec3 HeightField::GetNormal(float x, float z) const
+{
+	float dhdx, dhdz;
+	Bilinear(*this, x, z, &dhdx, &dhdz);
+
+	return SlopeNormal(dhdx, dhdz);
+}
+
+void HeightField::GetBounds(Vec3& minExtents, Vec3& maxExtents) const
+{
+	float top = lower.y;
+	for (size_t i=0; i < heights.size(); ++i)
+		top = max(top, heights[i]);
+
+	minExtents = lower;
+	maxExtents = Vec3(lower.x + (width-1)*spacing, top, lower.z + (depth-1)*spacing);
+}
+
+bool IsHeightField(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, float tolerance)
+{
+	Vec3 lower, upper;
+	MeshBounds(vertices, numVertices, lower, upper);
+
+	const float extent = max(upper.x-lower.x, upper.z-lower.z);
+	if (extent <= 0.0f)
+		return false;
+
+	const Grid g = MakeGrid(lower, upper, extent/kDetectResolution);
+	const float winding = Winding(vertices, indices, numTriangleIndices);
+
+	vector<float> lowest, highest;
+	RasterizeTop(g, vertices, indices, numTriangleIndices, winding, lowest, highest);
+
+	vector<int> samples;
+	vector<float> heights;
+
+	// a downward facing surface must be the bottom of the solid, if there is an 
+	// upward facing surface beneath it then it is an overhang with empty space below
+	for (int i=0; i < numTriangleIndices; i+=3)
+	{
+		const Vec3 a = vertices[indices[i+0]];
+		const Vec3 b = vertices[indices[i+1]];
+		const Vec3 c = vertices[indices[i+2]];
+
+		if (NormalY(a, b, c, winding) > -kMinNormalY)
+			continue;
+
+		RasterizeTriangle(g, a, b, c, samples, heights);
+
+		for (size_t s=0; s < samples.size(); ++s)
+		{
+			if (lowest[samples[s]] < heights[s] - tolerance)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void CreateHeightField(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, float spacing, HeightField& field)
+{
+	Vec3 lower, upper;
+	MeshBounds(vertices, numVertices, lower, upper);
+
+	const Grid g = MakeGrid(lower, upper, spacing);
+
+	vector<float> lowest;
+	RasterizeTop(g, vertices, indices, numTriangleIndices, Winding(vertices, indices, numTriangleIndices), lowest, field.heights);
+
+	for (size_t i=0; i < field.heights.size(); ++i)
+	{
+		if (field.heights[i] == -FLT_MAX)
+			field.heights[i] = lower.y;
+	}
+
+	field.width = g.width;
+	field.depth = g.depth;
+	field.spacing = spacing;
+	field.lower = lower;
+}
+
+void SampleHeightField(const HeightField& field, const Vec3* points, int numPoints, float* outHeights, Vec3* outNormals)
+{
+	int i = 0;
+
+#if defined(__AVX2__)
+
+	const __m256 invSpacing = _mm256_set1_ps(1.0f/field.spacing);
+	const __m256 lowerX = _mm256_set1_ps(field.lower.x);
+	const __m256 lowerZ = _mm256_set1_ps(field.lower.z);
+	const __m256 maxX = _mm256_set1_ps(float(field.width-1));
+	const __m256 maxZ = _mm256_set1_ps(float(field.depth-1));
+	const __m256i maxCellX = _mm256_set1_epi32(field.width-2);
+	const __m256i maxCellZ = _mm256_set1_epi32(field.depth-2);
+	const __m256i width = _mm256_set1_epi32(field.width);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	// offsets of the x and z components of 8 consecutive Vec3s
+	const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+	for (; i+8 <= numPoints; i+=8)
+	{
+		const float* p = &points[i].x;
+
+		const __m256 px = _mm256_i32gather_ps(p, stride, 4);
+		const __m256 pz = _mm256_i32gather_ps(p+2, stride, 4);
+
+		const __m256 gx = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(px, lowerX), invSpacing), zero), maxX);
+		const __m256 gz = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(pz, lowerZ), invSpacing), zero), maxZ);
+
+		const __m256i ix = _mm256_min_epi32(_mm256_cvttps_epi32(gx), maxCellX);
+		const __m256i iz = _mm256_min_epi32(_mm256_cvttps_epi32(gz), maxCellZ);
+
+		const __m256 tx = _mm256_sub_ps(gx, _mm256_cvtepi32_ps(ix));
+		const __m256 tz = _mm256_sub_ps(gz, _mm256_cvtepi32_ps(iz));
+
+		const __m256i i00 = _mm256_add_epi32(_mm256_mullo_epi32(iz, width), ix);
+		const __m256i i01 = _mm256_add_epi32(i00, width);
+
+		const float* h = &field.heights[0];
+
+		const __m256 h00 = _mm256_i32gather_ps(h, i00, 4);
+		const __m256 h10 = _mm256_i32gather_ps(h+1, i00, 4);
+		const __m256 h01 = _mm256_i32gather_ps(h, i01, 4);
+		const __m256 h11 = _mm256_i32gather_ps(h+1, i01, 4);
+
+		const __m256 dx0 = _mm256_sub_ps(h10, h00);
+		const __m256 dx1 = _mm256_sub_ps(h11, h01);
+
+		const __m256 h0 = MulAdd8(dx0, tx, h00);
+		const __m256 h1 = MulAdd8(dx1, tx, h01);
+
+		if (outHeights)
+			_mm256_storeu_ps(outHeights+i, MulAdd8(_mm256_sub_ps(h1, h0), tz, h0));
+
+		if (outNormals)
+		{
+			const __m256 dz0 = _mm256_sub_ps(h01, h00);
+			const __m256 dz1 = _mm256_sub_ps(h11, h10);
+
+			const __m256 nx = _mm256_mul_ps(MulAdd8(_mm256_sub_ps(dx1, dx0), tz, dx0), invSpacing);
+			const __m256 nz = _mm256_mul_ps(MulAdd8(_mm256_sub_ps(dz1, dz0), tx, dz0), invSpacing);
+
+			const __m256 invLength = _mm256_div_ps(one, _mm256_sqrt_ps(MulAdd8(nx, nx, MulAdd8(nz, nz, one))));
+
+			float x[8], y[8], z[8];
+			_mm256_storeu_ps(x, _mm256_mul_ps(nx, invLength));
+			_mm256_storeu_ps(y, invLength);
+			_mm256_storeu_ps(z, _mm256_mul_ps(nz, invLength));
+
+			for (int k=0; k < 8; ++k)
+				outNormals[i+k] = Vec3(-x[k], y[k], -z[k]);
+		}
+	}
+
+#endif
+
+	for (; i < numPoints; ++i)
+	{
+		float dhdx, dhdz;
+		const float h = Bilinear(field, points[i].x, points[i].z, &dhdx, &dhdz);
+
+		if (outHeights)
+			outHeights[i] = h;
+		if (outNormals)
+			outNormals[i] = SlopeNormal(dhdx, dhdz);
+	}
+}
+
+Mesh* CreateHeightFieldMesh(const HeightField& field, float tolerance)
+{
+	Mesh* m = new Mesh();
+
+	MeshBuilder builder(field, m);
+	builder.Block(0, 0, field.width-1, field.depth-1, tolerance);
+
+	return m;
+}
+
+void CreateHeightFieldSDF(const HeightField& field, int dim, float* sdf, Vec3& lower, float& width)
+{
+	Vec3 minExtents, maxExtents;
+	field.GetBounds(minExtents, maxExtents);
+
+	// cube around the field with a margin of a few voxels so the surface does not touch the boundary
+	const Vec3 edges = maxExtents-minExtents;
+	const float size = max(edges.x, max(edges.y, edges.z));
+	const float margin = size*4.0f/dim;
+
+	width = size + 2.0f*margin;
+	lower = 0.5f*(minExtents+maxExtents) - Vec3(0.5f*width);
+
+	const float spacing = width/dim;
+	const float invWidth = 1.0f/width;
+
+	for (int z=0; z < dim; ++z)
+	{
+		for (int x=0; x < dim; ++x)
+		{
+			// voxel centers
+			const float px = lower.x + (x+0.5f)*spacing;
+			const float pz = lower.z + (z+0.5f)*spacing;
+
+			float dhdx, dhdz;
+			const float h = Bilinear(field, px, pz, &dhdx, &dhdz);
+			const float ny = SlopeNormal(dhdx, dhdz).y;
+
+			for (int y=0; y < dim; ++y)
+			{
+				const float py = lower.y + (y+0.5f)*spacing;
+
+				// vertical distance projected onto the surface normal
+				sdf[z*dim*dim + y*dim + x] = (py-h)*ny*invWidth;
+			}
+		}
+	}
+}
@@ -0,0 +1,78 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+struct Mesh;
+
+// regular grid of heights along +y, samples are spaced uniformly in x and z starting from 
+// (lower.x, lower.z), lower.y is the base of the terrain (the lowest point of the source mesh)
+struct HeightField
+{
+	HeightField() : width(0), depth(0), spacing(0.0f) {}
+
+	// bilinearly interpolated height and surface normal, positions outside the grid are clamped
+	float GetHeight(float x, float z) const;
+	Vec3 GetNormal(float x, float z) const;
+
+	void GetBounds(Vec3& minExtents, Vec3& maxExtents) const;
+
+	int width;
+	int depth;
+
+	Vec3 lower;
+	float spacing;
+
+	std::vector<float> heights;	// width*depth samples, x varies fastest
+};
+
+// returns true if the solid described by the mesh is a height field along +y, i.e.: the space 
+// above its top surface is empty and no downward facing surface hangs over an upward facing one, 
+// near vertical faces are ignored and surfaces closer than tolerance are considered coincident
+bool IsHeightField(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, float tolerance);
+
+// resample the top surface of a mesh on a grid with the given spacing, samples not covered by 
+// any upward facing triangle are set to the base height
+void CreateHeightField(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, float spacing, HeightField& field);
+
+// batched height and normal queries at the x-z positions of points, uses AVX2 gathers when 
+// compiled with AVX2 enabled, outHeights or outNormals may be NULL
+void SampleHeightField(const HeightField& field, const Vec3* points, int numPoints, float* outHeights, Vec3* outNormals);
+
+// triangulates the top surface of the height field, grid blocks that are planar to within 
+// tolerance are merged into a single quad, so flat or sloped regions cost two triangles 
+// regardless of resolution, a tolerance of zero produces the full grid
+Mesh* CreateHeightFieldMesh(const HeightField& field, float tolerance);
+
+// signed distance slab for the height field in the format output by MakeSDF(), a dim^3 field 
+// covering a cube of the returned width whose lower corner is returned in lower, distances are 
+// negative below the surface and use a first order approximation to the true distance
+void CreateHeightFieldSDF(const HeightField& field, int dim, float* sdf, Vec3& lower, float& width);
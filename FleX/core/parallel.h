@@ -0,0 +1,53 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "threadpool.h"
+
+#include <algorithm>
+
+// number of threads in the shared pool used by ParallelFor()
+inline int GetParallelThreadCount()
+{
+	return GetParallelPool().GetThreadCount();
+}
+
+// calls func(begin, end) on contiguous sub-ranges of [0, count) from the threads of the shared pool, 
+// ranges are at least minGrain long so small loops run inline on the calling thread, func must only 
+// write to data owned by its own range, calls from inside another ParallelFor() run inline
+template <typename Func>
+void ParallelFor(int count, Func func, int minGrain=1024)
+{
+	ThreadPool& pool = GetParallelPool();
+
+	// a few ranges per thread so idle threads can steal from slow ones
+	const int numRanges = pool.GetThreadCount()*4;
+	const int grain = std::max(std::max(minGrain, 1), (count + numRanges - 1)/numRanges);
+
+	pool.ParallelFor(count, func, grain);
+}
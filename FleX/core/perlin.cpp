@@ -26,8 +26,15 @@
 // Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
 
 #include "perlin.h"
+#include "parallel.h"
 
 #include <cmath>
+#include <algorithm>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace Perlin
 {
@@ -274,6 +281,224 @@ static real64 PerlinNoise1DFunction(real64 x)
 	
 	return x0;
 }
+
+#if defined(__AVX2__)
+
+//	permutation table widened to 32 bits for gathers
+static struct NoisePermTable
+{
+	NoisePermTable()
+	{
+		for (int i=0; i < 2*NOISE_PERM_SIZE; ++i)
+			v[i] = NoisePerm[i];
+	}
+
+	int v[2*NOISE_PERM_SIZE];
+} NoisePerm32;
+
+//	a*b + c, fused when the target has FMA
+static inline __m256 MulAdd8(__m256 a, __m256 b, __m256 c)
+{
+#if defined(__FMA__)
+	return _mm256_fmadd_ps(a, b, c);
+#else
+	return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+static inline __m256i Perm8(__m256i i)
+{
+	return _mm256_i32gather_epi32(NoisePerm32.v, i, 4);
+}
+
+//	flips the sign of x in lanes where the given bit of h is set
+static inline __m256 FlipSign8(__m256 x, __m256i h, int bit)
+{
+	const __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(bit)), _mm256_set1_epi32(bit));
+	return _mm256_xor_ps(x, _mm256_and_ps(_mm256_castsi256_ps(mask), _mm256_set1_ps(-0.0f)));
+}
+
+static inline __m256 Select8(__m256i mask, __m256 a, __m256 b)
+{
+	return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask));
+}
+
+static inline __m256 Grad1d8(__m256i x, __m256 dx)
+{
+	const __m256i h = Perm8(x);
+	return FlipSign8(dx, h, 1);
+}
+
+static inline __m256 Grad2d8(__m256i x, __m256i y, __m256 dx, __m256 dy) 
+{
+	const __m256i h = Perm8(_mm256_add_epi32(Perm8(x), y));
+	return _mm256_add_ps(FlipSign8(dx, h, 1), FlipSign8(dy, h, 2));
+}
+
+static inline __m256 Grad3d8(__m256i x, __m256i y, __m256i z, __m256 dx, __m256 dy, __m256 dz) 
+{
+	const __m256i h = _mm256_and_si256(Perm8(_mm256_add_epi32(Perm8(_mm256_add_epi32(Perm8(x), y)), z)), _mm256_set1_epi32(15));
+
+	const __m256i lt8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(8), h);
+	const __m256i lt4 = _mm256_cmpgt_epi32(_mm256_set1_epi32(4), h);
+	const __m256i h12or14 = _mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14)));
+
+	const __m256 u = Select8(lt8, dx, dy);
+	const __m256 v = Select8(lt4, dy, Select8(h12or14, dx, dz));
+
+	return _mm256_add_ps(FlipSign8(u, h, 1), FlipSign8(v, h, 2));
+}
+
+static inline __m256 Lerp8(__m256 t, __m256 v1, __m256 v2)
+{
+	return MulAdd8(t, _mm256_sub_ps(v2, v1), v1);
+}
+
+static inline __m256 PerlinFade8(__m256 val)
+{
+	const __m256 val3 = _mm256_mul_ps(_mm256_mul_ps(val, val), val);
+	const __m256 val4 = _mm256_mul_ps(val3, val);
+
+	return MulAdd8(_mm256_set1_ps(10.0f), val3, _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(6.0f), val4), val), _mm256_mul_ps(_mm256_set1_ps(15.0f), val4)));
+}
+
+//	c modulo with the sign of the dividend, exact while |i| < 2^24
+static inline __m256i Mod8(__m256i i, int p)
+{
+	const __m256i period = _mm256_set1_epi32(p);
+	const __m256i q = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(i), _mm256_set1_ps(float(p))));
+
+	__m256i r = _mm256_sub_epi32(i, _mm256_mullo_epi32(q, period));
+
+	// correct a quotient rounded across an integer
+	const __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), i);
+	r = _mm256_sub_epi32(r, _mm256_and_si256(_mm256_andnot_si256(negative, _mm256_cmpgt_epi32(r, _mm256_sub_epi32(period, _mm256_set1_epi32(1)))), period));
+	r = _mm256_add_epi32(r, _mm256_and_si256(_mm256_andnot_si256(negative, _mm256_cmpgt_epi32(_mm256_setzero_si256(), r)), period));
+	r = _mm256_add_epi32(r, _mm256_and_si256(_mm256_and_si256(negative, _mm256_cmpgt_epi32(_mm256_sub_epi32(_mm256_set1_epi32(1), period), r)), period));
+	r = _mm256_sub_epi32(r, _mm256_and_si256(_mm256_and_si256(negative, _mm256_cmpgt_epi32(r, _mm256_setzero_si256())), period));
+
+	return r;
+}
+
+static inline __m256 Trilinear8(__m256 dx, __m256 dy, __m256 dz, __m256 w000, __m256 w100, __m256 w010, __m256 w110, __m256 w001, __m256 w101, __m256 w011, __m256 w111)
+{
+	const __m256 wx = PerlinFade8(dx);
+	const __m256 wy = PerlinFade8(dy);
+	const __m256 wz = PerlinFade8(dz);
+	const __m256 x00 = Lerp8(wx, w000, w100);
+	const __m256 x10 = Lerp8(wx, w010, w110);
+	const __m256 x01 = Lerp8(wx, w001, w101);
+	const __m256 x11 = Lerp8(wx, w011, w111);
+	const __m256 y0 = Lerp8(wy, x00, x10);
+	const __m256 y1 = Lerp8(wy, x01, x11);
+	return Lerp8(wz, y0, y1);
+}
+
+static __m256 PerlinNoise3DFunctionPeriodic8(__m256 x, __m256 y, __m256 z, int px, int py, int pz) 
+{
+	const __m256i mask = _mm256_set1_epi32(NOISE_PERM_SIZE-1);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 onef = _mm256_set1_ps(1.0f);
+
+	const __m256 fx = _mm256_floor_ps(x);
+	const __m256 fy = _mm256_floor_ps(y);
+	const __m256 fz = _mm256_floor_ps(z);
+	const __m256i ix = _mm256_cvttps_epi32(fx);
+	const __m256i iy = _mm256_cvttps_epi32(fy);
+	const __m256i iz = _mm256_cvttps_epi32(fz);
+	const __m256 dx = _mm256_sub_ps(x, fx), dy = _mm256_sub_ps(y, fy), dz = _mm256_sub_ps(z, fz);
+
+	const __m256i ix0 = _mm256_and_si256(Mod8(ix, px), mask);
+	const __m256i iy0 = _mm256_and_si256(Mod8(iy, py), mask);
+	const __m256i iz0 = _mm256_and_si256(Mod8(iz, pz), mask);
+
+	const __m256i ix1 = _mm256_and_si256(Mod8(_mm256_add_epi32(ix, one), px), mask);
+	const __m256i iy1 = _mm256_and_si256(Mod8(_mm256_add_epi32(iy, one), py), mask);
+	const __m256i iz1 = _mm256_and_si256(Mod8(_mm256_add_epi32(iz, one), pz), mask);
+
+	const __m256 dx1 = _mm256_sub_ps(dx, onef), dy1 = _mm256_sub_ps(dy, onef), dz1 = _mm256_sub_ps(dz, onef);
+
+	return Trilinear8(dx, dy, dz,
+		Grad3d8(ix0, iy0, iz0, dx,  dy,  dz),
+		Grad3d8(ix1, iy0, iz0, dx1, dy,  dz),
+		Grad3d8(ix0, iy1, iz0, dx,  dy1, dz),
+		Grad3d8(ix1, iy1, iz0, dx1, dy1, dz),
+		Grad3d8(ix0, iy0, iz1, dx,  dy,  dz1),
+		Grad3d8(ix1, iy0, iz1, dx1, dy,  dz1),
+		Grad3d8(ix0, iy1, iz1, dx,  dy1, dz1),
+		Grad3d8(ix1, iy1, iz1, dx1, dy1, dz1));
+}
+
+static __m256 PerlinNoise3DFunction8(__m256 x, __m256 y, __m256 z) 
+{
+	const __m256i mask = _mm256_set1_epi32(NOISE_PERM_SIZE-1);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 onef = _mm256_set1_ps(1.0f);
+
+	const __m256 fx = _mm256_floor_ps(x);
+	const __m256 fy = _mm256_floor_ps(y);
+	const __m256 fz = _mm256_floor_ps(z);
+	const __m256i ix = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+	const __m256i iy = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask);
+	const __m256i iz = _mm256_and_si256(_mm256_cvttps_epi32(fz), mask);
+	const __m256 dx = _mm256_sub_ps(x, fx), dy = _mm256_sub_ps(y, fy), dz = _mm256_sub_ps(z, fz);
+
+	const __m256i ix1 = _mm256_add_epi32(ix, one), iy1 = _mm256_add_epi32(iy, one), iz1 = _mm256_add_epi32(iz, one);
+	const __m256 dx1 = _mm256_sub_ps(dx, onef), dy1 = _mm256_sub_ps(dy, onef), dz1 = _mm256_sub_ps(dz, onef);
+
+	return Trilinear8(dx, dy, dz,
+		Grad3d8(ix,  iy,  iz,  dx,  dy,  dz),
+		Grad3d8(ix1, iy,  iz,  dx1, dy,  dz),
+		Grad3d8(ix,  iy1, iz,  dx,  dy1, dz),
+		Grad3d8(ix1, iy1, iz,  dx1, dy1, dz),
+		Grad3d8(ix,  iy,  iz1, dx,  dy,  dz1),
+		Grad3d8(ix1, iy,  iz1, dx1, dy,  dz1),
+		Grad3d8(ix,  iy1, iz1, dx,  dy1, dz1),
+		Grad3d8(ix1, iy1, iz1, dx1, dy1, dz1));
+}
+
+static __m256 PerlinNoise2DFunction8(__m256 x, __m256 y) 
+{
+	const __m256i mask = _mm256_set1_epi32(NOISE_PERM_SIZE-1);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 onef = _mm256_set1_ps(1.0f);
+
+	const __m256 fx = _mm256_floor_ps(x);
+	const __m256 fy = _mm256_floor_ps(y);
+	const __m256i ix = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+	const __m256i iy = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask);
+	const __m256 dx = _mm256_sub_ps(x, fx), dy = _mm256_sub_ps(y, fy);
+
+	const __m256i ix1 = _mm256_add_epi32(ix, one), iy1 = _mm256_add_epi32(iy, one);
+	const __m256 dx1 = _mm256_sub_ps(dx, onef), dy1 = _mm256_sub_ps(dy, onef);
+
+	const __m256 w00 = Grad2d8(ix,  iy,  dx,  dy);
+	const __m256 w10 = Grad2d8(ix1, iy,  dx1, dy);
+	const __m256 w01 = Grad2d8(ix,  iy1, dx,  dy1);
+	const __m256 w11 = Grad2d8(ix1, iy1, dx1, dy1);
+
+	const __m256 wx = PerlinFade8(dx);
+	const __m256 wy = PerlinFade8(dy);
+	const __m256 x0 = Lerp8(wx, w00, w10);
+	const __m256 x1 = Lerp8(wx, w01, w11);
+	return Lerp8(wy, x0, x1);
+}
+
+static __m256 PerlinNoise1DFunction8(__m256 x) 
+{
+	const __m256i mask = _mm256_set1_epi32(NOISE_PERM_SIZE-1);
+
+	const __m256 fx = _mm256_floor_ps(x);
+	const __m256i ix = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+	const __m256 dx = _mm256_sub_ps(x, fx);
+
+	const __m256 w00 = Grad1d8(ix, dx);
+	const __m256 w10 = Grad1d8(_mm256_add_epi32(ix, _mm256_set1_epi32(1)), _mm256_sub_ps(dx, _mm256_set1_ps(1.0f)));
+
+	return Lerp8(PerlinFade8(dx), w00, w10);
+}
+
+#endif
 }
 
 //------------------------------------------------
@@ -365,3 +590,180 @@ float Perlin3DPeriodic(float x, float y, float z, int px, int py, int pz, int oc
 
 	return r;
 }
+
+//------------------------------------------------
+//! Batch interfaces, AVX2 evaluates 8 points per lane group, remaining points use the single point versions
+
+void Perlin1D(const float* x, int n, int octaves, float persistence, float* result)
+{
+	int start = 0;
+
+#if defined(__AVX2__)
+	for (; start + 8 <= n; start += 8)
+	{
+		const __m256 px = _mm256_loadu_ps(&x[start]);
+
+		__m256 r = _mm256_setzero_ps();
+		float a = 1.0f;
+		int freq = 1;
+
+		for (int i=0; i < octaves; i++)
+		{
+			const __m256 f = _mm256_set1_ps(float(freq));
+
+			r = Perlin::MulAdd8(Perlin::PerlinNoise1DFunction8(_mm256_mul_ps(px, f)), _mm256_set1_ps(a), r);
+
+			a *= persistence;
+			freq = 2 << i;
+		}
+
+		_mm256_storeu_ps(&result[start], r);
+	}
+#endif
+
+	for (int i=start; i < n; ++i)
+		result[i] = Perlin1D(x[i], octaves, persistence);
+}
+
+void Perlin2D(const float* x, const float* y, int n, int octaves, float persistence, float* result)
+{
+	int start = 0;
+
+#if defined(__AVX2__)
+	for (; start + 8 <= n; start += 8)
+	{
+		const __m256 px = _mm256_loadu_ps(&x[start]);
+		const __m256 py = _mm256_loadu_ps(&y[start]);
+
+		__m256 r = _mm256_setzero_ps();
+		float a = 1.0f;
+		int freq = 1;
+
+		for (int i=0; i < octaves; i++)
+		{
+			const __m256 f = _mm256_set1_ps(float(freq));
+
+			r = Perlin::MulAdd8(Perlin::PerlinNoise2DFunction8(_mm256_mul_ps(px, f), _mm256_mul_ps(py, f)), _mm256_set1_ps(a), r);
+
+			a *= persistence;
+			freq = 2 << i;
+		}
+
+		_mm256_storeu_ps(&result[start], r);
+	}
+#endif
+
+	for (int i=start; i < n; ++i)
+		result[i] = Perlin2D(x[i], y[i], octaves, persistence);
+}
+
+void Perlin3D(const float* x, const float* y, const float* z, int n, int octaves, float persistence, float* result)
+{
+	int start = 0;
+
+#if defined(__AVX2__)
+	for (; start + 8 <= n; start += 8)
+	{
+		const __m256 px = _mm256_loadu_ps(&x[start]);
+		const __m256 py = _mm256_loadu_ps(&y[start]);
+		const __m256 pz = _mm256_loadu_ps(&z[start]);
+
+		__m256 r = _mm256_setzero_ps();
+		float a = 1.0f;
+		int freq = 1;
+
+		for (int i=0; i < octaves; i++)
+		{
+			const __m256 f = _mm256_set1_ps(float(freq));
+
+			r = Perlin::MulAdd8(Perlin::PerlinNoise3DFunction8(_mm256_mul_ps(px, f), _mm256_mul_ps(py, f), _mm256_mul_ps(pz, f)), _mm256_set1_ps(a), r);
+
+			a *= persistence;
+			freq = 2 << i;
+		}
+
+		_mm256_storeu_ps(&result[start], r);
+	}
+#endif
+
+	for (int i=start; i < n; ++i)
+		result[i] = Perlin3D(x[i], y[i], z[i], octaves, persistence);
+}
+
+void Perlin3DPeriodic(const float* x, const float* y, const float* z, int n, int px, int py, int pz, int octaves, float persistence, float* result)
+{
+	int start = 0;
+
+#if defined(__AVX2__)
+	for (; start + 8 <= n; start += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(&x[start]);
+		const __m256 vy = _mm256_loadu_ps(&y[start]);
+		const __m256 vz = _mm256_loadu_ps(&z[start]);
+
+		__m256 r = _mm256_setzero_ps();
+		float a = 1.0f;
+		int freq = 1;
+
+		for (int i=0; i < octaves; i++)
+		{
+			const __m256 f = _mm256_set1_ps(float(freq));
+
+			r = Perlin::MulAdd8(Perlin::PerlinNoise3DFunctionPeriodic8(_mm256_mul_ps(vx, f), _mm256_mul_ps(vy, f), _mm256_mul_ps(vz, f), px, py, pz), _mm256_set1_ps(a), r);
+
+			a *= persistence;
+			freq = 2 << i;
+		}
+
+		_mm256_storeu_ps(&result[start], r);
+	}
+#endif
+
+	for (int i=start; i < n; ++i)
+		result[i] = Perlin3DPeriodic(x[i], y[i], z[i], px, py, pz, octaves, persistence);
+}
+
+namespace
+{
+
+// evaluates grid rows in parallel, noise(x, y, z, n, result) fills one row
+template <typename Noise>
+void FillGrid(float x, float y, float z, float spacing, int dimx, int dimy, int dimz, float* result, Noise noise)
+{
+	ParallelFor(dimy*dimz, [&](int begin, int end)
+	{
+		std::vector<float> rowX(dimx), rowY(dimx), rowZ(dimx);
+
+		for (int i=0; i < dimx; ++i)
+			rowX[i] = x + float(i)*spacing;
+
+		for (int row=begin; row < end; ++row)
+		{
+			const int j = row%dimy;
+			const int k = row/dimy;
+
+			std::fill(rowY.begin(), rowY.end(), y + float(j)*spacing);
+			std::fill(rowZ.begin(), rowZ.end(), z + float(k)*spacing);
+
+			noise(&rowX[0], &rowY[0], &rowZ[0], dimx, &result[size_t(row)*dimx]);
+		}
+	}, std::max(1, 8192/std::max(dimx, 1)));
+}
+
+} // anonymous namespace
+
+void Perlin3DGrid(float x, float y, float z, float spacing, int dimx, int dimy, int dimz, int octaves, float persistence, float* result)
+{
+	FillGrid(x, y, z, spacing, dimx, dimy, dimz, result, [&](const float* px, const float* py, const float* pz, int n, float* r)
+	{
+		Perlin3D(px, py, pz, n, octaves, persistence, r);
+	});
+}
+
+void Perlin3DPeriodicGrid(float x, float y, float z, float spacing, int dimx, int dimy, int dimz, int px, int py, int pz, int octaves, float persistence, float* result)
+{
+	FillGrid(x, y, z, spacing, dimx, dimy, dimz, result, [&](const float* sx, const float* sy, const float* sz, int n, float* r)
+	{
+		Perlin3DPeriodic(sx, sy, sz, n, px, py, pz, octaves, persistence, r);
+	});
+}
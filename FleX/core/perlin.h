@@ -33,3 +33,14 @@ float Perlin3D(float x, float y, float z, int octaves, float persistence);
 
 // periodic versions of the same function, inspired by the Renderman pnoise() functions
 float Perlin3DPeriodic(float x, float y, float z, int px, int py, int pz, int octaves, float persistence);
+
+// batch versions evaluate n points given as separate coordinate arrays with AVX2, results match 
+// the single point versions to rounding, differences stay below 1e-4 with -ffast-math and FMA
+void Perlin1D(const float* x, int n, int octaves, float persistence, float* result);
+void Perlin2D(const float* x, const float* y, int n, int octaves, float persistence, float* result);
+void Perlin3D(const float* x, const float* y, const float* z, int n, int octaves, float persistence, float* result);
+void Perlin3DPeriodic(const float* x, const float* y, const float* z, int n, int px, int py, int pz, int octaves, float persistence, float* result);
+
+// fills a dimx*dimy*dimz grid in x fastest order, sampled at (x, y, z) + (i, j, k)*spacing, rows are evaluated in parallel
+void Perlin3DGrid(float x, float y, float z, float spacing, int dimx, int dimy, int dimz, int octaves, float persistence, float* result);
+void Perlin3DPeriodicGrid(float x, float y, float z, float spacing, int dimx, int dimy, int dimz, int px, int py, int pz, int octaves, float persistence, float* result);
@@ -0,0 +1,113 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "types.h"
+#include "parallel.h"
+
+#include <vector>
+
+// stable least significant digit radix sort of keys with an int payload, only the low keyBits bits 
+// of the keys are considered, digit histograms and scatters are computed in parallel per block
+inline void RadixSort(uint64_t* keys, int* values, int count, int keyBits)
+{
+	const int kDigitBits = 11;
+	const int kNumDigits = 1<<kDigitBits;
+
+	if (count <= 1 || keyBits <= 0)
+		return;
+
+	std::vector<uint64_t> tempKeys(count);
+	std::vector<int> tempValues(count);
+
+	const int numBlocks = std::min(GetParallelThreadCount(), (count + 65535)/65536);
+	const int blockSize = (count + numBlocks - 1)/numBlocks;
+
+	std::vector<int> offsets(numBlocks*kNumDigits);
+
+	uint64_t* srcKeys = keys;
+	int* srcValues = values;
+	uint64_t* dstKeys = &tempKeys[0];
+	int* dstValues = &tempValues[0];
+
+	for (int shift=0; shift < keyBits; shift += kDigitBits)
+	{
+		std::fill(offsets.begin(), offsets.end(), 0);
+
+		ParallelFor(numBlocks, [&](int begin, int end)
+		{
+			for (int b=begin; b < end; ++b)
+			{
+				int* histogram = &offsets[b*kNumDigits];
+
+				const int last = std::min(count, (b+1)*blockSize);
+				for (int i=b*blockSize; i < last; ++i)
+					histogram[(srcKeys[i]>>shift)&(kNumDigits-1)]++;
+			}
+		}, 1);
+
+		// exclusive scan in digit major order so each block scatters after the blocks before it
+		int sum = 0;
+		for (int d=0; d < kNumDigits; ++d)
+		{
+			for (int b=0; b < numBlocks; ++b)
+			{
+				const int c = offsets[b*kNumDigits + d];
+				offsets[b*kNumDigits + d] = sum;
+				sum += c;
+			}
+		}
+
+		ParallelFor(numBlocks, [&](int begin, int end)
+		{
+			for (int b=begin; b < end; ++b)
+			{
+				int* cursor = &offsets[b*kNumDigits];
+
+				const int last = std::min(count, (b+1)*blockSize);
+				for (int i=b*blockSize; i < last; ++i)
+				{
+					const int dst = cursor[(srcKeys[i]>>shift)&(kNumDigits-1)]++;
+
+					dstKeys[dst] = srcKeys[i];
+					dstValues[dst] = srcValues[i];
+				}
+			}
+		}, 1);
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+	}
+
+	// odd number of passes leaves the result in the temporary buffers
+	if (srcKeys != keys)
+	{
+		std::copy(srcKeys, srcKeys+count, keys);
+		std::copy(srcValues, srcValues+count, values);
+	}
+}
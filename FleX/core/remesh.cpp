@@ -0,0 +1,656 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "remesh.h"
+#include "mesh.h"
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	inline uint64_t EdgeKey(int a, int b)
+	{
+		return (uint64_t(min(a, b)) << 32) | uint32_t(max(a, b));
+	}
+
+	// boundary vertices where the outline turns by more than ~20 degrees are kept
+	const float kCornerTolerance = 0.35f;
+
+	struct HalfEdge
+	{
+		uint64_t key;
+		int from;
+		int to;
+		int tri;
+
+		bool operator < (const HalfEdge& rhs) const { return key < rhs.key; }
+	};
+
+	// an edge with the triangle containing the half edge from->to and, for interior edges, its twin
+	struct Edge
+	{
+		int from;
+		int to;
+		int tris[2];
+	};
+
+	class Remesher
+	{
+	public:
+
+		Remesher(const Mesh* mesh, float targetEdgeLength)
+		{
+			for (size_t i=0; i < mesh->m_positions.size(); ++i)
+				positions.push_back(Vec3(mesh->m_positions[i]));
+
+			indices.assign(mesh->m_indices.begin(), mesh->m_indices.end());
+
+			high = targetEdgeLength*4.0f/3.0f;
+			low = targetEdgeLength*4.0f/5.0f;
+
+			removed.assign(positions.size(), false);
+			boundary.assign(positions.size(), false);
+			corner.assign(positions.size(), false);
+
+			vector<Edge> edges;
+			vector<int> counts;
+			BuildEdges(edges, &counts);
+
+			// boundary vertices with exactly two boundary edges that continue in a nearly straight 
+			// line may be removed along the boundary, all other boundary vertices are corners
+			vector<int> boundaryEdges(positions.size(), 0);
+			vector<Vec3> directions(positions.size(), Vec3(0.0f));
+
+			for (size_t i=0; i < edges.size(); ++i)
+			{
+				const int a = edges[i].from;
+				const int b = edges[i].to;
+
+				if (counts[i] == 1)
+				{
+					boundary[a] = boundary[b] = true;
+
+					boundaryEdges[a]++;
+					boundaryEdges[b]++;
+
+					// boundary half edges run in a consistent direction around the hole
+					const Vec3 d = SafeNormalize(positions[b]-positions[a]);
+					directions[a] += d;
+					directions[b] -= d;
+				}
+				else if (counts[i] > 2)
+				{
+					boundary[a] = boundary[b] = true;
+					corner[a] = corner[b] = true;
+				}
+			}
+
+			for (size_t i=0; i < positions.size(); ++i)
+			{
+				// incoming minus outgoing direction vanishes on a straight boundary
+				if (boundary[i] && (boundaryEdges[i] != 2 || Length(directions[i]) > kCornerTolerance))
+					corner[i] = true;
+			}
+		}
+
+		void Run(int iterations)
+		{
+			for (int i=0; i < iterations; ++i)
+			{
+				// each pass only applies independent operations, repeat until there is nothing left to do
+				for (int pass=0; pass < 16 && SplitLongEdges(); ++pass) {}
+				for (int pass=0; pass < 16 && CollapseShortEdges(); ++pass) {}
+				for (int pass=0; pass < 4 && FlipEdges(); ++pass) {}
+
+				TangentialRelaxation();
+			}
+		}
+
+		Mesh* CreateMesh() const
+		{
+			Mesh* m = new Mesh();
+
+			vector<int> remap(positions.size(), -1);
+
+			for (size_t t=0; t < indices.size(); t+=3)
+			{
+				if (indices[t] == -1)
+					continue;
+
+				for (int v=0; v < 3; ++v)
+				{
+					int& index = remap[indices[t+v]];
+
+					if (index == -1)
+					{
+						index = int(m->m_positions.size());
+						m->m_positions.push_back(Point3(positions[indices[t+v]]));
+					}
+
+					m->m_indices.push_back(index);
+				}
+			}
+
+			m->CalculateNormals();
+
+			return m;
+		}
+
+	private:
+
+		Vec3 TriNormal(int a, int b, int c) const
+		{
+			return Cross(positions[b]-positions[a], positions[c]-positions[a]);
+		}
+
+		void BuildEdges(vector<Edge>& edges, vector<int>* counts=NULL) const
+		{
+			vector<HalfEdge> halfEdges;
+			halfEdges.reserve(indices.size());
+
+			for (int t=0; t < int(indices.size())/3; ++t)
+			{
+				if (indices[t*3] == -1)
+					continue;
+
+				for (int e=0; e < 3; ++e)
+				{
+					HalfEdge h;
+					h.from = indices[t*3 + e];
+					h.to = indices[t*3 + (e+1)%3];
+					h.tri = t;
+					h.key = EdgeKey(h.from, h.to);
+
+					halfEdges.push_back(h);
+				}
+			}
+
+			stable_sort(halfEdges.begin(), halfEdges.end());
+
+			edges.resize(0);
+			if (counts)
+				counts->resize(0);
+
+			for (size_t i=0; i < halfEdges.size(); )
+			{
+				size_t j = i+1;
+				while (j < halfEdges.size() && halfEdges[j].key == halfEdges[i].key)
+					++j;
+
+				Edge e;
+				e.from = halfEdges[i].from;
+				e.to = halfEdges[i].to;
+				e.tris[0] = halfEdges[i].tri;
+				e.tris[1] = (j-i == 2) ? halfEdges[i+1].tri : -1;
+
+				edges.push_back(e);
+
+				if (counts)
+					counts->push_back(int(j-i));
+
+				i = j;
+			}
+		}
+
+		// vertex to triangle adjacency
+		void BuildVertexTris()
+		{
+			vertexTriOffsets.assign(positions.size()+1, 0);
+
+			for (size_t t=0; t < indices.size(); t+=3)
+			{
+				if (indices[t] == -1)
+					continue;
+
+				for (int v=0; v < 3; ++v)
+					vertexTriOffsets[indices[t+v]+1]++;
+			}
+
+			for (size_t i=0; i < positions.size(); ++i)
+				vertexTriOffsets[i+1] += vertexTriOffsets[i];
+
+			vertexTris.resize(vertexTriOffsets.back());
+
+			vector<int> cursor(vertexTriOffsets.begin(), vertexTriOffsets.end()-1);
+
+			for (size_t t=0; t < indices.size(); t+=3)
+			{
+				if (indices[t] == -1)
+					continue;
+
+				for (int v=0; v < 3; ++v)
+					vertexTris[cursor[indices[t+v]]++] = int(t/3);
+			}
+		}
+
+		void GetNeighbors(int v, vector<int>& neighbors) const
+		{
+			neighbors.resize(0);
+
+			for (int i=vertexTriOffsets[v]; i < vertexTriOffsets[v+1]; ++i)
+			{
+				const int* tri = &indices[vertexTris[i]*3];
+
+				for (int k=0; k < 3; ++k)
+				{
+					if (tri[k] != v && find(neighbors.begin(), neighbors.end(), tri[k]) == neighbors.end())
+						neighbors.push_back(tri[k]);
+				}
+			}
+		}
+
+		void CountValences(const vector<Edge>& edges)
+		{
+			valence.assign(positions.size(), 0);
+
+			for (size_t i=0; i < edges.size(); ++i)
+			{
+				valence[edges[i].from]++;
+				valence[edges[i].to]++;
+			}
+		}
+
+		int TargetValence(int v) const { return boundary[v] ? 4 : 6; }
+
+		// splits triangle t's edge a-b at vertex m, preserving winding
+		void SplitTriangle(int t, int a, int b, int m)
+		{
+			int* tri = &indices[t*3];
+
+			int e = 0;
+			while (!((tri[e] == a && tri[(e+1)%3] == b) || (tri[e] == b && tri[(e+1)%3] == a)))
+				++e;
+
+			const int x0 = tri[e];
+			const int x1 = tri[(e+1)%3];
+			const int x2 = tri[(e+2)%3];
+
+			tri[0] = x0;
+			tri[1] = m;
+			tri[2] = x2;
+
+			indices.push_back(m);
+			indices.push_back(x1);
+			indices.push_back(x2);
+		}
+
+		bool SplitLongEdges()
+		{
+			vector<Edge> edges;
+			BuildEdges(edges);
+
+			// longest first, a triangle is split at most once per pass
+			vector<pair<float, int> > candidates;
+			for (size_t i=0; i < edges.size(); ++i)
+			{
+				const float length = Length(positions[edges[i].from]-positions[edges[i].to]);
+
+				if (length > high)
+					candidates.push_back(make_pair(-length, int(i)));
+			}
+
+			sort(candidates.begin(), candidates.end());
+
+			vector<bool> touched(indices.size()/3, false);
+			bool changed = false;
+
+			for (size_t c=0; c < candidates.size(); ++c)
+			{
+				const Edge& e = edges[candidates[c].second];
+
+				if (touched[e.tris[0]] || (e.tris[1] != -1 && touched[e.tris[1]]))
+					continue;
+
+				const int m = int(positions.size());
+				positions.push_back(0.5f*(positions[e.from]+positions[e.to]));
+				removed.push_back(false);
+
+				// midpoints of boundary edges stay on the boundary
+				boundary.push_back(e.tris[1] == -1);
+				corner.push_back(false);
+
+				for (int k=0; k < 2; ++k)
+				{
+					if (e.tris[k] != -1)
+					{
+						touched[e.tris[k]] = true;
+						SplitTriangle(e.tris[k], e.from, e.to, m);
+					}
+				}
+
+				changed = true;
+			}
+
+			return changed;
+		}
+
+		bool CollapseShortEdges()
+		{
+			vector<Edge> edges;
+			BuildEdges(edges);
+			BuildVertexTris();
+			CountValences(edges);
+
+			vector<pair<float, int> > candidates;
+			for (size_t i=0; i < edges.size(); ++i)
+			{
+				const float length = Length(positions[edges[i].from]-positions[edges[i].to]);
+
+				if (length < low)
+					candidates.push_back(make_pair(length, int(i)));
+			}
+
+			sort(candidates.begin(), candidates.end());
+
+			// vertices whose one ring has been modified this pass
+			vector<bool> touched(positions.size(), false);
+			vector<int> ringA, ringB;
+
+			bool changed = false;
+
+			for (size_t c=0; c < candidates.size(); ++c)
+			{
+				const Edge& e = edges[candidates[c].second];
+				const bool boundaryEdge = e.tris[1] == -1;
+
+				// vertex a is removed, interior vertices collapse along any edge, boundary 
+				// vertices only along the boundary and only where it is straight
+				int a = e.from;
+				int b = e.to;
+
+				if (boundaryEdge)
+				{
+					if (corner[a])
+						swap(a, b);
+
+					if (corner[a])
+						continue;
+				}
+				else
+				{
+					if (boundary[a])
+						swap(a, b);
+
+					if (boundary[a])
+						continue;
+				}
+
+				if (touched[a] || touched[b])
+					continue;
+
+				GetNeighbors(a, ringA);
+				GetNeighbors(b, ringB);
+
+				bool valid = true;
+
+				for (size_t i=0; i < ringA.size() && valid; ++i)
+					valid = !touched[ringA[i]];
+				for (size_t i=0; i < ringB.size() && valid; ++i)
+					valid = !touched[ringB[i]];
+
+				if (!valid)
+					continue;
+
+				// link condition, the only shared neighbors are the opposite vertices
+				int shared = 0;
+				for (size_t i=0; i < ringA.size(); ++i)
+				{
+					if (find(ringB.begin(), ringB.end(), ringA[i]) != ringB.end())
+					{
+						// the opposite vertices lose an edge
+						if (valence[ringA[i]] <= 3)
+							valid = false;
+
+						++shared;
+					}
+				}
+
+				if (!valid || shared != (boundaryEdge ? 1 : 2))
+					continue;
+
+				const Vec3 p = boundary[b] ? positions[b] : 0.5f*(positions[a]+positions[b]);
+
+				// no new long edges
+				for (size_t i=0; i < ringA.size() && valid; ++i)
+					valid = Length(p-positions[ringA[i]]) <= high;
+				for (size_t i=0; i < ringB.size() && valid && !boundary[b]; ++i)
+					valid = ringB[i] == a || Length(p-positions[ringB[i]]) <= high;
+
+				// no flipped or degenerate triangles
+				for (int v=0; v < 2 && valid; ++v)
+				{
+					const int x = v == 0 ? a : b;
+
+					for (int i=vertexTriOffsets[x]; i < vertexTriOffsets[x+1] && valid; ++i)
+					{
+						const int* tri = &indices[vertexTris[i]*3];
+
+						// the two triangles on the edge are removed
+						if ((tri[0] == a || tri[1] == a || tri[2] == a) && (tri[0] == b || tri[1] == b || tri[2] == b))
+							continue;
+
+						Vec3 before[3], after[3];
+						for (int k=0; k < 3; ++k)
+						{
+							before[k] = positions[tri[k]];
+							after[k] = (tri[k] == a || tri[k] == b) ? p : positions[tri[k]];
+						}
+
+						const Vec3 n0 = Cross(before[1]-before[0], before[2]-before[0]);
+						const Vec3 n1 = Cross(after[1]-after[0], after[2]-after[0]);
+
+						valid = Dot(n0, n1) > 0.25f*Length(n0)*Length(n1) && Length(n1) > 0.0f;
+					}
+				}
+
+				if (!valid)
+					continue;
+
+				// apply
+				for (int i=vertexTriOffsets[a]; i < vertexTriOffsets[a+1]; ++i)
+				{
+					int* tri = &indices[vertexTris[i]*3];
+
+					if (tri[0] == b || tri[1] == b || tri[2] == b)
+					{
+						tri[0] = tri[1] = tri[2] = -1;
+					}
+					else
+					{
+						for (int k=0; k < 3; ++k)
+							if (tri[k] == a)
+								tri[k] = b;
+					}
+				}
+
+				positions[b] = p;
+				removed[a] = true;
+
+				touched[a] = touched[b] = true;
+				for (size_t i=0; i < ringA.size(); ++i)
+					touched[ringA[i]] = true;
+				for (size_t i=0; i < ringB.size(); ++i)
+					touched[ringB[i]] = true;
+
+				changed = true;
+			}
+
+			return changed;
+		}
+
+		bool FlipEdges()
+		{
+			vector<Edge> edges;
+			BuildEdges(edges);
+			BuildVertexTris();
+			CountValences(edges);
+
+			vector<bool> touched(positions.size(), false);
+			vector<int> ring;
+
+			bool changed = false;
+
+			for (size_t i=0; i < edges.size(); ++i)
+			{
+				const Edge& e = edges[i];
+
+				if (e.tris[1] == -1)
+					continue;
+
+				const int a = e.from;
+				const int b = e.to;
+
+				// opposite vertices of (a, b, c) and (b, a, d)
+				int c = -1;
+				int d = -1;
+				for (int k=0; k < 3; ++k)
+				{
+					const int x = indices[e.tris[0]*3 + k];
+					const int y = indices[e.tris[1]*3 + k];
+
+					if (x != a && x != b)
+						c = x;
+					if (y != a && y != b)
+						d = y;
+				}
+
+				if (c == -1 || d == -1 || c == d || touched[a] || touched[b] || touched[c] || touched[d])
+					continue;
+
+				const int current[4] = { valence[a], valence[b], valence[c], valence[d] };
+				const int target[4] = { TargetValence(a), TargetValence(b), TargetValence(c), TargetValence(d) };
+
+				// keep at least a triangle fan around each vertex
+				if (current[0] <= 3 || current[1] <= 3)
+					continue;
+
+				int before = 0;
+				int after = 0;
+				for (int k=0; k < 4; ++k)
+				{
+					const int delta = k < 2 ? -1 : 1;
+
+					before += abs(current[k]-target[k]);
+					after += abs(current[k]+delta-target[k]);
+				}
+
+				if (after >= before)
+					continue;
+
+				// the new edge must not exist already
+				GetNeighbors(c, ring);
+				if (find(ring.begin(), ring.end(), d) != ring.end())
+					continue;
+
+				// only flip across nearly flat edges and never fold triangles over
+				const Vec3 n0 = SafeNormalize(TriNormal(a, b, c));
+				const Vec3 n1 = SafeNormalize(TriNormal(b, a, d));
+				const Vec3 m0 = TriNormal(a, d, c);
+				const Vec3 m1 = TriNormal(d, b, c);
+
+				if (Dot(n0, n1) < 0.7f || Dot(m0, n0+n1) <= 0.0f || Dot(m1, n0+n1) <= 0.0f)
+					continue;
+
+				int* t0 = &indices[e.tris[0]*3];
+				int* t1 = &indices[e.tris[1]*3];
+
+				t0[0] = a; t0[1] = d; t0[2] = c;
+				t1[0] = d; t1[1] = b; t1[2] = c;
+
+				touched[a] = touched[b] = touched[c] = touched[d] = true;
+				changed = true;
+			}
+
+			return changed;
+		}
+
+		void TangentialRelaxation()
+		{
+			BuildVertexTris();
+
+			vector<Vec3> relaxed(positions);
+			vector<int> ring;
+
+			for (int v=0; v < int(positions.size()); ++v)
+			{
+				if (removed[v] || boundary[v] || vertexTriOffsets[v] == vertexTriOffsets[v+1])
+					continue;
+
+				Vec3 normal(0.0f);
+				for (int i=vertexTriOffsets[v]; i < vertexTriOffsets[v+1]; ++i)
+				{
+					const int* tri = &indices[vertexTris[i]*3];
+					normal += TriNormal(tri[0], tri[1], tri[2]);
+				}
+
+				normal = SafeNormalize(normal);
+
+				GetNeighbors(v, ring);
+
+				Vec3 centroid(0.0f);
+				for (size_t i=0; i < ring.size(); ++i)
+					centroid += positions[ring[i]];
+
+				centroid /= float(ring.size());
+
+				// move towards the centroid in the tangent plane only
+				const Vec3 delta = centroid-positions[v];
+
+				relaxed[v] = positions[v] + 0.5f*(delta - normal*Dot(normal, delta));
+			}
+
+			positions.swap(relaxed);
+		}
+
+		vector<Vec3> positions;
+		vector<int> indices;	// removed triangles are marked with -1
+
+		vector<bool> removed;
+		vector<bool> boundary;
+		vector<bool> corner;
+
+		vector<int> valence;
+
+		vector<int> vertexTriOffsets;
+		vector<int> vertexTris;
+
+		float high;
+		float low;
+	};
+
+} // anonymous namespace
+
+Mesh* CreateIsotropicRemesh(const Mesh* mesh, float targetEdgeLength, int iterations)
+{
+	Remesher remesher(mesh, targetEdgeLength);
+	remesher.Run(iterations);
+
+	return remesher.CreateMesh();
+}
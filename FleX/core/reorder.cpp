@@ -0,0 +1,141 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "reorder.h"
+
+#include <vector>
+#include <algorithm>
+#include <float.h>
+
+using namespace std;
+
+namespace
+{
+	const int kKeyBits = 21;
+
+	// spreads the lower 21 bits of x so there are two zero bits between each one
+	inline uint64_t Part1By2(uint64_t x)
+	{
+		x &= 0x1fffff;
+		x = (x | (x << 32)) & 0x1f00000000ffffull;
+		x = (x | (x << 16)) & 0x1f0000ff0000ffull;
+		x = (x | (x <<  8)) & 0x100f00f00f00f00full;
+		x = (x | (x <<  4)) & 0x10c30c30c30c30c3ull;
+		x = (x | (x <<  2)) & 0x1249249249249249ull;
+
+		return x;
+	}
+
+} // anonymous namespace
+
+uint64_t MortonKey(uint32_t x, uint32_t y, uint32_t z)
+{
+	return (Part1By2(x) << 2) | (Part1By2(y) << 1) | Part1By2(z);
+}
+
+uint64_t HilbertKey(uint32_t x, uint32_t y, uint32_t z)
+{
+	// Skilling, "Programming the Hilbert curve", converts the coordinates to the 
+	// transposed Hilbert index which is then interleaved like a Morton key
+	uint32_t p[3] = { x, y, z };
+
+	const uint32_t m = 1 << (kKeyBits-1);
+
+	// inverse undo
+	for (uint32_t q=m; q > 1; q >>= 1)
+	{
+		const uint32_t mask = q-1;
+
+		for (int i=0; i < 3; ++i)
+		{
+			if (p[i] & q)
+			{
+				p[0] ^= mask;
+			}
+			else
+			{
+				const uint32_t t = (p[0] ^ p[i]) & mask;
+				p[0] ^= t;
+				p[i] ^= t;
+			}
+		}
+	}
+
+	// gray encode
+	p[1] ^= p[0];
+	p[2] ^= p[1];
+
+	uint32_t t = 0;
+	for (uint32_t q=m; q > 1; q >>= 1)
+	{
+		if (p[2] & q)
+			t ^= q-1;
+	}
+
+	p[0] ^= t;
+	p[1] ^= t;
+	p[2] ^= t;
+
+	return MortonKey(p[0], p[1], p[2]);
+}
+
+void CreateSpaceFillingCurveOrder(const Vec4* points, int numPoints, SpaceFillingCurve curve, int* order)
+{
+	Vec3 lower(FLT_MAX);
+	Vec3 upper(-FLT_MAX);
+
+	for (int i=0; i < numPoints; ++i)
+	{
+		lower = Min(lower, Vec3(points[i]));
+		upper = Max(upper, Vec3(points[i]));
+	}
+
+	// quantize over the largest edge so cells are cubic
+	const Vec3 edges = upper-lower;
+	const float maxEdge = max(edges.x, max(edges.y, edges.z));
+	const float scale = maxEdge > 0.0f ? ((1 << kKeyBits)-1)/maxEdge : 0.0f;
+
+	vector<pair<uint64_t, int> > keys(numPoints);
+
+	for (int i=0; i < numPoints; ++i)
+	{
+		const Vec3 p = (Vec3(points[i])-lower)*scale;
+
+		const uint32_t x = uint32_t(p.x);
+		const uint32_t y = uint32_t(p.y);
+		const uint32_t z = uint32_t(p.z);
+
+		keys[i].first = (curve == eHilbertCurve) ? HilbertKey(x, y, z) : MortonKey(x, y, z);
+		keys[i].second = i;
+	}
+
+	// ties are broken by original index
+	sort(keys.begin(), keys.end());
+
+	for (int i=0; i < numPoints; ++i)
+		order[i] = keys[i].second;
+}
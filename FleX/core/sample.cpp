@@ -0,0 +1,311 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "sample.h"
+#include "parallel.h"
+#include "radixsort.h"
+
+#include <algorithm>
+#include <float.h>
+
+using namespace std;
+
+namespace
+{
+	// columns of voxels scanned together by one task
+	const int kTileWidth = 8;
+
+	// cell coordinates are packed with 19 bits per axis below the phase
+	const int kCellBits = 19;
+
+	// stateless integer hash so candidates can be generated in any order
+	inline uint32_t HashIndex(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+
+		return x;
+	}
+
+	inline float HashUnit(uint32_t x)
+	{
+		return float(HashIndex(x) >> 8)*(1.0f/16777216.0f);
+	}
+}
+
+void SampleVoxels(const uint32_t* volume, int width, int height, int depth, Vec3 lower, float spacing, std::vector<Vec3>& samples)
+{
+	const int numTiles = (width + kTileWidth - 1)/kTileWidth;
+
+	vector<vector<Vec3> > tileSamples(numTiles);
+
+	ParallelFor(numTiles, [&](int begin, int end)
+	{
+		// one buffer per column so samples stay in x, y, z order while reading rows of the tile contiguously
+		vector<Vec3> columns[kTileWidth];
+
+		for (int t=begin; t < end; ++t)
+		{
+			const int x0 = t*kTileWidth;
+			const int x1 = min(x0 + kTileWidth, width);
+
+			for (int y=0; y < height; ++y)
+			{
+				for (int z=0; z < depth; ++z)
+				{
+					const uint32_t* row = &volume[z*width*height + y*width];
+
+					for (int x=x0; x < x1; ++x)
+					{
+						if (row[x])
+							columns[x-x0].push_back(lower + spacing*Vec3(float(x) + 0.5f, float(y) + 0.5f, float(z) + 0.5f));
+					}
+				}
+			}
+
+			for (int c=0; c < x1-x0; ++c)
+			{
+				tileSamples[t].insert(tileSamples[t].end(), columns[c].begin(), columns[c].end());
+				columns[c].resize(0);
+			}
+		}
+	}, 1);
+
+	size_t numSamples = samples.size();
+	for (int t=0; t < numTiles; ++t)
+		numSamples += tileSamples[t].size();
+
+	samples.reserve(numSamples);
+
+	for (int t=0; t < numTiles; ++t)
+		samples.insert(samples.end(), tileSamples[t].begin(), tileSamples[t].end());
+}
+
+void SampleSurface(const Vec3* vertices, const int* indices, int numTriangleIndices, int numCandidates, float minDistance, std::vector<Vec3>& samples)
+{
+	const int numTriangles = numTriangleIndices/3;
+
+	if (numTriangles == 0 || numCandidates <= 0)
+		return;
+
+	// cumulative triangle areas
+	vector<float> areas(numTriangles);
+	float totalArea = 0.0f;
+
+	for (int i=0; i < numTriangles; ++i)
+	{
+		const Vec3 a = vertices[indices[i*3+0]];
+		const Vec3 b = vertices[indices[i*3+1]];
+		const Vec3 c = vertices[indices[i*3+2]];
+
+		totalArea += 0.5f*Length(Cross(b-a, c-a));
+		areas[i] = totalArea;
+	}
+
+	if (totalArea <= 0.0f)
+		return;
+
+	// candidate i only depends on its index
+	vector<Vec3> candidates(numCandidates);
+
+	ParallelFor(numCandidates, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+		{
+			const float r = HashUnit(3*i+0)*totalArea;
+			const int t = min(int(upper_bound(areas.begin(), areas.end(), r) - areas.begin()), numTriangles-1);
+
+			// uniform barycentric coordinates
+			const float s = sqrtf(HashUnit(3*i+1));
+			const float u = 1.0f - s;
+			const float v = HashUnit(3*i+2)*s;
+			const float w = 1.0f - u - v;
+
+			candidates[i] = vertices[indices[t*3+0]]*u + vertices[indices[t*3+1]]*v + vertices[indices[t*3+2]]*w;
+		}
+	});
+
+	if (minDistance <= 0.0f)
+	{
+		samples.insert(samples.end(), candidates.begin(), candidates.end());
+		return;
+	}
+
+	Vec3 lower(FLT_MAX);
+	Vec3 upper(-FLT_MAX);
+
+	for (int i=0; i < numCandidates; ++i)
+	{
+		lower = Min(lower, candidates[i]);
+		upper = Max(upper, candidates[i]);
+	}
+
+	// cells must be at least minDistance wide so every conflict lies in a neighboring cell
+	const Vec3 edges = upper - lower;
+	const float cellSize = max(minDistance, max(max(edges.x, edges.y), edges.z)/float((1<<kCellBits)-1));
+	const float invCellSize = 1.0f/cellSize;
+
+	// sort candidates by phase, then cell, then index, cells whose coordinates are equal modulo 3 are 
+	// in the same phase and never neighbor each other so they can be resolved concurrently
+	vector<uint64_t> keys(numCandidates);
+	vector<int> order(numCandidates);
+
+	ParallelFor(numCandidates, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+		{
+			const Vec3 c = (candidates[i]-lower)*invCellSize;
+
+			const uint64_t x = min(int(c.x), (1<<kCellBits)-1);
+			const uint64_t y = min(int(c.y), (1<<kCellBits)-1);
+			const uint64_t z = min(int(c.z), (1<<kCellBits)-1);
+
+			const uint64_t phase = (x%3)*9 + (y%3)*3 + z%3;
+
+			keys[i] = (phase<<(3*kCellBits)) | (x<<(2*kCellBits)) | (y<<kCellBits) | z;
+			order[i] = i;
+		}
+	});
+
+	RadixSort(&keys[0], &order[0], numCandidates, 3*kCellBits + 5);
+
+	// start of each cell's run, runs of a phase are contiguous
+	vector<int> cellStarts;
+	vector<int> phaseStarts(28, 0);
+
+	for (int i=0; i < numCandidates; ++i)
+	{
+		if (i == 0 || keys[i] != keys[i-1])
+		{
+			cellStarts.push_back(i);
+			phaseStarts[int(keys[i]>>(3*kCellBits)) + 1] = int(cellStarts.size());
+		}
+	}
+	cellStarts.push_back(numCandidates);
+
+	for (int p=1; p < 28; ++p)
+		phaseStarts[p] = max(phaseStarts[p], phaseStarts[p-1]);
+
+	const int numCells = int(cellStarts.size()) - 1;
+	const uint64_t kCellMask = (uint64_t(1)<<kCellBits) - 1;
+	const uint64_t kCoordMask = (uint64_t(1)<<(3*kCellBits)) - 1;
+
+	// cells sorted by coordinate for neighbor lookups
+	vector<uint64_t> cellKeys(numCells);
+	vector<int> cellOrder(numCells);
+
+	for (int c=0; c < numCells; ++c)
+	{
+		cellKeys[c] = keys[cellStarts[c]]&kCoordMask;
+		cellOrder[c] = c;
+	}
+
+	RadixSort(&cellKeys[0], &cellOrder[0], numCells, 3*kCellBits);
+
+	// accepted candidates of a cell are packed at the start of its run in order
+	vector<int> acceptedCounts(numCells, 0);
+	vector<int> acceptedIndices(numCandidates);
+
+	// bytes rather than vector<bool> so flags can be written from different threads
+	vector<uint8_t> accepted(numCandidates, 0);
+
+	const float minDistanceSq = minDistance*minDistance;
+
+	for (int p=0; p < 27; ++p)
+	{
+		const int firstCell = phaseStarts[p];
+
+		// neighbors of a cell are always in other phases, so they are either final or still empty
+		ParallelFor(phaseStarts[p+1] - firstCell, [&](int begin, int end)
+		{
+			for (int c=firstCell + begin; c < firstCell + end; ++c)
+			{
+				const uint64_t key = keys[cellStarts[c]];
+
+				const int x = int((key>>(2*kCellBits))&kCellMask);
+				const int y = int((key>>kCellBits)&kCellMask);
+				const int z = int(key&kCellMask);
+
+				int neighbors[27];
+				int numNeighbors = 0;
+
+				for (int i=max(x-1, 0); i <= min(x+1, int(kCellMask)); ++i)
+				{
+					for (int j=max(y-1, 0); j <= min(y+1, int(kCellMask)); ++j)
+					{
+						for (int k=max(z-1, 0); k <= min(z+1, int(kCellMask)); ++k)
+						{
+							const uint64_t neighborKey = (uint64_t(i)<<(2*kCellBits)) | (uint64_t(j)<<kCellBits) | uint64_t(k);
+							const int n = int(lower_bound(cellKeys.begin(), cellKeys.end(), neighborKey) - cellKeys.begin());
+
+							if (n < numCells && cellKeys[n] == neighborKey)
+								neighbors[numNeighbors++] = cellOrder[n];
+						}
+					}
+				}
+
+				// candidates within a cell are resolved serially in index order
+				for (int r=cellStarts[c]; r < cellStarts[c+1]; ++r)
+				{
+					const int i = order[r];
+					const Vec3 position = candidates[i];
+
+					bool conflict = false;
+
+					for (int n=0; n < numNeighbors && !conflict; ++n)
+					{
+						const int* cellAccepted = &acceptedIndices[cellStarts[neighbors[n]]];
+
+						for (int a=0; a < acceptedCounts[neighbors[n]]; ++a)
+						{
+							if (LengthSq(candidates[cellAccepted[a]] - position) < minDistanceSq)
+							{
+								conflict = true;
+								break;
+							}
+						}
+					}
+
+					if (!conflict)
+					{
+						acceptedIndices[cellStarts[c] + acceptedCounts[c]++] = i;
+						accepted[i] = 1;
+					}
+				}
+			}
+		}, 64);
+	}
+
+	for (int i=0; i < numCandidates; ++i)
+	{
+		if (accepted[i])
+			samples.push_back(candidates[i]);
+	}
+}
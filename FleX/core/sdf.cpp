@@ -31,6 +31,10 @@
 #include <float.h>
 #include <math.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 namespace
@@ -99,7 +103,7 @@ namespace
 	}
 }
 
-// 2D fast marching method (FMM J. Sethian. A fast marching level set method for monotonically advancing fronts. Proc. Natl. Acad. Sci., 93:15911595, 1996.)
+// 2D fast marching method (FMM J. Sethian. A fast marching level set method for monotonically advancing fronts. Proc. Natl. Acad. Sci., 93:1591�1595, 1996.)
 namespace 
 {
 	struct Coord2D
@@ -185,7 +189,7 @@ void MakeSDF(const uint32_t* img, uint32_t w, uint32_t h, float* output)
 	}
 }
 
-// 3D fast marching method (FMM J. Sethian. A fast marching level set method for monotonically advancing fronts. Proc. Natl. Acad. Sci., 93:15911595, 1996.)
+// 3D fast marching method (FMM J. Sethian. A fast marching level set method for monotonically advancing fronts. Proc. Natl. Acad. Sci., 93:1591�1595, 1996.)
 namespace 
 {
 	struct Coord3D
@@ -291,6 +295,226 @@ void MakeSDF(const uint32_t* img, uint32_t w, uint32_t h, uint32_t d, float* out
 }
 
 
+float SampleSDF(const float* sdf, int dim, int x, int y, int z)
+{
+	assert(x < dim && x >= 0);
+	assert(y < dim && y >= 0);
+	assert(z < dim && z >= 0);
+
+	return sdf[z*dim*dim + y*dim + x];
+}
+
+// return normal of signed distance field
+Vec3 SampleSDFGrad(const float* sdf, int dim, int x, int y, int z)
+{
+	int x0 = max(x-1, 0);
+	int x1 = min(x+1, dim-1);
+
+	int y0 = max(y-1, 0);
+	int y1 = min(y+1, dim-1);
+
+	int z0 = max(z-1, 0);
+	int z1 = min(z+1, dim-1);
+
+	float dx = (SampleSDF(sdf, dim, x1, y, z) - SampleSDF(sdf, dim, x0, y, z))*(dim*0.5f);
+	float dy = (SampleSDF(sdf, dim, x, y1, z) - SampleSDF(sdf, dim, x, y0, z))*(dim*0.5f);
+	float dz = (SampleSDF(sdf, dim, x, y, z1) - SampleSDF(sdf, dim, x, y, z0))*(dim*0.5f);
+
+	return Vec3(dx, dy, dz);
+}
+
+namespace
+{
+	// find the cell containing a clamped voxel coordinate and the fractional position inside it
+	inline int CellCoord(float c, int dim, float& t)
+	{
+		c = min(max(c, 0.0f), float(dim-1));
+
+		int i = min(int(c), dim-2);
+		t = c - float(i);
+
+		return i;
+	}
+
+	inline float SampleTrilinear(const float* sdf, int w, int h, int d, float cx, float cy, float cz, Vec3* grad)
+	{
+		float tx, ty, tz;
+		const int i = CellCoord(cx, w, tx);
+		const int j = CellCoord(cy, h, ty);
+		const int k = CellCoord(cz, d, tz);
+
+		const int sx = 1;
+		const int sy = w;
+		const int sz = w*h;
+
+		const float* p = sdf + k*sz + j*sy + i;
+
+		const float c000 = p[0];
+		const float c100 = p[sx];
+		const float c010 = p[sy];
+		const float c110 = p[sy+sx];
+		const float c001 = p[sz];
+		const float c101 = p[sz+sx];
+		const float c011 = p[sz+sy];
+		const float c111 = p[sz+sy+sx];
+
+		// interpolate along x
+		const float c00 = c000 + (c100-c000)*tx;
+		const float c10 = c010 + (c110-c010)*tx;
+		const float c01 = c001 + (c101-c001)*tx;
+		const float c11 = c011 + (c111-c011)*tx;
+
+		// interpolate along y
+		const float c0 = c00 + (c10-c00)*ty;
+		const float c1 = c01 + (c11-c01)*ty;
+
+		if (grad)
+		{
+			// derivative of the trilinear basis along each axis
+			const float ex0 = (c100-c000) + ((c110-c010)-(c100-c000))*ty;
+			const float ex1 = (c101-c001) + ((c111-c011)-(c101-c001))*ty;
+
+			grad->x = ex0 + (ex1-ex0)*tz;
+			grad->y = (c10-c00) + ((c11-c01)-(c10-c00))*tz;
+			grad->z = c1-c0;
+		}
+
+		return c0 + (c1-c0)*tz;
+	}
+}
+
+float SampleSDFTrilinear(const float* sdf, uint32_t w, uint32_t h, uint32_t d, Vec3 p, Vec3* grad)
+{
+	assert(w > 1 && h > 1 && d > 1);
+
+	return SampleTrilinear(sdf, w, h, d, p.x, p.y, p.z, grad);
+}
+
+#if defined(__AVX2__)
+
+namespace
+{
+	// clamp a vector of voxel coordinates and split it into integer cell and fractional part
+	inline __m256i CellCoord8(__m256 c, int dim, __m256& t)
+	{
+		c = _mm256_min_ps(_mm256_max_ps(c, _mm256_setzero_ps()), _mm256_set1_ps(float(dim-1)));
+
+		__m256i i = _mm256_min_epi32(_mm256_cvttps_epi32(c), _mm256_set1_epi32(dim-2));
+		t = _mm256_sub_ps(c, _mm256_cvtepi32_ps(i));
+
+		return i;
+	}
+
+	inline __m256 Lerp8(__m256 a, __m256 b, __m256 t)
+	{
+		// fused when the target has FMA, -mavx2 alone does not imply it
+#if defined(__FMA__)
+		return _mm256_fmadd_ps(_mm256_sub_ps(b, a), t, a);
+#else
+		return _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(b, a), t), a);
+#endif
+	}
+}
+
+#endif
+
+void SampleSDFTrilinear(const float* sdf, uint32_t w, uint32_t h, uint32_t d, Vec3 lower, float invSpacing, const Vec3* points, int numPoints, float* outDist, Vec3* outGrad)
+{
+	assert(w > 1 && h > 1 && d > 1);
+
+	int start = 0;
+
+#if defined(__AVX2__)
+
+	const __m256i strideIndices = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+	const __m256 lx = _mm256_set1_ps(lower.x);
+	const __m256 ly = _mm256_set1_ps(lower.y);
+	const __m256 lz = _mm256_set1_ps(lower.z);
+	const __m256 scale = _mm256_set1_ps(invSpacing);
+
+	const __m256i sy = _mm256_set1_epi32(w);
+	const __m256i sz = _mm256_set1_epi32(w*h);
+
+	for (; start + 8 <= numPoints; start += 8)
+	{
+		const float* src = (const float*)(points + start);
+
+		// de-interleave 8 AoS points and map them to voxel coordinates
+		__m256 cx = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(src + 0, strideIndices, 4), lx), scale);
+		__m256 cy = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(src + 1, strideIndices, 4), ly), scale);
+		__m256 cz = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(src + 2, strideIndices, 4), lz), scale);
+
+		__m256 tx, ty, tz;
+		__m256i i = CellCoord8(cx, w, tx);
+		__m256i j = CellCoord8(cy, h, ty);
+		__m256i k = CellCoord8(cz, d, tz);
+
+		__m256i base = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(k, sz), _mm256_mullo_epi32(j, sy)), i);
+
+		// gather the 8 cell corners for each lane
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i b010 = _mm256_add_epi32(base, sy);
+		const __m256i b001 = _mm256_add_epi32(base, sz);
+		const __m256i b011 = _mm256_add_epi32(b001, sy);
+
+		const __m256 c000 = _mm256_i32gather_ps(sdf, base, 4);
+		const __m256 c100 = _mm256_i32gather_ps(sdf, _mm256_add_epi32(base, one), 4);
+		const __m256 c010 = _mm256_i32gather_ps(sdf, b010, 4);
+		const __m256 c110 = _mm256_i32gather_ps(sdf, _mm256_add_epi32(b010, one), 4);
+		const __m256 c001 = _mm256_i32gather_ps(sdf, b001, 4);
+		const __m256 c101 = _mm256_i32gather_ps(sdf, _mm256_add_epi32(b001, one), 4);
+		const __m256 c011 = _mm256_i32gather_ps(sdf, b011, 4);
+		const __m256 c111 = _mm256_i32gather_ps(sdf, _mm256_add_epi32(b011, one), 4);
+
+		const __m256 c00 = Lerp8(c000, c100, tx);
+		const __m256 c10 = Lerp8(c010, c110, tx);
+		const __m256 c01 = Lerp8(c001, c101, tx);
+		const __m256 c11 = Lerp8(c011, c111, tx);
+
+		const __m256 c0 = Lerp8(c00, c10, ty);
+		const __m256 c1 = Lerp8(c01, c11, ty);
+
+		if (outDist)
+			_mm256_storeu_ps(outDist + start, Lerp8(c0, c1, tz));
+
+		if (outGrad)
+		{
+			const __m256 ex0 = Lerp8(_mm256_sub_ps(c100, c000), _mm256_sub_ps(c110, c010), ty);
+			const __m256 ex1 = Lerp8(_mm256_sub_ps(c101, c001), _mm256_sub_ps(c111, c011), ty);
+
+			const __m256 gx = _mm256_mul_ps(Lerp8(ex0, ex1, tz), scale);
+			const __m256 gy = _mm256_mul_ps(Lerp8(_mm256_sub_ps(c10, c00), _mm256_sub_ps(c11, c01), tz), scale);
+			const __m256 gz = _mm256_mul_ps(_mm256_sub_ps(c1, c0), scale);
+
+			// no scatter in AVX2 so interleave back through the stack
+			float x[8], y[8], z[8];
+			_mm256_storeu_ps(x, gx);
+			_mm256_storeu_ps(y, gy);
+			_mm256_storeu_ps(z, gz);
+
+			for (int l=0; l < 8; ++l)
+				outGrad[start + l] = Vec3(x[l], y[l], z[l]);
+		}
+	}
+
+#endif
+
+	// scalar path handles the remainder (or everything on non-AVX2 builds)
+	for (int p=start; p < numPoints; ++p)
+	{
+		const Vec3 c = (points[p]-lower)*invSpacing;
+
+		Vec3 grad;
+		const float dist = SampleTrilinear(sdf, w, h, d, c.x, c.y, c.z, outGrad?&grad:NULL);
+
+		if (outDist)
+			outDist[p] = dist;
+
+		if (outGrad)
+			outGrad[p] = grad*invSpacing;
+	}
+}
 
 
 /*
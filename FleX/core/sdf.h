@@ -35,3 +35,19 @@
 // distance is scaled by 1 / max(dimension)
 void MakeSDF(const uint32_t* input, uint32_t width, uint32_t height, float* output);
 void MakeSDF(const uint32_t* input, uint32_t width, uint32_t height, uint32_t depth, float* output);
+
+// nearest cell sampling of a dim^3 field output by MakeSDF(), the gradient is a central difference 
+// scaled to the normalized distance units of MakeSDF()
+float SampleSDF(const float* sdf, int dim, int x, int y, int z);
+Vec3 SampleSDFGrad(const float* sdf, int dim, int x, int y, int z);
+
+// trilinearly interpolated distance and analytic gradient at a continuous position given in voxel
+// coordinates (voxel centers at integer coordinates), positions outside the field are clamped to its 
+// boundary, all dimensions must be >= 2, grad may be NULL
+float SampleSDFTrilinear(const float* sdf, uint32_t width, uint32_t height, uint32_t depth, Vec3 p, Vec3* grad=NULL);
+
+// batched version of the above for arrays of points, each point is mapped to voxel coordinates as 
+// (p-lower)*invSpacing, where lower is the position of the first voxel center, and gradients are 
+// returned with respect to the input space, uses AVX2 gathers when compiled with AVX2 enabled, 
+// outDist or outGrad may be NULL
+void SampleSDFTrilinear(const float* sdf, uint32_t width, uint32_t height, uint32_t depth, Vec3 lower, float invSpacing, const Vec3* points, int numPoints, float* outDist, Vec3* outGrad);
@@ -0,0 +1,221 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "skinning.h"
+#include "parallel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+void CreateMeshSkinning(const Vec3* restPositions, const int* skinIndices, const float* skinWeights, const int* rigidMeshSizes, int numRigids, int numVertices, const uint32_t* triIndices, int numTriIndices, MeshSkinning& skinning)
+{
+	int numSkinned = 0;
+	for (int r=0; r < numRigids; ++r)
+		numSkinned += rigidMeshSizes[r];
+
+	numSkinned = min(numSkinned, numVertices);
+
+	skinning.numSkinnedVertices = numSkinned;
+
+	skinning.restX.resize(numSkinned);
+	skinning.restY.resize(numSkinned);
+	skinning.restZ.resize(numSkinned);
+	skinning.rigids.resize(numSkinned);
+
+	for (int w=0; w < 4; ++w)
+	{
+		skinning.indices[w].resize(numSkinned);
+		skinning.weights[w].resize(numSkinned);
+	}
+
+	for (int r=0, startVertex=0; r < numRigids; ++r)
+	{
+		const int endVertex = min(startVertex + rigidMeshSizes[r], numSkinned);
+
+		for (int i=startVertex; i < endVertex; ++i)
+		{
+			skinning.restX[i] = restPositions[i].x;
+			skinning.restY[i] = restPositions[i].y;
+			skinning.restZ[i] = restPositions[i].z;
+			skinning.rigids[i] = r;
+
+			for (int w=0; w < 4; ++w)
+			{
+				// small shapes can have < 4 particles
+				const bool used = skinIndices[i*4+w] > -1;
+
+				skinning.indices[w][i] = used?skinIndices[i*4+w]:0;
+				skinning.weights[w][i] = used?skinWeights[i*4+w]:0.0f;
+			}
+		}
+
+		startVertex = endVertex;
+	}
+
+	// vertex to triangle adjacency, triangles are visited in order so each list is sorted
+	const int numTris = numTriIndices/3;
+
+	skinning.vertexTriStarts.assign(numVertices+1, 0);
+	skinning.vertexTris.resize(numTriIndices);
+
+	for (int i=0; i < numTriIndices; ++i)
+		skinning.vertexTriStarts[triIndices[i]+1]++;
+
+	for (int i=0; i < numVertices; ++i)
+		skinning.vertexTriStarts[i+1] += skinning.vertexTriStarts[i];
+
+	vector<int> offsets(skinning.vertexTriStarts.begin(), skinning.vertexTriStarts.end()-1);
+
+	for (int t=0; t < numTris; ++t)
+	{
+		for (int c=0; c < 3; ++c)
+			skinning.vertexTris[offsets[triIndices[t*3+c]]++] = t;
+	}
+}
+
+namespace
+{
+	inline Vec3 SkinVertex(const MeshSkinning& skinning, const Matrix33* rigidRotations, const Vec4* particles, const Vec4* particleRestPositions, int i)
+	{
+		const Matrix33& rotation = rigidRotations[skinning.rigids[i]];
+		const Vec3 rest(skinning.restX[i], skinning.restY[i], skinning.restZ[i]);
+
+		Vec3 skinPos;
+
+		for (int w=0; w < 4; ++w)
+		{
+			const int index = skinning.indices[w][i];
+			skinPos += (rotation*(rest - Vec3(particleRestPositions[index])) + Vec3(particles[index]))*skinning.weights[w][i];
+		}
+
+		return skinPos;
+	}
+}
+
+void ApplyMeshSkinning(MeshSkinning& skinning, const Matrix33* rigidRotations, const Vec4* particles, const Vec4* particleRestPositions, const uint32_t* triIndices, Vec3* positions, Vec3* normals)
+{
+	const int numSkinned = skinning.numSkinnedVertices;
+
+	ParallelFor(numSkinned, [&](int begin, int end)
+	{
+		int i = begin;
+
+#if defined(__AVX2__)
+
+		const float* rotations = (const float*)rigidRotations;
+		const float* current = (const float*)particles;
+		const float* rest = (const float*)particleRestPositions;
+
+		for (; i + 8 <= end; i += 8)
+		{
+			// gather the columns of each lane's rigid rotation
+			const __m256i rigid = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&skinning.rigids[i]), _mm256_set1_epi32(9));
+
+			__m256 m[9];
+			for (int k=0; k < 9; ++k)
+				m[k] = _mm256_i32gather_ps(rotations + k, rigid, 4);
+
+			const __m256 rx = _mm256_loadu_ps(&skinning.restX[i]);
+			const __m256 ry = _mm256_loadu_ps(&skinning.restY[i]);
+			const __m256 rz = _mm256_loadu_ps(&skinning.restZ[i]);
+
+			__m256 px = _mm256_setzero_ps();
+			__m256 py = _mm256_setzero_ps();
+			__m256 pz = _mm256_setzero_ps();
+
+			for (int w=0; w < 4; ++w)
+			{
+				const __m256i index = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)&skinning.indices[w][i]), 2);
+				const __m256 weight = _mm256_loadu_ps(&skinning.weights[w][i]);
+
+				// offset from the particle's rest position
+				const __m256 dx = _mm256_sub_ps(rx, _mm256_i32gather_ps(rest + 0, index, 4));
+				const __m256 dy = _mm256_sub_ps(ry, _mm256_i32gather_ps(rest + 1, index, 4));
+				const __m256 dz = _mm256_sub_ps(rz, _mm256_i32gather_ps(rest + 2, index, 4));
+
+				// rotate and translate to the particle's current position
+				const __m256 sx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0], dx), _mm256_mul_ps(m[3], dy)), _mm256_mul_ps(m[6], dz)), _mm256_i32gather_ps(current + 0, index, 4));
+				const __m256 sy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[1], dx), _mm256_mul_ps(m[4], dy)), _mm256_mul_ps(m[7], dz)), _mm256_i32gather_ps(current + 1, index, 4));
+				const __m256 sz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[2], dx), _mm256_mul_ps(m[5], dy)), _mm256_mul_ps(m[8], dz)), _mm256_i32gather_ps(current + 2, index, 4));
+
+				px = _mm256_add_ps(px, _mm256_mul_ps(sx, weight));
+				py = _mm256_add_ps(py, _mm256_mul_ps(sy, weight));
+				pz = _mm256_add_ps(pz, _mm256_mul_ps(sz, weight));
+			}
+
+			// interleave back to AoS
+			float x[8], y[8], z[8];
+			_mm256_storeu_ps(x, px);
+			_mm256_storeu_ps(y, py);
+			_mm256_storeu_ps(z, pz);
+
+			for (int k=0; k < 8; ++k)
+				positions[i+k] = Vec3(x[k], y[k], z[k]);
+		}
+
+#endif
+
+		for (; i < end; ++i)
+			positions[i] = SkinVertex(skinning, rigidRotations, particles, particleRestPositions, i);
+	});
+
+	const int numTris = int(skinning.vertexTris.size())/3;
+
+	skinning.triNormals.resize(numTris);
+
+	ParallelFor(numTris, [&](int begin, int end)
+	{
+		for (int t=begin; t < end; ++t)
+		{
+			const uint32_t a = triIndices[t*3+0];
+			const uint32_t b = triIndices[t*3+1];
+			const uint32_t c = triIndices[t*3+2];
+
+			skinning.triNormals[t] = Cross(positions[b]-positions[a], positions[c]-positions[a]);
+		}
+	});
+
+	// each vertex gathers its own triangles' normals in triangle order, which avoids scattering 
+	// between threads and gives the same sums as a serial pass over the triangles
+	const int numVertices = int(skinning.vertexTriStarts.size()) - 1;
+
+	ParallelFor(numVertices, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+		{
+			Vec3 n;
+
+			for (int j=skinning.vertexTriStarts[i]; j < skinning.vertexTriStarts[i+1]; ++j)
+				n += skinning.triNormals[skinning.vertexTris[j]];
+
+			normals[i] = Normalize(n);
+		}
+	});
+}
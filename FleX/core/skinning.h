@@ -0,0 +1,68 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// linear blend skinning of a render mesh to rigid particle clusters, stored as structure of arrays 
+// so vertices can be transformed in SIMD blocks
+struct MeshSkinning
+{
+	MeshSkinning() : numSkinnedVertices(0) {}
+
+	int numSkinnedVertices;
+
+	// rest positions of the skinned vertices
+	std::vector<float> restX;
+	std::vector<float> restY;
+	std::vector<float> restZ;
+
+	// one stream per influence, unused influences point at particle 0 with zero weight
+	std::vector<int> indices[4];
+	std::vector<float> weights[4];
+
+	// rigid whose rotation drives each skinned vertex
+	std::vector<int> rigids;
+
+	// triangles adjacent to each mesh vertex in increasing order
+	std::vector<int> vertexTriStarts;
+	std::vector<int> vertexTris;
+
+	// per frame triangle normals
+	std::vector<Vec3> triNormals;
+};
+
+// builds skinning for the first vertices of a mesh, rigid r drives the next rigidMeshSizes[r] vertices, 
+// skinIndices and skinWeights hold 4 influences per vertex with negative indices marking unused slots
+void CreateMeshSkinning(const Vec3* restPositions, const int* skinIndices, const float* skinWeights, const int* rigidMeshSizes, int numRigids, int numVertices, const uint32_t* triIndices, int numTriIndices, MeshSkinning& skinning);
+
+// skins vertices to the particles of their rigid in parallel blocks, then recomputes the normals of 
+// all mesh vertices by gathering the adjacent triangle normals, matching Mesh::CalculateNormals()
+void ApplyMeshSkinning(MeshSkinning& skinning, const Matrix33* rigidRotations, const Vec4* particles, const Vec4* particleRestPositions, const uint32_t* triIndices, Vec3* positions, Vec3* normals);
@@ -0,0 +1,631 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "springs.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <float.h>
+#include <atomic>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+
+// colors smaller than this per thread are not worth a barrier
+const int kMinSpringsPerThread = 2048;
+
+// threads wait here until all of them have arrived
+class SpinBarrier
+{
+public:
+
+	explicit SpinBarrier(int count) : mCount(count), mWaiting(0), mGeneration(0) {}
+
+	void Wait()
+	{
+		const int generation = mGeneration.load();
+
+		if (mWaiting.fetch_add(1) == mCount-1)
+		{
+			mWaiting.store(0);
+			mGeneration.fetch_add(1);
+		}
+		else
+		{
+			while (mGeneration.load() == generation)
+				this_thread::yield();
+		}
+	}
+
+private:
+
+	const int mCount;
+
+	atomic<int> mWaiting;
+	atomic<int> mGeneration;
+};
+
+inline void ProjectSpring(int a, int b, float restLength, float stiffness, Vec4* positions)
+{
+	Vec4& pa = positions[a];
+	Vec4& pb = positions[b];
+
+	const float dx = pa.x-pb.x;
+	const float dy = pa.y-pb.y;
+	const float dz = pa.z-pb.z;
+
+	const float length = sqrtf(dx*dx + dy*dy + dz*dz);
+	const float error = length-restLength;
+	const float invMassSum = pa.w + pb.w;
+
+	// tethers are slack when shorter than their rest length
+	if (invMassSum == 0.0f || length == 0.0f || (stiffness < 0.0f && error < 0.0f))
+		return;
+
+	const float s = (fabsf(stiffness)*error)/(invMassSum*length);
+
+	// static particles may be shared by springs of a color, so they are never written
+	if (pa.w != 0.0f)
+	{
+		pa.x -= dx*s*pa.w;
+		pa.y -= dy*s*pa.w;
+		pa.z -= dz*s*pa.w;
+	}
+
+	if (pb.w != 0.0f)
+	{
+		pb.x += dx*s*pb.w;
+		pb.y += dy*s*pb.w;
+		pb.z += dz*s*pb.w;
+	}
+}
+
+// runs func(thread, numThreads, barrier) on up to maxThreads pool threads at once, each call on its own thread so all of them reach the barrier
+template <typename Func>
+void ParallelRegion(int maxThreads, Func func)
+{
+	ThreadPool& pool = GetParallelPool();
+
+	const int numThreads = pool.GetConcurrency(maxThreads);
+
+	SpinBarrier barrier(numThreads);
+
+	pool.RunOnThreads(numThreads, [&](int thread)
+	{
+		func(thread, numThreads, barrier);
+	});
+}
+
+// start of the part of [0, count) processed by a thread
+inline int Slice(int count, int thread, int numThreads)
+{
+	return int(int64_t(count)*thread/numThreads);
+}
+
+// springs [begin, end) of a color, no two share a dynamic particle so lanes can be written back in any order
+void ProjectSpringRange(const SpringColoring& coloring, int begin, int end, Vec4* positions)
+{
+	int start = begin;
+
+#if defined(__AVX2__)
+
+	const float* base = (const float*)positions;
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	for (; start + 8 <= end; start += 8)
+	{
+		// particle indices scaled to float offsets of the Vec4 positions
+		const __m256i ia = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)&coloring.a[start]), 2);
+		const __m256i ib = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)&coloring.b[start]), 2);
+
+		const __m256 xa = _mm256_i32gather_ps(base + 0, ia, 4);
+		const __m256 ya = _mm256_i32gather_ps(base + 1, ia, 4);
+		const __m256 za = _mm256_i32gather_ps(base + 2, ia, 4);
+		const __m256 wa = _mm256_i32gather_ps(base + 3, ia, 4);
+
+		const __m256 xb = _mm256_i32gather_ps(base + 0, ib, 4);
+		const __m256 yb = _mm256_i32gather_ps(base + 1, ib, 4);
+		const __m256 zb = _mm256_i32gather_ps(base + 2, ib, 4);
+		const __m256 wb = _mm256_i32gather_ps(base + 3, ib, 4);
+
+		const __m256 dx = _mm256_sub_ps(xa, xb);
+		const __m256 dy = _mm256_sub_ps(ya, yb);
+		const __m256 dz = _mm256_sub_ps(za, zb);
+
+		const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+		const __m256 error = _mm256_sub_ps(length, _mm256_loadu_ps(&coloring.restLengths[start]));
+		const __m256 invMassSum = _mm256_add_ps(wa, wb);
+
+		const __m256 stiffness = _mm256_loadu_ps(&coloring.stiffness[start]);
+		const __m256 slack = _mm256_and_ps(_mm256_cmp_ps(stiffness, zero, _CMP_LT_OQ), _mm256_cmp_ps(error, zero, _CMP_LT_OQ));
+
+		const __m256 active = _mm256_andnot_ps(slack, _mm256_and_ps(_mm256_cmp_ps(invMassSum, zero, _CMP_NEQ_OQ), _mm256_cmp_ps(length, zero, _CMP_NEQ_OQ)));
+
+		if (_mm256_movemask_ps(active) == 0)
+			continue;
+
+		// inactive lanes may divide by zero, the mask clears them
+		const __m256 s = _mm256_and_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, stiffness), error), _mm256_mul_ps(invMassSum, length)), active);
+
+		const __m256 sa = _mm256_mul_ps(s, wa);
+		const __m256 sb = _mm256_mul_ps(s, wb);
+
+		float out[6][8];
+
+		_mm256_storeu_ps(out[0], _mm256_sub_ps(xa, _mm256_mul_ps(dx, sa)));
+		_mm256_storeu_ps(out[1], _mm256_sub_ps(ya, _mm256_mul_ps(dy, sa)));
+		_mm256_storeu_ps(out[2], _mm256_sub_ps(za, _mm256_mul_ps(dz, sa)));
+		_mm256_storeu_ps(out[3], _mm256_add_ps(xb, _mm256_mul_ps(dx, sb)));
+		_mm256_storeu_ps(out[4], _mm256_add_ps(yb, _mm256_mul_ps(dy, sb)));
+		_mm256_storeu_ps(out[5], _mm256_add_ps(zb, _mm256_mul_ps(dz, sb)));
+
+		float invMassA[8], invMassB[8];
+
+		_mm256_storeu_ps(invMassA, wa);
+		_mm256_storeu_ps(invMassB, wb);
+
+		// no scatter in AVX2, static particles can be shared by lanes and threads so they are skipped
+		for (int l=0; l < 8; ++l)
+		{
+			if (invMassA[l] != 0.0f)
+			{
+				Vec4& pa = positions[coloring.a[start+l]];
+
+				pa.x = out[0][l];
+				pa.y = out[1][l];
+				pa.z = out[2][l];
+			}
+
+			if (invMassB[l] != 0.0f)
+			{
+				Vec4& pb = positions[coloring.b[start+l]];
+
+				pb.x = out[3][l];
+				pb.y = out[4][l];
+				pb.z = out[5][l];
+			}
+		}
+	}
+
+#endif
+
+	for (int i=start; i < end; ++i)
+		ProjectSpring(coloring.a[i], coloring.b[i], coloring.restLengths[i], coloring.stiffness[i], positions);
+}
+
+// corrections of springs [begin, end) from the current positions, before weighting by inverse mass
+void ComputeSpringDeltas(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int begin, int end, const Vec4* positions)
+{
+	int start = begin;
+
+#if defined(__AVX2__)
+
+	const float* base = (const float*)positions;
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	// offsets of the first particle of 8 consecutive index pairs
+	const __m256i pairs = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+
+	for (; start + 8 <= end; start += 8)
+	{
+		const __m256i ia = _mm256_slli_epi32(_mm256_i32gather_epi32(&indices[start*2+0], pairs, 4), 2);
+		const __m256i ib = _mm256_slli_epi32(_mm256_i32gather_epi32(&indices[start*2+1], pairs, 4), 2);
+
+		const __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(base + 0, ia, 4), _mm256_i32gather_ps(base + 0, ib, 4));
+		const __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(base + 1, ia, 4), _mm256_i32gather_ps(base + 1, ib, 4));
+		const __m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(base + 2, ia, 4), _mm256_i32gather_ps(base + 2, ib, 4));
+
+		const __m256 invMassSum = _mm256_add_ps(_mm256_i32gather_ps(base + 3, ia, 4), _mm256_i32gather_ps(base + 3, ib, 4));
+
+		const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+		const __m256 error = _mm256_sub_ps(length, _mm256_loadu_ps(&restLengths[start]));
+
+		const __m256 k = _mm256_loadu_ps(&stiffness[start]);
+		const __m256 slack = _mm256_and_ps(_mm256_cmp_ps(k, zero, _CMP_LT_OQ), _mm256_cmp_ps(error, zero, _CMP_LT_OQ));
+
+		const __m256 active = _mm256_andnot_ps(slack, _mm256_and_ps(_mm256_cmp_ps(invMassSum, zero, _CMP_NEQ_OQ), _mm256_cmp_ps(length, zero, _CMP_NEQ_OQ)));
+
+		// inactive lanes may divide by zero, the mask clears them
+		const __m256 s = _mm256_and_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, k), error), _mm256_mul_ps(invMassSum, length)), active);
+
+		_mm256_storeu_ps(&solver.deltaX[start], _mm256_mul_ps(dx, s));
+		_mm256_storeu_ps(&solver.deltaY[start], _mm256_mul_ps(dy, s));
+		_mm256_storeu_ps(&solver.deltaZ[start], _mm256_mul_ps(dz, s));
+	}
+
+#endif
+
+	for (int i=start; i < end; ++i)
+	{
+		const Vec4& pa = positions[indices[i*2+0]];
+		const Vec4& pb = positions[indices[i*2+1]];
+
+		const float dx = pa.x-pb.x;
+		const float dy = pa.y-pb.y;
+		const float dz = pa.z-pb.z;
+
+		const float length = sqrtf(dx*dx + dy*dy + dz*dz);
+		const float error = length-restLengths[i];
+		const float invMassSum = pa.w + pb.w;
+
+		float s = 0.0f;
+
+		if (invMassSum != 0.0f && length != 0.0f && !(stiffness[i] < 0.0f && error < 0.0f))
+			s = (fabsf(stiffness[i])*error)/(invMassSum*length);
+
+		solver.deltaX[i] = dx*s;
+		solver.deltaY[i] = dy*s;
+		solver.deltaZ[i] = dz*s;
+	}
+}
+
+// accelerated Jacobi iterations, squared update sizes are accumulated into updates[iter] when it is not NULL
+void JacobiIterations(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int numSprings, Vec4* positions, int iterations, float spectralRadius, double* updates)
+{
+	const int numParticles = int(solver.particleStarts.size())-1;
+
+	assert(int(solver.particleSprings.size()) == numSprings*2);
+
+	solver.deltaX.resize(numSprings);
+	solver.deltaY.resize(numSprings);
+	solver.deltaZ.resize(numSprings);
+	solver.previous.resize(numParticles);
+
+	const int maxThreads = Min(GetParallelThreadCount(), Max(1, numSprings/kMinSpringsPerThread));
+	const float rhoSq = spectralRadius*spectralRadius;
+
+	vector<double> partials(updates ? iterations*maxThreads : 0, 0.0);
+
+	// springs and particles are split between threads, every pass reads results of the previous one so threads meet at a barrier in between
+	ParallelRegion(maxThreads, [&](int thread, int numThreads, SpinBarrier& barrier)
+	{
+		const int particleBegin = Slice(numParticles, thread, numThreads);
+		const int particleEnd = Slice(numParticles, thread+1, numThreads);
+
+		// the first accelerated step extrapolates from the starting positions when there is no delay
+		for (int p=particleBegin; p < particleEnd; ++p)
+			solver.previous[p] = positions[p];
+
+		float omega = 1.0f;
+
+		for (int iter=0; iter < iterations; ++iter)
+		{
+			ComputeSpringDeltas(solver, indices, restLengths, stiffness, Slice(numSprings, thread, numThreads), Slice(numSprings, thread+1, numThreads), positions);
+
+			barrier.Wait();
+
+			// Chebyshev recurrence, plain Jacobi while omega is one
+			if (spectralRadius > 0.0f && iter >= solver.delay)
+				omega = (iter == solver.delay) ? 2.0f/(2.0f-rhoSq) : 4.0f/(4.0f-rhoSq*omega);
+
+			double update = 0.0;
+
+			for (int p=particleBegin; p < particleEnd; ++p)
+			{
+				Vec3 delta(0.0f);
+
+				for (int j=solver.particleStarts[p]; j < solver.particleStarts[p+1]; ++j)
+				{
+					const int spring = solver.particleSprings[j]>>1;
+					const Vec3 d(solver.deltaX[spring], solver.deltaY[spring], solver.deltaZ[spring]);
+
+					// the first particle moves against the spring direction
+					if (solver.particleSprings[j]&1)
+						delta += d;
+					else
+						delta -= d;
+				}
+
+				const Vec4 x = positions[p];
+				const Vec3 y = Vec3(x) + delta*(solver.relaxation*solver.invCounts[p]*x.w);
+				const Vec3 prev = Vec3(solver.previous[p]);
+
+				const Vec3 next = (omega == 1.0f) ? y : prev + (y-prev)*omega;
+
+				solver.previous[p] = x;
+				positions[p] = Vec4(next, x.w);
+
+				update += LengthSq(next-Vec3(x));
+			}
+
+			if (updates)
+				partials[iter*maxThreads + thread] = update;
+
+			barrier.Wait();
+		}
+	});
+
+	for (int iter=0; updates && iter < iterations; ++iter)
+		for (int t=0; t < maxThreads; ++t)
+			updates[iter] += partials[iter*maxThreads + t];
+}
+
+} // anonymous namespace
+
+void CreateSpringColoring(const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* particles, int numParticles, SpringColoring& coloring)
+{
+	// particle to spring adjacency
+	vector<int> particleStarts(numParticles+1, 0);
+
+	for (int i=0; i < numSprings*2; ++i)
+		particleStarts[indices[i]+1]++;
+
+	for (int p=0; p < numParticles; ++p)
+		particleStarts[p+1] += particleStarts[p];
+
+	vector<int> particleSprings(numSprings*2);
+	vector<int> offsets(particleStarts.begin(), particleStarts.end()-1);
+
+	for (int i=0; i < numSprings*2; ++i)
+		particleSprings[offsets[indices[i]]++] = i/2;
+
+	vector<int> colors(numSprings, -1);
+	vector<int> colorCounts;
+	vector<int> lastUse;
+
+	for (int s=0; s < numSprings; ++s)
+	{
+		// mark colors taken by already colored springs sharing a particle, static particles are never 
+		// written so springs to a shared anchor do not conflict
+		for (int i=0; i < 2; ++i)
+		{
+			const int p = indices[s*2+i];
+
+			if (particles[p].w == 0.0f)
+				continue;
+
+			for (int j=particleStarts[p]; j < particleStarts[p+1]; ++j)
+			{
+				const int color = colors[particleSprings[j]];
+
+				if (color >= 0)
+					lastUse[color] = s;
+			}
+		}
+
+		int color = 0;
+		while (color < int(colorCounts.size()) && lastUse[color] == s)
+			++color;
+
+		if (color == int(colorCounts.size()))
+		{
+			colorCounts.push_back(0);
+			lastUse.push_back(-1);
+		}
+
+		colors[s] = color;
+		colorCounts[color]++;
+	}
+
+	const int numColors = int(colorCounts.size());
+
+	// largest colors first, they have the most parallel work
+	vector<int> colorOrder(numColors);
+	for (int c=0; c < numColors; ++c)
+		colorOrder[c] = c;
+
+	stable_sort(colorOrder.begin(), colorOrder.end(), [&](int x, int y) { return colorCounts[x] > colorCounts[y]; });
+
+	vector<int> colorRank(numColors);
+	for (int c=0; c < numColors; ++c)
+		colorRank[colorOrder[c]] = c;
+
+	coloring.colorStarts.assign(numColors+1, 0);
+	for (int c=0; c < numColors; ++c)
+		coloring.colorStarts[c+1] = coloring.colorStarts[c] + colorCounts[colorOrder[c]];
+
+	offsets.assign(coloring.colorStarts.begin(), coloring.colorStarts.end()-1);
+	coloring.springs.resize(numSprings);
+
+	for (int s=0; s < numSprings; ++s)
+		coloring.springs[offsets[colorRank[colors[s]]]++] = s;
+
+	// springs of a color in order of the particles they touch
+	for (int c=0; c < numColors; ++c)
+	{
+		sort(coloring.springs.begin() + coloring.colorStarts[c], coloring.springs.begin() + coloring.colorStarts[c+1], [&](int x, int y)
+		{
+			const int lx = Min(indices[x*2], indices[x*2+1]);
+			const int ly = Min(indices[y*2], indices[y*2+1]);
+
+			return lx < ly || (lx == ly && x < y);
+		});
+	}
+
+	coloring.a.resize(numSprings);
+	coloring.b.resize(numSprings);
+	coloring.restLengths.resize(numSprings);
+	coloring.stiffness.resize(numSprings);
+
+	for (int i=0; i < numSprings; ++i)
+	{
+		const int s = coloring.springs[i];
+
+		coloring.a[i] = indices[s*2+0];
+		coloring.b[i] = indices[s*2+1];
+		coloring.restLengths[i] = restLengths[s];
+		coloring.stiffness[i] = stiffness[s];
+	}
+}
+
+void ProjectSprings(const SpringColoring& coloring, Vec4* positions, int iterations)
+{
+	const int numColors = int(coloring.colorStarts.size())-1;
+
+	if (numColors <= 0)
+		return;
+
+	// colors are sorted by size so the first is the largest
+	const int largest = coloring.colorStarts[1]-coloring.colorStarts[0];
+	const int maxThreads = Min(GetParallelThreadCount(), Max(1, largest/kMinSpringsPerThread));
+
+	// threads split every color and meet at the barrier before the next
+	ParallelRegion(maxThreads, [&](int thread, int numThreads, SpinBarrier& barrier)
+	{
+		for (int iter=0; iter < iterations; ++iter)
+		{
+			for (int c=0; c < numColors; ++c)
+			{
+				const int start = coloring.colorStarts[c];
+				const int count = coloring.colorStarts[c+1]-start;
+
+				ProjectSpringRange(coloring, start + Slice(count, thread, numThreads), start + Slice(count, thread+1, numThreads), positions);
+
+				barrier.Wait();
+			}
+		}
+	});
+}
+
+void ProjectSpringsSerial(const int* indices, const float* restLengths, const float* stiffness, int numSprings, Vec4* positions, int iterations)
+{
+	for (int iter=0; iter < iterations; ++iter)
+		for (int s=0; s < numSprings; ++s)
+			ProjectSpring(indices[s*2+0], indices[s*2+1], restLengths[s], stiffness[s], positions);
+}
+
+float ComputeSpringError(const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* positions)
+{
+	double sum = 0.0;
+	int count = 0;
+
+	for (int s=0; s < numSprings; ++s)
+	{
+		const Vec4& pa = positions[indices[s*2+0]];
+		const Vec4& pb = positions[indices[s*2+1]];
+
+		if (pa.w + pb.w == 0.0f)
+			continue;
+
+		float error = Length(Vec3(pa)-Vec3(pb)) - restLengths[s];
+
+		if (stiffness[s] < 0.0f && error < 0.0f)
+			error = 0.0f;
+
+		sum += double(error)*error;
+		count++;
+	}
+
+	return count ? float(sqrt(sum/count)) : 0.0f;
+}
+
+void CreateJacobiSpringSolver(const int* indices, int numSprings, int numParticles, JacobiSpringSolver& solver)
+{
+	solver.particleStarts.assign(numParticles+1, 0);
+
+	for (int i=0; i < numSprings*2; ++i)
+		solver.particleStarts[indices[i]+1]++;
+
+	solver.invCounts.resize(numParticles);
+
+	for (int p=0; p < numParticles; ++p)
+	{
+		const int count = solver.particleStarts[p+1];
+
+		solver.invCounts[p] = count ? 1.0f/count : 0.0f;
+		solver.particleStarts[p+1] += solver.particleStarts[p];
+	}
+
+	solver.particleSprings.resize(numSprings*2);
+
+	vector<int> offsets(solver.particleStarts.begin(), solver.particleStarts.end()-1);
+
+	for (int i=0; i < numSprings*2; ++i)
+		solver.particleSprings[offsets[indices[i]]++] = i;
+}
+
+void ProjectSpringsJacobi(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int numSprings, Vec4* positions, int iterations)
+{
+	JacobiIterations(solver, indices, restLengths, stiffness, numSprings, positions, iterations, solver.spectralRadius, NULL);
+}
+
+float EstimateSpringSpectralRadius(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* positions, int iterations)
+{
+	if (iterations < 4)
+		return 0.0f;
+
+	vector<Vec4> scratch(positions, positions + solver.particleStarts.size()-1);
+	vector<double> updates(iterations, 0.0);
+
+	JacobiIterations(solver, indices, restLengths, stiffness, numSprings, &scratch[0], iterations, 0.0f, &updates[0]);
+
+	// updates shrink by the spectral radius per iteration once the slowest mode dominates, so skip the first half
+	const int first = iterations/2;
+	const int last = iterations-1;
+
+	if (updates[first] <= 0.0 || updates[last] <= 0.0)
+		return 0.0f;
+
+	const double rho = pow(updates[last]/updates[first], 0.5/(last-first));
+
+	return Clamp(float(rho), 0.0f, 0.999f);
+}
+
+float TuneSpringSpectralRadius(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* positions, int iterations)
+{
+	const int numParticles = int(solver.particleStarts.size())-1;
+
+	const float estimate = EstimateSpringSpectralRadius(solver, indices, restLengths, stiffness, numSprings, positions, Max(iterations, 16));
+
+	// the estimate from a short run is usually low, so also try values closer to one, and no acceleration in case it diverges
+	const float candidates[] = { 0.0f, estimate, 1.0f-(1.0f-estimate)*0.5f, 1.0f-(1.0f-estimate)*0.25f, 1.0f-(1.0f-estimate)*0.125f, 1.0f-(1.0f-estimate)*0.0625f };
+
+	vector<Vec4> scratch(numParticles);
+
+	float bestRadius = 0.0f;
+	float bestError = FLT_MAX;
+
+	for (int c=0; c < int(sizeof(candidates)/sizeof(candidates[0])); ++c)
+	{
+		scratch.assign(positions, positions + numParticles);
+
+		JacobiIterations(solver, indices, restLengths, stiffness, numSprings, &scratch[0], iterations, candidates[c], NULL);
+
+		const float error = ComputeSpringError(indices, restLengths, stiffness, numSprings, &scratch[0]);
+
+		if (error < bestError)
+		{
+			bestError = error;
+			bestRadius = candidates[c];
+		}
+	}
+
+	solver.spectralRadius = bestRadius;
+
+	return bestRadius;
+}
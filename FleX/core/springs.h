@@ -0,0 +1,105 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// distance constraints grouped so that no two springs of a color share a dynamic particle, each color 
+// can then be projected in parallel and a sweep over the colors is a Gauss-Seidel iteration, 
+// spring data is copied into color order as one array per attribute so it can be read 8 at a 
+// time with AVX2
+struct SpringColoring
+{
+	std::vector<int> springs;		// original spring indices ordered by color
+	std::vector<int> colorStarts;	// offsets of each color in springs, numColors+1 entries
+
+	// spring data in color order
+	std::vector<int> a;
+	std::vector<int> b;
+	std::vector<float> restLengths;
+	std::vector<float> stiffness;
+};
+
+// greedy coloring in spring order, each spring takes the lowest color unused by the springs of its 
+// particles, within a color springs are sorted by their particles so consecutive springs touch 
+// nearby memory, and colors are ordered from largest to smallest, particles with zero inverse mass 
+// in particles are never moved so they may be shared within a color, the coloring must be rebuilt 
+// when a particle is pinned
+void CreateSpringColoring(const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* particles, int numParticles, SpringColoring& coloring);
+
+// runs iterations Gauss-Seidel sweeps over the colored springs, springs move their particles in 
+// proportion to inverse mass, springs with negative stiffness are tethers that only resist stretching
+void ProjectSprings(const SpringColoring& coloring, Vec4* positions, int iterations);
+
+// serial Gauss-Seidel sweeps in spring index order
+void ProjectSpringsSerial(const int* indices, const float* restLengths, const float* stiffness, int numSprings, Vec4* positions, int iterations);
+
+// root mean square length error of the springs between particles that can move, slack tethers have no error
+float ComputeSpringError(const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* positions);
+
+// Jacobi spring projection with Chebyshev semi-iterative acceleration, every spring computes its 
+// correction from the same positions and each particle averages the corrections of its springs, 
+// after a delay the iterates are extrapolated as x = omega*(y - xprev) + xprev with omega from 
+// the Chebyshev recurrence for the given spectral radius
+struct JacobiSpringSolver
+{
+	// particle to spring adjacency, entries are spring*2 + end
+	std::vector<int> particleStarts;
+	std::vector<int> particleSprings;
+	std::vector<float> invCounts;
+
+	// per spring corrections, one array per axis so they can be written 8 at a time with AVX2
+	std::vector<float> deltaX;
+	std::vector<float> deltaY;
+	std::vector<float> deltaZ;
+
+	// positions of the previous iteration
+	std::vector<Vec4> previous;
+
+	float spectralRadius;	// estimate of the Jacobi spectral radius in [0, 1), 0 runs plain Jacobi
+	float relaxation;		// scale of the averaged corrections
+	int delay;				// plain Jacobi iterations before the acceleration starts
+
+	JacobiSpringSolver() : spectralRadius(0.0f), relaxation(1.0f), delay(8) {}
+};
+
+// builds the adjacency for indices, spring arrays use the SimBuffers layout so springIndices, springLengths and 
+// springStiffness can be passed directly, arrays passed to the other calls must have the same topology
+void CreateJacobiSpringSolver(const int* indices, int numSprings, int numParticles, JacobiSpringSolver& solver);
+
+// runs iterations of accelerated Jacobi projection on positions, same spring conventions as ProjectSprings()
+void ProjectSpringsJacobi(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int numSprings, Vec4* positions, int iterations);
+
+// estimates the spectral radius from the decay of the update size over iterations of plain Jacobi on a copy of positions
+float EstimateSpringSpectralRadius(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* positions, int iterations);
+
+// starts from the estimate and keeps the spectral radius with the lowest error after iterations of 
+// accelerated projection on a copy of positions, the result is stored in the solver and returned
+float TuneSpringSpectralRadius(JacobiSpringSolver& solver, const int* indices, const float* restLengths, const float* stiffness, int numSprings, const Vec4* positions, int iterations);
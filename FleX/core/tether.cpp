@@ -0,0 +1,448 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "tether.h"
+#include "parallel.h"
+
+#include <queue>
+#include <algorithm>
+#include <float.h>
+
+using namespace std;
+
+namespace
+{
+	// compressed adjacency of the constraint graph
+	struct Graph
+	{
+		vector<int> offsets;
+		vector<int> neighbors;
+		vector<float> lengths;
+	};
+
+	void BuildGraph(const Vec4* particles, int numParticles, const int* edges, int numEdges, Graph& graph)
+	{
+		graph.offsets.assign(numParticles+1, 0);
+
+		for (int i=0; i < numEdges; ++i)
+		{
+			graph.offsets[edges[i*2+0]+1]++;
+			graph.offsets[edges[i*2+1]+1]++;
+		}
+
+		for (int i=0; i < numParticles; ++i)
+			graph.offsets[i+1] += graph.offsets[i];
+
+		graph.neighbors.resize(graph.offsets.back());
+		graph.lengths.resize(graph.offsets.back());
+
+		vector<int> cursor(graph.offsets.begin(), graph.offsets.end()-1);
+
+		for (int i=0; i < numEdges; ++i)
+		{
+			const int a = edges[i*2+0];
+			const int b = edges[i*2+1];
+
+			const float length = Length(Vec3(particles[a])-Vec3(particles[b]));
+
+			graph.neighbors[cursor[a]] = b;
+			graph.lengths[cursor[a]++] = length;
+
+			graph.neighbors[cursor[b]] = a;
+			graph.lengths[cursor[b]++] = length;
+		}
+	}
+
+	struct Label
+	{
+		Label() {}
+		Label(float d, int n, int s) : distance(d), node(n), source(s) {}
+
+		float distance;
+		int node;
+		int source;
+
+		// min-heap ordering for std::priority_queue
+		bool operator < (const Label& rhs) const { return distance > rhs.distance; }
+	};
+
+	// labels (a source index and distance each) all anchor groups may hold at once, 16M labels 
+	// is 128MB, a single group is always allowed
+	const size_t kMaxGroupLabels = size_t(1) << 24;
+
+	// the k nearest sources of every node, stored in k consecutive slots sorted by distance
+	struct NearestSources
+	{
+		void Init(int numNodes, int k)
+		{
+			maxSources = k;
+			counts.assign(numNodes, 0);
+			sources.resize(numNodes*k);
+			distances.resize(numNodes*k);
+		}
+
+		bool Contains(int node, int source) const
+		{
+			for (int i=0; i < counts[node]; ++i)
+				if (sources[node*maxSources + i] == source)
+					return true;
+
+			return false;
+		}
+
+		bool Full(int node) const { return counts[node] == maxSources; }
+
+		int maxSources;
+
+		vector<int> counts;
+		vector<int> sources;
+		vector<float> distances;
+	};
+
+	// multi-source Dijkstra where each node settles once per source up to k sources, labels are
+	// popped in order of distance so the first k distinct sources to reach a node are its nearest
+	void FindNearestSources(const Graph& graph, const int* sources, int numSources, NearestSources& result)
+	{
+		priority_queue<Label> queue;
+
+		for (int i=0; i < numSources; ++i)
+			queue.push(Label(0.0f, sources[i], sources[i]));
+
+		while (!queue.empty())
+		{
+			const Label label = queue.top();
+			queue.pop();
+
+			const int node = label.node;
+
+			if (result.Full(node) || result.Contains(node, label.source))
+				continue;
+
+			const int slot = node*result.maxSources + result.counts[node]++;
+			result.sources[slot] = label.source;
+			result.distances[slot] = label.distance;
+
+			for (int e=graph.offsets[node]; e < graph.offsets[node+1]; ++e)
+			{
+				const int neighbor = graph.neighbors[e];
+
+				if (!result.Full(neighbor) && !result.Contains(neighbor, label.source))
+					queue.push(Label(label.distance + graph.lengths[e], neighbor, label.source));
+			}
+		}
+	}
+
+	// kd-tree over anchor positions, anchors are stored permuted so each node covers a contiguous range
+	struct KdTree
+	{
+		struct Node
+		{
+			Vec3 lower;
+			Vec3 upper;
+
+			int begin;
+			int end;
+			int children;	// index of the left child, the right child follows it, -1 for leaves
+		};
+
+		void Build(const Vec4* particles, const vector<int>& anchors)
+		{
+			indices = anchors;
+			points.resize(anchors.size());
+
+			for (size_t i=0; i < anchors.size(); ++i)
+				points[i] = Vec3(particles[anchors[i]]);
+
+			nodes.resize(0);
+			nodes.reserve(2*anchors.size()/kLeafSize + 1);
+
+			Node root = { Vec3(0.0f), Vec3(0.0f), 0, int(anchors.size()), -1 };
+			nodes.push_back(root);
+
+			Split(0);
+		}
+
+		void Split(int n)
+		{
+			const int begin = nodes[n].begin;
+			const int end = nodes[n].end;
+
+			Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+			for (int i=begin; i < end; ++i)
+			{
+				lower = Min(lower, points[i]);
+				upper = Max(upper, points[i]);
+			}
+
+			nodes[n].lower = lower;
+			nodes[n].upper = upper;
+
+			if (end - begin <= kLeafSize)
+				return;
+
+			// split the widest axis at the median
+			const Vec3 edges = upper-lower;
+			const int axis = (edges.x > edges.y) ? (edges.x > edges.z ? 0 : 2) : (edges.y > edges.z ? 1 : 2);
+			const int mid = (begin + end)/2;
+
+			vector<int> order(end-begin);
+			for (int i=0; i < end-begin; ++i)
+				order[i] = begin + i;
+
+			nth_element(order.begin(), order.begin() + (mid-begin), order.end(), [&](int a, int b) { return points[a][axis] < points[b][axis]; });
+
+			vector<Vec3> sortedPoints(end-begin);
+			vector<int> sortedIndices(end-begin);
+			for (int i=0; i < end-begin; ++i)
+			{
+				sortedPoints[i] = points[order[i]];
+				sortedIndices[i] = indices[order[i]];
+			}
+
+			copy(sortedPoints.begin(), sortedPoints.end(), points.begin() + begin);
+			copy(sortedIndices.begin(), sortedIndices.end(), indices.begin() + begin);
+
+			const int children = int(nodes.size());
+
+			nodes[n].children = children;
+
+			Node left = { Vec3(0.0f), Vec3(0.0f), begin, mid, -1 };
+			Node right = { Vec3(0.0f), Vec3(0.0f), mid, end, -1 };
+
+			nodes.push_back(left);
+			nodes.push_back(right);
+
+			Split(children);
+			Split(children+1);
+		}
+
+		// the k nearest anchors to p ordered by squared distance then anchor index, 
+		// which matches a brute force scan over anchors in increasing index order
+		void Query(const Vec3& p, int k, vector<pair<float, int> >& nearest) const
+		{
+			nearest.resize(0);
+
+			if (nodes.size())
+				Query(0, p, k, nearest);
+		}
+
+		// squared distance from p to the bounds of a node, a lower bound on the distance to its anchors
+		float DistanceSq(int n, const Vec3& p) const
+		{
+			return LengthSq(p - Max(nodes[n].lower, Min(nodes[n].upper, p)));
+		}
+
+		void Query(int n, const Vec3& p, int k, vector<pair<float, int> >& nearest) const
+		{
+			const Node& node = nodes[n];
+
+			if (node.children == -1)
+			{
+				for (int i=node.begin; i < node.end; ++i)
+				{
+					const pair<float, int> candidate(LengthSq(p-points[i]), indices[i]);
+
+					if (int(nearest.size()) < k)
+						nearest.insert(upper_bound(nearest.begin(), nearest.end(), candidate), candidate);
+					else if (candidate < nearest.back())
+					{
+						nearest.pop_back();
+						nearest.insert(upper_bound(nearest.begin(), nearest.end(), candidate), candidate);
+					}
+				}
+
+				return;
+			}
+
+			int nearChild = node.children;
+			int farChild = node.children+1;
+
+			float nearDistance = DistanceSq(nearChild, p);
+			float farDistance = DistanceSq(farChild, p);
+
+			if (farDistance < nearDistance)
+			{
+				swap(nearChild, farChild);
+				swap(nearDistance, farDistance);
+			}
+
+			// children at an equal distance may still hold anchors that win on index
+			if (int(nearest.size()) < k || nearDistance <= nearest.back().first)
+				Query(nearChild, p, k, nearest);
+
+			if (int(nearest.size()) < k || farDistance <= nearest.back().first)
+				Query(farChild, p, k, nearest);
+		}
+
+		static const int kLeafSize = 8;
+
+		vector<Node> nodes;
+		vector<Vec3> points;
+		vector<int> indices;
+	};
+
+} // anonymous namespace
+
+int CreateTethers(const Vec4* particles, int numParticles, const int* edges, int numEdges, int maxAnchors, std::vector<Tether>& tethers)
+{
+	vector<int> anchors;
+	for (int i=0; i < numParticles; ++i)
+	{
+		if (particles[i].w == 0.0f)
+			anchors.push_back(i);
+	}
+
+	if (anchors.empty() || maxAnchors <= 0)
+		return 0;
+
+	Graph graph;
+	BuildGraph(particles, numParticles, edges, numEdges, graph);
+
+	// split anchors into one group per thread, the k nearest anchors overall are 
+	// among the union of the k nearest anchors from each group, every group stores 
+	// numParticles*maxAnchors labels so fewer groups are used when that exceeds the budget
+	const size_t labelsPerGroup = size_t(numParticles)*maxAnchors;
+	const int maxGroups = int(max(kMaxGroupLabels/labelsPerGroup, size_t(1)));
+
+	const int numGroups = min(min(GetParallelThreadCount(), int(anchors.size())), maxGroups);
+	const int groupSize = (int(anchors.size()) + numGroups - 1)/numGroups;
+
+	vector<NearestSources> groups(numGroups);
+
+	ParallelFor(numGroups, [&](int begin, int end)
+	{
+		for (int g=begin; g < end; ++g)
+		{
+			const int start = g*groupSize;
+			const int count = min(groupSize, int(anchors.size()) - start);
+
+			groups[g].Init(numParticles, maxAnchors);
+
+			if (count > 0)
+				FindNearestSources(graph, &anchors[start], count, groups[g]);
+		}
+	}, 1);
+
+	// merge groups, each particle writes up to maxAnchors tethers into its own slots
+	vector<Tether> candidates(numParticles*maxAnchors);
+	vector<int> counts(numParticles, 0);
+
+	ParallelFor(numParticles, [&](int begin, int end)
+	{
+		vector<pair<float, int> > merged;
+
+		for (int i=begin; i < end; ++i)
+		{
+			if (particles[i].w == 0.0f)
+				continue;
+
+			merged.resize(0);
+
+			for (int g=0; g < numGroups; ++g)
+			{
+				for (int s=0; s < groups[g].counts[i]; ++s)
+					merged.push_back(make_pair(groups[g].distances[i*maxAnchors + s], groups[g].sources[i*maxAnchors + s]));
+			}
+
+			sort(merged.begin(), merged.end());
+
+			counts[i] = min(int(merged.size()), maxAnchors);
+
+			for (int s=0; s < counts[i]; ++s)
+			{
+				Tether& t = candidates[i*maxAnchors + s];
+				t.anchor = merged[s].second;
+				t.particle = i;
+				t.restLength = merged[s].first;
+			}
+		}
+	});
+
+	const size_t start = tethers.size();
+
+	for (int i=0; i < numParticles; ++i)
+	{
+		for (int s=0; s < counts[i]; ++s)
+			tethers.push_back(candidates[i*maxAnchors + s]);
+	}
+
+	return int(tethers.size() - start);
+}
+
+int CreateNearestTethers(const Vec4* particles, int numParticles, int maxAnchors, std::vector<Tether>& tethers)
+{
+	vector<int> anchors;
+	for (int i=0; i < numParticles; ++i)
+	{
+		if (particles[i].w == 0.0f)
+			anchors.push_back(i);
+	}
+
+	if (anchors.empty() || maxAnchors <= 0)
+		return 0;
+
+	KdTree tree;
+	tree.Build(particles, anchors);
+
+	// each particle writes up to maxAnchors tethers into its own slots
+	vector<Tether> candidates(numParticles*maxAnchors);
+	vector<int> counts(numParticles, 0);
+
+	ParallelFor(numParticles, [&](int begin, int end)
+	{
+		vector<pair<float, int> > nearest;
+		nearest.reserve(maxAnchors+1);
+
+		for (int i=begin; i < end; ++i)
+		{
+			if (particles[i].w == 0.0f)
+				continue;
+
+			tree.Query(Vec3(particles[i]), maxAnchors, nearest);
+
+			counts[i] = int(nearest.size());
+
+			for (int s=0; s < counts[i]; ++s)
+			{
+				Tether& t = candidates[i*maxAnchors + s];
+				t.anchor = nearest[s].second;
+				t.particle = i;
+				t.restLength = sqrtf(nearest[s].first);
+			}
+		}
+	});
+
+	const size_t start = tethers.size();
+
+	for (int i=0; i < numParticles; ++i)
+	{
+		for (int s=0; s < counts[i]; ++s)
+			tethers.push_back(candidates[i*maxAnchors + s]);
+	}
+
+	return int(tethers.size() - start);
+}
@@ -0,0 +1,54 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// long range attachment, a unilateral constraint that keeps particle within restLength of anchor
+struct Tether
+{
+	int anchor;
+	int particle;
+	float restLength;
+};
+
+// tethers every free particle to its maxAnchors nearest anchors (particles with zero inverse mass), 
+// distances are geodesic, measured as the shortest path over the constraint graph given by pairs 
+// of particle indices in edges, with the rest distance between particles as the edge length, 
+// anchors are processed in parallel groups that each hold numParticles*maxAnchors labels (8 bytes 
+// each), the number of groups is reduced to keep all groups within 128MB unless a single group is 
+// larger, particles that are not connected to any anchor get no tethers, tethers are appended 
+// ordered by particle then distance, returns the number added
+int CreateTethers(const Vec4* particles, int numParticles, const int* edges, int numEdges, int maxAnchors, std::vector<Tether>& tethers);
+
+// tethers every free particle to its maxAnchors nearest anchors by straight line distance, anchors 
+// are found with a kd-tree and particles are processed in parallel, equidistant anchors are ordered 
+// by index, tethers are appended ordered by particle then distance, returns the number added
+int CreateNearestTethers(const Vec4* particles, int numParticles, int maxAnchors, std::vector<Tether>& tethers);
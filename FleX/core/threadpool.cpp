@@ -0,0 +1,234 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "threadpool.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <stdint.h>
+
+using namespace std;
+
+namespace
+{
+	// set on worker threads and while a thread runs a job
+	thread_local bool tInTask = false;
+
+	atomic<ThreadPool*> gParallelPool(NULL);
+	mutex gParallelPoolMutex;
+}
+
+ThreadPool::ThreadPool(int numThreads) : mGeneration(0), mShutdown(false)
+{
+	numThreads = max(1, numThreads);
+
+	mJob.func = NULL;
+	mJob.remaining = 0;
+	mJob.steal = true;
+
+	for (int i=0; i < numThreads; ++i)
+		mQueues.push_back(new Queue());
+
+	// queue 0 belongs to the calling thread
+	for (int i=1; i < numThreads; ++i)
+		mThreads.push_back(thread(&ThreadPool::WorkerMain, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+		mShutdown = true;
+	}
+
+	mWake.notify_all();
+
+	for (size_t i=0; i < mThreads.size(); ++i)
+		mThreads[i].join();
+
+	for (size_t i=0; i < mQueues.size(); ++i)
+		delete mQueues[i];
+}
+
+bool ThreadPool::InTask()
+{
+	return tInTask;
+}
+
+int ThreadPool::GetConcurrency(int maxThreads) const
+{
+	return InTask() ? 1 : max(1, min(maxThreads, GetThreadCount()));
+}
+
+bool ThreadPool::Pop(int queue, Task& task)
+{
+	Queue& q = *mQueues[queue];
+
+	lock_guard<mutex> lock(q.mutex);
+
+	if (q.tasks.empty())
+		return false;
+
+	task = q.tasks.front();
+	q.tasks.pop_front();
+
+	return true;
+}
+
+bool ThreadPool::Steal(int thief, Task& task)
+{
+	const int numQueues = int(mQueues.size());
+
+	for (int i=1; i < numQueues; ++i)
+	{
+		Queue& q = *mQueues[(thief + i)%numQueues];
+
+		lock_guard<mutex> lock(q.mutex);
+
+		// checked under the queue lock so a thief from the previous job cannot take a pinned task
+		if (q.tasks.empty() || !mJob.steal.load())
+			continue;
+
+		task = q.tasks.back();
+		q.tasks.pop_back();
+
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::Run(const function<void(int, int)>& func, int count, int grain, bool steal)
+{
+	lock_guard<mutex> runLock(mRunMutex);
+
+	const int numQueues = int(mQueues.size());
+	const int numTasks = (count + grain - 1)/grain;
+
+	assert(steal || numTasks <= numQueues);
+
+	mJob.func = &func;
+	mJob.remaining = numTasks;
+	mJob.steal = steal;
+
+	// contiguous blocks of tasks per queue so each worker starts on neighboring data
+	for (int q=0; q < numQueues; ++q)
+	{
+		const int first = int(int64_t(numTasks)*q/numQueues);
+		const int last = int(int64_t(numTasks)*(q+1)/numQueues);
+
+		lock_guard<mutex> lock(mQueues[q]->mutex);
+
+		for (int t=first; t < last; ++t)
+		{
+			Task task = { t*grain, min((t+1)*grain, count) };
+			mQueues[q]->tasks.push_back(task);
+		}
+	}
+
+	{
+		lock_guard<mutex> lock(mMutex);
+		++mGeneration;
+	}
+
+	mWake.notify_all();
+
+	tInTask = true;
+
+	// the caller works too, then spins on stragglers
+	Task task;
+	while (mJob.remaining.load() > 0)
+	{
+		if (Pop(0, task) || Steal(0, task))
+		{
+			func(task.begin, task.end);
+			mJob.remaining.fetch_sub(1);
+		}
+		else
+			this_thread::yield();
+	}
+
+	tInTask = false;
+
+	mJob.func = NULL;
+}
+
+void ThreadPool::WorkerMain(int index)
+{
+	tInTask = true;
+
+	int generation = 0;
+
+	for (;;)
+	{
+		{
+			unique_lock<mutex> lock(mMutex);
+			mWake.wait(lock, [&]() { return mShutdown || mGeneration.load() != generation; });
+
+			if (mShutdown)
+				return;
+
+			generation = mGeneration.load();
+		}
+
+		Task task;
+		while (Pop(index, task) || Steal(index, task))
+		{
+			(*mJob.func)(task.begin, task.end);
+			mJob.remaining.fetch_sub(1);
+		}
+	}
+}
+
+ThreadPool& GetParallelPool()
+{
+	ThreadPool* pool = gParallelPool.load();
+
+	if (!pool)
+	{
+		lock_guard<mutex> lock(gParallelPoolMutex);
+
+		pool = gParallelPool.load();
+
+		if (!pool)
+		{
+			pool = new ThreadPool(int(thread::hardware_concurrency()));
+			gParallelPool.store(pool);
+		}
+	}
+
+	return *pool;
+}
+
+void SetParallelThreadCount(int numThreads)
+{
+	lock_guard<mutex> lock(gParallelPoolMutex);
+
+	ThreadPool* pool = gParallelPool.exchange(new ThreadPool(numThreads));
+
+	delete pool;
+}
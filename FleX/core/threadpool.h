@@ -0,0 +1,147 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads, each with its own task deque, idle workers steal from the back 
+// of the other deques so uneven ranges (e.g.: clustered contacts) are balanced without a 
+// central queue, the thread calling a job works on its own share and steals until the job completes, 
+// jobs started from inside a task run inline on that thread so loops can nest without deadlocking
+class ThreadPool
+{
+public:
+
+	explicit ThreadPool(int numThreads);
+	~ThreadPool();
+
+	int GetThreadCount() const { return int(mQueues.size()); }
+
+	// true on worker threads and on a thread running a job, further jobs from it run inline
+	static bool InTask();
+
+	// number of threads RunOnThreads() can keep busy at once, 1 from inside a task
+	int GetConcurrency(int maxThreads) const;
+
+	// calls func(begin, end) on sub-ranges of [0, count) of at most grain items and returns when all have run
+	template <typename Func>
+	void ParallelFor(int count, Func func, int grain=256);
+
+	// calls func(thread) for thread in [0, numThreads) with each call on a different thread so they run 
+	// concurrently and may wait for each other, numThreads must not exceed GetConcurrency()
+	template <typename Func>
+	void RunOnThreads(int numThreads, Func func);
+
+private:
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	struct Task
+	{
+		int begin;
+		int end;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	// a single range job, the function is type erased so tasks stay plain data
+	struct Job
+	{
+		const std::function<void(int, int)>* func;
+		std::atomic<int> remaining;
+		std::atomic<bool> steal;
+	};
+
+	void Run(const std::function<void(int, int)>& func, int count, int grain, bool steal);
+
+	bool Pop(int queue, Task& task);
+	bool Steal(int thief, Task& task);
+
+	void WorkerMain(int index);
+
+	std::vector<Queue*> mQueues;
+	std::vector<std::thread> mThreads;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+
+	Job mJob;
+	std::atomic<int> mGeneration;
+	bool mShutdown;
+
+	// serializes jobs submitted from different threads
+	std::mutex mRunMutex;
+};
+
+template <typename Func>
+void ThreadPool::ParallelFor(int count, Func func, int grain)
+{
+	if (count <= 0)
+		return;
+
+	// small loops run inline without waking the workers
+	if (count <= grain || mQueues.size() == 1 || InTask())
+	{
+		func(0, count);
+		return;
+	}
+
+	const std::function<void(int, int)> f(func);
+	Run(f, count, grain, true);
+}
+
+template <typename Func>
+void ThreadPool::RunOnThreads(int numThreads, Func func)
+{
+	if (numThreads <= 1)
+	{
+		func(0);
+		return;
+	}
+
+	// one pinned task per queue, stealing would let one thread run two of them in turn
+	const std::function<void(int, int)> f([&](int begin, int end) { func(begin); });
+	Run(f, numThreads, 1, false);
+}
+
+// shared pool used by ParallelFor(), created on first use with one thread per hardware thread
+ThreadPool& GetParallelPool();
+
+// replaces the shared pool, must not be called while parallel work is running
+void SetParallelThreadCount(int numThreads);
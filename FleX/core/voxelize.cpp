@@ -27,6 +27,7 @@
 
 #include "aabbtree.h"
 #include "mesh.h"
+#include "parallel.h"
 
 void Voxelize(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, uint32_t width, uint32_t height, uint32_t depth, uint32_t* volume, Vec3 minExtents, Vec3 maxExtents)
 {
@@ -43,10 +44,14 @@ void Voxelize(const Vec3* vertices, int numVertices, const int* indices, int num
 	// this is the bias we apply to step 'off' a triangle we hit, not very robust
 	const float eps = 0.00001f*extents.z;
 
-	for (uint32_t x=0; x < width; ++x)
+	// columns write disjoint voxels so they are traced in parallel
+	ParallelFor(int(width*height), [&](int begin, int end)
 	{
-		for (uint32_t y=0; y < height; ++y)
+		for (int column=begin; column < end; ++column)
 		{
+			const uint32_t x = uint32_t(column)/height;
+			const uint32_t y = uint32_t(column)%height;
+
 			bool inside = false;
 
 			Vec3 rayDir = Vec3(0.0f, 0.0f, 1.0f);
@@ -89,5 +94,5 @@ void Voxelize(const Vec3* vertices, int numVertices, const int* indices, int num
 					break;
 			}
 		}
-	}	
+	}, 64);
 }
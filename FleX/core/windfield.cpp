@@ -0,0 +1,344 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "windfield.h"
+#include "perlin.h"
+#include "parallel.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+
+// positions are evaluated in batches of this many
+const int kBatchSize = 64;
+
+// wraps a grid coordinate into the tile, returns the lower node, the upper node and the fraction between them
+inline void GetWrappedCell(float x, float dim, int& i0, int& i1, float& t)
+{
+	const float w = x - dim*floorf(x/dim);
+	const float f = floorf(w);
+
+	i0 = Min(int(f), int(dim)-1);
+	i1 = i0+1 == int(dim) ? 0 : i0+1;
+	t = w - f;
+}
+
+void SampleBatch(const WindField& field, float time, const Vec4* positions, int count, Vec3* velocities)
+{
+	const int numNodes = field.dim[0]*field.dim[1]*field.dim[2];
+
+	// frames either side of the time
+	int frame0, frame1;
+	float frameT;
+	GetWrappedCell(time/field.period*field.numFrames, float(field.numFrames), frame0, frame1, frameT);
+
+	const int frameOffset0 = frame0*numNodes;
+	const int frameOffset1 = frame1*numNodes;
+
+	const float invCellSize = 1.0f/field.cellSize;
+
+	int start = 0;
+
+#if defined(__AVX2__)
+
+	const int* words = (const int*)&field.samples[0];
+
+	const __m256 dimX = _mm256_set1_ps(float(field.dim[0]));
+	const __m256 dimY = _mm256_set1_ps(float(field.dim[1]));
+	const __m256 dimZ = _mm256_set1_ps(float(field.dim[2]));
+	const __m256 invCell = _mm256_set1_ps(invCellSize);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 weight0 = _mm256_set1_ps((1.0f-frameT)*field.scale);
+	const __m256 weight1 = _mm256_set1_ps(frameT*field.scale);
+
+	for (; start + 8 <= count; start += 8)
+	{
+		float px[8], py[8], pz[8];
+		for (int i=0; i < 8; ++i)
+		{
+			px[i] = positions[start+i].x;
+			py[i] = positions[start+i].y;
+			pz[i] = positions[start+i].z;
+		}
+
+		__m256i lower[3], upper[3];
+		__m256 fraction[3];
+
+		const __m256 coords[3] = { _mm256_mul_ps(_mm256_loadu_ps(px), invCell), _mm256_mul_ps(_mm256_loadu_ps(py), invCell), _mm256_mul_ps(_mm256_loadu_ps(pz), invCell) };
+		const __m256 dims[3] = { dimX, dimY, dimZ };
+
+		for (int a=0; a < 3; ++a)
+		{
+			const __m256 w = _mm256_sub_ps(coords[a], _mm256_mul_ps(dims[a], _mm256_floor_ps(_mm256_div_ps(coords[a], dims[a]))));
+			const __m256 f = _mm256_floor_ps(w);
+			const __m256i dim = _mm256_set1_epi32(field.dim[a]);
+
+			lower[a] = _mm256_min_epi32(_mm256_cvttps_epi32(f), _mm256_sub_epi32(dim, _mm256_set1_epi32(1)));
+
+			const __m256i next = _mm256_add_epi32(lower[a], _mm256_set1_epi32(1));
+			upper[a] = _mm256_andnot_si256(_mm256_cmpeq_epi32(next, dim), next);
+
+			fraction[a] = _mm256_sub_ps(w, f);
+		}
+
+		__m256 vx = _mm256_setzero_ps();
+		__m256 vy = _mm256_setzero_ps();
+		__m256 vz = _mm256_setzero_ps();
+
+		for (int c=0; c < 8; ++c)
+		{
+			const __m256i x = (c&1) ? upper[0] : lower[0];
+			const __m256i y = (c&2) ? upper[1] : lower[1];
+			const __m256i z = (c&4) ? upper[2] : lower[2];
+
+			const __m256 wx = (c&1) ? fraction[0] : _mm256_sub_ps(one, fraction[0]);
+			const __m256 wy = (c&2) ? fraction[1] : _mm256_sub_ps(one, fraction[1]);
+			const __m256 wz = (c&4) ? fraction[2] : _mm256_sub_ps(one, fraction[2]);
+			const __m256 w = _mm256_mul_ps(_mm256_mul_ps(wx, wy), wz);
+
+			const __m256i node = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_mullo_epi32(z, _mm256_set1_epi32(field.dim[1])), y), _mm256_set1_epi32(field.dim[0])), x);
+
+			for (int f=0; f < 2; ++f)
+			{
+				const __m256i word = _mm256_slli_epi32(_mm256_add_epi32(node, _mm256_set1_epi32(f ? frameOffset1 : frameOffset0)), 1);
+				const __m256 weight = _mm256_mul_ps(w, f ? weight1 : weight0);
+
+				const __m256i xy = _mm256_i32gather_epi32(words, word, 4);
+				const __m256i zw = _mm256_i32gather_epi32(words, _mm256_add_epi32(word, _mm256_set1_epi32(1)), 4);
+
+				// sign extend the 16 bit halves
+				vx = _mm256_add_ps(vx, _mm256_mul_ps(weight, _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(xy, 16), 16))));
+				vy = _mm256_add_ps(vy, _mm256_mul_ps(weight, _mm256_cvtepi32_ps(_mm256_srai_epi32(xy, 16))));
+				vz = _mm256_add_ps(vz, _mm256_mul_ps(weight, _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(zw, 16), 16))));
+			}
+		}
+
+		float rx[8], ry[8], rz[8];
+		_mm256_storeu_ps(rx, vx);
+		_mm256_storeu_ps(ry, vy);
+		_mm256_storeu_ps(rz, vz);
+
+		for (int i=0; i < 8; ++i)
+			velocities[start+i] = Vec3(rx[i], ry[i], rz[i]);
+	}
+
+#endif
+
+	const float weights[2] = { (1.0f-frameT)*field.scale, frameT*field.scale };
+	const int frameOffsets[2] = { frameOffset0, frameOffset1 };
+
+	for (int i=start; i < count; ++i)
+	{
+		int lower[3], upper[3];
+		float fraction[3];
+
+		for (int a=0; a < 3; ++a)
+			GetWrappedCell(positions[i][a]*invCellSize, float(field.dim[a]), lower[a], upper[a], fraction[a]);
+
+		Vec3 v(0.0f);
+
+		for (int c=0; c < 8; ++c)
+		{
+			const int x = (c&1) ? upper[0] : lower[0];
+			const int y = (c&2) ? upper[1] : lower[1];
+			const int z = (c&4) ? upper[2] : lower[2];
+
+			const float w = ((c&1) ? fraction[0] : 1.0f-fraction[0])*((c&2) ? fraction[1] : 1.0f-fraction[1])*((c&4) ? fraction[2] : 1.0f-fraction[2]);
+
+			const int node = (z*field.dim[1] + y)*field.dim[0] + x;
+
+			for (int f=0; f < 2; ++f)
+			{
+				const int16_t* s = &field.samples[(frameOffsets[f] + node)*4];
+				const float weight = w*weights[f];
+
+				v += weight*Vec3(float(s[0]), float(s[1]), float(s[2]));
+			}
+		}
+
+		velocities[i] = v;
+	}
+}
+
+} // anonymous namespace
+
+void CreateWindField(int dimx, int dimy, int dimz, int numFrames, float cellSize, float period, int octaves, WindField& field)
+{
+	field.dim[0] = dimx;
+	field.dim[1] = dimy;
+	field.dim[2] = dimz;
+	field.numFrames = numFrames;
+	field.cellSize = cellSize;
+	field.period = period;
+
+	const int numNodes = dimx*dimy*dimz;
+
+	// noise lattice periods, one noise cell spans about 4 grid cells
+	const int noisePeriod[3] = { Max(1, dimx/4), Max(1, dimy/4), Max(1, dimz/4) };
+
+	// each frame samples the noise at an offset on a circle so the sequence loops, the three potential 
+	// components sample decorrelated regions of the noise
+	const float kLoopRadius = 0.5f;
+	const Vec3 kComponentOffsets[3] = { Vec3(0.0f), Vec3(31.416f, 47.853f, 12.793f), Vec3(73.217f, 19.381f, 55.462f) };
+
+	vector<Vec3> velocities(numFrames*numNodes);
+
+	ParallelFor(numFrames, [&](int begin, int end)
+	{
+		vector<Vec3> potential(numNodes);
+		vector<float> rowX(dimx), rowY(dimx), rowZ(dimx), rowNoise(dimx);
+
+		for (int frame=begin; frame < end; ++frame)
+		{
+			const float angle = k2Pi*float(frame)/float(numFrames);
+			const Vec3 loop(kLoopRadius*cosf(angle), 0.0f, kLoopRadius*sinf(angle));
+
+			// evaluate each potential component a row at a time with the batch noise
+			for (int z=0; z < dimz; ++z)
+			{
+				for (int y=0; y < dimy; ++y)
+				{
+					for (int k=0; k < 3; ++k)
+					{
+						for (int x=0; x < dimx; ++x)
+						{
+							const Vec3 s = Vec3(float(x)*noisePeriod[0]/dimx, float(y)*noisePeriod[1]/dimy, float(z)*noisePeriod[2]/dimz) + loop + kComponentOffsets[k];
+
+							rowX[x] = s.x;
+							rowY[x] = s.y;
+							rowZ[x] = s.z;
+						}
+
+						Perlin3DPeriodic(&rowX[0], &rowY[0], &rowZ[0], dimx, noisePeriod[0], noisePeriod[1], noisePeriod[2], octaves, 0.5f, &rowNoise[0]);
+
+						for (int x=0; x < dimx; ++x)
+							potential[(z*dimy + y)*dimx + x][k] = rowNoise[x];
+					}
+				}
+			}
+
+			// curl by central differences with wrapped neighbors
+			const float invSpacing = 0.5f/cellSize;
+
+			for (int z=0; z < dimz; ++z)
+			{
+				for (int y=0; y < dimy; ++y)
+				{
+					for (int x=0; x < dimx; ++x)
+					{
+						const Vec3& px0 = potential[(z*dimy + y)*dimx + (x+dimx-1)%dimx];
+						const Vec3& px1 = potential[(z*dimy + y)*dimx + (x+1)%dimx];
+						const Vec3& py0 = potential[(z*dimy + (y+dimy-1)%dimy)*dimx + x];
+						const Vec3& py1 = potential[(z*dimy + (y+1)%dimy)*dimx + x];
+						const Vec3& pz0 = potential[(((z+dimz-1)%dimz)*dimy + y)*dimx + x];
+						const Vec3& pz1 = potential[(((z+1)%dimz)*dimy + y)*dimx + x];
+
+						velocities[frame*numNodes + (z*dimy + y)*dimx + x] = invSpacing*Vec3(
+							(py1.z - py0.z) - (pz1.y - pz0.y),
+							(pz1.x - pz0.x) - (px1.z - px0.z),
+							(px1.y - px0.y) - (py1.x - py0.x));
+					}
+				}
+			}
+		}
+	}, 1);
+
+	// normalize to unit rms speed and quantize
+	double sumSq = 0.0;
+	float maxComponent = 0.0f;
+
+	for (size_t i=0; i < velocities.size(); ++i)
+	{
+		sumSq += LengthSq(velocities[i]);
+		maxComponent = Max(maxComponent, Max(fabsf(velocities[i].x), Max(fabsf(velocities[i].y), fabsf(velocities[i].z))));
+	}
+
+	const float rms = velocities.size() ? float(sqrt(sumSq/velocities.size())) : 0.0f;
+	const float quantize = maxComponent > 0.0f ? 32767.0f/maxComponent : 0.0f;
+
+	field.scale = (rms > 0.0f && quantize > 0.0f) ? 1.0f/(quantize*rms) : 0.0f;
+	field.samples.resize(velocities.size()*4);
+
+	for (size_t i=0; i < velocities.size(); ++i)
+	{
+		for (int k=0; k < 3; ++k)
+			field.samples[i*4+k] = int16_t(Clamp(floorf(velocities[i][k]*quantize + 0.5f), -32767.0f, 32767.0f));
+
+		field.samples[i*4+3] = 0;
+	}
+}
+
+void SampleWindField(const WindField& field, float time, const Vec4* positions, int numPositions, Vec3* velocities)
+{
+	if (field.samples.empty())
+	{
+		for (int i=0; i < numPositions; ++i)
+			velocities[i] = Vec3(0.0f);
+
+		return;
+	}
+
+	ParallelFor(numPositions, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; i += kBatchSize)
+			SampleBatch(field, time, positions + i, Min(kBatchSize, end-i), velocities + i);
+	}, 4096);
+}
+
+void ApplyWindField(const WindField& field, float time, float strength, float drag, float dt, const Vec4* particles, Vec3* velocities, int numParticles)
+{
+	if (field.samples.empty())
+		return;
+
+	const float k = Min(drag*dt, 1.0f);
+
+	ParallelFor(numParticles, [&](int begin, int end)
+	{
+		Vec3 wind[kBatchSize];
+
+		for (int i=begin; i < end; i += kBatchSize)
+		{
+			const int count = Min(kBatchSize, end-i);
+
+			SampleBatch(field, time, particles + i, count, wind);
+
+			for (int j=0; j < count; ++j)
+			{
+				// kinematic particles are not pushed
+				if (particles[i+j].w > 0.0f)
+					velocities[i+j] += (strength*wind[j] - velocities[i+j])*k;
+			}
+		}
+	}, 4096);
+}
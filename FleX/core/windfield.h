@@ -0,0 +1,59 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "maths.h"
+
+#include <vector>
+
+// wind velocity grid that tiles space and loops in time, built from the curl of periodic Perlin noise 
+// so the flow is divergence free, samples are quantized to 16 bits to keep many frames resident
+struct WindField
+{
+	WindField() : numFrames(0), cellSize(1.0f), period(1.0f), scale(0.0f) { dim[0] = dim[1] = dim[2] = 0; }
+
+	int dim[3];
+	int numFrames;
+
+	float cellSize;
+	float period;
+
+	// four samples per node and frame, x and y share the first 32 bit word and z the second, velocity is sample*scale
+	std::vector<int16_t> samples;
+	float scale;
+};
+
+// builds numFrames frames of a dimx*dimy*dimz node grid with cellSize spacing over one period in seconds, 
+// velocities are normalized to unit rms speed
+void CreateWindField(int dimx, int dimy, int dimz, int numFrames, float cellSize, float period, int octaves, WindField& field);
+
+// trilinear interpolation in space and linear in time, in SIMD batches
+void SampleWindField(const WindField& field, float time, const Vec4* positions, int numPositions, Vec3* velocities);
+
+// relaxes the velocity of particles with non-zero inverse mass towards strength times the wind at their position
+void ApplyWindField(const WindField& field, float time, float strength, float drag, float dt, const Vec4* particles, Vec3* velocities, int numParticles);
@@ -0,0 +1,358 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 20132017 NVIDIA Corporation. All rights reserved.
+
+#include "../include/NvFlexExt.h"
+
+#include "../core/core.h"
+#include "../core/maths.h"
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <stdio.h>
+
+#if defined(WIN32) || defined(WIN64)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Asset serialization and cooking cache
+
+namespace
+{
+	// RAII wrapper to handle file pointer clean up
+	struct FilePointer
+	{
+		FilePointer(FILE* ptr) : p(ptr) {}
+		~FilePointer() { if (p) fclose(p); }
+
+		operator FILE*() { return p; }
+
+		FILE* p;
+	};
+
+	const char kAssetMagic[4] = { 'F', 'X', 'A', 'S' };
+
+	// bump when the file layout or any asset cooking method changes, old cache entries then stop matching
+	const uint32_t kAssetVersion = 1;
+
+	// arrays start on cache line boundaries so a mapped file can be used in place
+	const uint64_t kAssetAlignment = 64;
+
+	enum AssetArray
+	{
+		eParticles,
+		eSpringIndices,
+		eSpringCoefficients,
+		eSpringRestLengths,
+		eShapeIndices,
+		eShapeOffsets,
+		eShapeCoefficients,
+		eShapeCenters,
+		eShapePlasticThresholds,
+		eShapePlasticCreeps,
+		eTriangleIndices,
+
+		eNumAssetArrays
+	};
+
+	struct AssetHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+
+		int32_t numParticles;
+		int32_t maxParticles;
+		int32_t numSprings;
+		int32_t numShapeIndices;
+		int32_t numShapes;
+		int32_t numTriangles;
+
+		int32_t inflatable;
+		float inflatableVolume;
+		float inflatablePressure;
+		float inflatableStiffness;
+
+		// byte offset from the start of the file and byte size of each array, NULL arrays have size zero
+		uint64_t offsets[eNumAssetArrays];
+		uint64_t sizes[eNumAssetArrays];
+	};
+
+	// size in bytes each array has when present
+	void GetArraySizes(const AssetHeader& header, uint64_t sizes[eNumAssetArrays])
+	{
+		sizes[eParticles] = uint64_t(header.numParticles)*4*sizeof(float);
+		sizes[eSpringIndices] = uint64_t(header.numSprings)*2*sizeof(int);
+		sizes[eSpringCoefficients] = uint64_t(header.numSprings)*sizeof(float);
+		sizes[eSpringRestLengths] = uint64_t(header.numSprings)*sizeof(float);
+		sizes[eShapeIndices] = uint64_t(header.numShapeIndices)*sizeof(int);
+		sizes[eShapeOffsets] = uint64_t(header.numShapes)*sizeof(int);
+		sizes[eShapeCoefficients] = uint64_t(header.numShapes)*sizeof(float);
+		sizes[eShapeCenters] = uint64_t(header.numShapes)*3*sizeof(float);
+		sizes[eShapePlasticThresholds] = uint64_t(header.numShapes)*sizeof(float);
+		sizes[eShapePlasticCreeps] = uint64_t(header.numShapes)*sizeof(float);
+		sizes[eTriangleIndices] = uint64_t(header.numTriangles)*3*sizeof(int);
+	}
+
+	template <typename T>
+	T* ReadArray(const vector<char>& file, const AssetHeader& header, AssetArray array, int count)
+	{
+		if (header.sizes[array] == 0)
+			return NULL;
+
+		T* data = new T[count];
+		memcpy(data, &file[size_t(header.offsets[array])], size_t(header.sizes[array]));
+
+		// arrays with spare capacity, e.g.: particles up to maxParticles, are only stored up to their used size
+		memset((char*)data + header.sizes[array], 0, size_t(count)*sizeof(T) - size_t(header.sizes[array]));
+
+		return data;
+	}
+
+	string gAssetCacheDirectory;
+
+	// distinguishes temporary files written by threads of the same process
+	atomic<unsigned int> gAssetTempCounter(0);
+
+	string GetCachedAssetPath(unsigned long long key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.asset", key);
+
+		return gAssetCacheDirectory + "/" + name;
+	}
+}
+
+bool NvFlexExtSaveAsset(const char* filename, unsigned long long key, const NvFlexExtAsset* asset)
+{
+	AssetHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kAssetMagic, sizeof(kAssetMagic));
+
+	header.version = kAssetVersion;
+	header.key = key;
+	header.numParticles = asset->numParticles;
+	header.maxParticles = asset->maxParticles;
+	header.numSprings = asset->numSprings;
+	header.numShapeIndices = asset->numShapeIndices;
+	header.numShapes = asset->numShapes;
+	header.numTriangles = asset->numTriangles;
+	header.inflatable = asset->inflatable;
+	header.inflatableVolume = asset->inflatableVolume;
+	header.inflatablePressure = asset->inflatablePressure;
+	header.inflatableStiffness = asset->inflatableStiffness;
+
+	const void* arrays[eNumAssetArrays] = 
+	{
+		asset->particles,
+		asset->springIndices,
+		asset->springCoefficients,
+		asset->springRestLengths,
+		asset->shapeIndices,
+		asset->shapeOffsets,
+		asset->shapeCoefficients,
+		asset->shapeCenters,
+		asset->shapePlasticThresholds,
+		asset->shapePlasticCreeps,
+		asset->triangleIndices
+	};
+
+	uint64_t sizes[eNumAssetArrays];
+	GetArraySizes(header, sizes);
+
+	// lay out arrays after the header
+	uint64_t offset = sizeof(AssetHeader);
+
+	for (int i=0; i < eNumAssetArrays; ++i)
+	{
+		if (arrays[i] && sizes[i])
+		{
+			offset = (offset + kAssetAlignment - 1)&~(kAssetAlignment - 1);
+
+			header.offsets[i] = offset;
+			header.sizes[i] = sizes[i];
+
+			offset += sizes[i];
+		}
+	}
+
+	FilePointer f = fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	if (fwrite(&header, sizeof(header), 1, f) != 1)
+		return false;
+
+	uint64_t position = sizeof(AssetHeader);
+	const char padding[kAssetAlignment] = { 0 };
+
+	for (int i=0; i < eNumAssetArrays; ++i)
+	{
+		if (header.sizes[i] == 0)
+			continue;
+
+		if (header.offsets[i] > position && fwrite(padding, size_t(header.offsets[i] - position), 1, f) != 1)
+			return false;
+
+		if (fwrite(arrays[i], size_t(header.sizes[i]), 1, f) != 1)
+			return false;
+
+		position = header.offsets[i] + header.sizes[i];
+	}
+
+	return true;
+}
+
+NvFlexExtAsset* NvFlexExtLoadAsset(const char* filename, unsigned long long key)
+{
+	FilePointer f = fopen(filename, "rb");
+	if (!f)
+		return NULL;
+
+	// read the whole file, arrays are then copied out so the asset can be released with NvFlexExtDestroyAsset()
+	fseek(f, 0, SEEK_END);
+	const long length = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (length < long(sizeof(AssetHeader)))
+		return NULL;
+
+	vector<char> file(length);
+	if (fread(&file[0], length, 1, f) != 1)
+		return NULL;
+
+	AssetHeader header;
+	memcpy(&header, &file[0], sizeof(header));
+
+	if (memcmp(header.magic, kAssetMagic, sizeof(kAssetMagic)) != 0 || header.version != kAssetVersion || header.key != key)
+		return NULL;
+
+	if (header.numParticles < 0 || header.maxParticles < header.numParticles || header.numSprings < 0 || header.numShapeIndices < 0 || header.numShapes < 0 || header.numTriangles < 0)
+		return NULL;
+
+	uint64_t sizes[eNumAssetArrays];
+	GetArraySizes(header, sizes);
+
+	// reject truncated files and arrays that don't match the counts
+	for (int i=0; i < eNumAssetArrays; ++i)
+	{
+		if (header.sizes[i] == 0)
+			continue;
+
+		if (header.sizes[i] != sizes[i] || header.offsets[i]%kAssetAlignment != 0 || header.offsets[i] + header.sizes[i] > uint64_t(length))
+			return NULL;
+	}
+
+	NvFlexExtAsset* asset = new NvFlexExtAsset();
+	memset(asset, 0, sizeof(*asset));
+
+	asset->numParticles = header.numParticles;
+	asset->maxParticles = header.maxParticles;
+	asset->numSprings = header.numSprings;
+	asset->numShapeIndices = header.numShapeIndices;
+	asset->numShapes = header.numShapes;
+	asset->numTriangles = header.numTriangles;
+	asset->inflatable = header.inflatable != 0;
+	asset->inflatableVolume = header.inflatableVolume;
+	asset->inflatablePressure = header.inflatablePressure;
+	asset->inflatableStiffness = header.inflatableStiffness;
+
+	asset->particles = ReadArray<float>(file, header, eParticles, header.maxParticles*4);
+	asset->springIndices = ReadArray<int>(file, header, eSpringIndices, header.numSprings*2);
+	asset->springCoefficients = ReadArray<float>(file, header, eSpringCoefficients, header.numSprings);
+	asset->springRestLengths = ReadArray<float>(file, header, eSpringRestLengths, header.numSprings);
+	asset->shapeIndices = ReadArray<int>(file, header, eShapeIndices, header.numShapeIndices);
+	asset->shapeOffsets = ReadArray<int>(file, header, eShapeOffsets, header.numShapes);
+	asset->shapeCoefficients = ReadArray<float>(file, header, eShapeCoefficients, header.numShapes);
+	asset->shapeCenters = ReadArray<float>(file, header, eShapeCenters, header.numShapes*3);
+	asset->shapePlasticThresholds = ReadArray<float>(file, header, eShapePlasticThresholds, header.numShapes);
+	asset->shapePlasticCreeps = ReadArray<float>(file, header, eShapePlasticCreeps, header.numShapes);
+	asset->triangleIndices = ReadArray<int>(file, header, eTriangleIndices, header.numTriangles*3);
+
+	return asset;
+}
+
+unsigned long long NvFlexExtHashAssetData(unsigned long long hash, const void* data, int numBytes)
+{
+	// 64 bit FNV-1a, a zero hash starts from the offset basis mixed with the format version
+	if (hash == 0)
+	{
+		hash = 14695981039346656037ULL;
+		hash = NvFlexExtHashAssetData(hash, &kAssetVersion, sizeof(kAssetVersion));
+	}
+
+	const uint8_t* p = (const uint8_t*)data;
+
+	for (int i=0; i < numBytes; ++i)
+	{
+		hash ^= p[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+void NvFlexExtSetAssetCacheDirectory(const char* path)
+{
+	gAssetCacheDirectory = path ? path : "";
+}
+
+bool NvFlexExtGetAssetCacheEnabled()
+{
+	return !gAssetCacheDirectory.empty();
+}
+
+NvFlexExtAsset* NvFlexExtLoadCachedAsset(unsigned long long key)
+{
+	if (gAssetCacheDirectory.empty())
+		return NULL;
+
+	return NvFlexExtLoadAsset(GetCachedAssetPath(key).c_str(), key);
+}
+
+void NvFlexExtStoreCachedAsset(unsigned long long key, const NvFlexExtAsset* asset)
+{
+	if (gAssetCacheDirectory.empty() || !asset)
+		return;
+
+	const string path = GetCachedAssetPath(key);
+
+	// write to a unique temporary file and rename it into place, so processes sharing the 
+	// cache never read a partially written asset
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", int(getpid()), gAssetTempCounter++);
+
+	const string temp = path + suffix;
+
+	if (!NvFlexExtSaveAsset(temp.c_str(), key, asset) || rename(temp.c_str(), path.c_str()) != 0)
+		remove(temp.c_str());
+}
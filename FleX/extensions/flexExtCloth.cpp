@@ -28,6 +28,14 @@
 #include "../include/NvFlexExt.h"
 
 #include "../core/cloth.h"
+#include "../core/tether.h"
+#include "../core/parallel.h"
+
+#include <chrono>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace
 {
@@ -83,6 +91,28 @@ int NvFlexExtCreateWeldedMeshIndices(const float* vertices, int numVertices, int
 
 NvFlexExtAsset* NvFlexExtCreateClothFromMesh(const float* particles, int numVertices, const int* indices, int numTriangles, float stretchStiffness, float bendStiffness, float tetherStiffness, float tetherGive, float pressure)
 {
+	return NvFlexExtCreateClothFromMeshWithTethers(particles, numVertices, indices, numTriangles, stretchStiffness, bendStiffness, tetherStiffness, tetherGive, 1, 0.0f, pressure);
+}
+
+NvFlexExtAsset* NvFlexExtCreateClothFromMeshWithTethers(const float* particles, int numVertices, const int* indices, int numTriangles, float stretchStiffness, float bendStiffness, float tetherStiffness, float tetherGive, int maxTethers, float tetherFalloff, float pressure)
+{
+	// reuse an asset cooked earlier from the same mesh and parameters
+	const float params[] = { stretchStiffness, bendStiffness, tetherStiffness, tetherGive, float(maxTethers), tetherFalloff, pressure };
+
+	unsigned long long key = 0;
+
+	if (NvFlexExtGetAssetCacheEnabled())
+	{
+		key = NvFlexExtHashAssetData(0, "cloth", 5);
+		key = NvFlexExtHashAssetData(key, particles, numVertices*4*sizeof(float));
+		key = NvFlexExtHashAssetData(key, indices, numTriangles*3*sizeof(int));
+		key = NvFlexExtHashAssetData(key, params, sizeof(params));
+
+		NvFlexExtAsset* cachedAsset = NvFlexExtLoadCachedAsset(key);
+		if (cachedAsset)
+			return cachedAsset;
+	}
+
 	NvFlexExtAsset* asset = new NvFlexExtAsset();
 	memset(asset, 0, sizeof(*asset));
 
@@ -105,54 +135,31 @@ NvFlexExtAsset* NvFlexExtCreateClothFromMesh(const float* particles, int numVert
 		// create tethers
 		if (tetherStiffness > 0.0f)
 		{
-			std::vector<int> anchors;
-			anchors.reserve(numVertices);
+			// find the closest attachment points
+			std::vector<Tether> tethers;
+			CreateNearestTethers((const Vec4*)particles, numVertices, maxTethers, tethers);
 
-			// find anchors
-			for (int i=0; i < numVertices; ++i)
-			{
-				Vec4& particle = ((Vec4*)particles)[i];
+			float nearestLength = 0.0f;
 
-				if (particle.w == 0.0f)
-					anchors.push_back(i);
-			}
-
-			if (anchors.size())
+			for (int i=0; i < int(tethers.size()); ++i)
 			{
-				// create tethers
-				for (int i=0; i < numVertices; ++i)
-				{
-					Vec4& particle = ((Vec4*)particles)[i];
-					if (particle.w == 0.0f)
-						continue;
+				const Tether& t = tethers[i];
 
-					float minSqrDist = FLT_MAX;
-					int minIndex = -1;
+				// tethers are sorted by distance per particle so the first is the nearest
+				if (i == 0 || tethers[i-1].particle != t.particle)
+					nearestLength = t.restLength;
 
-					// find the closest attachment point
-					for (int a=0; a < int(anchors.size()); ++a)
-					{
-						Vec4& attachment = ((Vec4*)particles)[anchors[a]];
-
-						float distSqr = LengthSq(Vec3(particle)-Vec3(attachment));
-						if (distSqr < minSqrDist)
-						{
-							minSqrDist = distSqr;
-							minIndex = anchors[a];
-						}
-					}
+				// tethers to further anchors are weakened by (nearest/distance)^falloff
+				float stiffness = tetherStiffness;
+				if (tetherFalloff > 0.0f && t.restLength > nearestLength)
+					stiffness *= powf(nearestLength/t.restLength, tetherFalloff);
 
-					// add a tether
-					if (minIndex != -1)
-					{						
-						cloth.mConstraintIndices.push_back(i);
-						cloth.mConstraintIndices.push_back(minIndex);
-						cloth.mConstraintRestLengths.push_back(sqrtf(minSqrDist)*(1.0f + tetherGive));						
-						
-						// negative stiffness indicates tether (unilateral constraint)
-						cloth.mConstraintCoefficients.push_back(-tetherStiffness);
-					}
-				}
+				cloth.mConstraintIndices.push_back(t.particle);
+				cloth.mConstraintIndices.push_back(t.anchor);
+				cloth.mConstraintRestLengths.push_back(t.restLength*(1.0f + tetherGive));
+
+				// negative stiffness indicates tether (unilateral constraint)
+				cloth.mConstraintCoefficients.push_back(-stiffness);
 			}
 		}
 
@@ -185,18 +192,96 @@ NvFlexExtAsset* NvFlexExtCreateClothFromMesh(const float* particles, int numVert
 		return NULL;
 	}
 
+	NvFlexExtStoreCachedAsset(key, asset);
+
 	return asset;
 }
 
 struct FlexExtTearingClothAsset : public NvFlexExtAsset
 {
 	ClothMesh* mMesh;
+
+	// springs found over the strain threshold in the last call, in spring order
+	std::vector<int> mCandidates;
+
+	NvFlexExtTearingStats mStats;
 };
 
+namespace
+{
+	// appends springs in [begin, end) whose strain may exceed maxStrain, the test is conservative
+	// and candidates are confirmed with the exact test before splitting
+	void FindStrainedSprings(const FlexExtTearingClothAsset* asset, float maxStrain, int begin, int end, std::vector<int>& candidates)
+	{
+		const Vec4* particles = (const Vec4*)asset->particles;
+		const int* indices = asset->springIndices;
+		const float* restLengths = asset->springRestLengths;
+
+		// slightly lower threshold so rounding differences never drop a candidate
+		const float scale = maxStrain*maxStrain*0.999f;
+
+		int i = begin;
+
+#if defined(__AVX2__)
+
+		const __m256i stride = _mm256_set1_epi32(4);
+		const __m256 scaleSq = _mm256_set1_ps(scale);
+		const float* base = asset->particles;
+
+		for (; i + 8 <= end; i += 8)
+		{
+			// deinterleave spring endpoints and convert to float offsets
+			const __m256i pair0 = _mm256_loadu_si256((const __m256i*)(indices + i*2));
+			const __m256i pair1 = _mm256_loadu_si256((const __m256i*)(indices + i*2 + 8));
+
+			const __m256i perm = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+			const __m256i p0 = _mm256_permutevar8x32_epi32(pair0, perm);
+			const __m256i p1 = _mm256_permutevar8x32_epi32(pair1, perm);
+
+			const __m256i a = _mm256_mullo_epi32(_mm256_permute2x128_si256(p0, p1, 0x20), stride);
+			const __m256i b = _mm256_mullo_epi32(_mm256_permute2x128_si256(p0, p1, 0x31), stride);
+
+			const __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(base + 0, a, 4), _mm256_i32gather_ps(base + 0, b, 4));
+			const __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(base + 1, a, 4), _mm256_i32gather_ps(base + 1, b, 4));
+			const __m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(base + 2, a, 4), _mm256_i32gather_ps(base + 2, b, 4));
+
+			const __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+			const __m256 rest = _mm256_loadu_ps(restLengths + i);
+			const __m256 limitSq = _mm256_mul_ps(_mm256_mul_ps(rest, rest), scaleSq);
+
+			const int mask = _mm256_movemask_ps(_mm256_cmp_ps(lengthSq, limitSq, _CMP_GT_OQ));
+
+			// lanes in order, a plain loop keeps this portable to compilers without a count trailing zeros builtin
+			for (int lane=0; mask && lane < 8; ++lane)
+			{
+				if (mask & (1<<lane))
+					candidates.push_back(i + lane);
+			}
+		}
+
+#endif
+
+		for (; i < end; ++i)
+		{
+			const Vec3 p = Vec3(particles[indices[i*2+0]]);
+			const Vec3 q = Vec3(particles[indices[i*2+1]]);
+
+			if (LengthSq(p-q) > restLengths[i]*restLengths[i]*scale)
+				candidates.push_back(i);
+		}
+	}
+
+	float SecondsSince(const std::chrono::high_resolution_clock::time_point& start)
+	{
+		return std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
 NvFlexExtAsset* NvFlexExtCreateTearingClothFromMesh(const float* particles, int numParticles, int maxParticles, const int* indices, int numTriangles, float stretchStiffness, float bendStiffness, float pressure)
 {
+	// value-initialized, zeroes the base asset and mMesh/mStats without touching mCandidates
 	FlexExtTearingClothAsset* asset = new FlexExtTearingClothAsset();
-	memset(asset, 0, sizeof(*asset));
 
 	asset->particles = new float[maxParticles*4];
 	memcpy(asset->particles, particles, numParticles*sizeof(float)*4);	
@@ -242,6 +327,11 @@ NvFlexExtAsset* NvFlexExtCreateTearingClothFromMesh(const float* particles, int
 
 }
 
+void NvFlexExtGetTearingStats(NvFlexExtAsset* asset, NvFlexExtTearingStats* stats)
+{
+	*stats = ((FlexExtTearingClothAsset*)asset)->mStats;
+}
+
 void NvFlexExtDestroyTearingCloth(NvFlexExtAsset* asset)
 {
 	FlexExtTearingClothAsset* tearable = (FlexExtTearingClothAsset*)asset;
@@ -264,55 +354,113 @@ void NvFlexExtTearClothMesh(NvFlexExtAsset* asset, float maxStrain, int maxSplit
 
 	maxCopies = Min(maxCopies, tearable->maxParticles-tearable->numParticles);
 
-	// iterate over all edges and tear if beyond maximum strain
-	for (int i=0; i < tearable->numSprings && int(copies.size()) < maxCopies && splits < maxSplits; ++i)
+	tearable->mCandidates.resize(0);
+	tearable->mStats.strainTime = 0.0f;
+	tearable->mStats.splitTime = 0.0f;
+
+	// particles created by splits this call have no valid position until the caller copies them
+	const int firstNewParticle = tearable->mMesh->mNumVertices;
+
+	// springs are processed in waves of one block per thread, strain is evaluated for a wave in parallel 
+	// then its candidates are split in spring order, so scanning stops as soon as the split budget is used
+	const int kBlockSize = 4096;
+	const int numThreads = GetParallelThreadCount();
+
+	std::vector<std::vector<int> > blockCandidates(numThreads);
+
+	for (int scanned=0; scanned < tearable->numSprings && int(copies.size()) < maxCopies && splits < maxSplits; )
 	{
-		int a = tearable->springIndices[i*2+0];
-		int b = tearable->springIndices[i*2+1];
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
 
-		Vec3 p = Vec3(&tearable->particles[a*4]);
-		Vec3 q = Vec3(&tearable->particles[b*4]);
+		const int waveStart = scanned;
+		const int numBlocks = Min(numThreads, (tearable->numSprings - waveStart + kBlockSize - 1)/kBlockSize);
 
-		// check strain and break if greater than max threshold
-		if (Length(p-q) > tearable->springRestLengths[i]*maxStrain)
+		ParallelFor(numBlocks, [&](int begin, int end)
 		{
-			// skip fixed particles
-			if (Vec4(&tearable->particles[a*4]).w == 0.0f)
-				continue;
+			for (int b=begin; b < end; ++b)
+			{
+				blockCandidates[b].resize(0);
 
-			if (Vec4(&tearable->particles[b*4]).w == 0.0f)
-				continue;
+				const int blockStart = waveStart + b*kBlockSize;
+				FindStrainedSprings(tearable, maxStrain, blockStart, Min(blockStart + kBlockSize, tearable->numSprings), blockCandidates[b]);
+			}
+		}, 1);
+
+		scanned = Min(waveStart + numBlocks*kBlockSize, tearable->numSprings);
+
+		// blocks are concatenated so candidates stay in spring order
+		const int firstCandidate = int(tearable->mCandidates.size());
 
-			// choose vertex of edge to split
-			const int splitIndex = Randf() > 0.5f ? a : b;
-			const Vec3 splitPlane = Normalize(p-q);	// todo: use plane perpendicular to normal and edge..
+		for (int b=0; b < numBlocks; ++b)
+			tearable->mCandidates.insert(tearable->mCandidates.end(), blockCandidates[b].begin(), blockCandidates[b].end());
 
-			std::vector<int> adjacentTriangles;
-			std::vector<int> adjacentVertices;
+		tearable->mStats.strainTime += SecondsSince(start);
+
+		start = std::chrono::high_resolution_clock::now();
+
+		// splits are applied serially since each one appends edges, constraints and particles
+		for (int c=firstCandidate; c < int(tearable->mCandidates.size()) && int(copies.size()) < maxCopies && splits < maxSplits; ++c)
+		{
+			const int i = tearable->mCandidates[c];
 
-			const int newIndex = tearable->mMesh->SplitVertex((Vec4*)tearable->particles, splitIndex, splitPlane, adjacentTriangles, adjacentVertices, edits, copies, maxCopies-int(copies.size()));
+			int a = tearable->springIndices[i*2+0];
+			int b = tearable->springIndices[i*2+1];
 
-			if (newIndex != -1)
+			// spring was remapped onto a new particle by an earlier split
+			if (a >= firstNewParticle || b >= firstNewParticle)
+				continue;
+
+			Vec3 p = Vec3(&tearable->particles[a*4]);
+			Vec3 q = Vec3(&tearable->particles[b*4]);
+
+			// check strain and break if greater than max threshold
+			if (Length(p-q) > tearable->springRestLengths[i]*maxStrain)
 			{
-				++splits;
+				// skip fixed particles
+				if (Vec4(&tearable->particles[a*4]).w == 0.0f)
+					continue;
+
+				if (Vec4(&tearable->particles[b*4]).w == 0.0f)
+					continue;
+
+				// choose vertex of edge to split
+				const int splitIndex = Randf() > 0.5f ? a : b;
+				const Vec3 splitPlane = Normalize(p-q);	// todo: use plane perpendicular to normal and edge..
 
-				// separate each adjacent vertex if it is now singular
-				for (int s=0; s < int(adjacentVertices.size()); ++s)
+				std::vector<int> adjacentTriangles;
+				std::vector<int> adjacentVertices;
+
+				const int newIndex = tearable->mMesh->SplitVertex((Vec4*)tearable->particles, splitIndex, splitPlane, adjacentTriangles, adjacentVertices, edits, copies, maxCopies-int(copies.size()));
+
+				if (newIndex != -1)
 				{
-					const int adjacentVertex = adjacentVertices[s];
+					++splits;
 
-					tearable->mMesh->SeparateVertex(adjacentVertex, edits, copies, maxCopies-int(copies.size()));
-				}
+					// separate each adjacent vertex if it is now singular
+					for (int s=0; s < int(adjacentVertices.size()); ++s)
+					{
+						const int adjacentVertex = adjacentVertices[s];
+
+						tearable->mMesh->SeparateVertex(adjacentVertex, edits, copies, maxCopies-int(copies.size()));
+					}
 
-				// also test the new vertex which can become singular
-				tearable->mMesh->SeparateVertex(newIndex, edits, copies, maxCopies-int(copies.size()));
+					// also test the new vertex which can become singular
+					tearable->mMesh->SeparateVertex(newIndex, edits, copies, maxCopies-int(copies.size()));
+				}
 			}
 		}
+
+		tearable->mStats.splitTime += SecondsSince(start);
 	}
 
+	tearable->mStats.numCandidates = int(tearable->mCandidates.size());
+
 	// update asset particle count
 	tearable->numParticles = tearable->mMesh->mNumVertices;
 
+	tearable->mStats.numSplits = splits;
+	tearable->mStats.numParticleCopies = int(copies.size());
+
 	// output copies
 	for (int c=0; c < int(copies.size()); ++c)
 	{
@@ -29,8 +29,13 @@
 #include <limits>
 #include <algorithm>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "../core/core.h"
 #include "../core/maths.h"
+#include "../core/parallel.h"
 
 #include "../include/NvFlex.h"
 #include "../include/NvFlexExt.h"
@@ -43,10 +48,15 @@ public:
 
 	static const int kWordSize = sizeof(Word)*8;
 
-	Bitmap(int numBits) : mBits((numBits+kWordSize-1)/kWordSize)
+	Bitmap(int numBits=0) : mBits((numBits+kWordSize-1)/kWordSize)
 	{
 	}
 
+	void Resize(int numBits)
+	{
+		mBits.assign((numBits+kWordSize-1)/kWordSize, 0);
+	}
+
 	inline void Set(int bit)
 	{
 		const int wordIndex = bit/kWordSize;
@@ -54,7 +64,7 @@ public:
 
 		const Word word = mBits[wordIndex];
 
-		mBits[wordIndex] = word|(1<<bitIndex);
+		mBits[wordIndex] = word|(Word(1)<<bitIndex);
 	}
 
 	inline void Reset(int bit)
@@ -64,7 +74,7 @@ public:
 
 		const Word word = mBits[wordIndex];
 
-		mBits[wordIndex] = word&~(1<<bitIndex);
+		mBits[wordIndex] = word&~(Word(1)<<bitIndex);
 	}
 
 	inline bool IsSet(int bit)
@@ -74,7 +84,7 @@ public:
 
 		const Word word = mBits[wordIndex];
 
-		return (word & (1<<bitIndex)) != 0;
+		return (word & (Word(1)<<bitIndex)) != 0;
 	}
 
 private:
@@ -83,6 +93,16 @@ private:
 };
 
 
+// a range of a container's constraint array, shape ranges also own a contiguous range of shape indices
+struct ConstraintRange
+{
+	int start;
+	int count;
+
+	int indexStart;
+	int indexCount;
+};
+
 struct NvFlexExtContainer
 {
 	int mMaxParticles;
@@ -93,7 +113,22 @@ struct NvFlexExtContainer
 	// first n indices 
 	NvFlexVector<int> mActiveList;
 	
+	// free slots as a stack, it starts (and is reset by compaction) with the lowest index on top, 
+	// freed slots are pushed unsorted and are the first to be reused
 	std::vector<int> mFreeList;
+
+	// last slot, never allocated or active, constraints of removed instances are pointed at it 
+	// so they don't add to the constraint counts of particles that reuse the freed slots
+	int mInertParticle;
+
+	// allocated slots, and slots present in the sorted active list
+	Bitmap mLive;
+	Bitmap mListed;
+
+	// sorted active list and slots allocated since it was last updated
+	std::vector<int> mActiveIndices;
+	std::vector<int> mAllocatedIndices;
+
 	std::vector<NvFlexExtInstance*> mInstances;
 
 	// particles
@@ -132,14 +167,32 @@ struct NvFlexExtContainer
 	NvFlexVector<Vec3> mBoundsLower;
 	NvFlexVector<Vec3> mBoundsUpper;
 
-	// needs compact
+	// free ranges in increasing order, constraints in free ranges are inert (zero stiffness or degenerate)
+	std::vector<ConstraintRange> mFreeSprings;
+	std::vector<ConstraintRange> mFreeTriangles;
+	std::vector<ConstraintRange> mFreeShapes;
+
+	// ranges of removed instances that still have to be made inert
+	std::vector<ConstraintRange> mDeadSprings;
+	std::vector<ConstraintRange> mDeadTriangles;
+	std::vector<ConstraintRange> mDeadShapes;
+
+	// instances whose constraints still have to be written
+	std::vector<NvFlexExtInstance*> mPendingInstances;
+
+	// fraction of inert constraints above which all constraints are repacked
+	float mDefragmentThreshold;
+
+	bool mPlasticDeformation;
+
+	// constraints changed since the last push
 	bool mNeedsCompact;
 	// needs to update active list
 	bool mNeedsActiveListRebuild;
 
 	NvFlexExtContainer(NvFlexLibrary* l) :
 		mMaxParticles(0), mSolver(NULL), mFlexLib(l),
-		mActiveList(l),mParticles(l),mParticlesRest(l),mVelocities(l),
+		mActiveList(l),mInertParticle(-1),mParticles(l),mParticlesRest(l),mVelocities(l),
 		mPhases(l),mNormals(l),mShapeOffsets(l),mShapeIndices(l),
 		mShapeCoefficients(l),mShapePlasticThresholds(l),
 		mShapePlasticCreeps(l),mShapeRotations(l),mShapeTranslations(l),
@@ -147,7 +200,7 @@ struct NvFlexExtContainer
 		mSpringCoefficients(l),mTriangleIndices(l),mTriangleNormals(l),
 		mInflatableStarts(l),mInflatableCounts(l),mInflatableRestVolumes(l),
 		mInflatableCoefficients(l),mInflatableOverPressures(l), mBoundsLower(l), mBoundsUpper(l),
-		mNeedsCompact(false), mNeedsActiveListRebuild(false)
+		mDefragmentThreshold(0.5f), mPlasticDeformation(false), mNeedsCompact(false), mNeedsActiveListRebuild(false)
 	{}
 };
 
@@ -156,41 +209,100 @@ struct NvFlexExtContainer
 namespace
 {
 
-// compacts all constraints into linear arrays
-void CompactObjects(NvFlexExtContainer* c)
+// instance with the sizes of the ranges it owns in the container, the starts are 
+// springStart, triangleIndex, shapeIndex and shapeIndexStart
+struct FlexExtInstance : public NvFlexExtInstance
+{
+	int springStart;
+	int numSprings;
+	int numTriangles;
+	int numShapes;
+	int shapeIndexStart;
+	int numShapeIndices;
+
+	// constraints have been written to the container
+	bool placed;
+};
+
+// returns a range to a free list, merging it with its neighbors
+void ReleaseRange(std::vector<ConstraintRange>& freeRanges, const ConstraintRange& range)
 {
-	int totalNumSprings = 0;
-	int totalNumTris = 0;
-	int totalNumShapes = 0;
-	int totalNumShapeIndices = 0;
+	if (range.count == 0)
+		return;
+
+	size_t i = 0;
+	while (i < freeRanges.size() && freeRanges[i].start < range.start)
+		++i;
 
-	bool plasticDeformation = false;
+	freeRanges.insert(freeRanges.begin() + i, range);
 
-	// pre-calculate array sizes
-	for (size_t i = 0; i < c->mInstances.size(); ++i)
+	// merge with next
+	if (i+1 < freeRanges.size() && range.start + range.count == freeRanges[i+1].start)
 	{
-		NvFlexExtInstance* inst = c->mInstances[i];
+		freeRanges[i].count += freeRanges[i+1].count;
+		freeRanges[i].indexCount += freeRanges[i+1].indexCount;
+		freeRanges.erase(freeRanges.begin() + i + 1);
+	}
 
-		const NvFlexExtAsset* asset = inst->asset;
+	// merge with previous
+	if (i > 0 && freeRanges[i-1].start + freeRanges[i-1].count == range.start)
+	{
+		freeRanges[i-1].count += freeRanges[i].count;
+		freeRanges[i-1].indexCount += freeRanges[i].indexCount;
+		freeRanges.erase(freeRanges.begin() + i);
+	}
+}
+
+// takes the front of the first free range that fits, shape ranges must leave at least one 
+// index per remaining free shape so the inert shapes stay valid
+bool AllocateRange(std::vector<ConstraintRange>& freeRanges, int count, int indexCount, bool shapes, ConstraintRange& range)
+{
+	for (size_t i=0; i < freeRanges.size(); ++i)
+	{
+		ConstraintRange& r = freeRanges[i];
 
-		// index into the triangle array for this instance
-		inst->triangleIndex = totalNumTris;
+		const int remaining = r.count - count;
+		const int remainingIndices = r.indexCount - indexCount;
 
-		totalNumSprings += asset->numSprings;
-		totalNumTris += asset->numTriangles;
+		bool fits;
+		if (shapes)
+			fits = (remaining == 0 && remainingIndices == 0) || (remaining > 0 && remainingIndices >= remaining);
+		else
+			fits = remaining >= 0;
 
-		totalNumShapeIndices += asset->numShapeIndices;
-		totalNumShapes += asset->numShapes;
+		if (fits)
+		{
+			range.start = r.start;
+			range.count = count;
+			range.indexStart = r.indexStart;
+			range.indexCount = indexCount;
+
+			r.start += count;
+			r.count -= count;
+			r.indexStart += indexCount;
+			r.indexCount -= indexCount;
+
+			if (r.count == 0)
+				freeRanges.erase(freeRanges.begin() + i);
 
-		if (asset->shapePlasticThresholds && asset->shapePlasticCreeps)
-		{ 
-			plasticDeformation = true;
+			return true;
 		}
 	}
 
-	//----------------------
-	// map buffers
+	return false;
+}
+
+int CountFree(const std::vector<ConstraintRange>& freeRanges)
+{
+	int count = 0;
+	for (size_t i=0; i < freeRanges.size(); ++i)
+		count += freeRanges[i].count;
+
+	return count;
+}
 
+void MapConstraints(NvFlexExtContainer* c)
+{
 	// springs
 	c->mSpringIndices.map();
 	c->mSpringLengths.map();
@@ -218,209 +330,450 @@ void CompactObjects(NvFlexExtContainer* c)
 
 	c->mShapeTranslations.map();
 	c->mShapeRotations.map();
+}
 
-	//----------------------
-	// resize buffers
-
+void UnmapConstraints(NvFlexExtContainer* c)
+{
 	// springs
-	c->mSpringIndices.resize(totalNumSprings * 2);
-	c->mSpringLengths.resize(totalNumSprings);
-	c->mSpringCoefficients.resize(totalNumSprings);
+	c->mSpringIndices.unmap();
+	c->mSpringLengths.unmap();
+	c->mSpringCoefficients.unmap();
 
 	// cloth
-	c->mTriangleIndices.resize(totalNumTris * 3);
-	c->mTriangleNormals.resize(totalNumTris);
+	c->mTriangleIndices.unmap();
+	c->mTriangleNormals.unmap();
 
 	// inflatables
-	c->mInflatableStarts.resize(0);
-	c->mInflatableCounts.resize(0);
-	c->mInflatableRestVolumes.resize(0);
-	c->mInflatableCoefficients.resize(0);
-	c->mInflatableOverPressures.resize(0);
+	c->mInflatableStarts.unmap();
+	c->mInflatableCounts.unmap();
+	c->mInflatableRestVolumes.unmap();
+	c->mInflatableCoefficients.unmap();
+	c->mInflatableOverPressures.unmap();
 
 	// shapes
-	c->mShapeIndices.resize(totalNumShapeIndices);
-	c->mShapeRestPositions.resize(totalNumShapeIndices);
-	c->mShapeOffsets.resize(1 + totalNumShapes);
-	c->mShapeCoefficients.resize(totalNumShapes);
+	c->mShapeIndices.unmap();
+	c->mShapeRestPositions.unmap();
+	c->mShapeOffsets.unmap();
+	c->mShapeCoefficients.unmap();
 
-	if (plasticDeformation) 
-	{
-		c->mShapePlasticThresholds.resize(totalNumShapes);
-		c->mShapePlasticCreeps.resize(totalNumShapes);
-	}
-	else
+	c->mShapePlasticThresholds.unmap();
+	c->mShapePlasticCreeps.unmap();
+
+	c->mShapeTranslations.unmap();
+	c->mShapeRotations.unmap();
+}
+
+// frees an instance's ranges, the constraints are made inert on the next push
+void ReleaseInstance(NvFlexExtContainer* c, FlexExtInstance* inst)
+{
+	if (!inst->placed)
 	{
-		c->mShapePlasticThresholds.resize(0);
-		c->mShapePlasticCreeps.resize(0);
+		std::vector<NvFlexExtInstance*>::iterator iter = std::find(c->mPendingInstances.begin(), c->mPendingInstances.end(), inst);
+		if (iter != c->mPendingInstances.end())
+			c->mPendingInstances.erase(iter);
+
+		return;
 	}
 
-	c->mShapeTranslations.resize(totalNumShapes);
-	c->mShapeRotations.resize(totalNumShapes);
+	const ConstraintRange springs = { inst->springStart, inst->numSprings, 0, 0 };
+	const ConstraintRange triangles = { inst->triangleIndex, inst->numTriangles, 0, 0 };
+	const ConstraintRange shapes = { inst->shapeIndex, inst->numShapes, inst->shapeIndexStart, inst->numShapeIndices };
+
+	ReleaseRange(c->mFreeSprings, springs);
+	ReleaseRange(c->mFreeTriangles, triangles);
+	ReleaseRange(c->mFreeShapes, shapes);
+
+	if (springs.count)
+		c->mDeadSprings.push_back(springs);
+	if (triangles.count)
+		c->mDeadTriangles.push_back(triangles);
+	if (shapes.count)
+		c->mDeadShapes.push_back(shapes);
+
+	inst->placed = false;
+	inst->triangleIndex = -1;
+	inst->shapeIndex = -1;
+}
 
-	int* __restrict dstSpringIndices = (totalNumSprings) ? &c->mSpringIndices[0] : NULL;
-	float* __restrict dstSpringLengths = (totalNumSprings) ? &c->mSpringLengths[0] : NULL;
-	float* __restrict dstSpringCoefficients = (totalNumSprings) ? &c->mSpringCoefficients[0] : NULL;
+// makes the constraints of released ranges inert, they only reference the reserved inert slot
+void ClearDeadRanges(NvFlexExtContainer* c)
+{
+	const int inert = c->mInertParticle;
+
+	// springs with zero stiffness
+	for (size_t i=0; i < c->mDeadSprings.size(); ++i)
+	{
+		const ConstraintRange& r = c->mDeadSprings[i];
 
-	int* __restrict dstTriangleIndices = (totalNumTris) ? &c->mTriangleIndices[0] : NULL;
+		for (int s=r.start; s < r.start + r.count; ++s)
+		{
+			c->mSpringIndices[s*2+0] = inert;
+			c->mSpringIndices[s*2+1] = inert;
+			c->mSpringCoefficients[s] = 0.0f;
+		}
+	}
 
-	int* __restrict dstShapeIndices = (totalNumShapeIndices) ? &c->mShapeIndices[0] : NULL;
-	Vec3* __restrict dstShapeRestPositions = (totalNumShapeIndices) ? &c->mShapeRestPositions[0] : NULL;
-	int* __restrict dstShapeOffsets = (totalNumShapes) ? &c->mShapeOffsets[0] : NULL;
-	float* __restrict dstShapeCoefficients = (totalNumShapes) ? &c->mShapeCoefficients[0] : NULL;
-	float* __restrict dstShapePlasticThresholds = NULL;
-	float* __restrict dstShapePlasticCreeps = NULL;
-	if (plasticDeformation)
+	// degenerate triangles
+	for (size_t i=0; i < c->mDeadTriangles.size(); ++i)
 	{
-		dstShapePlasticThresholds = (totalNumShapes) ? &c->mShapePlasticThresholds[0] : NULL;
-		dstShapePlasticCreeps = (totalNumShapes) ? &c->mShapePlasticCreeps[0] : NULL;
+		const ConstraintRange& r = c->mDeadTriangles[i];
+
+		for (int t=r.start; t < r.start + r.count; ++t)
+		{
+			c->mTriangleIndices[t*3+0] = inert;
+			c->mTriangleIndices[t*3+1] = inert;
+			c->mTriangleIndices[t*3+2] = inert;
+		}
 	}
-	Vec3* __restrict dstShapeTranslations = (totalNumShapes) ? &c->mShapeTranslations[0] : NULL;
-	Quat* __restrict dstShapeRotations = (totalNumShapes) ? &c->mShapeRotations[0] : NULL;
 
-	// push leading zero if necessary
-	if (totalNumShapes != 0)
+	// shapes with zero stiffness, their offsets are kept so the layout stays valid
+	for (size_t i=0; i < c->mDeadShapes.size(); ++i)
 	{
-		*dstShapeOffsets = 0;
-		++dstShapeOffsets;
+		const ConstraintRange& r = c->mDeadShapes[i];
+
+		for (int s=r.indexStart; s < r.indexStart + r.indexCount; ++s)
+			c->mShapeIndices[s] = inert;
+
+		for (int s=r.start; s < r.start + r.count; ++s)
+		{
+			c->mShapeCoefficients[s] = 0.0f;
+
+			if (c->mPlasticDeformation)
+			{
+				c->mShapePlasticThresholds[s] = 0.0f;
+				c->mShapePlasticCreeps[s] = 0.0f;
+			}
+		}
 	}
 
-	int shapeIndexOffset = 0;
-	int shapeIndex = 0;
+	c->mDeadSprings.resize(0);
+	c->mDeadTriangles.resize(0);
+	c->mDeadShapes.resize(0);
+}
 
-	// go through each instance and update springs, shapes, etc
-	for (size_t i = 0; i < c->mInstances.size(); ++i)
+// drops free ranges at the end of the constraint arrays
+void TrimFreeRanges(NvFlexExtContainer* c)
+{
+	if (c->mFreeSprings.size())
 	{
-		NvFlexExtInstance* inst = c->mInstances[i];
+		const ConstraintRange& r = c->mFreeSprings.back();
 
-		const NvFlexExtAsset* asset = inst->asset;
+		if (r.start + r.count == c->mSpringCoefficients.size())
+		{
+			c->mSpringIndices.resize(r.start*2);
+			c->mSpringLengths.resize(r.start);
+			c->mSpringCoefficients.resize(r.start);
 
-		// map indices from the asset to the instance
-		const int* __restrict remap = &inst->particleIndices[0];
+			c->mFreeSprings.pop_back();
+		}
+	}
 
-		// flatten spring data
-		int numSprings = asset->numSprings;
-		const int numSpringIndices = asset->numSprings * 2;
-		const int* __restrict srcSpringIndices = asset->springIndices;
+	if (c->mFreeTriangles.size())
+	{
+		const ConstraintRange& r = c->mFreeTriangles.back();
 
-		for (int i = 0; i < numSpringIndices; ++i)
+		if (r.start + r.count == c->mTriangleNormals.size())
 		{
-			*dstSpringIndices = remap[*srcSpringIndices];
+			c->mTriangleIndices.resize(r.start*3);
+			c->mTriangleNormals.resize(r.start);
 
-			++dstSpringIndices;
-			++srcSpringIndices;
+			c->mFreeTriangles.pop_back();
 		}
+	}
 
-		memcpy(dstSpringLengths, asset->springRestLengths, numSprings*sizeof(float));
-		memcpy(dstSpringCoefficients, asset->springCoefficients, numSprings*sizeof(float));
+	if (c->mFreeShapes.size())
+	{
+		const ConstraintRange& r = c->mFreeShapes.back();
 
-		dstSpringLengths += numSprings;
-		dstSpringCoefficients += numSprings;
+		if (r.start + r.count == c->mShapeCoefficients.size())
+		{
+			c->mShapeIndices.resize(r.indexStart);
+			c->mShapeRestPositions.resize(r.indexStart);
+			c->mShapeOffsets.resize(r.start + 1);
+			c->mShapeCoefficients.resize(r.start);
+			c->mShapeTranslations.resize(r.start);
+			c->mShapeRotations.resize(r.start);
+
+			if (c->mPlasticDeformation)
+			{
+				c->mShapePlasticThresholds.resize(r.start);
+				c->mShapePlasticCreeps.resize(r.start);
+			}
+
+			c->mFreeShapes.pop_back();
+		}
+	}
+}
+
+// writes an instance's constraints to free ranges or to the end of the constraint arrays
+void PlaceInstance(NvFlexExtContainer* c, FlexExtInstance* inst)
+{
+	const NvFlexExtAsset* asset = inst->asset;
+
+	// map indices from the asset to the instance
+	const int* __restrict remap = &inst->particleIndices[0];
+
+	inst->numSprings = asset->numSprings;
+	inst->numTriangles = asset->numTriangles;
+	inst->numShapes = asset->numShapes;
+	inst->numShapeIndices = asset->numShapeIndices;
 
-		// shapes
-		if (asset->numShapes)
+	ConstraintRange range;
+
+	// springs
+	if (!AllocateRange(c->mFreeSprings, inst->numSprings, 0, false, range))
+	{
+		range.start = c->mSpringCoefficients.size();
+
+		c->mSpringIndices.resize((range.start + inst->numSprings)*2);
+		c->mSpringLengths.resize(range.start + inst->numSprings);
+		c->mSpringCoefficients.resize(range.start + inst->numSprings);
+	}
+
+	inst->springStart = range.start;
+
+	for (int i=0; i < inst->numSprings; ++i)
+	{
+		c->mSpringIndices[(range.start + i)*2+0] = remap[asset->springIndices[i*2+0]];
+		c->mSpringIndices[(range.start + i)*2+1] = remap[asset->springIndices[i*2+1]];
+		c->mSpringLengths[range.start + i] = asset->springRestLengths[i];
+		c->mSpringCoefficients[range.start + i] = asset->springCoefficients[i];
+	}
+
+	// triangles
+	if (!AllocateRange(c->mFreeTriangles, inst->numTriangles, 0, false, range))
+	{
+		range.start = c->mTriangleNormals.size();
+
+		c->mTriangleIndices.resize((range.start + inst->numTriangles)*3);
+		c->mTriangleNormals.resize(range.start + inst->numTriangles);
+	}
+
+	// index into the triangle array for this instance
+	inst->triangleIndex = range.start;
+
+	for (int i=0; i < inst->numTriangles*3; ++i)
+		c->mTriangleIndices[range.start*3 + i] = remap[asset->triangleIndices[i]];
+
+	// shapes
+	inst->shapeIndex = -1;
+
+	if (inst->numShapes)
+	{
+		const int numShapes = inst->numShapes;
+		const int numShapeIndices = inst->numShapeIndices;
+
+		int freeEnd = -1;
+
+		if (AllocateRange(c->mFreeShapes, numShapes, numShapeIndices, true, range))
+		{
+			// end of the free range the instance was placed at the front of
+			freeEnd = range.start + numShapes;
+			for (size_t i=0; i < c->mFreeShapes.size(); ++i)
+				if (c->mFreeShapes[i].start == freeEnd)
+					freeEnd += c->mFreeShapes[i].count;
+		}
+		else
 		{
-			const int indexOffset = shapeIndexOffset;
+			range.start = c->mShapeCoefficients.size();
+			range.indexStart = c->mShapeIndices.size();
 
-			// store start index into shape array
-			inst->shapeIndex = shapeIndex;
+			c->mShapeIndices.resize(range.indexStart + numShapeIndices);
+			c->mShapeRestPositions.resize(range.indexStart + numShapeIndices);
+			c->mShapeOffsets.resize(range.start + numShapes + 1);
+			c->mShapeCoefficients.resize(range.start + numShapes);
+			c->mShapeTranslations.resize(range.start + numShapes);
+			c->mShapeRotations.resize(range.start + numShapes);
 
-			int shapeStart = 0;
+			if (c->mPlasticDeformation)
+			{
+				c->mShapePlasticThresholds.resize(range.start + numShapes);
+				c->mShapePlasticCreeps.resize(range.start + numShapes);
+			}
 
-			for (int s=0; s < asset->numShapes; ++s)
+			// leading zero
+			c->mShapeOffsets[0] = 0;
+		}
+
+		const bool plastic = asset->shapePlasticThresholds && asset->shapePlasticCreeps;
+
+		// plasticity is enabled for all shapes once any asset needs it
+		if (plastic && !c->mPlasticDeformation)
+		{
+			const int totalNumShapes = c->mShapeCoefficients.size();
+
+			c->mShapePlasticThresholds.resize(totalNumShapes);
+			c->mShapePlasticCreeps.resize(totalNumShapes);
+
+			for (int s=0; s < totalNumShapes; ++s)
 			{
-				dstShapeOffsets[shapeIndex] = asset->shapeOffsets[s] + indexOffset;
-				dstShapeCoefficients[shapeIndex]  = asset->shapeCoefficients[s];
-				if (plasticDeformation)
-				{
-					if (asset->shapePlasticThresholds)
-						dstShapePlasticThresholds[shapeIndex] = asset->shapePlasticThresholds[s];
-					else
-						dstShapePlasticThresholds[shapeIndex] = 0.0f;
-
-					if (asset->shapePlasticCreeps)
-						dstShapePlasticCreeps[shapeIndex]  = asset->shapePlasticCreeps[s];
-					else
-						dstShapePlasticCreeps[shapeIndex] = 0.0f;
-				}
-				dstShapeTranslations[shapeIndex]  = Vec3(&inst->shapeTranslations[s*3]);
-				dstShapeRotations[shapeIndex]  = Quat(&inst->shapeRotations[s*4]);
-
-				++shapeIndex;
-
-				const int shapeEnd = asset->shapeOffsets[s];
-
-				for (int i=shapeStart; i < shapeEnd; ++i)
-				{
-					const int currentParticle = asset->shapeIndices[i];
-
-					// remap indices and create local space positions for each shape
-					dstShapeRestPositions[shapeIndexOffset] = Vec3(&asset->particles[currentParticle*4]) - Vec3(&asset->shapeCenters[s*3]);
-					dstShapeIndices[shapeIndexOffset] = remap[asset->shapeIndices[i]];
-
-					++shapeIndexOffset;
-				}
-
-				shapeStart = shapeEnd;
-			}		
+				c->mShapePlasticThresholds[s] = 0.0f;
+				c->mShapePlasticCreeps[s] = 0.0f;
+			}
+
+			c->mPlasticDeformation = true;
 		}
 
-		if (asset->numTriangles)
+		// store start index into shape array
+		inst->shapeIndex = range.start;
+		inst->shapeIndexStart = range.indexStart;
+
+		int shapeStart = 0;
+
+		for (int s=0; s < numShapes; ++s)
 		{
-			// triangles
-			const int numTriIndices = asset->numTriangles * 3;
-			const int* __restrict srcTriIndices = asset->triangleIndices;
+			const int shape = range.start + s;
 
-			for (int i = 0; i < numTriIndices; ++i)
+			c->mShapeOffsets[shape + 1] = asset->shapeOffsets[s] + range.indexStart;
+			c->mShapeCoefficients[shape] = asset->shapeCoefficients[s];
+
+			if (c->mPlasticDeformation)
+			{
+				c->mShapePlasticThresholds[shape] = asset->shapePlasticThresholds ? asset->shapePlasticThresholds[s] : 0.0f;
+				c->mShapePlasticCreeps[shape] = asset->shapePlasticCreeps ? asset->shapePlasticCreeps[s] : 0.0f;
+			}
+
+			c->mShapeTranslations[shape] = Vec3(&inst->shapeTranslations[s*3]);
+			c->mShapeRotations[shape] = Quat(&inst->shapeRotations[s*4]);
+
+			const int shapeEnd = asset->shapeOffsets[s];
+
+			for (int i=shapeStart; i < shapeEnd; ++i)
 			{
-				*dstTriangleIndices = remap[*srcTriIndices];
+				const int currentParticle = asset->shapeIndices[i];
 
-				++dstTriangleIndices;
-				++srcTriIndices;
+				// remap indices and create local space positions for each shape
+				c->mShapeRestPositions[range.indexStart + i] = Vec3(&asset->particles[currentParticle*4]) - Vec3(&asset->shapeCenters[s*3]);
+				c->mShapeIndices[range.indexStart + i] = remap[currentParticle];
 			}
 
-			if (asset->inflatable)
+			shapeStart = shapeEnd;
+		}
+
+		// inert shapes left at the front of the free range may now end before they begin, 
+		// give them one index each until the old layout is valid again
+		if (freeEnd != -1)
+		{
+			int begin = range.indexStart + numShapeIndices;
+
+			for (int s=range.start + numShapes; s < freeEnd; ++s)
 			{
-				c->mInflatableStarts.push_back(inst->triangleIndex);
-				c->mInflatableCounts.push_back(asset->numTriangles);
-				c->mInflatableRestVolumes.push_back(asset->inflatableVolume);
-				c->mInflatableCoefficients.push_back(asset->inflatableStiffness);
-				c->mInflatableOverPressures.push_back(asset->inflatablePressure);
+				if (c->mShapeOffsets[s + 1] > begin)
+					break;
+
+				c->mShapeOffsets[s + 1] = ++begin;
 			}
 		}
 	}
 
+	inst->placed = true;
+}
 
-	//----------------------
-	// unmap buffers
+// repacks all instances' constraints contiguously
+void Defragment(NvFlexExtContainer* c)
+{
+	// keep the current pose of placed shapes
+	for (size_t i=0; i < c->mInstances.size(); ++i)
+	{
+		FlexExtInstance* inst = (FlexExtInstance*)c->mInstances[i];
 
-	// springs
-	c->mSpringIndices.unmap();
-	c->mSpringLengths.unmap();
-	c->mSpringCoefficients.unmap();
+		if (!inst->placed || inst->shapeIndex == -1)
+			continue;
 
-	// cloth
-	c->mTriangleIndices.unmap();
-	c->mTriangleNormals.unmap();
+		for (int s=0; s < inst->numShapes; ++s)
+		{
+			((Vec3*)inst->shapeTranslations)[s] = c->mShapeTranslations[inst->shapeIndex + s];
+			((Quat*)inst->shapeRotations)[s] = c->mShapeRotations[inst->shapeIndex + s];
+		}
+	}
 
-	// inflatables
-	c->mInflatableStarts.unmap();
-	c->mInflatableCounts.unmap();
-	c->mInflatableRestVolumes.unmap();
-	c->mInflatableCoefficients.unmap();
-	c->mInflatableOverPressures.unmap();
+	c->mSpringIndices.resize(0);
+	c->mSpringLengths.resize(0);
+	c->mSpringCoefficients.resize(0);
 
-	// shapes
-	c->mShapeIndices.unmap();
-	c->mShapeRestPositions.unmap();
-	c->mShapeOffsets.unmap();
-	c->mShapeCoefficients.unmap();
+	c->mTriangleIndices.resize(0);
+	c->mTriangleNormals.resize(0);
 
-	c->mShapePlasticThresholds.unmap();
-	c->mShapePlasticCreeps.unmap();
+	c->mShapeIndices.resize(0);
+	c->mShapeRestPositions.resize(0);
+	c->mShapeOffsets.resize(1);
+	c->mShapeOffsets[0] = 0;
+	c->mShapeCoefficients.resize(0);
+	c->mShapePlasticThresholds.resize(0);
+	c->mShapePlasticCreeps.resize(0);
+	c->mShapeTranslations.resize(0);
+	c->mShapeRotations.resize(0);
 
-	c->mShapeTranslations.unmap();
-	c->mShapeRotations.unmap();
+	c->mFreeSprings.resize(0);
+	c->mFreeTriangles.resize(0);
+	c->mFreeShapes.resize(0);
+
+	c->mDeadSprings.resize(0);
+	c->mDeadTriangles.resize(0);
+	c->mDeadShapes.resize(0);
+
+	c->mPlasticDeformation = false;
+
+	for (size_t i=0; i < c->mInstances.size(); ++i)
+		PlaceInstance(c, (FlexExtInstance*)c->mInstances[i]);
+
+	c->mPendingInstances.resize(0);
+}
+
+// writes the constraints of new and changed instances and makes those of removed instances inert, 
+// only the ranges of affected instances are rewritten unless too much of the storage is inert
+void UpdateObjects(NvFlexExtContainer* c)
+{
+	MapConstraints(c);
+
+	if (c->mShapeOffsets.size() == 0)
+	{
+		c->mShapeOffsets.resize(1);
+		c->mShapeOffsets[0] = 0;
+	}
+
+	ClearDeadRanges(c);
+	TrimFreeRanges(c);
+
+	for (size_t i=0; i < c->mPendingInstances.size(); ++i)
+		PlaceInstance(c, (FlexExtInstance*)c->mPendingInstances[i]);
+
+	c->mPendingInstances.resize(0);
+
+	const int numInertSprings = CountFree(c->mFreeSprings);
+	const int numInertTriangles = CountFree(c->mFreeTriangles);
+	const int numInertShapes = CountFree(c->mFreeShapes);
+
+	if (numInertSprings > c->mDefragmentThreshold*c->mSpringCoefficients.size() ||
+		numInertTriangles > c->mDefragmentThreshold*c->mTriangleNormals.size() ||
+		numInertShapes > c->mDefragmentThreshold*c->mShapeCoefficients.size())
+	{
+		Defragment(c);
+	}
+
+	// inflatables are rebuilt, there is at most one per instance
+	c->mInflatableStarts.resize(0);
+	c->mInflatableCounts.resize(0);
+	c->mInflatableRestVolumes.resize(0);
+	c->mInflatableCoefficients.resize(0);
+	c->mInflatableOverPressures.resize(0);
+
+	for (size_t i=0; i < c->mInstances.size(); ++i)
+	{
+		const NvFlexExtInstance* inst = c->mInstances[i];
+		const NvFlexExtAsset* asset = inst->asset;
+
+		if (asset->numTriangles && asset->inflatable)
+		{
+			c->mInflatableStarts.push_back(inst->triangleIndex);
+			c->mInflatableCounts.push_back(asset->numTriangles);
+			c->mInflatableRestVolumes.push_back(asset->inflatableVolume);
+			c->mInflatableCoefficients.push_back(asset->inflatableStiffness);
+			c->mInflatableOverPressures.push_back(asset->inflatablePressure);
+		}
+	}
+
+	UnmapConstraints(c);
 
 	// ----------------------
 	// Flex update
@@ -434,13 +787,10 @@ void CompactObjects(NvFlexExtContainer* c)
 	// shapes
 	if (c->mShapeCoefficients.size())
 	{
-		NvFlexSetRigids(c->mSolver, c->mShapeOffsets.buffer, c->mShapeIndices.buffer, c->mShapeRestPositions.buffer, NULL, c->mShapeCoefficients.buffer, c->mShapePlasticThresholds.buffer, c->mShapePlasticCreeps.buffer, c->mShapeRotations.buffer, c->mShapeTranslations.buffer, int(c->mShapeCoefficients.size()), c->mShapeIndices.size());
+		NvFlexSetRigids(c->mSolver, c->mShapeOffsets.buffer, c->mShapeIndices.buffer, c->mShapeRestPositions.buffer, NULL, c->mShapeCoefficients.buffer, c->mPlasticDeformation ? c->mShapePlasticThresholds.buffer : NULL, c->mPlasticDeformation ? c->mShapePlasticCreeps.buffer : NULL, c->mShapeRotations.buffer, c->mShapeTranslations.buffer, int(c->mShapeCoefficients.size()), c->mShapeIndices.size());
 	}
 	else
 	{
-		c->mShapeRotations.resize(0);
-		c->mShapeTranslations.resize(0);
-
 		NvFlexSetRigids(c->mSolver, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0);		
 	}
 
@@ -457,7 +807,6 @@ void CompactObjects(NvFlexExtContainer* c)
 		NvFlexSetInflatables(c->mSolver, NULL, NULL, NULL, NULL, NULL, 0);
 
 	c->mNeedsCompact = false;
-
 }
 
 } // anonymous namespace
@@ -470,11 +819,15 @@ NvFlexExtContainer* NvFlexExtCreateContainer(NvFlexLibrary* flexLib, NvFlexSolve
 	c->mSolver = solver;
 	c->mFlexLib = flexLib;
 	c->mMaxParticles = maxParticles;
+	c->mInertParticle = maxParticles-1;
 
-	// initialize free list
-	c->mFreeList.resize(maxParticles);
-	for (int i=0; i < maxParticles; ++i)
-		c->mFreeList[i] = i;
+	// initialize free list, the inert slot is never handed out
+	c->mFreeList.resize(Max(maxParticles-1, 0));
+	for (int i=0; i < int(c->mFreeList.size()); ++i)
+		c->mFreeList[i] = maxParticles-2-i;
+
+	c->mLive.Resize(maxParticles);
+	c->mListed.Resize(maxParticles);
 
 	c->mActiveList.init(maxParticles);
 	c->mParticles.init(maxParticles);
@@ -515,12 +868,18 @@ int NvFlexExtAllocParticles(NvFlexExtContainer* c, int n, int* indices)
 	const int numToAlloc = Min(int(c->mFreeList.size()), n);
 	const int start = int(c->mFreeList.size())-numToAlloc;
 
-	if (numToAlloc)
+	// pop from the top of the stack, recently freed slots are reused before the lowest untouched ones
+	for (int i=0; i < numToAlloc; ++i)
 	{
-		memcpy(indices, &c->mFreeList[start], numToAlloc*sizeof(int));
-		c->mFreeList.resize(start);
+		const int index = c->mFreeList[c->mFreeList.size()-1-i];
+
+		indices[i] = index;
+		c->mLive.Set(index);
 	}
 
+	c->mFreeList.resize(start);
+	c->mAllocatedIndices.insert(c->mAllocatedIndices.end(), indices, indices+numToAlloc);
+
 	c->mNeedsActiveListRebuild = true;
 
 	return numToAlloc;
@@ -528,43 +887,167 @@ int NvFlexExtAllocParticles(NvFlexExtContainer* c, int n, int* indices)
 
 void NvFlexExtFreeParticles(NvFlexExtContainer* c, int n, const int* indices)
 {
-#if _DEBUG
 	for (int i=0; i < n; ++i)
 	{
 		// check valid values
-		assert(indices[i] >= 0 && indices[i] < int(c->mFreeList.capacity()));
+		assert(indices[i] >= 0 && indices[i] < c->mMaxParticles);
 
 		// check for double delete
-		assert(std::find(c->mFreeList.begin(), c->mFreeList.end(), indices[i]) == c->mFreeList.end());
+		assert(c->mLive.IsSet(indices[i]));
+
+		c->mLive.Reset(indices[i]);
 	}
-#endif
 
+	// freed slots are removed from the active list when it is next updated
 	c->mFreeList.insert(c->mFreeList.end(), indices, indices+n);
 
 	c->mNeedsActiveListRebuild = true;
 }
 
+namespace
+{
+
+// merges slots allocated since the last update into the sorted active list and drops freed slots
+void UpdateActiveIndices(NvFlexExtContainer* c)
+{
+	std::vector<int>& added = c->mAllocatedIndices;
+
+	// slots may have been freed or allocated twice since the last update
+	size_t numAdded = 0;
+	for (size_t i=0; i < added.size(); ++i)
+	{
+		const int index = added[i];
+
+		if (c->mLive.IsSet(index) && !c->mListed.IsSet(index))
+		{
+			c->mListed.Set(index);
+			added[numAdded++] = index;
+		}
+	}
+
+	added.resize(numAdded);
+	std::sort(added.begin(), added.end());
+
+	std::vector<int> merged;
+	merged.reserve(c->mActiveIndices.size() + numAdded);
+
+	size_t a = 0;
+	for (size_t i=0; i < c->mActiveIndices.size(); ++i)
+	{
+		const int index = c->mActiveIndices[i];
+
+		if (!c->mLive.IsSet(index))
+		{
+			c->mListed.Reset(index);
+			continue;
+		}
+
+		while (a < numAdded && added[a] < index)
+			merged.push_back(added[a++]);
+
+		merged.push_back(index);
+	}
+
+	merged.insert(merged.end(), added.begin() + a, added.end());
+
+	c->mActiveIndices.swap(merged);
+	added.resize(0);
+}
+
+} // anonymous namespace
+
 int NvFlexExtGetActiveList(NvFlexExtContainer* c, int* indices)
 {
-	int count = 0;
+	UpdateActiveIndices(c);
+
+	const int count = int(c->mActiveIndices.size());
+
+	if (count)
+		memcpy(indices, &c->mActiveIndices[0], count*sizeof(int));
+
+	return count;
+}
+
+int NvFlexExtCompactParticles(NvFlexExtContainer* c, NvFlexExtParticleData* particleData, int* movedFrom, int* movedTo)
+{
+	UpdateActiveIndices(c);
+
+	const int numActive = int(c->mActiveIndices.size());
+
+	// live slots beyond the first numActive fill the holes below it, lowest hole gets the highest slot
+	std::vector<int> remap(c->mMaxParticles, -1);
 
-	Bitmap inactive(c->mMaxParticles);
+	int numMoves = 0;
+	int hole = 0;
 
-	// create bitmap
-	for (size_t i=0; i < c->mFreeList.size(); ++i)
+	for (int i=numActive-1; i >= 0; --i)
 	{
-		// if this fires then somehow a duplicate has ended up in the free list (double delete)
-		assert(!inactive.IsSet(c->mFreeList[i]));
+		const int src = c->mActiveIndices[i];
+
+		if (src < numActive)
+			break;
+
+		while (c->mLive.IsSet(hole))
+			++hole;
+
+		((Vec4*)(particleData->particles))[hole] = ((Vec4*)(particleData->particles))[src];
+		((Vec4*)(particleData->restParticles))[hole] = ((Vec4*)(particleData->restParticles))[src];
+		((Vec3*)(particleData->velocities))[hole] = ((Vec3*)(particleData->velocities))[src];
+		((int*)(particleData->phases))[hole] = ((int*)(particleData->phases))[src];
+		((Vec4*)(particleData->normals))[hole] = ((Vec4*)(particleData->normals))[src];
+
+		c->mLive.Reset(src);
+		c->mLive.Set(hole);
+
+		remap[src] = hole;
+
+		if (movedFrom)
+			movedFrom[numMoves] = src;
+		if (movedTo)
+			movedTo[numMoves] = hole;
 
-		inactive.Set(c->mFreeList[i]);
+		++numMoves;
 	}
 
-	// iterate bitmap to find active elements
+	if (numMoves == 0)
+		return 0;
+
+	// live slots are now [0, numActive)
+	c->mFreeList.resize(c->mMaxParticles-1 - numActive);
+	for (int i=0; i < int(c->mFreeList.size()); ++i)
+		c->mFreeList[i] = c->mMaxParticles-2-i;
+
 	for (int i=0; i < c->mMaxParticles; ++i)
-		if (inactive.IsSet(i) == false)
-			indices[count++] = i;
+		c->mListed.Reset(i);
 
-	return count;
+	c->mActiveIndices.resize(numActive);
+	for (int i=0; i < numActive; ++i)
+	{
+		c->mActiveIndices[i] = i;
+		c->mListed.Set(i);
+	}
+
+	c->mAllocatedIndices.resize(0);
+
+	// remap instances and rewrite their constraints
+	for (size_t i=0; i < c->mInstances.size(); ++i)
+	{
+		NvFlexExtInstance* inst = c->mInstances[i];
+
+		for (int p=0; p < inst->numParticles; ++p)
+		{
+			const int index = remap[inst->particleIndices[p]];
+
+			if (index != -1)
+				inst->particleIndices[p] = index;
+		}
+	}
+
+	NvFlexExtNotifyAssetChanged(c, NULL);
+
+	c->mNeedsActiveListRebuild = true;
+
+	return numMoves;
 }
 
 NvFlexExtParticleData NvFlexExtMapParticleData(NvFlexExtContainer* c)
@@ -658,17 +1141,78 @@ void NvFlexExtUnmapShapeData(NvFlexExtContainer* c)
 }
 
 
-NvFlexExtInstance* NvFlexExtCreateInstance(NvFlexExtContainer* c, NvFlexExtParticleData* particleData, const NvFlexExtAsset* asset, const float* transform, float vx, float vy, float vz, int phase, float invMassScale)
-{	
+namespace
+{
+
+// writes an instance's transformed asset particles in [begin, end) to the mapped particle data
+void WriteInstanceParticles(const NvFlexExtInstance* inst, NvFlexExtParticleData* particleData, const Matrix44& xform, const Vec3& velocity, int phase, float invMassScale, int begin, int end)
+{
+	const NvFlexExtAsset* asset = inst->asset;
+
+	Vec4* __restrict particles = (Vec4*)particleData->particles;
+	Vec4* __restrict restParticles = (Vec4*)particleData->restParticles;
+
+#if defined(__SSE2__)
+
+	const __m128 c0 = _mm_loadu_ps(&xform.columns[0][0]);
+	const __m128 c1 = _mm_loadu_ps(&xform.columns[1][0]);
+	const __m128 c2 = _mm_loadu_ps(&xform.columns[2][0]);
+	const __m128 c3 = _mm_loadu_ps(&xform.columns[3][0]);
+
+	for (int i=begin; i < end; ++i)
+	{
+		const int index = inst->particleIndices[i];
+		const __m128 p = _mm_loadu_ps(&asset->particles[i*4]);
+
+		// add transformed particles to the locked particle data
+		__m128 r = _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(0,0,0,0)), c0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(1,1,1,1)), c1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(2,2,2,2)), c2));
+		r = _mm_add_ps(r, c3);
+
+		_mm_storeu_ps(&particles[index].x, r);
+		_mm_storeu_ps(&restParticles[index].x, p);
+
+		particles[index].w = asset->particles[i*4+3]*invMassScale;
+	}
+
+#else
+
+	for (int i=begin; i < end; ++i)
+	{
+		const int index = inst->particleIndices[i];
+
+		// add transformed particles to the locked particle data
+		particles[index] = xform*Vec4(Vec3(&asset->particles[i*4]), 1.0f);
+		particles[index].w = asset->particles[i*4+3]*invMassScale;
+		restParticles[index] = Vec4(&asset->particles[i*4]);
+	}
+
+#endif
+
+	for (int i=begin; i < end; ++i)
+	{
+		const int index = inst->particleIndices[i];
+
+		((Vec3*)(particleData->velocities))[index] = velocity;
+		((int*)(particleData->phases))[index] = phase;
+		((Vec4*)(particleData->normals))[index] = Vec4(0.0f);
+	}
+}
+
+// allocates an instance's particles and shape transforms, particle data is written separately
+FlexExtInstance* AllocInstance(NvFlexExtContainer* c, const NvFlexExtAsset* asset, const Matrix44& xform)
+{
 	const int numParticles = asset->numParticles;
 
 	// check if asset will fit
 	if (int(c->mFreeList.size()) < numParticles)
 		return NULL;
 
-	NvFlexExtInstance* inst = new NvFlexExtInstance();
+	FlexExtInstance* inst = new FlexExtInstance();
 
 	inst->asset = asset;
+	inst->placed = false;
 	inst->triangleIndex = -1;
 	inst->shapeIndex = -1;
 	inst->inflatableIndex = -1;
@@ -684,22 +1228,7 @@ NvFlexExtInstance* NvFlexExtCreateInstance(NvFlexExtContainer* c, NvFlexExtParti
 	(void)n;
 
 	c->mInstances.push_back(inst);
-
-	const Matrix44 xform(transform);
-
-	for (int i=0; i < numParticles; ++i)
-	{
-		const int index = inst->particleIndices[i];
-
-		// add transformed particles to the locked particle data
-		((Vec4*)(particleData->particles))[index] = xform*Vec4(Vec3(&asset->particles[i*4]), 1.0f);
-		((Vec4*)(particleData->particles))[index].w = asset->particles[i*4+3]*invMassScale;
-		((Vec4*)(particleData->restParticles))[index] = Vec4(&asset->particles[i*4]);
-
-		((Vec3*)(particleData->velocities))[index] = Vec3(vx, vy, vz);
-		((int*)(particleData->phases))[index] = phase;
-		((Vec4*)(particleData->normals))[index] = Vec4(0.0f);
-	}
+	c->mPendingInstances.push_back(inst);
 
 	const int numShapes = asset->numShapes;
 
@@ -725,8 +1254,51 @@ NvFlexExtInstance* NvFlexExtCreateInstance(NvFlexExtContainer* c, NvFlexExtParti
 	return inst;
 }
 
+} // anonymous namespace
+
+NvFlexExtInstance* NvFlexExtCreateInstance(NvFlexExtContainer* c, NvFlexExtParticleData* particleData, const NvFlexExtAsset* asset, const float* transform, float vx, float vy, float vz, int phase, float invMassScale)
+{	
+	const Matrix44 xform(transform);
+
+	FlexExtInstance* inst = AllocInstance(c, asset, xform);
+	if (!inst)
+		return NULL;
+
+	ParallelFor(inst->numParticles, [&](int begin, int end)
+	{
+		WriteInstanceParticles(inst, particleData, xform, Vec3(vx, vy, vz), phase, invMassScale, begin, end);
+	}, 8192);
+
+	return inst;
+}
+
+int NvFlexExtCreateInstances(NvFlexExtContainer* c, NvFlexExtParticleData* particleData, const NvFlexExtAsset* const* assets, const float* transforms, const int* phases, int numInstances, float vx, float vy, float vz, float invMassScale, NvFlexExtInstance** instances)
+{
+	int numCreated = 0;
+
+	// allocation is serial, particle data for all instances is written in parallel
+	for (; numCreated < numInstances; ++numCreated)
+	{
+		FlexExtInstance* inst = AllocInstance(c, assets[numCreated], Matrix44(&transforms[numCreated*16]));
+		if (!inst)
+			break;
+
+		instances[numCreated] = inst;
+	}
+
+	ParallelFor(numCreated, [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+			WriteInstanceParticles(instances[i], particleData, Matrix44(&transforms[i*16]), Vec3(vx, vy, vz), phases[i], invMassScale, 0, instances[i]->numParticles);
+	}, 16);
+
+	return numCreated;
+}
+
 void NvFlexExtDestroyInstance(NvFlexExtContainer* c, const NvFlexExtInstance* inst)
 {
+	ReleaseInstance(c, (FlexExtInstance*)inst);
+
 	NvFlexExtFreeParticles(c, inst->numParticles, &inst->particleIndices[0]);
 	delete[] inst->particleIndices;
 
@@ -741,7 +1313,7 @@ void NvFlexExtDestroyInstance(NvFlexExtContainer* c, const NvFlexExtInstance* in
 	c->mNeedsCompact = true;
 	c->mNeedsActiveListRebuild = true;
 
-	delete inst;
+	delete (FlexExtInstance*)inst;
 }
 
 void NvFlexExtTickContainer(NvFlexExtContainer* c, float dt, int substeps, bool enableTiming)
@@ -758,9 +1330,28 @@ void NvFlexExtTickContainer(NvFlexExtContainer* c, float dt, int substeps, bool
 
 void NvFlexExtNotifyAssetChanged(NvFlexExtContainer* c, const NvFlexExtAsset* asset)
 {
+	// rewrite the constraints of instances using the asset, keeping the current pose of their shapes
+	NvFlexExtUpdateInstances(c);
+
+	for (size_t i=0; i < c->mInstances.size(); ++i)
+	{
+		FlexExtInstance* inst = (FlexExtInstance*)c->mInstances[i];
+
+		if ((asset == NULL || inst->asset == asset) && inst->placed)
+		{
+			ReleaseInstance(c, inst);
+			c->mPendingInstances.push_back(inst);
+		}
+	}
+
 	c->mNeedsCompact = true;
 }
 
+void NvFlexExtSetDefragmentThreshold(NvFlexExtContainer* c, float threshold)
+{
+	c->mDefragmentThreshold = threshold;
+}
+
 void NvFlexExtPushToDevice(NvFlexExtContainer* c)
 {
 	if (c->mNeedsActiveListRebuild)
@@ -785,7 +1376,7 @@ void NvFlexExtPushToDevice(NvFlexExtContainer* c)
 	NvFlexSetNormals(c->mSolver, c->mNormals.buffer, NULL);
 	
 	if (c->mNeedsCompact)
-		CompactObjects(c);
+		UpdateObjects(c);
 }
 
 void NvFlexExtPullFromDevice(NvFlexExtContainer* c)
@@ -807,23 +1398,26 @@ void NvFlexExtUpdateInstances(NvFlexExtContainer* c)
 	c->mShapeTranslations.map();
 	c->mShapeRotations.map();
 
-	for (int i=0; i < int(c->mInstances.size()); ++i)
+	ParallelFor(int(c->mInstances.size()), [&](int begin, int end)
 	{
-		NvFlexExtInstance* inst = c->mInstances[i];
+		for (int i=begin; i < end; ++i)
+		{
+			FlexExtInstance* inst = (FlexExtInstance*)c->mInstances[i];
 
-		// copy data back to per-instance memory from the container's memory
-		const int numShapes = inst->asset->numShapes;
-		const int shapeStart = inst->shapeIndex;
+			// copy data back to per-instance memory from the container's memory
+			const int numShapes = inst->numShapes;
+			const int shapeStart = inst->shapeIndex;
 
-		if (shapeStart == -1)
-			continue;
+			if (shapeStart == -1)
+				continue;
 
-		for (int s=0; s < numShapes; ++s)
-		{
-			((Vec3*)inst->shapeTranslations)[s] = c->mShapeTranslations[shapeStart + s];
-			((Quat*)inst->shapeRotations)[s] = c->mShapeRotations[shapeStart + s];
-		}		
-	}
+			for (int s=0; s < numShapes; ++s)
+			{
+				((Vec3*)inst->shapeTranslations)[s] = c->mShapeTranslations[shapeStart + s];
+				((Quat*)inst->shapeRotations)[s] = c->mShapeRotations[shapeStart + s];
+			}		
+		}
+	}, 256);
 
 	c->mShapeTranslations.unmap();
 	c->mShapeRotations.unmap();
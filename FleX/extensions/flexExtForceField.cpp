@@ -0,0 +1,450 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 20132017 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+#include <algorithm>
+
+#include "../core/core.h"
+#include "../core/maths.h"
+#include "../core/parallel.h"
+#include "../core/radixsort.h"
+
+#include "../include/NvFlex.h"
+#include "../include/NvFlexExt.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+
+// particles are transposed to SoA in blocks, lanes of the SIMD kernel run over a block
+const int kBlockSize = 64;
+
+// fields and particles are binned by cell when there are at least this many fields, sorting particles 
+// costs about as much as testing this many fields against every particle
+#if defined(__AVX2__)
+const int kMinBinnedFields = 128;
+#else
+const int kMinBinnedFields = 32;
+#endif
+
+// fields overlapping more cells are tested against every block
+const int kMaxFieldCells = 4096;
+
+// cell coordinates are packed as 21 bit biased integers
+const int kCellBias = 1<<20;
+
+inline int FloorToCell(float x, float invCellSize)
+{
+	return int(Clamp(floorf(x*invCellSize), -float(kCellBias), float(kCellBias-1)));
+}
+
+inline uint64_t GetCellKey(int x, int y, int z)
+{
+	return (uint64_t(x + kCellBias)<<42) | (uint64_t(y + kCellBias)<<21) | uint64_t(z + kCellBias);
+}
+
+// uniform grid of the cells each field's bounds overlap, cells are sorted by key with their fields in index order
+struct FieldBins
+{
+	float invCellSize;
+
+	vector<uint64_t> cellKeys;
+	vector<int> cellStarts;
+	vector<int> cellFields;
+
+	// fields that are too large to bin
+	vector<int> globalFields;
+};
+
+void BuildFieldBins(const NvFlexExtForceField* forceFields, int numForceFields, FieldBins& bins)
+{
+	// cells are the size of the average field
+	float diameter = 0.0f;
+	int numFields = 0;
+
+	for (int f=0; f < numForceFields; ++f)
+	{
+		if (forceFields[f].mRadius > 0.0f)
+		{
+			diameter += 2.0f*forceFields[f].mRadius;
+			++numFields;
+		}
+	}
+
+	bins.invCellSize = numFields ? float(numFields)/diameter : 1.0f;
+
+	vector<uint64_t> keys;
+	vector<int> fields;
+
+	for (int f=0; f < numForceFields; ++f)
+	{
+		const NvFlexExtForceField& field = forceFields[f];
+
+		// fields with no extent never affect particles
+		if (field.mRadius <= 0.0f)
+			continue;
+
+		int lower[3], upper[3];
+		int numCells = 1;
+
+		for (int a=0; a < 3; ++a)
+		{
+			lower[a] = FloorToCell(field.mPosition[a] - field.mRadius, bins.invCellSize);
+			upper[a] = FloorToCell(field.mPosition[a] + field.mRadius, bins.invCellSize);
+
+			numCells = Min(numCells*(upper[a]-lower[a]+1), kMaxFieldCells+1);
+		}
+
+		if (numCells > kMaxFieldCells)
+		{
+			bins.globalFields.push_back(f);
+			continue;
+		}
+
+		for (int z=lower[2]; z <= upper[2]; ++z)
+			for (int y=lower[1]; y <= upper[1]; ++y)
+				for (int x=lower[0]; x <= upper[0]; ++x)
+				{
+					keys.push_back(GetCellKey(x, y, z));
+					fields.push_back(f);
+				}
+	}
+
+	// stable so each cell's fields stay in index order
+	if (keys.size())
+		RadixSort(&keys[0], &fields[0], int(keys.size()), 63);
+
+	bins.cellFields.swap(fields);
+
+	for (size_t i=0; i < keys.size(); ++i)
+	{
+		if (i == 0 || keys[i] != keys[i-1])
+		{
+			bins.cellKeys.push_back(keys[i]);
+			bins.cellStarts.push_back(int(i));
+		}
+	}
+
+	bins.cellStarts.push_back(int(keys.size()));
+}
+
+// appends the fields overlapping a cell followed by the fields too large to bin
+void QueryFieldBins(const FieldBins& bins, uint64_t key, vector<int>& fields)
+{
+	const vector<uint64_t>::const_iterator iter = lower_bound(bins.cellKeys.begin(), bins.cellKeys.end(), key);
+
+	if (iter != bins.cellKeys.end() && *iter == key)
+	{
+		const int cell = int(iter - bins.cellKeys.begin());
+		fields.insert(fields.end(), bins.cellFields.begin() + bins.cellStarts[cell], bins.cellFields.begin() + bins.cellStarts[cell+1]);
+	}
+
+	fields.insert(fields.end(), bins.globalFields.begin(), bins.globalFields.end());
+}
+
+// particles of a block in SoA layout, count is padded to the SIMD width with particles outside every field
+struct ParticleBlock
+{
+	float x[kBlockSize];
+	float y[kBlockSize];
+	float z[kBlockSize];
+	float invMass[kBlockSize];
+
+	float vx[kBlockSize];
+	float vy[kBlockSize];
+	float vz[kBlockSize];
+
+	int count;
+};
+
+// velocity change per unit field strength along the field direction, same as the CUDA kernel
+inline float GetUnitMultiplier(NvFlexExtForceMode mode, float invMass, float dt)
+{
+	if (mode == eNvFlexExtModeForce)
+		return dt*invMass;	// time/mass
+	else if (mode == eNvFlexExtModeImpulse)
+		return invMass;		// 1/mass
+	else
+		return 1.0f;
+}
+
+void ApplyForceField(const NvFlexExtForceField& field, ParticleBlock& block, float dt)
+{
+	const float radius = field.mRadius;
+	const float strength = field.mStrength;
+	const float timeScale = field.mMode == eNvFlexExtModeForce ? dt : 1.0f;
+	const bool massScale = field.mMode != eNvFlexExtModeVelocityChange;
+
+	int start = 0;
+
+#if defined(__AVX2__)
+
+	const __m256 px = _mm256_set1_ps(field.mPosition[0]);
+	const __m256 py = _mm256_set1_ps(field.mPosition[1]);
+	const __m256 pz = _mm256_set1_ps(field.mPosition[2]);
+	const __m256 r = _mm256_set1_ps(radius);
+	const __m256 s = _mm256_set1_ps(strength);
+	const __m256 t = _mm256_set1_ps(timeScale);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	for (; start + 8 <= block.count; start += 8)
+	{
+		const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&block.x[start]), px);
+		const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&block.y[start]), py);
+		const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&block.z[start]), pz);
+
+		const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+		const __m256 inside = _mm256_cmp_ps(length, r, _CMP_LT_OQ);
+
+		if (_mm256_movemask_ps(inside) == 0)
+			continue;
+
+		// field direction is the offset itself at the center
+		const __m256 invLength = _mm256_blendv_ps(one, _mm256_div_ps(one, length), _mm256_cmp_ps(length, zero, _CMP_GT_OQ));
+
+		__m256 fieldStrength = s;
+		if (field.mLinearFalloff)
+			fieldStrength = _mm256_mul_ps(fieldStrength, _mm256_sub_ps(one, _mm256_div_ps(length, r)));
+
+		__m256 unitMultiplier = one;
+		if (massScale)
+			unitMultiplier = _mm256_mul_ps(t, _mm256_loadu_ps(&block.invMass[start]));
+
+		const __m256 dvx = _mm256_and_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(dx, invLength), fieldStrength), unitMultiplier), inside);
+		const __m256 dvy = _mm256_and_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(dy, invLength), fieldStrength), unitMultiplier), inside);
+		const __m256 dvz = _mm256_and_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(dz, invLength), fieldStrength), unitMultiplier), inside);
+
+		_mm256_storeu_ps(&block.vx[start], _mm256_add_ps(_mm256_loadu_ps(&block.vx[start]), dvx));
+		_mm256_storeu_ps(&block.vy[start], _mm256_add_ps(_mm256_loadu_ps(&block.vy[start]), dvy));
+		_mm256_storeu_ps(&block.vz[start], _mm256_add_ps(_mm256_loadu_ps(&block.vz[start]), dvz));
+	}
+
+#endif
+
+	// branch free so it vectorizes without AVX2
+	const float falloff = field.mLinearFalloff ? 1.0f : 0.0f;
+	const float massWeight = massScale ? 1.0f : 0.0f;
+
+	for (int i=start; i < block.count; ++i)
+	{
+		const float dx = block.x[i] - field.mPosition[0];
+		const float dy = block.y[i] - field.mPosition[1];
+		const float dz = block.z[i] - field.mPosition[2];
+
+		const float length = sqrtf(dx*dx + dy*dy + dz*dz);
+
+		// field direction is the offset itself at the center
+		const float invLength = 1.0f/Max(length, FLT_MIN);
+		const float scale = length > 0.0f ? invLength : 1.0f;
+
+		// if using linear falloff, scale with distance
+		const float fieldStrength = strength*(1.0f - (length/radius)*falloff);
+		const float unitMultiplier = timeScale*(block.invMass[i]*massWeight + (1.0f - massWeight));
+		const float inside = length < radius ? 1.0f : 0.0f;
+
+		block.vx[i] += dx*scale*fieldStrength*unitMultiplier*inside;
+		block.vy[i] += dy*scale*fieldStrength*unitMultiplier*inside;
+		block.vz[i] += dz*scale*fieldStrength*unitMultiplier*inside;
+	}
+}
+
+} // anonymous namespace
+
+void NvFlexExtApplyForceFields(const NvFlexExtForceField* forceFields, int numForceFields, const float* particles, float* velocities, int numParticles, float dt)
+{
+	if (numForceFields <= 0 || numParticles <= 0)
+		return;
+
+	FieldBins bins;
+	const bool binned = numForceFields >= kMinBinnedFields;
+
+	// particles are sorted by cell so a block shares its cell's fields, otherwise blocks are in particle order
+	vector<uint64_t> keys;
+	vector<int> order;
+
+	if (binned)
+	{
+		BuildFieldBins(forceFields, numForceFields, bins);
+
+		keys.resize(numParticles);
+		order.resize(numParticles);
+
+		ParallelFor(numParticles, [&](int begin, int end)
+		{
+			for (int i=begin; i < end; ++i)
+			{
+				const float* p = &particles[i*4];
+
+				keys[i] = GetCellKey(FloorToCell(p[0], bins.invCellSize), FloorToCell(p[1], bins.invCellSize), FloorToCell(p[2], bins.invCellSize));
+				order[i] = i;
+			}
+		});
+
+		RadixSort(&keys[0], &order[0], numParticles, 63);
+	}
+
+	const int kGrain = 16*kBlockSize;
+
+	ParallelFor(numParticles, [&](int begin, int end)
+	{
+		ParticleBlock block;
+		int indices[kBlockSize];
+
+		vector<int> fields;
+
+		for (int blockStart=begin; blockStart < end; blockStart += block.count)
+		{
+			// blocks in the binned order end at cell boundaries
+			int blockEnd = Min(blockStart + kBlockSize, end);
+
+			if (binned)
+			{
+				for (int i=blockStart+1; i < blockEnd; ++i)
+				{
+					if (keys[i] != keys[blockStart])
+					{
+						blockEnd = i;
+						break;
+					}
+				}
+			}
+
+			block.count = blockEnd-blockStart;
+
+			Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+
+			for (int i=0; i < block.count; ++i)
+			{
+				indices[i] = binned ? order[blockStart + i] : blockStart + i;
+
+				const Vec4 p = ((const Vec4*)particles)[indices[i]];
+
+				block.x[i] = p.x;
+				block.y[i] = p.y;
+				block.z[i] = p.z;
+				block.invMass[i] = p.w;
+
+				lower = Min(lower, Vec3(p));
+				upper = Max(upper, Vec3(p));
+			}
+
+			// candidate fields in index order so velocities accumulate in the same order as the CUDA kernel
+			fields.resize(0);
+
+			if (binned)
+			{
+				QueryFieldBins(bins, keys[blockStart], fields);
+				sort(fields.begin(), fields.end());
+			}
+			else
+			{
+				fields.resize(numForceFields);
+				for (int f=0; f < numForceFields; ++f)
+					fields[f] = f;
+			}
+
+			bool loaded = false;
+
+			for (size_t c=0; c < fields.size(); ++c)
+			{
+				const NvFlexExtForceField& field = forceFields[fields[c]];
+
+				// skip fields that do not reach the block bounds
+				const Vec3 center(field.mPosition[0], field.mPosition[1], field.mPosition[2]);
+				if (LengthSq(center - Max(lower, Min(center, upper))) >= field.mRadius*field.mRadius)
+					continue;
+
+				if (!loaded)
+				{
+					for (int i=0; i < block.count; ++i)
+					{
+						const Vec3 v = ((const Vec3*)velocities)[indices[i]];
+
+						block.vx[i] = v.x;
+						block.vy[i] = v.y;
+						block.vz[i] = v.z;
+					}
+
+					loaded = true;
+				}
+
+				ApplyForceField(field, block, dt);
+			}
+
+			if (loaded)
+			{
+				for (int i=0; i < block.count; ++i)
+					((Vec3*)velocities)[indices[i]] = Vec3(block.vx[i], block.vy[i], block.vz[i]);
+			}
+		}
+	}, kGrain);
+}
+
+void NvFlexExtApplyForceFieldsReference(const NvFlexExtForceField* forceFields, int numForceFields, const float* particles, float* velocities, int numParticles, float dt)
+{
+	// direct port of the CUDA UpdateForceFields kernel
+	for (int i=0; i < numParticles; ++i)
+	{
+		const Vec4 p = ((const Vec4*)particles)[i];
+		Vec3 v = ((const Vec3*)velocities)[i];
+
+		for (int f=0; f < numForceFields; ++f)
+		{
+			const NvFlexExtForceField& forceField = forceFields[f];
+
+			Vec3 localPos = Vec3(p.x, p.y, p.z) - Vec3(forceField.mPosition[0], forceField.mPosition[1], forceField.mPosition[2]);
+
+			float length = Length(localPos);
+			if (length >= forceField.mRadius)
+				continue;
+
+			Vec3 fieldDir;
+			if (length > 0.0f)
+				fieldDir = localPos/length;
+			else
+				fieldDir = localPos;
+
+			// if using linear falloff, scale with distance
+			float fieldStrength = forceField.mStrength;
+			if (forceField.mLinearFalloff)
+				fieldStrength *= (1.0f - (length/forceField.mRadius));
+
+			const float unitMultiplier = GetUnitMultiplier(forceField.mMode, p.w, dt);
+
+			Vec3 deltaVelocity = fieldDir*fieldStrength*unitMultiplier;
+			v += deltaVelocity;
+		}
+
+		((Vec3*)velocities)[i] = v;
+	}
+}
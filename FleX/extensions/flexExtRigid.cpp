@@ -35,41 +35,25 @@
 #include <iostream>
 #include <fstream>
 
-namespace
-{
-
-float SampleSDF(const float* sdf, int dim, int x, int y, int z)
-{
-	assert(x < dim && x >= 0);
-	assert(y < dim && y >= 0);
-	assert(z < dim && z >= 0);
-
-	return sdf[z*dim*dim + y*dim + x];
-}
-
-// return normal of signed distance field
-Vec3 SampleSDFGrad(const float* sdf, int dim, int x, int y, int z)
+NvFlexExtAsset* NvFlexExtCreateRigidFromMesh(const float* vertices, int numVertices, const int* indices, int numTriangleIndices, float spacing, float expand)
 {
-	int x0 = std::max(x-1, 0);
-	int x1 = std::min(x+1, dim-1);
-
-	int y0 = std::max(y-1, 0);
-	int y1 = std::min(y+1, dim-1);
+	// reuse an asset cooked earlier from the same mesh and parameters
+	const float params[] = { spacing, expand };
 
-	int z0 = std::max(z-1, 0);
-	int z1 = std::min(z+1, dim-1);
+	unsigned long long key = 0;
 
-	float dx = (SampleSDF(sdf, dim, x1, y, z) - SampleSDF(sdf, dim, x0, y, z))*(dim*0.5f);
-	float dy = (SampleSDF(sdf, dim, x, y1, z) - SampleSDF(sdf, dim, x, y0, z))*(dim*0.5f);
-	float dz = (SampleSDF(sdf, dim, x, y, z1) - SampleSDF(sdf, dim, x, y, z0))*(dim*0.5f);
-
-	return Vec3(dx, dy, dz);
-}
-
-} // anonymous namespace
+	if (NvFlexExtGetAssetCacheEnabled())
+	{
+		key = NvFlexExtHashAssetData(0, "rigid", 5);
+		key = NvFlexExtHashAssetData(key, vertices, numVertices*3*sizeof(float));
+		key = NvFlexExtHashAssetData(key, indices, numTriangleIndices*sizeof(int));
+		key = NvFlexExtHashAssetData(key, params, sizeof(params));
+
+		NvFlexExtAsset* cachedAsset = NvFlexExtLoadCachedAsset(key);
+		if (cachedAsset)
+			return cachedAsset;
+	}
 
-NvFlexExtAsset* NvFlexExtCreateRigidFromMesh(const float* vertices, int numVertices, const int* indices, int numTriangleIndices, float spacing, float expand)
-{
 	// Switch to relative coordinates by computing the mean position of the vertices and subtracting the result from every vertex position
 	// The increased precision will prevent ghost forces caused by inaccurate center of mass computations
 	Vec3 meshOffset(0.0f);
@@ -220,5 +204,7 @@ NvFlexExtAsset* NvFlexExtCreateRigidFromMesh(const float* vertices, int numVerti
 
 	//std::cout << 11111 << std::endl;
 
+	NvFlexExtStoreCachedAsset(key, asset);
+
 	return asset;
 }
@@ -30,6 +30,9 @@
 #include "../core/core.h"
 #include "../core/maths.h"
 #include "../core/voxelize.h"
+#include "../core/sample.h"
+#include "../core/hashgrid.h"
+#include "../core/parallel.h"
 
 #include <vector>
 #include <algorithm>
@@ -90,100 +93,6 @@ struct Seed
 	}
 };
 
-// basic SAP based acceleration structure for point cloud queries
-struct SweepAndPrune
-{
-	struct Entry
-	{
-		Entry(Vec3 p, int i) : point(p), index(i) {}
-
-		Vec3 point;
-		int index;
-	};
-
-	SweepAndPrune(const Vec3* points, int n)
-	{
-		entries.reserve(n);		
-		for (int i=0; i < n; ++i)
-			entries.push_back(Entry(points[i], i));
-
-		struct SortOnAxis
-		{
-			int axis;
-
-			SortOnAxis(int axis) : axis(axis) {}
-
-			bool operator()(const Entry& lhs, const Entry& rhs) const			
-			{
-				return lhs.point[axis] < rhs.point[axis];
-			}
-		};
-
-		// calculate particle bounds and longest axis
-		Vec3 lower(FLT_MAX), upper(-FLT_MAX);
-		for (int i=0; i < n; ++i)
-		{
-			lower = Min(points[i], lower);
-			upper = Max(points[i], upper);
-		}
-
-		Vec3 edges = upper-lower;
-		
-		if (edges.x > edges.y && edges.x > edges.z)
-			longestAxis = 0;
-		else if (edges.y > edges.z)
-			longestAxis = 1;
-		else
-			longestAxis = 2;
-		
-		std::sort(entries.begin(), entries.end(), SortOnAxis(longestAxis));
-	}
-
-	void QuerySphere(Vec3 center, float radius, std::vector<int>& indices)
-	{
-		// find start point in the array
-		int low = 0;
-		int high = int(entries.size());
-		
-		// the point we are trying to find
-		float queryLower = center[longestAxis] - radius;
-		float queryUpper = center[longestAxis] + radius;
-
-		// binary search to find the start point in the sorted entries array
-		while (low < high)
-		{
-			const int mid = (high+low)/2;
-
-			if (queryLower > entries[mid].point[longestAxis])
-				low = mid+1;
-			else
-				high = mid;
-		}
-
-		// scan forward over potential overlaps
-		float radiusSq = radius*radius;
-
-		for (int i=low; i < int(entries.size()); ++i)
-		{
-			Vec3 p = entries[i].point;
-
-			if (LengthSq(p-center) < radiusSq)
-			{
-				indices.push_back(entries[i].index);
-			}					
-			else if (entries[i].point[longestAxis] > queryUpper)
-			{
-				// early out if ther are no more possible candidates
-				break;
-			}
-		}
-	}
-	
-	int longestAxis;	// [0,2] -> x,y,z
-
-	std::vector<Entry> entries;
-};
-
 int CreateClusters(Vec3* particles, const float* priority, int numParticles, std::vector<int>& outClusterOffsets, std::vector<int>& outClusterIndices, std::vector<Vec3>& outClusterPositions, float radius, float smoothing = 0.0f)
 {
 	std::vector<Seed> seeds;
@@ -205,7 +114,8 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 	// sort seeds on priority
 	std::stable_sort(seeds.begin(), seeds.end());
 
-	SweepAndPrune sap(particles, numParticles);
+	HashGrid grid;
+	grid.Build(particles, numParticles, radius);
 
 	while (seeds.size())
 	{
@@ -217,7 +127,7 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 		{
 			Cluster c;
 
-			sap.QuerySphere(Vec3(particles[seed.index]), radius, c.indices);
+			grid.QuerySphere(Vec3(particles[seed.index]), radius, c.indices);
 			
 			// mark overlapping particles as used so they are removed from the list of potential cluster seeds
 			for (int i=0; i < int(c.indices.size()); ++i)
@@ -231,18 +141,22 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 
 	if (smoothing > 0.0f)
 	{
-		for (int i = 0; i < int(clusters.size()); ++i)
+		// clusters are independent once seeded
+		ParallelFor(int(clusters.size()), [&](int begin, int end)
 		{
-			Cluster& c = clusters[i];
+			for (int i = begin; i < end; ++i)
+			{
+				Cluster& c = clusters[i];
 
-			// clear cluster indices
-			c.indices.resize(0);
+				// clear cluster indices
+				c.indices.resize(0);
 
-			// calculate cluster particles using cluster mean and smoothing radius
-			sap.QuerySphere(c.mean, smoothing, c.indices);
+				// calculate cluster particles using cluster mean and smoothing radius
+				grid.QuerySphere(c.mean, smoothing, c.indices);
 
-			c.mean = CalculateMean(particles, &c.indices[0], int(c.indices.size()));
-		}
+				c.mean = CalculateMean(particles, &c.indices[0], int(c.indices.size()));
+			}
+		}, 64);
 	}
 
 	// write out cluster indices
@@ -277,32 +191,63 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 // creates distance constraints between particles within some radius
 int CreateLinks(const Vec3* particles, int numParticles, std::vector<int>& outSpringIndices, std::vector<float>& outSpringLengths, std::vector<float>& outSpringStiffness, float radius, float stiffness = 1.0f)
 {
-	int count = 0;
+	HashGrid grid;
+	grid.Build(particles, numParticles, radius);
 
-	std::vector<int> neighbors;
-	SweepAndPrune sap(particles, numParticles);
+	// each block of particles writes links to its own buffers which are then concatenated in particle order
+	const int kBlockSize = 1024;
+	const int numBlocks = (numParticles + kBlockSize - 1)/kBlockSize;
 
-	for (int i = 0; i < numParticles; ++i)
-	{
-		neighbors.resize(0);
+	std::vector<std::vector<int> > blockIndices(numBlocks);
+	std::vector<std::vector<float> > blockLengths(numBlocks);
 
-		sap.QuerySphere(Vec3(particles[i]), radius, neighbors);
+	ParallelFor(numBlocks, [&](int begin, int end)
+	{
+		std::vector<int> neighbors;
 
-		for (int j = 0; j < int(neighbors.size()); ++j)
+		for (int b = begin; b < end; ++b)
 		{
-			const int nj = neighbors[j];
-
-			if (nj != i)
+			for (int i = b*kBlockSize; i < Min((b+1)*kBlockSize, numParticles); ++i)
 			{
-				outSpringIndices.push_back(i);
-				outSpringIndices.push_back(nj);
-				outSpringLengths.push_back(Length(Vec3(particles[i]) - Vec3(particles[nj])));
-				outSpringStiffness.push_back(stiffness);
+				neighbors.resize(0);
+
+				grid.QuerySphere(Vec3(particles[i]), radius, neighbors);
+
+				for (int j = 0; j < int(neighbors.size()); ++j)
+				{
+					const int nj = neighbors[j];
 
-				++count;
+					if (nj != i)
+					{
+						blockIndices[b].push_back(i);
+						blockIndices[b].push_back(nj);
+						blockLengths[b].push_back(Length(Vec3(particles[i]) - Vec3(particles[nj])));
+					}
+				}
 			}
 		}
-	}
+	}, 1);
+
+	// prefix sum of block sizes gives the output offset of each block
+	std::vector<int> offsets(numBlocks + 1, int(outSpringLengths.size()));
+
+	for (int b = 0; b < numBlocks; ++b)
+		offsets[b+1] = offsets[b] + int(blockLengths[b].size());
+
+	const int count = offsets[numBlocks] - offsets[0];
+
+	outSpringIndices.resize(offsets[numBlocks]*2);
+	outSpringLengths.resize(offsets[numBlocks]);
+	outSpringStiffness.resize(offsets[numBlocks], stiffness);
+
+	ParallelFor(numBlocks, [&](int begin, int end)
+	{
+		for (int b = begin; b < end; ++b)
+		{
+			std::copy(blockIndices[b].begin(), blockIndices[b].end(), outSpringIndices.begin() + offsets[b]*2);
+			std::copy(blockLengths[b].begin(), blockLengths[b].end(), outSpringLengths.begin() + offsets[b]);
+		}
+	}, 1);
 
 	return count;
 }
@@ -311,85 +256,89 @@ void CreateSkinning(const Vec3* vertices, int numVertices, const Vec3* clusters,
 {
 	const int maxBones = 4;
 
-	SweepAndPrune sap(clusters, numClusters);
-
-	std::vector<int> influences;
+	HashGrid grid;
+	grid.Build(clusters, numClusters, maxdist);
 
 	// for each vertex, find the closest n clusters
-	for (int i = 0; i < numVertices; ++i)
+	ParallelFor(numVertices, [&](int begin, int end)
 	{
-		int indices[4] = { -1, -1, -1, -1 };
-		float distances[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
-		float weights[maxBones];
+		std::vector<int> influences;
 
-		influences.resize(0);
-		sap.QuerySphere(vertices[i], maxdist, influences);
-
-		for (int c = 0; c < int(influences.size()); ++c)			
+		for (int i = begin; i < end; ++i)
 		{
-			float dSq = LengthSq(vertices[i] - clusters[influences[c]]);
+			int indices[4] = { -1, -1, -1, -1 };
+			float distances[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+			float weights[maxBones];
 
-			// insertion sort
-			int w = 0;
-			for (; w < maxBones; ++w)
-				if (dSq < distances[w])
-					break;
+			influences.resize(0);
+			grid.QuerySphere(vertices[i], maxdist, influences);
 
-			if (w < maxBones)
+			for (int c = 0; c < int(influences.size()); ++c)			
 			{
-				// shuffle down
-				for (int s = maxBones - 1; s > w; --s)
+				float dSq = LengthSq(vertices[i] - clusters[influences[c]]);
+
+				// insertion sort
+				int w = 0;
+				for (; w < maxBones; ++w)
+					if (dSq < distances[w])
+						break;
+
+				if (w < maxBones)
 				{
-					indices[s] = indices[s - 1];
-					distances[s] = distances[s - 1];
-				}
+					// shuffle down
+					for (int s = maxBones - 1; s > w; --s)
+					{
+						indices[s] = indices[s - 1];
+						distances[s] = distances[s - 1];
+					}
 
-				distances[w] = dSq;
-				indices[w] = influences[c];
+					distances[w] = dSq;
+					indices[w] = influences[c];
+				}
 			}
-		}
 
-		// weight particles according to distance
-		float wSum = 0.0f;
+			// weight particles according to distance
+			float wSum = 0.0f;
 
-		for (int w = 0; w < maxBones; ++w)
-		{
-			if (distances[w] > Sqr(maxdist))
+			for (int w = 0; w < maxBones; ++w)
 			{
-				// clamp bones over a given distance to zero
-				weights[w] = 0.0f;
+				if (distances[w] > Sqr(maxdist))
+				{
+					// clamp bones over a given distance to zero
+					weights[w] = 0.0f;
+				}
+				else
+				{
+					// weight falls off inversely with distance
+					weights[w] = 1.0f / (powf(distances[w], falloff) + 0.0001f);
+				}
+
+				wSum += weights[w];
+			}
+
+			if (wSum == 0.0f)
+			{
+				// if all weights are zero then just 
+				// rigidly skin to the closest bone
+				weights[0] = 1.0f;
 			}
 			else
 			{
-				// weight falls off inversely with distance
-				weights[w] = 1.0f / (powf(distances[w], falloff) + 0.0001f);
+				// normalize weights
+				for (int w = 0; w < maxBones; ++w)
+				{
+					weights[w] = weights[w] / wSum;
+				}
 			}
 
-			wSum += weights[w];
-		}
-
-		if (wSum == 0.0f)
-		{
-			// if all weights are zero then just 
-			// rigidly skin to the closest bone
-			weights[0] = 1.0f;
-		}
-		else
-		{
-			// normalize weights
-			for (int w = 0; w < maxBones; ++w)
+			// output
+			for (int j = 0; j < maxBones; ++j)
 			{
-				weights[w] = weights[w] / wSum;
+				outWeights[i*maxBones + j] = weights[j];
+				outIndices[i*maxBones + j] = indices[j];
 			}
 		}
-
-		// output
-		for (int j = 0; j < maxBones; ++j)
-		{
-			outWeights[i*maxBones + j] = weights[j];
-			outIndices[i*maxBones + j] = indices[j];
-		}
-	}
+	});
 }
 
 // creates mesh interior and surface sample points and clusters them into particles
@@ -446,54 +395,18 @@ void SampleMesh(const Vec3* vertices, int numVertices, const int* indices, int n
 		Voxelize(vertices, numVertices, indices, numIndices, maxDim, maxDim, maxDim, &voxels[0], meshLower, meshLower + Vec3(maxDim*spacing));
 
 		// sample interior
-		for (int x = 0; x < maxDim; ++x)
-		{
-			for (int y = 0; y < maxDim; ++y)
-			{
-				for (int z = 0; z < maxDim; ++z)
-				{
-					const int index = z*maxDim*maxDim + y*maxDim + x;
-
-					// if voxel is marked as occupied the add a particle
-					if (voxels[index])
-					{
-						Vec3 position = meshLower + spacing*Vec3(float(x) + 0.5f, float(y) + 0.5f, float(z) + 0.5f);
-
-						// normalize the sdf value and transform to world scale
-						samples.push_back(position);
-					}
-				}
-			}
-		}
+		SampleVoxels(&voxels[0], maxDim, maxDim, maxDim, meshLower, spacing, samples);
 	}
 
 	if (surfaceSampling > 0.0f)
 	{
 		// sample vertices
-		for (int i = 0; i < numVertices; ++i)
-			samples.push_back(vertices[i]);
+		samples.insert(samples.end(), vertices, vertices + numVertices);
 
-		// random surface sampling (non-uniform)
+		// blue noise surface sampling, spaced well below the particle radius so clustering sees an even cover
 		const int numSamples = int(50000 * surfaceSampling);
-		const int numTriangles = numIndices/3;
-
-		RandInit();
-
-		for (int i = 0; i < numSamples; ++i)
-		{
-			int t = Rand() % numTriangles;
-			float u = Randf();
-			float v = Randf()*(1.0f - u);
-			float w = 1.0f - u - v;
-
-			int a = indices[t*3 + 0];
-			int b = indices[t*3 + 1];
-			int c = indices[t*3 + 2];
-
-			Vec3 p = vertices[a] * u + vertices[b] * v + vertices[c] * w;
 
-			samples.push_back(p);
-		}
+		SampleSurface(vertices, indices, numIndices, numSamples, 0.5f*radius, samples);
 	}
 
 	std::vector<int> clusterIndices;
@@ -511,6 +424,23 @@ void SampleMesh(const Vec3* vertices, int numVertices, const int* indices, int n
 
 NvFlexExtAsset* NvFlexExtCreateSoftFromMesh(const float* vertices, int numVertices, const int* indices, int numIndices, float particleSpacing, float volumeSampling, float surfaceSampling, float clusterSpacing, float clusterRadius, float clusterStiffness, float linkRadius, float linkStiffness, float globalStiffness, float clusterPlasticThreshold, float clusterPlasticCreep)
 {
+	// reuse an asset cooked earlier from the same mesh and parameters
+	const float params[] = { particleSpacing, volumeSampling, surfaceSampling, clusterSpacing, clusterRadius, clusterStiffness, linkRadius, linkStiffness, globalStiffness, clusterPlasticThreshold, clusterPlasticCreep };
+
+	unsigned long long key = 0;
+
+	if (NvFlexExtGetAssetCacheEnabled())
+	{
+		key = NvFlexExtHashAssetData(0, "soft", 4);
+		key = NvFlexExtHashAssetData(key, vertices, numVertices*3*sizeof(float));
+		key = NvFlexExtHashAssetData(key, indices, numIndices*sizeof(int));
+		key = NvFlexExtHashAssetData(key, params, sizeof(params));
+
+		NvFlexExtAsset* cachedAsset = NvFlexExtLoadCachedAsset(key);
+		if (cachedAsset)
+			return cachedAsset;
+	}
+
 	// Switch to relative coordinates by computing the mean position of the vertices and subtracting the result from every vertex position
 	// The increased precision will prevent ghost forces caused by inaccurate center of mass computations
 	Vec3 meshOffset(0.0f);
@@ -670,6 +600,8 @@ NvFlexExtAsset* NvFlexExtCreateSoftFromMesh(const float* vertices, int numVertic
 	asset->numShapeIndices = int(clusterIndices.size());
 	asset->numShapes = numClusters;
 
+	NvFlexExtStoreCachedAsset(key, asset);
+
 	return asset;
 }
 
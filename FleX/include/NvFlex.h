@@ -306,6 +306,7 @@ enum NvFlexComputeType
 	eNvFlexCUDA,		//!< Use CUDA compute for Flex, the application must link against the CUDA libraries
 	eNvFlexD3D11,		//!< Use DirectX 11 compute for Flex, the application must link against the D3D libraries
 	eNvFlexD3D12,		//!< Use DirectX 12 compute for Flex, the application must link against the D3D libraries
+	eNvFlexCPU,			//!< Use the multithreaded host solver, the application must link against the CPU libraries, supports cloth, rigids and shape collision but not fluids or diffuse particles
 };
 
 
@@ -320,7 +321,7 @@ struct NvFlexInitDesc
 	void* computeContext;           //!< Direct3D context to use for simulation, if none is specified a new context will be created, in DirectX 12 this should be a pointer to the ID3D12CommandQueue where compute operations will take place. 
 	bool runOnRenderContext;		//!< If true, run Flex on D3D11 render context, or D3D12 direct queue. If false, run on a D3D12 compute queue, or vendor specific D3D11 compute queue, allowing compute and graphics to run in parallel on some GPUs.
 
-	NvFlexComputeType computeType;	//!< Set to eNvFlexD3D11 if DirectX 11 should be used, eNvFlexD3D12 for DirectX 12, this must match the libraries used to link the application
+	NvFlexComputeType computeType;	//!< Set to eNvFlexD3D11 if DirectX 11 should be used, eNvFlexD3D12 for DirectX 12, eNvFlexCPU for the host solver, this must match the libraries used to link the application
 };
 
 /**
@@ -418,6 +418,25 @@ NV_FLEX_API int NvFlexExtCreateWeldedMeshIndices(const float* vertices, int numV
  */
 NV_FLEX_API NvFlexExtAsset* NvFlexExtCreateClothFromMesh(const float* particles, int numParticles, const int* indices, int numTriangles, float stretchStiffness, float bendStiffness, float tetherStiffness, float tetherGive, float pressure);
 
+/**
+ * Create a cloth asset in the same way as NvFlexExtCreateClothFromMesh(), but attach each free particle to several of its nearest fixed particles.
+ * Calling this with maxTethers = 1 produces exactly the same asset as NvFlexExtCreateClothFromMesh().
+ *
+ * @param[in] particles Positions and masses of the particles in the format [x, y, z, 1/m]
+ * @param[in] numParticles The number of particles
+ * @param[in] indices The triangle indices, these should be 'welded' using NvFlexExtCreateWeldedMeshIndices() first
+ * @param[in] numTriangles The number of triangles
+ * @param[in] stretchStiffness The stiffness coefficient for stretch constraints
+ * @param[in] bendStiffness The stiffness coefficient used for bending constraints
+ * @param[in] tetherStiffness If > 0.0f then the function will create tethers attached to particles with zero inverse mass
+ * @param[in] tetherGive The fraction of the tether rest length that the tether may extend before the constraint activates
+ * @param[in] maxTethers The maximum number of tethers per particle, each to one of the nearest particles with zero inverse mass
+ * @param[in] tetherFalloff Tethers beyond the nearest one have their stiffness scaled by (nearest distance/distance)^tetherFalloff, 0.0f gives all tethers equal stiffness
+ * @param[in] pressure If > 0.0f then a volume (pressure) constraint will also be added to the asset, the rest volume and stiffness will be automatically computed by this function
+ * @return A pointer to an asset structure holding the particles and constraints
+ */
+NV_FLEX_API NvFlexExtAsset* NvFlexExtCreateClothFromMeshWithTethers(const float* particles, int numParticles, const int* indices, int numTriangles, float stretchStiffness, float bendStiffness, float tetherStiffness, float tetherGive, int maxTethers, float tetherFalloff, float pressure);
+
 /**
  * Create a cloth asset consisting of stretch and bend distance constraints given an indexed triangle mesh. This creates an asset with the same
  * structure as NvFlexExtCreateClothFromMesh(), however tether constraints are not supported, and additional information regarding mesh topology
@@ -484,6 +503,27 @@ struct NvFlexExtTearingMeshEdit
  */
 NV_FLEX_API void NvFlexExtTearClothMesh(NvFlexExtAsset* asset, float maxStrain,  int maxSplits, NvFlexExtTearingParticleClone* particleCopies, int* numParticleCopies, int maxCopies, NvFlexExtTearingMeshEdit* triangleEdits, int* numTriangleEdits, int maxEdits);
 
+/**
+ * Counters describing the work done by the most recent call to NvFlexExtTearClothMesh()
+ */
+struct NvFlexExtTearingStats
+{
+	int numCandidates;		//!< Number of springs found above the strain threshold, scanning stops once maxSplits or maxCopies is reached
+	int numSplits;			//!< Number of vertex splits performed
+	int numParticleCopies;	//!< Number of particle copies output
+
+	float strainTime;		//!< Time in seconds spent evaluating spring strain
+	float splitTime;		//!< Time in seconds spent splitting vertices and updating topology
+};
+
+/**
+ * Retrieve counters for the most recent call to NvFlexExtTearClothMesh() on an asset
+ *
+ * @param[in] asset The asset, this must be created with NvFlexExtCreateTearingClothFromMesh()
+ * @param[out] stats Pointer to a structure that will be filled with the counters
+ */
+NV_FLEX_API void NvFlexExtGetTearingStats(NvFlexExtAsset* asset, NvFlexExtTearingStats* stats);
+
 /**
  * Create a shape body asset from a closed triangle mesh. The mesh is first voxelized at a spacing specified by the radius, and particles are placed at occupied voxels.
  *
@@ -525,6 +565,64 @@ NV_FLEX_API NvFlexExtAsset* NvFlexExtCreateSoftFromMesh(const float* vertices, i
  */
 NV_FLEX_API void NvFlexExtDestroyAsset(NvFlexExtAsset* asset);
 
+/**
+ * Writes an asset to a binary file. The file holds a versioned header followed by each of the asset's arrays, aligned to 64 bytes so the file may be memory mapped and used in place.
+ *
+ * @param[in] filename The file to write
+ * @param[in] key A value identifying how the asset was created, e.g.: from NvFlexExtHashAssetData(), that is checked when the asset is loaded
+ * @param[in] asset The asset to write
+ * @return True if the file was written
+ */
+NV_FLEX_API bool NvFlexExtSaveAsset(const char* filename, unsigned long long key, const NvFlexExtAsset* asset);
+
+/**
+ * Reads an asset written by NvFlexExtSaveAsset().
+ *
+ * @param[in] filename The file to read
+ * @param[in] key The key the asset was saved with
+ * @return A new asset that should be freed with NvFlexExtDestroyAsset(), or NULL if the file is missing, truncated, has a different key, or was written by a different version
+ */
+NV_FLEX_API NvFlexExtAsset* NvFlexExtLoadAsset(const char* filename, unsigned long long key);
+
+/**
+ * Accumulates data into a 64 bit hash used to key cached assets, the hash includes the asset format version so cooked assets are invalidated when asset creation changes.
+ *
+ * @param[in] hash The hash of the preceding data, or 0 to start a new hash
+ * @param[in] data The data to hash
+ * @param[in] numBytes The size of the data in bytes
+ * @return The updated hash
+ */
+NV_FLEX_API unsigned long long NvFlexExtHashAssetData(unsigned long long hash, const void* data, int numBytes);
+
+/**
+ * Sets a directory where cooked assets are cached. When set, NvFlexExtCreateClothFromMesh(), NvFlexExtCreateClothFromMeshWithTethers(), NvFlexExtCreateRigidFromMesh() and NvFlexExtCreateSoftFromMesh()
+ * hash their mesh and parameters, load a matching asset from the directory if one exists and otherwise store the asset they create. The directory must already exist and may be shared by multiple processes.
+ *
+ * @param[in] path The cache directory, or NULL to disable caching (the default)
+ */
+NV_FLEX_API void NvFlexExtSetAssetCacheDirectory(const char* path);
+
+/**
+ * Returns true if a cache directory has been set with NvFlexExtSetAssetCacheDirectory(), callers can skip hashing their inputs when it is not.
+ */
+NV_FLEX_API bool NvFlexExtGetAssetCacheEnabled();
+
+/**
+ * Loads an asset from the cache directory.
+ *
+ * @param[in] key The key the asset was stored with
+ * @return A new asset that should be freed with NvFlexExtDestroyAsset(), or NULL if caching is disabled or there is no matching asset
+ */
+NV_FLEX_API NvFlexExtAsset* NvFlexExtLoadCachedAsset(unsigned long long key);
+
+/**
+ * Stores an asset in the cache directory, does nothing if caching is disabled.
+ *
+ * @param[in] key The key identifying the asset
+ * @param[in] asset The asset to store
+ */
+NV_FLEX_API void NvFlexExtStoreCachedAsset(unsigned long long key, const NvFlexExtAsset* asset);
+
 /**
 * Creates information for linear blend skining a graphics mesh to a set of transforms (bones)
 *
@@ -544,7 +642,7 @@ NV_FLEX_API void NvFlexExtCreateSoftMeshSkinning(const float* vertices, int numV
  *
  * @param[in] lib The library instance to use
  * @param[in] solver The solver to wrap
- * @param[in] maxParticles The maximum number of particles to manage
+ * @param[in] maxParticles The maximum number of particles to manage, the last slot is reserved for the constraints of destroyed instances so at most maxParticles-1 can be allocated
  * @return A pointer to the new container
  */
 NV_FLEX_API NvFlexExtContainer* NvFlexExtCreateContainer(NvFlexLibrary* lib, NvFlexSolver* solver, int maxParticles);
@@ -606,6 +704,19 @@ struct NvFlexExtParticleData
 NV_FLEX_API NvFlexExtParticleData NvFlexExtMapParticleData(NvFlexExtContainer* container);
 NV_FLEX_API void NvFlexExtUnmapParticleData(NvFlexExtContainer* container);
 
+/**
+ * Moves allocated particles into the lowest slots so the active particles form a single contiguous range. Instance particle 
+ * indices and constraints are remapped by the container, indices of particles allocated with NvFlexExtAllocParticles() must be 
+ * remapped by the caller using the reported moves
+ *
+ * @param[in] container The container to compact
+ * @param[in] particleData Pointer to a mapped particle data struct, returned from NvFlexExtMapParticleData()
+ * @param[out] movedFrom Receives the old index of each moved particle, may be NULL, should have room for the number of active particles
+ * @param[out] movedTo Receives the new index of each moved particle, may be NULL, should have room for the number of active particles
+ * @return The number of moved particles
+ */
+NV_FLEX_API int NvFlexExtCompactParticles(NvFlexExtContainer* container, NvFlexExtParticleData* particleData, int* movedFrom, int* movedTo);
+
 struct NvFlexExtTriangleData
 {
 	int* indices;		//!< Receives a pointer to the array of triangle index data
@@ -660,6 +771,25 @@ NV_FLEX_API void NvFlexExtUnmapShapeData(NvFlexExtContainer* container);
  */
 NV_FLEX_API NvFlexExtInstance* NvFlexExtCreateInstance(NvFlexExtContainer* container,  NvFlexExtParticleData* particleData, const NvFlexExtAsset* asset, const float* transform, float vx, float vy, float vz, int phase, float invMassScale);
 
+/**
+ * Creates instances of many assets in one call, equivalent to calling NvFlexExtCreateInstance() for each instance in order but
+ * writing the particle data of all instances in parallel. Constraints of all new instances are written on the next push to the device.
+ *
+ * @param[in] container The container to spawn into
+ * @param[in] particleData Pointer to a mapped particle data struct, returned from NvFlexExtMapParticleData()
+ * @param[in] assets The asset of each instance
+ * @param[in] transforms A 4x4 column major, column vector transform per instance, 16 floats each
+ * @param[in] phases The phase used for the particles of each instance
+ * @param[in] numInstances The number of instances to create
+ * @param[in] vx The velocity of the particles along the x axis
+ * @param[in] vy The velocity of the particles along the y axis
+ * @param[in] vz The velocity of the particles along the z axis
+ * @param[in] invMassScale A factor applied to the per particle inverse mass
+ * @param[out] instances Receives a pointer to each created instance
+ * @return The number of instances created, creation stops at the first instance that does not fit in the container
+ */
+NV_FLEX_API int NvFlexExtCreateInstances(NvFlexExtContainer* container, NvFlexExtParticleData* particleData, const NvFlexExtAsset* const* assets, const float* transforms, const int* phases, int numInstances, float vx, float vy, float vz, float invMassScale, NvFlexExtInstance** instances);
+
 /** Destoy an instance of an asset
  *
  * @param[in] container The container the instance belongs to
@@ -675,6 +805,15 @@ NV_FLEX_API void NvFlexExtDestroyInstance(NvFlexExtContainer* container, const N
  */
 NV_FLEX_API void NvFlexExtNotifyAssetChanged(NvFlexExtContainer* container, const NvFlexExtAsset* asset);
 
+/** Sets the fraction of inert constraints at which the container repacks its constraint arrays. Destroyed instances 
+ *  leave their constraints inert and their ranges are reused by new instances, only the constraints of created, destroyed
+ *  or changed instances are rewritten until the inert fraction of springs, triangles or shapes exceeds the threshold
+ *
+ * @param[in] container The container
+ * @param[in] threshold Fraction of inert constraints in [0, 1], 0 repacks on every change, the default is 0.5
+ */
+NV_FLEX_API void NvFlexExtSetDefragmentThreshold(NvFlexExtContainer* container, float threshold);
+
 /**
  * Updates the container, applies force fields, steps the solver forward in time, updates the host with the results synchronously.
  * This is a helper function which performs a synchronous update using the following flow.
@@ -786,6 +925,25 @@ NV_FLEX_API void NvFlexExtDestroyForceFieldCallback(NvFlexExtForceFieldCallback*
  */
 NV_FLEX_API void NvFlexExtSetForceFields(NvFlexExtForceFieldCallback* callback, const NvFlexExtForceField* forceFields, int numForceFields);
 
+/**
+ * Applies force fields to particles on the host with the same semantics as the force field callback, for builds and 
+ * tools without a device. Particles are processed in parallel SIMD blocks and fields are binned in a uniform grid when there are many.
+ *
+ * @param[in] forceFields A pointer to an array of force field data in host memory
+ * @param[in] numForceFields The number of force fields
+ * @param[in] particles A pointer to an array of particle positions in (x, y, z, 1/m) format
+ * @param[in,out] velocities A pointer to an array of particle velocities in (vx, vy, vz) format
+ * @param[in] numParticles The number of particles to update
+ * @param[in] dt The time step used for eNvFlexExtModeForce fields
+ */
+NV_FLEX_API void NvFlexExtApplyForceFields(const NvFlexExtForceField* forceFields, int numForceFields, const float* particles, float* velocities, int numParticles, float dt);
+
+/**
+ * Serial scalar version of NvFlexExtApplyForceFields() that follows the device kernel step by step, use it to validate 
+ * device results read back with NvFlexGetVelocities() or the results of NvFlexExtApplyForceFields()
+ */
+NV_FLEX_API void NvFlexExtApplyForceFieldsReference(const NvFlexExtForceField* forceFields, int numForceFields, const float* particles, float* velocities, int numParticles, float dt);
+
 /**
 * Create a soft joint, the container will internally store a reference to the joint array
 *
@@ -33,6 +33,8 @@
 #include <algorithm>
 #include <stdint.h>
 
+#include "hostchecks.h"
+
 const char* g_benchmarkFilename = "../../benchmark.txt";
 std::wofstream g_benchmarkFile;
 
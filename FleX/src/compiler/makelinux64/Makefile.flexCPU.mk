@@ -0,0 +1,172 @@
+# Makefile generated by XPJ for linux64
+-include Makefile.custom
+ProjectName = flexCPU
+flexCPU_cppfiles   += ./../../../src/cpu/collision.cpp
+flexCPU_cppfiles   += ./../../../src/cpu/flex.cpp
+flexCPU_cppfiles   += ./../../../src/cpu/solver.cpp
+flexCPU_cppfiles   += ./../../../core/aerodynamics.cpp
+flexCPU_cppfiles   += ./../../../core/hashgrid.cpp
+flexCPU_cppfiles   += ./../../../core/maths.cpp
+flexCPU_cppfiles   += ./../../../core/threadpool.cpp
+
+flexCPU_cpp_release_dep    = $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexCPU_cppfiles)))))
+flexCPU_cc_release_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.release.P, $(flexCPU_ccfiles)))))
+flexCPU_c_release_dep      = $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.P, $(flexCPU_cfiles)))))
+flexCPU_release_dep      = $(flexCPU_cpp_release_dep) $(flexCPU_cc_release_dep) $(flexCPU_c_release_dep)
+-include $(flexCPU_release_dep)
+flexCPU_cpp_debug_dep    = $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexCPU_cppfiles)))))
+flexCPU_cc_debug_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.debug.P, $(flexCPU_ccfiles)))))
+flexCPU_c_debug_dep      = $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.P, $(flexCPU_cfiles)))))
+flexCPU_debug_dep      = $(flexCPU_cpp_debug_dep) $(flexCPU_cc_debug_dep) $(flexCPU_c_debug_dep)
+-include $(flexCPU_debug_dep)
+flexCPU_release_hpaths    := 
+flexCPU_release_hpaths    += ./../../..
+flexCPU_release_lpaths    := 
+flexCPU_release_defines   := $(flexCPU_custom_defines)
+flexCPU_release_libraries := 
+flexCPU_release_common_cflags	:= $(flexCPU_custom_cflags)
+flexCPU_release_common_cflags    += -MMD
+flexCPU_release_common_cflags    += $(addprefix -D, $(flexCPU_release_defines))
+flexCPU_release_common_cflags    += $(addprefix -I, $(flexCPU_release_hpaths))
+flexCPU_release_common_cflags  += -m64
+flexCPU_release_common_cflags  += -Wall -std=c++0x -fPIC -fpermissive -fno-strict-aliasing
+flexCPU_release_common_cflags  += -O3 -ffast-math -DNDEBUG
+flexCPU_release_cflags	:= $(flexCPU_release_common_cflags)
+flexCPU_release_cppflags	:= $(flexCPU_release_common_cflags)
+flexCPU_release_lflags    := $(flexCPU_custom_lflags)
+flexCPU_release_lflags    += $(addprefix -L, $(flexCPU_release_lpaths))
+flexCPU_release_lflags    += -Wl,--start-group $(addprefix -l, $(flexCPU_release_libraries)) -Wl,--end-group
+flexCPU_release_lflags  += -m64
+flexCPU_release_objsdir  = $(OBJS_DIR)/flexCPU_release
+flexCPU_release_cpp_o    = $(addprefix $(flexCPU_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexCPU_cppfiles)))))
+flexCPU_release_cc_o    = $(addprefix $(flexCPU_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexCPU_ccfiles)))))
+flexCPU_release_c_o      = $(addprefix $(flexCPU_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexCPU_cfiles)))))
+flexCPU_release_obj      = $(flexCPU_release_cpp_o) $(flexCPU_release_cc_o) $(flexCPU_release_c_o)
+flexCPU_release_bin      := ./../../../lib/linux64/NvFlexReleaseCPU_x64.a
+
+clean_flexCPU_release: 
+	@$(ECHO) clean flexCPU release
+	@$(RMDIR) $(flexCPU_release_objsdir)
+	@$(RMDIR) $(flexCPU_release_bin)
+	@$(RMDIR) $(DEPSDIR)/flexCPU/release
+
+build_flexCPU_release: postbuild_flexCPU_release
+postbuild_flexCPU_release: mainbuild_flexCPU_release
+mainbuild_flexCPU_release: prebuild_flexCPU_release $(flexCPU_release_bin)
+prebuild_flexCPU_release:
+
+$(flexCPU_release_bin): $(flexCPU_release_obj) 
+	mkdir -p `dirname ./../../../lib/linux64/NvFlexReleaseCPU_x64.a`
+	@$(AR) rcs $(flexCPU_release_bin) $(flexCPU_release_obj)
+	$(ECHO) building $@ complete!
+
+flexCPU_release_DEPDIR = $(dir $(@))/$(*F)
+$(flexCPU_release_cpp_o): $(flexCPU_release_objsdir)/%.o:
+	$(ECHO) flexCPU: compiling release $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cppfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCPU_release_cppflags) -c $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cppfiles)) -o $@
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cppfiles))))))
+	cp $(flexCPU_release_DEPDIR).d $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cppfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCPU_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cppfiles))))).P; \
+	  rm -f $(flexCPU_release_DEPDIR).d
+
+$(flexCPU_release_cc_o): $(flexCPU_release_objsdir)/%.o:
+	$(ECHO) flexCPU: compiling release $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_ccfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCPU_release_cppflags) -c $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_ccfiles)) -o $@
+	mkdir -p $(dir $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_ccfiles))))))
+	cp $(flexCPU_release_DEPDIR).d $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_ccfiles))))).release.P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCPU_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_ccfiles))))).release.P; \
+	  rm -f $(flexCPU_release_DEPDIR).d
+
+$(flexCPU_release_c_o): $(flexCPU_release_objsdir)/%.o:
+	$(ECHO) flexCPU: compiling release $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cfiles))...
+	mkdir -p $(dir $(@))
+	$(CC) $(flexCPU_release_cflags) -c $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cfiles)) -o $@ 
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cfiles))))))
+	cp $(flexCPU_release_DEPDIR).d $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCPU_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_release_objsdir),, $@))), $(flexCPU_cfiles))))).P; \
+	  rm -f $(flexCPU_release_DEPDIR).d
+
+flexCPU_debug_hpaths    := 
+flexCPU_debug_hpaths    += ./../../..
+flexCPU_debug_lpaths    := 
+flexCPU_debug_defines   := $(flexCPU_custom_defines)
+flexCPU_debug_libraries := 
+flexCPU_debug_common_cflags	:= $(flexCPU_custom_cflags)
+flexCPU_debug_common_cflags    += -MMD
+flexCPU_debug_common_cflags    += $(addprefix -D, $(flexCPU_debug_defines))
+flexCPU_debug_common_cflags    += $(addprefix -I, $(flexCPU_debug_hpaths))
+flexCPU_debug_common_cflags  += -m64
+flexCPU_debug_common_cflags  += -Wall -std=c++0x -fPIC -fpermissive -fno-strict-aliasing
+flexCPU_debug_common_cflags  += -g -O0
+flexCPU_debug_cflags	:= $(flexCPU_debug_common_cflags)
+flexCPU_debug_cppflags	:= $(flexCPU_debug_common_cflags)
+flexCPU_debug_lflags    := $(flexCPU_custom_lflags)
+flexCPU_debug_lflags    += $(addprefix -L, $(flexCPU_debug_lpaths))
+flexCPU_debug_lflags    += -Wl,--start-group $(addprefix -l, $(flexCPU_debug_libraries)) -Wl,--end-group
+flexCPU_debug_lflags  += -m64
+flexCPU_debug_objsdir  = $(OBJS_DIR)/flexCPU_debug
+flexCPU_debug_cpp_o    = $(addprefix $(flexCPU_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexCPU_cppfiles)))))
+flexCPU_debug_cc_o    = $(addprefix $(flexCPU_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexCPU_ccfiles)))))
+flexCPU_debug_c_o      = $(addprefix $(flexCPU_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexCPU_cfiles)))))
+flexCPU_debug_obj      = $(flexCPU_debug_cpp_o) $(flexCPU_debug_cc_o) $(flexCPU_debug_c_o)
+flexCPU_debug_bin      := ./../../../lib/linux64/NvFlexDebugCPU_x64.a
+
+clean_flexCPU_debug: 
+	@$(ECHO) clean flexCPU debug
+	@$(RMDIR) $(flexCPU_debug_objsdir)
+	@$(RMDIR) $(flexCPU_debug_bin)
+	@$(RMDIR) $(DEPSDIR)/flexCPU/debug
+
+build_flexCPU_debug: postbuild_flexCPU_debug
+postbuild_flexCPU_debug: mainbuild_flexCPU_debug
+mainbuild_flexCPU_debug: prebuild_flexCPU_debug $(flexCPU_debug_bin)
+prebuild_flexCPU_debug:
+
+$(flexCPU_debug_bin): $(flexCPU_debug_obj) 
+	mkdir -p `dirname ./../../../lib/linux64/NvFlexDebugCPU_x64.a`
+	@$(AR) rcs $(flexCPU_debug_bin) $(flexCPU_debug_obj)
+	$(ECHO) building $@ complete!
+
+flexCPU_debug_DEPDIR = $(dir $(@))/$(*F)
+$(flexCPU_debug_cpp_o): $(flexCPU_debug_objsdir)/%.o:
+	$(ECHO) flexCPU: compiling debug $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cppfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCPU_debug_cppflags) -c $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cppfiles)) -o $@
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cppfiles))))))
+	cp $(flexCPU_debug_DEPDIR).d $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cppfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCPU_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cppfiles))))).P; \
+	  rm -f $(flexCPU_debug_DEPDIR).d
+
+$(flexCPU_debug_cc_o): $(flexCPU_debug_objsdir)/%.o:
+	$(ECHO) flexCPU: compiling debug $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_ccfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCPU_debug_cppflags) -c $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_ccfiles)) -o $@
+	mkdir -p $(dir $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_ccfiles))))))
+	cp $(flexCPU_debug_DEPDIR).d $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_ccfiles))))).debug.P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCPU_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_ccfiles))))).debug.P; \
+	  rm -f $(flexCPU_debug_DEPDIR).d
+
+$(flexCPU_debug_c_o): $(flexCPU_debug_objsdir)/%.o:
+	$(ECHO) flexCPU: compiling debug $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cfiles))...
+	mkdir -p $(dir $(@))
+	$(CC) $(flexCPU_debug_cflags) -c $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cfiles)) -o $@ 
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cfiles))))))
+	cp $(flexCPU_debug_DEPDIR).d $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCPU_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCPU_debug_objsdir),, $@))), $(flexCPU_cfiles))))).P; \
+	  rm -f $(flexCPU_debug_DEPDIR).d
+
+clean_flexCPU:  clean_flexCPU_release clean_flexCPU_debug
+	rm -rf $(DEPSDIR)
+
+export VERBOSE
+ifndef VERBOSE
+.SILENT:
+endif
@@ -0,0 +1,188 @@
+# Makefile generated by XPJ for linux64
+-include Makefile.custom
+ProjectName = flexCheck
+flexCheck_cppfiles   += ./../../main_check.cpp
+flexCheck_cppfiles   += ./../../../core/aerodynamics.cpp
+flexCheck_cppfiles   += ./../../../core/bending.cpp
+flexCheck_cppfiles   += ./../../../core/core.cpp
+flexCheck_cppfiles   += ./../../../core/heightfield.cpp
+flexCheck_cppfiles   += ./../../../core/maths.cpp
+flexCheck_cppfiles   += ./../../../core/perlin.cpp
+flexCheck_cppfiles   += ./../../../core/platform.cpp
+flexCheck_cppfiles   += ./../../../core/reorder.cpp
+flexCheck_cppfiles   += ./../../../core/sdf.cpp
+flexCheck_cppfiles   += ./../../../core/skinning.cpp
+flexCheck_cppfiles   += ./../../../core/springs.cpp
+flexCheck_cppfiles   += ./../../../core/tether.cpp
+flexCheck_cppfiles   += ./../../../core/threadpool.cpp
+flexCheck_cppfiles   += ./../../../core/windfield.cpp
+
+flexCheck_cpp_release_dep    = $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexCheck_cppfiles)))))
+flexCheck_cc_release_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.release.P, $(flexCheck_ccfiles)))))
+flexCheck_c_release_dep      = $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.P, $(flexCheck_cfiles)))))
+flexCheck_release_dep      = $(flexCheck_cpp_release_dep) $(flexCheck_cc_release_dep) $(flexCheck_c_release_dep)
+-include $(flexCheck_release_dep)
+flexCheck_cpp_debug_dep    = $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexCheck_cppfiles)))))
+flexCheck_cc_debug_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.debug.P, $(flexCheck_ccfiles)))))
+flexCheck_c_debug_dep      = $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.P, $(flexCheck_cfiles)))))
+flexCheck_debug_dep      = $(flexCheck_cpp_debug_dep) $(flexCheck_cc_debug_dep) $(flexCheck_c_debug_dep)
+-include $(flexCheck_debug_dep)
+flexCheck_release_hpaths    := 
+flexCheck_release_hpaths    += ./../../..
+flexCheck_release_lpaths    := 
+flexCheck_release_lpaths    += ./../../../lib/linux64
+flexCheck_release_defines   := $(flexCheck_custom_defines)
+flexCheck_release_libraries := 
+flexCheck_release_libraries += :NvFlexExtReleaseCPU_x64.a
+flexCheck_release_libraries += :NvFlexReleaseCPU_x64.a
+flexCheck_release_common_cflags	:= $(flexCheck_custom_cflags)
+flexCheck_release_common_cflags    += -MMD
+flexCheck_release_common_cflags    += $(addprefix -D, $(flexCheck_release_defines))
+flexCheck_release_common_cflags    += $(addprefix -I, $(flexCheck_release_hpaths))
+flexCheck_release_common_cflags  += -m64
+flexCheck_release_common_cflags  += -Wall -std=c++0x -fPIC -fpermissive -fno-strict-aliasing
+flexCheck_release_common_cflags  += -O3 -ffast-math -DNDEBUG
+flexCheck_release_cflags	:= $(flexCheck_release_common_cflags)
+flexCheck_release_cppflags	:= $(flexCheck_release_common_cflags)
+flexCheck_release_lflags    := $(flexCheck_custom_lflags)
+flexCheck_release_lflags    += $(addprefix -L, $(flexCheck_release_lpaths))
+flexCheck_release_lflags    += -Wl,--start-group $(addprefix -l, $(flexCheck_release_libraries)) -Wl,--end-group
+flexCheck_release_lflags  += -g -ldl -lrt -pthread
+flexCheck_release_lflags  += -m64
+flexCheck_release_objsdir  = $(OBJS_DIR)/flexCheck_release
+flexCheck_release_cpp_o    = $(addprefix $(flexCheck_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexCheck_cppfiles)))))
+flexCheck_release_cc_o    = $(addprefix $(flexCheck_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexCheck_ccfiles)))))
+flexCheck_release_c_o      = $(addprefix $(flexCheck_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexCheck_cfiles)))))
+flexCheck_release_obj      = $(flexCheck_release_cpp_o) $(flexCheck_release_cc_o) $(flexCheck_release_c_o)
+flexCheck_release_bin      := ./../../../bin/linux64/NvFlexCheckRelease_x64
+
+clean_flexCheck_release: 
+	@$(ECHO) clean flexCheck release
+	@$(RMDIR) $(flexCheck_release_objsdir)
+	@$(RMDIR) $(flexCheck_release_bin)
+	@$(RMDIR) $(DEPSDIR)/flexCheck/release
+
+build_flexCheck_release: postbuild_flexCheck_release
+postbuild_flexCheck_release: mainbuild_flexCheck_release
+mainbuild_flexCheck_release: prebuild_flexCheck_release $(flexCheck_release_bin)
+prebuild_flexCheck_release:
+
+$(flexCheck_release_bin): $(flexCheck_release_obj) build_flexExtCPU_release 
+	mkdir -p `dirname ./../../../bin/linux64/NvFlexCheckRelease_x64`
+	$(CCLD) $(flexCheck_release_obj) $(flexCheck_release_lflags) -o $(flexCheck_release_bin) 
+	$(ECHO) building $@ complete!
+
+flexCheck_release_DEPDIR = $(dir $(@))/$(*F)
+$(flexCheck_release_cpp_o): $(flexCheck_release_objsdir)/%.o:
+	$(ECHO) flexCheck: compiling release $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cppfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCheck_release_cppflags) -c $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cppfiles)) -o $@
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cppfiles))))))
+	cp $(flexCheck_release_DEPDIR).d $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cppfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCheck_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cppfiles))))).P; \
+	  rm -f $(flexCheck_release_DEPDIR).d
+
+$(flexCheck_release_cc_o): $(flexCheck_release_objsdir)/%.o:
+	$(ECHO) flexCheck: compiling release $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_ccfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCheck_release_cppflags) -c $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_ccfiles)) -o $@
+	mkdir -p $(dir $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_ccfiles))))))
+	cp $(flexCheck_release_DEPDIR).d $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_ccfiles))))).release.P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCheck_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_ccfiles))))).release.P; \
+	  rm -f $(flexCheck_release_DEPDIR).d
+
+$(flexCheck_release_c_o): $(flexCheck_release_objsdir)/%.o:
+	$(ECHO) flexCheck: compiling release $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cfiles))...
+	mkdir -p $(dir $(@))
+	$(CC) $(flexCheck_release_cflags) -c $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cfiles)) -o $@ 
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cfiles))))))
+	cp $(flexCheck_release_DEPDIR).d $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCheck_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCheck/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_release_objsdir),, $@))), $(flexCheck_cfiles))))).P; \
+	  rm -f $(flexCheck_release_DEPDIR).d
+
+flexCheck_debug_hpaths    := 
+flexCheck_debug_hpaths    += ./../../..
+flexCheck_debug_lpaths    := 
+flexCheck_debug_lpaths    += ./../../../lib/linux64
+flexCheck_debug_defines   := $(flexCheck_custom_defines)
+flexCheck_debug_libraries := 
+flexCheck_debug_libraries += :NvFlexExtDebugCPU_x64.a
+flexCheck_debug_libraries += :NvFlexDebugCPU_x64.a
+flexCheck_debug_common_cflags	:= $(flexCheck_custom_cflags)
+flexCheck_debug_common_cflags    += -MMD
+flexCheck_debug_common_cflags    += $(addprefix -D, $(flexCheck_debug_defines))
+flexCheck_debug_common_cflags    += $(addprefix -I, $(flexCheck_debug_hpaths))
+flexCheck_debug_common_cflags  += -m64
+flexCheck_debug_common_cflags  += -Wall -std=c++0x -fPIC -fpermissive -fno-strict-aliasing
+flexCheck_debug_common_cflags  += -g -O0
+flexCheck_debug_cflags	:= $(flexCheck_debug_common_cflags)
+flexCheck_debug_cppflags	:= $(flexCheck_debug_common_cflags)
+flexCheck_debug_lflags    := $(flexCheck_custom_lflags)
+flexCheck_debug_lflags    += $(addprefix -L, $(flexCheck_debug_lpaths))
+flexCheck_debug_lflags    += -Wl,--start-group $(addprefix -l, $(flexCheck_debug_libraries)) -Wl,--end-group
+flexCheck_debug_lflags  += -g -ldl -lrt -pthread
+flexCheck_debug_lflags  += -m64
+flexCheck_debug_objsdir  = $(OBJS_DIR)/flexCheck_debug
+flexCheck_debug_cpp_o    = $(addprefix $(flexCheck_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexCheck_cppfiles)))))
+flexCheck_debug_cc_o    = $(addprefix $(flexCheck_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexCheck_ccfiles)))))
+flexCheck_debug_c_o      = $(addprefix $(flexCheck_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexCheck_cfiles)))))
+flexCheck_debug_obj      = $(flexCheck_debug_cpp_o) $(flexCheck_debug_cc_o) $(flexCheck_debug_c_o)
+flexCheck_debug_bin      := ./../../../bin/linux64/NvFlexCheckDebug_x64
+
+clean_flexCheck_debug: 
+	@$(ECHO) clean flexCheck debug
+	@$(RMDIR) $(flexCheck_debug_objsdir)
+	@$(RMDIR) $(flexCheck_debug_bin)
+	@$(RMDIR) $(DEPSDIR)/flexCheck/debug
+
+build_flexCheck_debug: postbuild_flexCheck_debug
+postbuild_flexCheck_debug: mainbuild_flexCheck_debug
+mainbuild_flexCheck_debug: prebuild_flexCheck_debug $(flexCheck_debug_bin)
+prebuild_flexCheck_debug:
+
+$(flexCheck_debug_bin): $(flexCheck_debug_obj) build_flexExtCPU_debug 
+	mkdir -p `dirname ./../../../bin/linux64/NvFlexCheckDebug_x64`
+	$(CCLD) $(flexCheck_debug_obj) $(flexCheck_debug_lflags) -o $(flexCheck_debug_bin) 
+	$(ECHO) building $@ complete!
+
+flexCheck_debug_DEPDIR = $(dir $(@))/$(*F)
+$(flexCheck_debug_cpp_o): $(flexCheck_debug_objsdir)/%.o:
+	$(ECHO) flexCheck: compiling debug $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cppfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCheck_debug_cppflags) -c $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cppfiles)) -o $@
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cppfiles))))))
+	cp $(flexCheck_debug_DEPDIR).d $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cppfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCheck_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cppfiles))))).P; \
+	  rm -f $(flexCheck_debug_DEPDIR).d
+
+$(flexCheck_debug_cc_o): $(flexCheck_debug_objsdir)/%.o:
+	$(ECHO) flexCheck: compiling debug $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_ccfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexCheck_debug_cppflags) -c $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_ccfiles)) -o $@
+	mkdir -p $(dir $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_ccfiles))))))
+	cp $(flexCheck_debug_DEPDIR).d $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_ccfiles))))).debug.P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCheck_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_ccfiles))))).debug.P; \
+	  rm -f $(flexCheck_debug_DEPDIR).d
+
+$(flexCheck_debug_c_o): $(flexCheck_debug_objsdir)/%.o:
+	$(ECHO) flexCheck: compiling debug $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cfiles))...
+	mkdir -p $(dir $(@))
+	$(CC) $(flexCheck_debug_cflags) -c $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cfiles)) -o $@ 
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cfiles))))))
+	cp $(flexCheck_debug_DEPDIR).d $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexCheck_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexCheck/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexCheck_debug_objsdir),, $@))), $(flexCheck_cfiles))))).P; \
+	  rm -f $(flexCheck_debug_DEPDIR).d
+
+clean_flexCheck:  clean_flexCheck_release clean_flexCheck_debug
+	rm -rf $(DEPSDIR)
+
+export VERBOSE
+ifndef VERBOSE
+.SILENT:
+endif
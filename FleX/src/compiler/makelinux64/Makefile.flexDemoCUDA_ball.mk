@@ -1,22 +1,42 @@
 # Makefile generated by XPJ for linux64
 -include Makefile.custom
 ProjectName = flexDemoCUDA
+# FLEX_COMPUTE=CPU links the host solver libraries instead of CUDA
+FLEX_COMPUTE ?= CUDA
+ifeq ($(FLEX_COMPUTE),CPU)
+flexDemoCUDA_custom_defines += NV_FLEX_CPU
+flexDemoCUDA_compute_lflags :=
+else
+flexDemoCUDA_compute_lflags := -lcudart_static
+endif
 flexDemoCUDA_cppfiles   += ./../../imgui.cpp
 flexDemoCUDA_cppfiles   += ./../../main_ball.cpp
 flexDemoCUDA_cppfiles   += ./../../opengl/imguiRenderGL.cpp
 flexDemoCUDA_cppfiles   += ./../../opengl/shader.cpp
 flexDemoCUDA_cppfiles   += ./../../opengl/shadersGL.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/aabbtree.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/aerodynamics.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/core.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/decompose.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/extrude.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/hashgrid.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/heightfield.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/maths.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/mesh.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/perlin.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/pfm.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/platform.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/remesh.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/reorder.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/sample.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/sdf.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/skinning.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/springs.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/tether.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/tga.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/threadpool.cpp
 flexDemoCUDA_cppfiles   += ./../../../core/voxelize.cpp
+flexDemoCUDA_cppfiles   += ./../../../core/windfield.cpp
 
 flexDemoCUDA_cpp_release_dep    = $(addprefix $(DEPSDIR)/flexDemoCUDA/release/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexDemoCUDA_cppfiles)))))
 flexDemoCUDA_cc_release_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.release.P, $(flexDemoCUDA_ccfiles)))))
@@ -38,9 +58,9 @@ flexDemoCUDA_release_lpaths    += /usr/local/cuda/lib64
 flexDemoCUDA_release_lpaths    += ./../../../lib/linux64
 flexDemoCUDA_release_defines   := $(flexDemoCUDA_custom_defines)
 flexDemoCUDA_release_libraries := 
-flexDemoCUDA_release_libraries += :NvFlexExtReleaseCUDA_x64.a
-flexDemoCUDA_release_libraries += :NvFlexReleaseCUDA_x64.a
-flexDemoCUDA_release_libraries += :NvFlexExtReleaseCUDA_x64.a
+flexDemoCUDA_release_libraries += :NvFlexExtRelease$(FLEX_COMPUTE)_x64.a
+flexDemoCUDA_release_libraries += :NvFlexRelease$(FLEX_COMPUTE)_x64.a
+flexDemoCUDA_release_libraries += :NvFlexExtRelease$(FLEX_COMPUTE)_x64.a
 flexDemoCUDA_release_libraries += :libSDL2.a
 flexDemoCUDA_release_libraries += :libSDL2main.a
 flexDemoCUDA_release_common_cflags	:= $(flexDemoCUDA_custom_cflags)
@@ -55,14 +75,14 @@ flexDemoCUDA_release_cppflags	:= $(flexDemoCUDA_release_common_cflags)
 flexDemoCUDA_release_lflags    := $(flexDemoCUDA_custom_lflags)
 flexDemoCUDA_release_lflags    += $(addprefix -L, $(flexDemoCUDA_release_lpaths))
 flexDemoCUDA_release_lflags    += -Wl,--start-group $(addprefix -l, $(flexDemoCUDA_release_libraries)) -Wl,--end-group
-flexDemoCUDA_release_lflags  += -g -L../../../external/glew/lib/linux -L/usr/lib -L"../../../lib/linux64" -L../../../external/SDL2-2.0.4/lib/x64/ -L/usr/local/cuda/lib64 -L../../../external/yaml-cpp/lib/ -lGL -lglut -lGLU -lGLEW -lpng -lyaml-cpp -lcudart_static -ldl -lrt -pthread
+flexDemoCUDA_release_lflags  += -g -L../../../external/glew/lib/linux -L/usr/lib -L"../../../lib/linux64" -L../../../external/SDL2-2.0.4/lib/x64/ -L/usr/local/cuda/lib64 -L../../../external/yaml-cpp/lib/ -lGL -lglut -lGLU -lGLEW -lpng -lyaml-cpp $(flexDemoCUDA_compute_lflags) -ldl -lrt -pthread
 flexDemoCUDA_release_lflags  += -m64
-flexDemoCUDA_release_objsdir  = $(OBJS_DIR)/flexDemoCUDA_release
+flexDemoCUDA_release_objsdir  = $(OBJS_DIR)/flexDemo$(FLEX_COMPUTE)_release
 flexDemoCUDA_release_cpp_o    = $(addprefix $(flexDemoCUDA_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexDemoCUDA_cppfiles)))))
 flexDemoCUDA_release_cc_o    = $(addprefix $(flexDemoCUDA_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexDemoCUDA_ccfiles)))))
 flexDemoCUDA_release_c_o      = $(addprefix $(flexDemoCUDA_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexDemoCUDA_cfiles)))))
 flexDemoCUDA_release_obj      = $(flexDemoCUDA_release_cpp_o) $(flexDemoCUDA_release_cc_o) $(flexDemoCUDA_release_c_o)
-flexDemoCUDA_release_bin      := ./../../../bin/linux64/NvFlexDemoReleaseCUDA_x64_ball
+flexDemoCUDA_release_bin      := ./../../../bin/linux64/NvFlexDemoRelease$(FLEX_COMPUTE)_x64_ball
 
 clean_flexDemoCUDA_release: 
 	@$(ECHO) clean flexDemoCUDA release
@@ -75,8 +95,8 @@ postbuild_flexDemoCUDA_release: mainbuild_flexDemoCUDA_release
 mainbuild_flexDemoCUDA_release: prebuild_flexDemoCUDA_release $(flexDemoCUDA_release_bin)
 prebuild_flexDemoCUDA_release:
 
-$(flexDemoCUDA_release_bin): $(flexDemoCUDA_release_obj) build_flexExtCUDA_release 
-	mkdir -p `dirname ./../../../bin/linux64/NvFlexDemoReleaseCUDA_x64`
+$(flexDemoCUDA_release_bin): $(flexDemoCUDA_release_obj) build_flexExt$(FLEX_COMPUTE)_release 
+	mkdir -p `dirname ./../../../bin/linux64/NvFlexDemoRelease$(FLEX_COMPUTE)_x64`
 	$(CCLD) $(flexDemoCUDA_release_obj) $(flexDemoCUDA_release_lflags) -o $(flexDemoCUDA_release_bin) 
 	$(ECHO) building $@ complete!
 
@@ -121,9 +141,9 @@ flexDemoCUDA_debug_lpaths    += /usr/local/cuda/lib64
 flexDemoCUDA_debug_lpaths    += ./../../../lib/linux64
 flexDemoCUDA_debug_defines   := $(flexDemoCUDA_custom_defines)
 flexDemoCUDA_debug_libraries := 
-flexDemoCUDA_debug_libraries += :NvFlexExtDebugCUDA_x64.a
-flexDemoCUDA_debug_libraries += :NvFlexDebugCUDA_x64.a
-flexDemoCUDA_debug_libraries += :NvFlexExtDebugCUDA_x64.a
+flexDemoCUDA_debug_libraries += :NvFlexExtDebug$(FLEX_COMPUTE)_x64.a
+flexDemoCUDA_debug_libraries += :NvFlexDebug$(FLEX_COMPUTE)_x64.a
+flexDemoCUDA_debug_libraries += :NvFlexExtDebug$(FLEX_COMPUTE)_x64.a
 flexDemoCUDA_debug_libraries += :libSDL2.a
 flexDemoCUDA_debug_libraries += :libSDL2main.a
 flexDemoCUDA_debug_common_cflags	:= $(flexDemoCUDA_custom_cflags)
@@ -138,14 +158,14 @@ flexDemoCUDA_debug_cppflags	:= $(flexDemoCUDA_debug_common_cflags)
 flexDemoCUDA_debug_lflags    := $(flexDemoCUDA_custom_lflags)
 flexDemoCUDA_debug_lflags    += $(addprefix -L, $(flexDemoCUDA_debug_lpaths))
 flexDemoCUDA_debug_lflags    += -Wl,--start-group $(addprefix -l, $(flexDemoCUDA_debug_libraries)) -Wl,--end-group
-flexDemoCUDA_debug_lflags  += -g -L../../../external/glew/lib/linux -L/usr/lib -L"../../../lib/linux64" -L../../../external/SDL2-2.0.4/lib/x64/ -L/usr/local/cuda/lib64 -L../../../external/yaml-cpp/lib/ -lGL -lglut -lGLU -lGLEW -lpng -lyaml-cpp -lcudart_static -ldl -lrt -pthread
+flexDemoCUDA_debug_lflags  += -g -L../../../external/glew/lib/linux -L/usr/lib -L"../../../lib/linux64" -L../../../external/SDL2-2.0.4/lib/x64/ -L/usr/local/cuda/lib64 -L../../../external/yaml-cpp/lib/ -lGL -lglut -lGLU -lGLEW -lpng -lyaml-cpp $(flexDemoCUDA_compute_lflags) -ldl -lrt -pthread
 flexDemoCUDA_debug_lflags  += -m64
-flexDemoCUDA_debug_objsdir  = $(OBJS_DIR)/flexDemoCUDA_debug
+flexDemoCUDA_debug_objsdir  = $(OBJS_DIR)/flexDemo$(FLEX_COMPUTE)_debug
 flexDemoCUDA_debug_cpp_o    = $(addprefix $(flexDemoCUDA_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexDemoCUDA_cppfiles)))))
 flexDemoCUDA_debug_cc_o    = $(addprefix $(flexDemoCUDA_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexDemoCUDA_ccfiles)))))
 flexDemoCUDA_debug_c_o      = $(addprefix $(flexDemoCUDA_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexDemoCUDA_cfiles)))))
 flexDemoCUDA_debug_obj      = $(flexDemoCUDA_debug_cpp_o) $(flexDemoCUDA_debug_cc_o) $(flexDemoCUDA_debug_c_o)
-flexDemoCUDA_debug_bin      := ./../../../bin/linux64/NvFlexDemoDebugCUDA_x64
+flexDemoCUDA_debug_bin      := ./../../../bin/linux64/NvFlexDemoDebug$(FLEX_COMPUTE)_x64
 
 clean_flexDemoCUDA_debug: 
 	@$(ECHO) clean flexDemoCUDA debug
@@ -158,8 +178,8 @@ postbuild_flexDemoCUDA_debug: mainbuild_flexDemoCUDA_debug
 mainbuild_flexDemoCUDA_debug: prebuild_flexDemoCUDA_debug $(flexDemoCUDA_debug_bin)
 prebuild_flexDemoCUDA_debug:
 
-$(flexDemoCUDA_debug_bin): $(flexDemoCUDA_debug_obj) build_flexExtCUDA_debug 
-	mkdir -p `dirname ./../../../bin/linux64/NvFlexDemoDebugCUDA_x64`
+$(flexDemoCUDA_debug_bin): $(flexDemoCUDA_debug_obj) build_flexExt$(FLEX_COMPUTE)_debug 
+	mkdir -p `dirname ./../../../bin/linux64/NvFlexDemoDebug$(FLEX_COMPUTE)_x64`
 	$(CCLD) $(flexDemoCUDA_debug_obj) $(flexDemoCUDA_debug_lflags) -o $(flexDemoCUDA_debug_bin) 
 	$(ECHO) building $@ complete!
 
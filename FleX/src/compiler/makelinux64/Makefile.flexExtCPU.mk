@@ -0,0 +1,185 @@
+# Makefile generated by XPJ for linux64
+-include Makefile.custom
+ProjectName = flexExtCPU
+flexExtCPU_cppfiles   += ./../../../extensions/flexExtCloth.cpp
+flexExtCPU_cppfiles   += ./../../../extensions/flexExtContainer.cpp
+flexExtCPU_cppfiles   += ./../../../extensions/flexExtMovingFrame.cpp
+flexExtCPU_cppfiles   += ./../../../extensions/flexExtRigid.cpp
+flexExtCPU_cppfiles   += ./../../../extensions/flexExtSoft.cpp
+flexExtCPU_cppfiles   += ./../../../extensions/flexExtForceField.cpp
+flexExtCPU_cppfiles   += ./../../../extensions/flexExtAsset.cpp
+flexExtCPU_cppfiles   += ./../../../extensions/cpu/flexExt.cpp
+flexExtCPU_cppfiles   += ./../../../core/sdf.cpp
+flexExtCPU_cppfiles   += ./../../../core/voxelize.cpp
+flexExtCPU_cppfiles   += ./../../../core/maths.cpp
+flexExtCPU_cppfiles   += ./../../../core/aabbtree.cpp
+flexExtCPU_cppfiles   += ./../../../core/tether.cpp
+flexExtCPU_cppfiles   += ./../../../core/hashgrid.cpp
+flexExtCPU_cppfiles   += ./../../../core/sample.cpp
+flexExtCPU_cppfiles   += ./../../../core/threadpool.cpp
+
+flexExtCPU_cpp_release_dep    = $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexExtCPU_cppfiles)))))
+flexExtCPU_cc_release_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.release.P, $(flexExtCPU_ccfiles)))))
+flexExtCPU_c_release_dep      = $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.P, $(flexExtCPU_cfiles)))))
+flexExtCPU_release_dep      = $(flexExtCPU_cpp_release_dep) $(flexExtCPU_cc_release_dep) $(flexExtCPU_c_release_dep)
+-include $(flexExtCPU_release_dep)
+flexExtCPU_cpp_debug_dep    = $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexExtCPU_cppfiles)))))
+flexExtCPU_cc_debug_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.debug.P, $(flexExtCPU_ccfiles)))))
+flexExtCPU_c_debug_dep      = $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.P, $(flexExtCPU_cfiles)))))
+flexExtCPU_debug_dep      = $(flexExtCPU_cpp_debug_dep) $(flexExtCPU_cc_debug_dep) $(flexExtCPU_c_debug_dep)
+-include $(flexExtCPU_debug_dep)
+flexExtCPU_release_hpaths    := 
+flexExtCPU_release_hpaths    += ./../../..
+flexExtCPU_release_hpaths    += ./../../../external/freeglut/include
+flexExtCPU_release_lpaths    := 
+flexExtCPU_release_defines   := $(flexExtCPU_custom_defines)
+flexExtCPU_release_libraries := 
+flexExtCPU_release_libraries += ./../../../lib/linux64/NvFlexReleaseCPU_x64.a
+flexExtCPU_release_common_cflags	:= $(flexExtCPU_custom_cflags)
+flexExtCPU_release_common_cflags    += -MMD
+flexExtCPU_release_common_cflags    += $(addprefix -D, $(flexExtCPU_release_defines))
+flexExtCPU_release_common_cflags    += $(addprefix -I, $(flexExtCPU_release_hpaths))
+flexExtCPU_release_common_cflags  += -m64
+flexExtCPU_release_common_cflags  += -Wall -std=c++0x -fPIC -fpermissive -fno-strict-aliasing
+flexExtCPU_release_common_cflags  += -O3 -ffast-math -DNDEBUG
+flexExtCPU_release_cflags	:= $(flexExtCPU_release_common_cflags)
+flexExtCPU_release_cppflags	:= $(flexExtCPU_release_common_cflags)
+flexExtCPU_release_lflags    := $(flexExtCPU_custom_lflags)
+flexExtCPU_release_lflags    += $(addprefix -L, $(flexExtCPU_release_lpaths))
+flexExtCPU_release_lflags    += -Wl,--start-group $(addprefix -l, $(flexExtCPU_release_libraries)) -Wl,--end-group
+flexExtCPU_release_lflags  += -m64
+flexExtCPU_release_objsdir  = $(OBJS_DIR)/flexExtCPU_release
+flexExtCPU_release_cpp_o    = $(addprefix $(flexExtCPU_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexExtCPU_cppfiles)))))
+flexExtCPU_release_cc_o    = $(addprefix $(flexExtCPU_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexExtCPU_ccfiles)))))
+flexExtCPU_release_c_o      = $(addprefix $(flexExtCPU_release_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexExtCPU_cfiles)))))
+flexExtCPU_release_obj      = $(flexExtCPU_release_cpp_o) $(flexExtCPU_release_cc_o) $(flexExtCPU_release_c_o)
+flexExtCPU_release_bin      := ./../../../lib/linux64/NvFlexExtReleaseCPU_x64.a
+
+clean_flexExtCPU_release: 
+	@$(ECHO) clean flexExtCPU release
+	@$(RMDIR) $(flexExtCPU_release_objsdir)
+	@$(RMDIR) $(flexExtCPU_release_bin)
+	@$(RMDIR) $(DEPSDIR)/flexExtCPU/release
+
+build_flexExtCPU_release: postbuild_flexExtCPU_release
+postbuild_flexExtCPU_release: mainbuild_flexExtCPU_release
+mainbuild_flexExtCPU_release: prebuild_flexExtCPU_release build_flexCPU_release $(flexExtCPU_release_bin)
+prebuild_flexExtCPU_release:
+
+$(flexExtCPU_release_bin): $(flexExtCPU_release_obj) 
+	mkdir -p `dirname ./../../../lib/linux64/NvFlexExtReleaseCPU_x64.a`
+	@$(AR) rcs $(flexExtCPU_release_bin) $(flexExtCPU_release_obj)
+	$(ECHO) building $@ complete!
+
+flexExtCPU_release_DEPDIR = $(dir $(@))/$(*F)
+$(flexExtCPU_release_cpp_o): $(flexExtCPU_release_objsdir)/%.o:
+	$(ECHO) flexExtCPU: compiling release $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cppfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexExtCPU_release_cppflags) -c $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cppfiles)) -o $@
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cppfiles))))))
+	cp $(flexExtCPU_release_DEPDIR).d $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cppfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexExtCPU_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cppfiles))))).P; \
+	  rm -f $(flexExtCPU_release_DEPDIR).d
+
+$(flexExtCPU_release_cc_o): $(flexExtCPU_release_objsdir)/%.o:
+	$(ECHO) flexExtCPU: compiling release $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_ccfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexExtCPU_release_cppflags) -c $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_ccfiles)) -o $@
+	mkdir -p $(dir $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_ccfiles))))))
+	cp $(flexExtCPU_release_DEPDIR).d $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_ccfiles))))).release.P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexExtCPU_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_ccfiles))))).release.P; \
+	  rm -f $(flexExtCPU_release_DEPDIR).d
+
+$(flexExtCPU_release_c_o): $(flexExtCPU_release_objsdir)/%.o:
+	$(ECHO) flexExtCPU: compiling release $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cfiles))...
+	mkdir -p $(dir $(@))
+	$(CC) $(flexExtCPU_release_cflags) -c $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cfiles)) -o $@ 
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cfiles))))))
+	cp $(flexExtCPU_release_DEPDIR).d $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexExtCPU_release_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexExtCPU/release/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_release_objsdir),, $@))), $(flexExtCPU_cfiles))))).P; \
+	  rm -f $(flexExtCPU_release_DEPDIR).d
+
+flexExtCPU_debug_hpaths    := 
+flexExtCPU_debug_hpaths    += ./../../..
+flexExtCPU_debug_hpaths    += ./../../../external/freeglut/include
+flexExtCPU_debug_lpaths    := 
+flexExtCPU_debug_defines   := $(flexExtCPU_custom_defines)
+flexExtCPU_debug_libraries := 
+flexExtCPU_debug_libraries += ./../../../lib/linux64/NvFlexDebugCPU_x64.a
+flexExtCPU_debug_common_cflags	:= $(flexExtCPU_custom_cflags)
+flexExtCPU_debug_common_cflags    += -MMD
+flexExtCPU_debug_common_cflags    += $(addprefix -D, $(flexExtCPU_debug_defines))
+flexExtCPU_debug_common_cflags    += $(addprefix -I, $(flexExtCPU_debug_hpaths))
+flexExtCPU_debug_common_cflags  += -m64
+flexExtCPU_debug_common_cflags  += -Wall -std=c++0x -fPIC -fpermissive -fno-strict-aliasing
+flexExtCPU_debug_common_cflags  += -g -O0
+flexExtCPU_debug_cflags	:= $(flexExtCPU_debug_common_cflags)
+flexExtCPU_debug_cppflags	:= $(flexExtCPU_debug_common_cflags)
+flexExtCPU_debug_lflags    := $(flexExtCPU_custom_lflags)
+flexExtCPU_debug_lflags    += $(addprefix -L, $(flexExtCPU_debug_lpaths))
+flexExtCPU_debug_lflags    += -Wl,--start-group $(addprefix -l, $(flexExtCPU_debug_libraries)) -Wl,--end-group
+flexExtCPU_debug_lflags  += -m64
+flexExtCPU_debug_objsdir  = $(OBJS_DIR)/flexExtCPU_debug
+flexExtCPU_debug_cpp_o    = $(addprefix $(flexExtCPU_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.o, $(flexExtCPU_cppfiles)))))
+flexExtCPU_debug_cc_o    = $(addprefix $(flexExtCPU_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.o, $(flexExtCPU_ccfiles)))))
+flexExtCPU_debug_c_o      = $(addprefix $(flexExtCPU_debug_objsdir)/, $(subst ./, , $(subst ../, , $(patsubst %.c, %.c.o, $(flexExtCPU_cfiles)))))
+flexExtCPU_debug_obj      = $(flexExtCPU_debug_cpp_o) $(flexExtCPU_debug_cc_o) $(flexExtCPU_debug_c_o)
+flexExtCPU_debug_bin      := ./../../../lib/linux64/NvFlexExtDebugCPU_x64.a
+
+clean_flexExtCPU_debug: 
+	@$(ECHO) clean flexExtCPU debug
+	@$(RMDIR) $(flexExtCPU_debug_objsdir)
+	@$(RMDIR) $(flexExtCPU_debug_bin)
+	@$(RMDIR) $(DEPSDIR)/flexExtCPU/debug
+
+build_flexExtCPU_debug: postbuild_flexExtCPU_debug
+postbuild_flexExtCPU_debug: mainbuild_flexExtCPU_debug
+mainbuild_flexExtCPU_debug: prebuild_flexExtCPU_debug build_flexCPU_debug $(flexExtCPU_debug_bin)
+prebuild_flexExtCPU_debug:
+
+$(flexExtCPU_debug_bin): $(flexExtCPU_debug_obj) 
+	mkdir -p `dirname ./../../../lib/linux64/NvFlexExtDebugCPU_x64.a`
+	@$(AR) rcs $(flexExtCPU_debug_bin) $(flexExtCPU_debug_obj)
+	$(ECHO) building $@ complete!
+
+flexExtCPU_debug_DEPDIR = $(dir $(@))/$(*F)
+$(flexExtCPU_debug_cpp_o): $(flexExtCPU_debug_objsdir)/%.o:
+	$(ECHO) flexExtCPU: compiling debug $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cppfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexExtCPU_debug_cppflags) -c $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cppfiles)) -o $@
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cppfiles))))))
+	cp $(flexExtCPU_debug_DEPDIR).d $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cppfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexExtCPU_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cpp.o,.cpp, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cppfiles))))).P; \
+	  rm -f $(flexExtCPU_debug_DEPDIR).d
+
+$(flexExtCPU_debug_cc_o): $(flexExtCPU_debug_objsdir)/%.o:
+	$(ECHO) flexExtCPU: compiling debug $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_ccfiles))...
+	mkdir -p $(dir $(@))
+	$(CXX) $(flexExtCPU_debug_cppflags) -c $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_ccfiles)) -o $@
+	mkdir -p $(dir $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_ccfiles))))))
+	cp $(flexExtCPU_debug_DEPDIR).d $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_ccfiles))))).debug.P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexExtCPU_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .cc.o,.cc, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_ccfiles))))).debug.P; \
+	  rm -f $(flexExtCPU_debug_DEPDIR).d
+
+$(flexExtCPU_debug_c_o): $(flexExtCPU_debug_objsdir)/%.o:
+	$(ECHO) flexExtCPU: compiling debug $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cfiles))...
+	mkdir -p $(dir $(@))
+	$(CC) $(flexExtCPU_debug_cflags) -c $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cfiles)) -o $@ 
+	@mkdir -p $(dir $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cfiles))))))
+	cp $(flexExtCPU_debug_DEPDIR).d $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cfiles))))).P; \
+	  sed -e 's/#.*//' -e 's/^[^:]*: *//' -e 's/ *\\$$//' \
+		-e '/^$$/ d' -e 's/$$/ :/' < $(flexExtCPU_debug_DEPDIR).d >> $(addprefix $(DEPSDIR)/flexExtCPU/debug/, $(subst ./, , $(subst ../, , $(filter %$(strip $(subst .c.o,.c, $(subst $(flexExtCPU_debug_objsdir),, $@))), $(flexExtCPU_cfiles))))).P; \
+	  rm -f $(flexExtCPU_debug_DEPDIR).d
+
+clean_flexExtCPU:  clean_flexExtCPU_release clean_flexExtCPU_debug
+	rm -rf $(DEPSDIR)
+
+export VERBOSE
+ifndef VERBOSE
+.SILENT:
+endif
@@ -6,11 +6,17 @@ flexExtCUDA_cppfiles   += ./../../../extensions/flexExtContainer.cpp
 flexExtCUDA_cppfiles   += ./../../../extensions/flexExtMovingFrame.cpp
 flexExtCUDA_cppfiles   += ./../../../extensions/flexExtRigid.cpp
 flexExtCUDA_cppfiles   += ./../../../extensions/flexExtSoft.cpp
+flexExtCUDA_cppfiles   += ./../../../extensions/flexExtForceField.cpp
+flexExtCUDA_cppfiles   += ./../../../extensions/flexExtAsset.cpp
 flexExtCUDA_cuda_extensions_cuda_flexExt_cu   += ./../../../extensions/cuda/flexExt.cu
 flexExtCUDA_cppfiles   += ./../../../core/sdf.cpp
 flexExtCUDA_cppfiles   += ./../../../core/voxelize.cpp
 flexExtCUDA_cppfiles   += ./../../../core/maths.cpp
 flexExtCUDA_cppfiles   += ./../../../core/aabbtree.cpp
+flexExtCUDA_cppfiles   += ./../../../core/tether.cpp
+flexExtCUDA_cppfiles   += ./../../../core/hashgrid.cpp
+flexExtCUDA_cppfiles   += ./../../../core/sample.cpp
+flexExtCUDA_cppfiles   += ./../../../core/threadpool.cpp
 
 flexExtCUDA_cpp_release_dep    = $(addprefix $(DEPSDIR)/flexExtCUDA/release/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(flexExtCUDA_cppfiles)))))
 flexExtCUDA_cc_release_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.release.P, $(flexExtCUDA_ccfiles)))))
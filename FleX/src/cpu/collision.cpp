@@ -0,0 +1,466 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "solver.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace std;
+
+namespace NvFlexCpu
+{
+
+namespace
+{
+
+const int kBvhLeafSize = 4;
+
+int BuildBvhNode(const vector<Vec3>& centers, const vector<Vec3>& lowers, const vector<Vec3>& uppers, int start, int end, TriangleBvh& bvh)
+{
+	const int index = int(bvh.nodes.size());
+	bvh.nodes.push_back(TriangleBvh::Node());
+
+	Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+	Vec3 centerLower(FLT_MAX), centerUpper(-FLT_MAX);
+
+	for (int i=start; i < end; ++i)
+	{
+		const int t = bvh.items[i];
+
+		lower = Min(lower, lowers[t]);
+		upper = Max(upper, uppers[t]);
+
+		centerLower = Min(centerLower, centers[t]);
+		centerUpper = Max(centerUpper, centers[t]);
+	}
+
+	TriangleBvh::Node node;
+	node.lower = lower;
+	node.upper = upper;
+	node.left = -1;
+	node.start = start;
+	node.count = end-start;
+
+	if (end-start > kBvhLeafSize)
+	{
+		// median split along the widest axis of the centroids
+		const Vec3 edges = centerUpper-centerLower;
+		const int axis = (edges.x > edges.y && edges.x > edges.z) ? 0 : (edges.y > edges.z ? 1 : 2);
+		const int mid = (start+end)/2;
+
+		nth_element(bvh.items.begin()+start, bvh.items.begin()+mid, bvh.items.begin()+end, [&](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+		node.left = BuildBvhNode(centers, lowers, uppers, start, mid, bvh);
+		
+		// right child is built after the left subtree so its index is stored in start
+		node.start = BuildBvhNode(centers, lowers, uppers, mid, end, bvh);
+		node.count = 0;
+	}
+
+	bvh.nodes[index] = node;
+
+	return index;
+}
+
+inline bool Overlap(const Vec3& lowerA, const Vec3& upperA, const Vec3& lowerB, const Vec3& upperB)
+{
+	return !(lowerA.x > upperB.x || lowerA.y > upperB.y || lowerA.z > upperB.z || upperA.x < lowerB.x || upperA.y < lowerB.y || upperA.z < lowerB.z);
+}
+
+template <typename Func>
+void QueryBvh(const TriangleBvh& bvh, const Vec3& lower, const Vec3& upper, Func func)
+{
+	if (bvh.nodes.empty())
+		return;
+
+	int stack[64];
+	int count = 0;
+
+	stack[count++] = 0;
+
+	while (count)
+	{
+		const TriangleBvh::Node& node = bvh.nodes[stack[--count]];
+
+		if (!Overlap(lower, upper, node.lower, node.upper))
+			continue;
+
+		if (node.left < 0)
+		{
+			for (int i=node.start; i < node.start+node.count; ++i)
+				func(bvh.items[i]);
+		}
+		else if (count+2 <= 64)
+		{
+			stack[count++] = node.left;
+			stack[count++] = node.start;
+		}
+	}
+}
+
+// keeps the closest contacts when a particle touches more features than it has slots for
+int AddContact(Contact* contacts, int count, int maxContacts, const Contact& c, float distance, float* distances)
+{
+	if (count < maxContacts)
+	{
+		contacts[count] = c;
+		distances[count] = distance;
+		return count+1;
+	}
+
+	int furthest = 0;
+	for (int i=1; i < count; ++i)
+	{
+		if (distances[i] > distances[furthest])
+			furthest = i;
+	}
+
+	if (distance < distances[furthest])
+	{
+		contacts[furthest] = c;
+		distances[furthest] = distance;
+	}
+
+	return count;
+}
+
+float SampleDistanceField(const DistanceField& field, const Vec3& p)
+{
+	const int x = Clamp(int(floorf(p.x)), 0, field.dim[0]-2);
+	const int y = Clamp(int(floorf(p.y)), 0, field.dim[1]-2);
+	const int z = Clamp(int(floorf(p.z)), 0, field.dim[2]-2);
+
+	const float fx = Clamp(p.x-x, 0.0f, 1.0f);
+	const float fy = Clamp(p.y-y, 0.0f, 1.0f);
+	const float fz = Clamp(p.z-z, 0.0f, 1.0f);
+
+	auto value = [&](int i, int j, int k) { return field.values[(k*field.dim[1] + j)*field.dim[0] + i]; };
+
+	const float x00 = Lerp(value(x, y, z), value(x+1, y, z), fx);
+	const float x10 = Lerp(value(x, y+1, z), value(x+1, y+1, z), fx);
+	const float x01 = Lerp(value(x, y, z+1), value(x+1, y, z+1), fx);
+	const float x11 = Lerp(value(x, y+1, z+1), value(x+1, y+1, z+1), fx);
+
+	return Lerp(Lerp(x00, x10, fy), Lerp(x01, x11, fy), fz);
+}
+
+} // anonymous namespace
+
+void BuildTriangleBvh(const Vec3* vertices, const int* indices, int numTriangles, TriangleBvh& bvh)
+{
+	bvh.nodes.clear();
+	bvh.items.resize(numTriangles);
+
+	if (!numTriangles)
+		return;
+
+	vector<Vec3> centers(numTriangles);
+	vector<Vec3> lowers(numTriangles);
+	vector<Vec3> uppers(numTriangles);
+
+	for (int i=0; i < numTriangles; ++i)
+	{
+		const Vec3& a = vertices[indices[i*3+0]];
+		const Vec3& b = vertices[indices[i*3+1]];
+		const Vec3& c = vertices[indices[i*3+2]];
+
+		lowers[i] = Min(Min(a, b), c);
+		uppers[i] = Max(Max(a, b), c);
+		centers[i] = (a+b+c)/3.0f;
+
+		bvh.items[i] = i;
+	}
+
+	bvh.nodes.reserve(2*numTriangles/kBvhLeafSize + 1);
+
+	BuildBvhNode(centers, lowers, uppers, 0, numTriangles, bvh);
+}
+
+int CollideShapes(const NvFlexSolver* solver, const Vec3& p, const Vec3& x, int phase, float dt, Contact* contacts, int maxContacts)
+{
+	const NvFlexLibrary* lib = solver->lib;
+	const NvFlexParams& params = solver->params;
+
+	const float range = params.collisionDistance + params.shapeCollisionMargin;
+	const float invDt = dt > 0.0f ? 1.0f/dt : 0.0f;
+
+	float distances[64];
+	maxContacts = Min(maxContacts, 64);
+
+	int count = 0;
+
+	for (int s=0; s < int(solver->geometry.size()); ++s)
+	{
+		const int flags = solver->shapeFlags[s];
+
+		// triggers only report overlaps on the GPU backends, they never generate a response
+		if ((flags & eNvFlexShapeFlagTrigger) || !(flags & phase & eNvFlexPhaseShapeChannelMask))
+			continue;
+
+		const NvFlexCollisionGeometry& geo = solver->geometry[s];
+
+		const Vec3 position = Vec3(solver->shapePositions[s]);
+		const Quat rotation = solver->shapeRotations[s];
+		const Vec3 prevPosition = Vec3(solver->shapePrevPositions[s]);
+		const Quat prevRotation = solver->shapePrevRotations[s];
+
+		// query point in shape local space
+		const Vec3 local = RotateInv(rotation, p-position);
+
+		// local space closest features, normals point away from the shape
+		Vec3 localPoints[64];
+		Vec3 localNormals[64];
+		float localDistances[64];
+		int numFeatures = 0;
+
+		switch (flags & eNvFlexShapeFlagTypeMask)
+		{
+			case eNvFlexShapeSphere:
+			{
+				const float d = Length(local);
+
+				localNormals[0] = d > 0.0f ? local/d : Vec3(0.0f, 1.0f, 0.0f);
+				localPoints[0] = localNormals[0]*geo.sphere.radius;
+				localDistances[0] = d - geo.sphere.radius;
+				numFeatures = 1;
+				break;
+			}
+			case eNvFlexShapeCapsule:
+			{
+				const Vec3 axisPoint(Clamp(local.x, -geo.capsule.halfHeight, geo.capsule.halfHeight), 0.0f, 0.0f);
+				const Vec3 delta = local-axisPoint;
+				const float d = Length(delta);
+
+				localNormals[0] = d > 0.0f ? delta/d : Vec3(0.0f, 1.0f, 0.0f);
+				localPoints[0] = axisPoint + localNormals[0]*geo.capsule.radius;
+				localDistances[0] = d - geo.capsule.radius;
+				numFeatures = 1;
+				break;
+			}
+			case eNvFlexShapeBox:
+			{
+				const Vec3 extents(geo.box.halfExtents);
+				const Vec3 closest = ClosestPointToAABB(local, -extents, extents);
+				const Vec3 delta = local-closest;
+				const float d = Length(delta);
+
+				if (d > 0.0f)
+				{
+					localNormals[0] = delta/d;
+					localPoints[0] = closest;
+					localDistances[0] = d;
+				}
+				else
+				{
+					// inside, push out through the nearest face
+					int axis = 0;
+					float best = FLT_MAX;
+
+					for (int a=0; a < 3; ++a)
+					{
+						const float depth = extents[a] - fabsf(local[a]);
+						if (depth < best)
+						{
+							best = depth;
+							axis = a;
+						}
+					}
+
+					Vec3 n(0.0f);
+					n[axis] = local[axis] < 0.0f ? -1.0f : 1.0f;
+
+					localNormals[0] = n;
+					localPoints[0] = local;
+					localPoints[0][axis] = n[axis]*extents[axis];
+					localDistances[0] = -best;
+				}
+
+				numFeatures = 1;
+				break;
+			}
+			case eNvFlexShapeConvexMesh:
+			{
+				map<unsigned int, ConvexMesh*>::const_iterator it = lib->convexMeshes.find(geo.convexMesh.mesh);
+				if (it == lib->convexMeshes.end() || it->second->planes.empty())
+					break;
+
+				const Vec3 scale(geo.convexMesh.scale);
+
+				// the separating plane with the largest distance, planes are scaled with the instance
+				float best = -FLT_MAX;
+				Vec3 bestNormal(0.0f);
+
+				for (size_t i=0; i < it->second->planes.size(); ++i)
+				{
+					const Vec4& plane = it->second->planes[i];
+
+					Vec3 n = Vec3(plane.x/scale.x, plane.y/scale.y, plane.z/scale.z);
+					const float l = Length(n);
+					if (l == 0.0f)
+						continue;
+
+					n /= l;
+
+					const float d = Dot(n, local) + plane.w/l;
+					if (d > best)
+					{
+						best = d;
+						bestNormal = n;
+					}
+				}
+
+				localNormals[0] = bestNormal;
+				localPoints[0] = local - bestNormal*best;
+				localDistances[0] = best;
+				numFeatures = 1;
+				break;
+			}
+			case eNvFlexShapeTriangleMesh:
+			{
+				map<unsigned int, TriangleMesh*>::const_iterator it = lib->triangleMeshes.find(geo.triMesh.mesh);
+				if (it == lib->triangleMeshes.end())
+					break;
+
+				const TriangleMesh& mesh = *it->second;
+				const Vec3 scale(geo.triMesh.scale);
+				const Vec3 invScale(1.0f/scale.x, 1.0f/scale.y, 1.0f/scale.z);
+
+				// which side of each face the particle is on is decided at the start of the step so fast particles are not pushed through
+				const Vec3 localStart = RotateInv(rotation, x-position);
+
+				const Vec3 extent = Vec3(fabsf(range*invScale.x), fabsf(range*invScale.y), fabsf(range*invScale.z));
+				const Vec3 queryLower = Min(local, localStart)*invScale - extent;
+				const Vec3 queryUpper = Max(local, localStart)*invScale + extent;
+
+				const float travel = Length(local-localStart);
+
+				// swap the query bounds for negative scales
+				const Vec3 lower = Min(queryLower, queryUpper);
+				const Vec3 upper = Max(queryLower, queryUpper);
+
+				QueryBvh(mesh.bvh, lower, upper, [&](int t)
+				{
+					const Vec3 a = mesh.vertices[mesh.indices[t*3+0]]*scale;
+					const Vec3 b = mesh.vertices[mesh.indices[t*3+1]]*scale;
+					const Vec3 c = mesh.vertices[mesh.indices[t*3+2]]*scale;
+
+					Vec3 n = Cross(b-a, c-a);
+					const float l = Length(n);
+					if (l == 0.0f)
+						return;
+
+					n /= l;
+
+					if (Dot(localStart-a, n) < 0.0f)
+						n = -n;
+
+					float v, w;
+					const Vec3 closest = ClosestPointOnTriangle(a, b, c, local, v, w);
+					const float d = Dot(local-closest, n);
+
+					// lateral offset within range and no deeper than the particle travelled over the step
+					const float lateralSq = LengthSq(local-closest) - d*d;
+
+					if (d < range && d > -(travel + range) && lateralSq < range*range && numFeatures < 64)
+					{
+						localNormals[numFeatures] = n;
+						localPoints[numFeatures] = closest;
+						localDistances[numFeatures] = d;
+						numFeatures++;
+					}
+				});
+
+				break;
+			}
+			case eNvFlexShapeSDF:
+			{
+				map<unsigned int, DistanceField*>::const_iterator it = lib->distanceFields.find(geo.sdf.field);
+				if (it == lib->distanceFields.end() || it->second->values.empty())
+					break;
+
+				const DistanceField& field = *it->second;
+				const float scale = geo.sdf.scale;
+
+				if (scale <= 0.0f || field.dim[0] < 2 || field.dim[1] < 2 || field.dim[2] < 2)
+					break;
+
+				// field covers the local space volume [0, scale]^3 with samples at voxel centers
+				const Vec3 voxel = Vec3(local.x/scale*field.dim[0], local.y/scale*field.dim[1], local.z/scale*field.dim[2]) - Vec3(0.5f);
+				const Vec3 clamped = Vec3(Clamp(voxel.x, 0.0f, float(field.dim[0]-1)), Clamp(voxel.y, 0.0f, float(field.dim[1]-1)), Clamp(voxel.z, 0.0f, float(field.dim[2]-1)));
+
+				// outside the volume the distance to the boundary is added to the boundary sample
+				const Vec3 outside = Vec3((voxel.x-clamped.x)/field.dim[0], (voxel.y-clamped.y)/field.dim[1], (voxel.z-clamped.z)/field.dim[2])*scale;
+
+				const float d = SampleDistanceField(field, clamped)*scale + Length(outside);
+
+				if (d >= range)
+					break;
+
+				const float h = 0.5f;
+				Vec3 gradient(
+					SampleDistanceField(field, clamped + Vec3(h, 0.0f, 0.0f)) - SampleDistanceField(field, clamped - Vec3(h, 0.0f, 0.0f)),
+					SampleDistanceField(field, clamped + Vec3(0.0f, h, 0.0f)) - SampleDistanceField(field, clamped - Vec3(0.0f, h, 0.0f)),
+					SampleDistanceField(field, clamped + Vec3(0.0f, 0.0f, h)) - SampleDistanceField(field, clamped - Vec3(0.0f, 0.0f, h)));
+
+				if (LengthSq(outside) > 0.0f)
+					gradient = outside;
+
+				const Vec3 n = SafeNormalize(gradient, Vec3(0.0f, 1.0f, 0.0f));
+
+				localNormals[0] = n;
+				localPoints[0] = local - n*d;
+				localDistances[0] = d;
+				numFeatures = 1;
+				break;
+			}
+		}
+
+		for (int f=0; f < numFeatures; ++f)
+		{
+			if (localDistances[f] >= range)
+				continue;
+
+			const Vec3 n = Rotate(rotation, localNormals[f]);
+			const Vec3 point = Rotate(rotation, localPoints[f]) + position;
+
+			// the feature point moved from its previous world space location over the step
+			const Vec3 prevPoint = Rotate(prevRotation, localPoints[f]) + prevPosition;
+
+			Contact c;
+			c.plane = Vec4(n, -Dot(n, point));
+			c.velocity = (point-prevPoint)*invDt;
+			c.shape = s;
+
+			count = AddContact(contacts, count, maxContacts, c, localDistances[f], distances);
+		}
+	}
+
+	return count;
+}
+
+} // namespace NvFlexCpu
@@ -0,0 +1,883 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "solver.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+using namespace NvFlexCpu;
+
+namespace
+{
+
+// copies count elements between buffers of possibly different strides, only the bytes common to both layouts are copied
+void CopyElements(void* dst, int dstStride, const void* src, int srcStride, int count)
+{
+	const int size = min(dstStride, srcStride);
+
+	for (int i=0; i < count; ++i)
+		memcpy((char*)dst + size_t(i)*dstStride, (const char*)src + size_t(i)*srcStride, size);
+}
+
+// copies a region described by desc from buffer into dst, a NULL desc copies as much of the buffer as fits
+template <typename T>
+void CopyFromBuffer(vector<T>& dst, NvFlexBuffer* buffer, const NvFlexCopyDesc* desc)
+{
+	if (!buffer)
+		return;
+
+	int srcOffset = 0;
+	int dstOffset = 0;
+	int count = min(buffer->count, int(dst.size()));
+
+	if (desc)
+	{
+		srcOffset = desc->srcOffset;
+		dstOffset = desc->dstOffset;
+		count = desc->elementCount;
+	}
+
+	count = min(count, min(buffer->count - srcOffset, int(dst.size()) - dstOffset));
+
+	if (count > 0)
+		CopyElements(&dst[dstOffset], sizeof(T), (const char*)buffer->data + size_t(srcOffset)*buffer->stride, buffer->stride, count);
+}
+
+template <typename T>
+void CopyToBuffer(NvFlexBuffer* buffer, const vector<T>& src, const NvFlexCopyDesc* desc)
+{
+	if (!buffer)
+		return;
+
+	int srcOffset = 0;
+	int dstOffset = 0;
+	int count = min(buffer->count, int(src.size()));
+
+	if (desc)
+	{
+		srcOffset = desc->srcOffset;
+		dstOffset = desc->dstOffset;
+		count = desc->elementCount;
+	}
+
+	count = min(count, min(buffer->count - dstOffset, int(src.size()) - srcOffset));
+
+	if (count > 0)
+		CopyElements((char*)buffer->data + size_t(dstOffset)*buffer->stride, buffer->stride, &src[srcOffset], sizeof(T), count);
+}
+
+// copies the first count elements of a buffer, a NULL buffer leaves dst empty
+template <typename T>
+void CopyArray(vector<T>& dst, NvFlexBuffer* buffer, int count)
+{
+	dst.clear();
+
+	if (!buffer || count <= 0)
+		return;
+
+	dst.resize(count);
+	CopyElements(&dst[0], sizeof(T), buffer->data, buffer->stride, min(count, buffer->count));
+}
+
+template <typename T>
+void CopyArrayToBuffer(NvFlexBuffer* buffer, const vector<T>& src, int count)
+{
+	if (!buffer)
+		return;
+
+	count = min(min(count, int(src.size())), buffer->count);
+
+	if (count > 0)
+		CopyElements(buffer->data, buffer->stride, &src[0], sizeof(T), count);
+}
+
+// compressed lists of the items touching each particle, items reference elementSize consecutive particle indices
+void BuildParticleAdjacency(const vector<int>& indices, int elementSize, int numParticles, vector<int>& starts, vector<int>& items)
+{
+	starts.assign(numParticles+1, 0);
+
+	for (size_t i=0; i < indices.size(); ++i)
+	{
+		if (indices[i] >= 0 && indices[i] < numParticles)
+			starts[indices[i]+1]++;
+	}
+
+	for (int i=0; i < numParticles; ++i)
+		starts[i+1] += starts[i];
+
+	items.resize(starts[numParticles]);
+
+	vector<int> offsets(starts.begin(), starts.end()-1);
+
+	for (size_t i=0; i < indices.size(); ++i)
+	{
+		if (indices[i] >= 0 && indices[i] < numParticles)
+			items[offsets[indices[i]]++] = int(i)/elementSize;
+	}
+}
+
+void SetDefaultParams(NvFlexParams& params)
+{
+	memset(&params, 0, sizeof(params));
+
+	params.numIterations = 3;
+	params.gravity[1] = -9.8f;
+	params.radius = 0.15f;
+	params.solidRestDistance = 0.15f;
+	params.fluidRestDistance = 0.1f;
+	params.maxSpeed = FLT_MAX;
+	params.maxAcceleration = 100.0f;
+	params.relaxationMode = eNvFlexRelaxationLocal;
+	params.relaxationFactor = 1.0f;
+	params.cohesion = 0.025f;
+	params.anisotropyMin = 0.1f;
+	params.anisotropyMax = 2.0f;
+	params.solidPressure = 1.0f;
+	params.buoyancy = 1.0f;
+	params.diffuseThreshold = 100.0f;
+	params.diffuseBuoyancy = 1.0f;
+	params.diffuseDrag = 0.8f;
+	params.diffuseBallistic = 16;
+	params.diffuseLifetime = 2.0f;
+}
+
+void GetBounds(const vector<Vec3>& vertices, Vec3& lower, Vec3& upper)
+{
+	lower = Vec3(FLT_MAX);
+	upper = Vec3(-FLT_MAX);
+
+	for (size_t i=0; i < vertices.size(); ++i)
+	{
+		lower = Min(lower, vertices[i]);
+		upper = Max(upper, vertices[i]);
+	}
+}
+
+template <typename T>
+int GetIds(const map<unsigned int, T*>& objects, unsigned int* ids, int n)
+{
+	int count = 0;
+
+	for (typename map<unsigned int, T*>::const_iterator it=objects.begin(); it != objects.end(); ++it, ++count)
+	{
+		if (count < n)
+			ids[count] = it->first;
+	}
+
+	return count;
+}
+
+template <typename T>
+void DestroyObject(map<unsigned int, T*>& objects, unsigned int id)
+{
+	typename map<unsigned int, T*>::iterator it = objects.find(id);
+
+	if (it != objects.end())
+	{
+		delete it->second;
+		objects.erase(it);
+	}
+}
+
+} // anonymous namespace
+
+void NvFlexCpu::ReportError(NvFlexLibrary* lib, NvFlexErrorSeverity severity, const char* msg, const char* file, int line)
+{
+	if (lib && lib->errorFunc)
+		lib->errorFunc(severity, msg, file, line);
+}
+
+//-----------------------------------------------------------------------------
+// library
+
+NvFlexLibrary* NvFlexInit(int version, NvFlexErrorCallback errorFunc, NvFlexInitDesc* desc)
+{
+	if (version != NV_FLEX_VERSION)
+	{
+		if (errorFunc)
+			errorFunc(eNvFlexLogError, "Flex library version does not match the headers", __FILE__, __LINE__);
+
+		return NULL;
+	}
+
+	// this library only provides the host backend
+	if (desc && desc->computeType != eNvFlexCPU)
+	{
+		if (errorFunc)
+			errorFunc(eNvFlexLogError, "The CPU Flex library requires NvFlexInitDesc::computeType to be eNvFlexCPU", __FILE__, __LINE__);
+
+		return NULL;
+	}
+
+	// allow clusters to share nodes between jobs, the solver and the host extension kernels share one pool
+	if (const char* env = getenv("NV_FLEX_CPU_THREADS"))
+		SetParallelThreadCount(max(atoi(env), 1));
+
+	NvFlexLibrary* lib = new NvFlexLibrary();
+	lib->errorFunc = errorFunc;
+	lib->nextId = 1;
+
+	snprintf(lib->deviceName, sizeof(lib->deviceName), "CPU (%d threads)", GetParallelThreadCount());
+
+	return lib;
+}
+
+void NvFlexShutdown(NvFlexLibrary* lib)
+{
+	if (!lib)
+		return;
+
+	while (!lib->solvers.empty())
+		NvFlexDestroySolver(lib->solvers.back());
+
+	while (!lib->triangleMeshes.empty())
+		DestroyObject(lib->triangleMeshes, lib->triangleMeshes.begin()->first);
+
+	while (!lib->convexMeshes.empty())
+		DestroyObject(lib->convexMeshes, lib->convexMeshes.begin()->first);
+
+	while (!lib->distanceFields.empty())
+		DestroyObject(lib->distanceFields, lib->distanceFields.begin()->first);
+
+	delete lib;
+}
+
+int NvFlexGetVersion()
+{
+	return NV_FLEX_VERSION;
+}
+
+const char* NvFlexGetDeviceName(NvFlexLibrary* lib)
+{
+	return lib->deviceName;
+}
+
+void NvFlexGetDeviceAndContext(NvFlexLibrary* lib, void** device, void** context)
+{
+	if (device)
+		*device = NULL;
+	if (context)
+		*context = NULL;
+}
+
+void NvFlexAcquireContext(NvFlexLibrary* lib) {}
+void NvFlexRestoreContext(NvFlexLibrary* lib) {}
+void NvFlexFlush(NvFlexLibrary* lib) {}
+void NvFlexWait(NvFlexLibrary* lib) {}
+void NvFlexComputeWaitForGraphics(NvFlexLibrary* lib) {}
+
+void NvFlexGetDataAftermath(NvFlexLibrary* lib, void* pDataOut, void* pStatusOut) {}
+
+//-----------------------------------------------------------------------------
+// buffers
+
+NvFlexBuffer* NvFlexAllocBuffer(NvFlexLibrary* lib, int elementCount, int elementByteStride, NvFlexBufferType type)
+{
+	NvFlexBuffer* buffer = new NvFlexBuffer();
+	buffer->lib = lib;
+	buffer->count = max(elementCount, 0);
+	buffer->stride = elementByteStride;
+	buffer->type = type;
+	buffer->data = calloc(max(size_t(buffer->count)*elementByteStride, size_t(1)), 1);
+
+	return buffer;
+}
+
+void NvFlexFreeBuffer(NvFlexBuffer* buf)
+{
+	if (!buf)
+		return;
+
+	free(buf->data);
+	delete buf;
+}
+
+// work is complete when NvFlexUpdateSolver() returns so maps never wait
+void* NvFlexMap(NvFlexBuffer* buffer, int flags)
+{
+	return buffer->data;
+}
+
+void NvFlexUnmap(NvFlexBuffer* buffer) {}
+
+NvFlexBuffer* NvFlexRegisterOGLBuffer(NvFlexLibrary* lib, int buf, int elementCount, int elementByteStride)
+{
+	ReportError(lib, eNvFlexLogWarning, "Graphics interop is not available on the CPU backend", __FILE__, __LINE__);
+	return NULL;
+}
+
+void NvFlexUnregisterOGLBuffer(NvFlexBuffer* buf) {}
+
+NvFlexBuffer* NvFlexRegisterD3DBuffer(NvFlexLibrary* lib, void* buffer, int elementCount, int elementByteStride)
+{
+	ReportError(lib, eNvFlexLogWarning, "Graphics interop is not available on the CPU backend", __FILE__, __LINE__);
+	return NULL;
+}
+
+void NvFlexUnregisterD3DBuffer(NvFlexBuffer* buf) {}
+
+//-----------------------------------------------------------------------------
+// solvers
+
+void NvFlexSetSolverDescDefaults(NvFlexSolverDesc* desc)
+{
+	desc->featureMode = eNvFlexFeatureModeDefault;
+	desc->maxParticles = 0;
+	desc->maxDiffuseParticles = 0;
+	desc->maxNeighborsPerParticle = 96;
+	desc->maxContactsPerParticle = 6;
+}
+
+NvFlexSolver* NvFlexCreateSolver(NvFlexLibrary* lib, const NvFlexSolverDesc* desc)
+{
+	NvFlexSolver* s = new NvFlexSolver();
+	s->lib = lib;
+	s->desc = *desc;
+	s->desc.maxNeighborsPerParticle = max(s->desc.maxNeighborsPerParticle, 1);
+	s->desc.maxContactsPerParticle = max(s->desc.maxContactsPerParticle, 1);
+
+	SetDefaultParams(s->params);
+
+	const int n = max(desc->maxParticles, 0);
+
+	s->positions.resize(n, Vec4(0.0f));
+	s->restPositions.resize(n, Vec4(0.0f));
+	s->velocities.resize(n, Vec3(0.0f));
+	s->phases.resize(n, 0);
+	s->normals.resize(n, Vec4(0.0f));
+
+	s->active.resize(n);
+	for (int i=0; i < n; ++i)
+		s->active[i] = i;
+
+	s->numActive = 0;
+
+	s->particleSpringStarts.assign(n+1, 0);
+	s->particleTriangleStarts.assign(n+1, 0);
+
+	memset(s->callbacks, 0, sizeof(s->callbacks));
+	memset(&s->timers, 0, sizeof(s->timers));
+
+	s->latency = 0.0f;
+	s->lower = Vec3(0.0f);
+	s->upper = Vec3(0.0f);
+
+	lib->solvers.push_back(s);
+
+	return s;
+}
+
+void NvFlexDestroySolver(NvFlexSolver* solver)
+{
+	if (!solver)
+		return;
+
+	vector<NvFlexSolver*>& solvers = solver->lib->solvers;
+	solvers.erase(remove(solvers.begin(), solvers.end(), solver), solvers.end());
+
+	delete solver;
+}
+
+int NvFlexGetSolvers(NvFlexLibrary* lib, NvFlexSolver** solvers, int n)
+{
+	for (int i=0; i < min(n, int(lib->solvers.size())); ++i)
+		solvers[i] = lib->solvers[i];
+
+	return int(lib->solvers.size());
+}
+
+NvFlexLibrary* NvFlexGetSolverLibrary(NvFlexSolver* solver)
+{
+	return solver->lib;
+}
+
+void NvFlexGetSolverDesc(NvFlexSolver* solver, NvFlexSolverDesc* desc)
+{
+	*desc = solver->desc;
+}
+
+NvFlexSolverCallback NvFlexRegisterSolverCallback(NvFlexSolver* solver, NvFlexSolverCallback function, NvFlexSolverCallbackStage stage)
+{
+	const NvFlexSolverCallback previous = solver->callbacks[stage];
+	solver->callbacks[stage] = function;
+
+	return previous;
+}
+
+void NvFlexUpdateSolver(NvFlexSolver* solver, float dt, int substeps, bool enableTimers)
+{
+	NvFlexCpu::UpdateSolver(solver, dt, substeps, enableTimers);
+}
+
+void NvFlexSetParams(NvFlexSolver* solver, const NvFlexParams* params)
+{
+	solver->params = *params;
+}
+
+void NvFlexGetParams(NvFlexSolver* solver, NvFlexParams* params)
+{
+	*params = solver->params;
+}
+
+void NvFlexSetActive(NvFlexSolver* solver, NvFlexBuffer* indices, const NvFlexCopyDesc* desc)
+{
+	CopyFromBuffer(solver->active, indices, desc);
+}
+
+void NvFlexGetActive(NvFlexSolver* solver, NvFlexBuffer* indices, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(indices, solver->active, desc);
+}
+
+void NvFlexSetActiveCount(NvFlexSolver* solver, int n)
+{
+	solver->numActive = Clamp(n, 0, int(solver->active.size()));
+}
+
+int NvFlexGetActiveCount(NvFlexSolver* solver)
+{
+	return solver->numActive;
+}
+
+void NvFlexSetParticles(NvFlexSolver* solver, NvFlexBuffer* p, const NvFlexCopyDesc* desc)
+{
+	CopyFromBuffer(solver->positions, p, desc);
+}
+
+void NvFlexGetParticles(NvFlexSolver* solver, NvFlexBuffer* p, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(p, solver->positions, desc);
+}
+
+void NvFlexSetRestParticles(NvFlexSolver* solver, NvFlexBuffer* p, const NvFlexCopyDesc* desc)
+{
+	CopyFromBuffer(solver->restPositions, p, desc);
+}
+
+void NvFlexGetRestParticles(NvFlexSolver* solver, NvFlexBuffer* p, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(p, solver->restPositions, desc);
+}
+
+// no fluid surface smoothing on the host, the simulated positions are returned
+void NvFlexGetSmoothParticles(NvFlexSolver* solver, NvFlexBuffer* p, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(p, solver->positions, desc);
+}
+
+void NvFlexSetVelocities(NvFlexSolver* solver, NvFlexBuffer* v, const NvFlexCopyDesc* desc)
+{
+	CopyFromBuffer(solver->velocities, v, desc);
+}
+
+void NvFlexGetVelocities(NvFlexSolver* solver, NvFlexBuffer* v, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(v, solver->velocities, desc);
+}
+
+void NvFlexSetPhases(NvFlexSolver* solver, NvFlexBuffer* phases, const NvFlexCopyDesc* desc)
+{
+	CopyFromBuffer(solver->phases, phases, desc);
+}
+
+void NvFlexGetPhases(NvFlexSolver* solver, NvFlexBuffer* phases, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(phases, solver->phases, desc);
+}
+
+void NvFlexSetNormals(NvFlexSolver* solver, NvFlexBuffer* normals, const NvFlexCopyDesc* desc)
+{
+	CopyFromBuffer(solver->normals, normals, desc);
+}
+
+void NvFlexGetNormals(NvFlexSolver* solver, NvFlexBuffer* normals, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(normals, solver->normals, desc);
+}
+
+void NvFlexSetSprings(NvFlexSolver* solver, NvFlexBuffer* indices, NvFlexBuffer* restLengths, NvFlexBuffer* stiffness, int numSprings)
+{
+	CopyArray(solver->springIndices, indices, numSprings*2);
+	CopyArray(solver->springLengths, restLengths, numSprings);
+	CopyArray(solver->springStiffness, stiffness, numSprings);
+
+	BuildParticleAdjacency(solver->springIndices, 2, int(solver->positions.size()), solver->particleSpringStarts, solver->particleSprings);
+}
+
+void NvFlexGetSprings(NvFlexSolver* solver, NvFlexBuffer* indices, NvFlexBuffer* restLengths, NvFlexBuffer* stiffness, int numSprings)
+{
+	CopyArrayToBuffer(indices, solver->springIndices, numSprings*2);
+	CopyArrayToBuffer(restLengths, solver->springLengths, numSprings);
+	CopyArrayToBuffer(stiffness, solver->springStiffness, numSprings);
+}
+
+void NvFlexSetRigids(NvFlexSolver* solver, NvFlexBuffer* offsets, NvFlexBuffer* indices, NvFlexBuffer* restPositions, NvFlexBuffer* restNormals, NvFlexBuffer* stiffness, NvFlexBuffer* thresholds, NvFlexBuffer* creeps, NvFlexBuffer* rotations, NvFlexBuffer* translations, int numRigids, int numIndices)
+{
+	CopyArray(solver->rigidOffsets, offsets, numRigids ? numRigids+1 : 0);
+	CopyArray(solver->rigidIndices, indices, numIndices);
+	CopyArray(solver->rigidRestPositions, restPositions, numIndices);
+	CopyArray(solver->rigidRestNormals, restNormals, numIndices);
+	CopyArray(solver->rigidStiffness, stiffness, numRigids);
+	CopyArray(solver->rigidThresholds, thresholds, numRigids);
+	CopyArray(solver->rigidCreeps, creeps, numRigids);
+	CopyArray(solver->rigidRotations, rotations, numRigids);
+	CopyArray(solver->rigidTranslations, translations, numRigids);
+
+	solver->rigidStiffness.resize(numRigids, 1.0f);
+	solver->rigidRotations.resize(numRigids, Quat());
+	solver->rigidTranslations.resize(numRigids, Vec3(0.0f));
+}
+
+void NvFlexGetRigids(NvFlexSolver* solver, NvFlexBuffer* offsets, NvFlexBuffer* indices, NvFlexBuffer* restPositions, NvFlexBuffer* restNormals, NvFlexBuffer* stiffness, NvFlexBuffer* thresholds, NvFlexBuffer* creeps, NvFlexBuffer* rotations, NvFlexBuffer* translations)
+{
+	CopyArrayToBuffer(offsets, solver->rigidOffsets, int(solver->rigidOffsets.size()));
+	CopyArrayToBuffer(indices, solver->rigidIndices, int(solver->rigidIndices.size()));
+	CopyArrayToBuffer(restPositions, solver->rigidRestPositions, int(solver->rigidRestPositions.size()));
+	CopyArrayToBuffer(restNormals, solver->rigidRestNormals, int(solver->rigidRestNormals.size()));
+	CopyArrayToBuffer(stiffness, solver->rigidStiffness, int(solver->rigidStiffness.size()));
+	CopyArrayToBuffer(thresholds, solver->rigidThresholds, int(solver->rigidThresholds.size()));
+	CopyArrayToBuffer(creeps, solver->rigidCreeps, int(solver->rigidCreeps.size()));
+	CopyArrayToBuffer(rotations, solver->rigidRotations, int(solver->rigidRotations.size()));
+	CopyArrayToBuffer(translations, solver->rigidTranslations, int(solver->rigidTranslations.size()));
+}
+
+void NvFlexSetShapes(NvFlexSolver* solver, NvFlexBuffer* geometry, NvFlexBuffer* shapePositions, NvFlexBuffer* shapeRotations, NvFlexBuffer* shapePrevPositions, NvFlexBuffer* shapePrevRotations, NvFlexBuffer* shapeFlags, int numShapes)
+{
+	// one geometry entry per shape
+	CopyArray(solver->geometry, geometry, numShapes);
+	CopyArray(solver->shapePositions, shapePositions, numShapes);
+	CopyArray(solver->shapeRotations, shapeRotations, numShapes);
+	CopyArray(solver->shapePrevPositions, shapePrevPositions, numShapes);
+	CopyArray(solver->shapePrevRotations, shapePrevRotations, numShapes);
+	CopyArray(solver->shapeFlags, shapeFlags, numShapes);
+
+	// shapes without a previous transform are static
+	if (solver->shapePrevPositions.empty())
+		solver->shapePrevPositions = solver->shapePositions;
+	if (solver->shapePrevRotations.empty())
+		solver->shapePrevRotations = solver->shapeRotations;
+}
+
+void NvFlexSetDynamicTriangles(NvFlexSolver* solver, NvFlexBuffer* indices, NvFlexBuffer* normals, int numTris)
+{
+	CopyArray(solver->triangles, indices, numTris*3);
+	CopyArray(solver->triangleNormals, normals, numTris);
+
+	solver->triangleNormals.resize(numTris, Vec3(0.0f));
+
+	const int numParticles = int(solver->positions.size());
+
+	CreateTriangleColoring(numTris ? &solver->triangles[0] : NULL, numTris, numParticles, solver->triangleColoring);
+	BuildParticleAdjacency(solver->triangles, 3, numParticles, solver->particleTriangleStarts, solver->particleTriangles);
+}
+
+void NvFlexGetDynamicTriangles(NvFlexSolver* solver, NvFlexBuffer* indices, NvFlexBuffer* normals, int numTris)
+{
+	CopyArrayToBuffer(indices, solver->triangles, numTris*3);
+	CopyArrayToBuffer(normals, solver->triangleNormals, numTris);
+}
+
+void NvFlexSetInflatables(NvFlexSolver* solver, NvFlexBuffer* startTris, NvFlexBuffer* numTris, NvFlexBuffer* restVolumes, NvFlexBuffer* overPressures, NvFlexBuffer* constraintScales, int numInflatables)
+{
+	CopyArray(solver->inflatableStarts, startTris, numInflatables);
+	CopyArray(solver->inflatableCounts, numTris, numInflatables);
+	CopyArray(solver->inflatableRestVolumes, restVolumes, numInflatables);
+	CopyArray(solver->inflatablePressures, overPressures, numInflatables);
+	CopyArray(solver->inflatableScales, constraintScales, numInflatables);
+
+	if (numInflatables)
+		ReportError(solver->lib, eNvFlexLogWarning, "Inflatable constraints are not simulated by the CPU backend", __FILE__, __LINE__);
+}
+
+// fluid quantities are not simulated on the host, reads return rest state values
+void NvFlexGetDensities(NvFlexSolver* solver, NvFlexBuffer* densities, const NvFlexCopyDesc* desc)
+{
+	CopyToBuffer(densities, vector<float>(solver->positions.size(), 0.0f), desc);
+}
+
+void NvFlexGetAnisotropy(NvFlexSolver* solver, NvFlexBuffer* q1, NvFlexBuffer* q2, NvFlexBuffer* q3, const NvFlexCopyDesc* desc)
+{
+	const size_t n = solver->positions.size();
+	const float r = solver->params.radius;
+
+	CopyToBuffer(q1, vector<Vec4>(n, Vec4(1.0f, 0.0f, 0.0f, r)), desc);
+	CopyToBuffer(q2, vector<Vec4>(n, Vec4(0.0f, 1.0f, 0.0f, r)), desc);
+	CopyToBuffer(q3, vector<Vec4>(n, Vec4(0.0f, 0.0f, 1.0f, r)), desc);
+}
+
+void NvFlexGetDiffuseParticles(NvFlexSolver* solver, NvFlexBuffer* p, NvFlexBuffer* v, NvFlexBuffer* count)
+{
+	if (count && count->count > 0)
+		*(int*)count->data = 0;
+}
+
+void NvFlexSetDiffuseParticles(NvFlexSolver* solver, NvFlexBuffer* p, NvFlexBuffer* v, int n) {}
+
+void NvFlexGetContacts(NvFlexSolver* solver, NvFlexBuffer* planes, NvFlexBuffer* velocities, NvFlexBuffer* indices, NvFlexBuffer* counts)
+{
+	const int maxContacts = solver->desc.maxContactsPerParticle;
+	const int numParticles = int(solver->positions.size());
+
+	// contacts are stored per api particle so the index map is the identity
+	if (indices)
+	{
+		for (int i=0; i < min(numParticles, indices->count); ++i)
+			((int*)indices->data)[i] = i;
+	}
+
+	if (counts)
+	{
+		for (int i=0; i < min(numParticles, counts->count); ++i)
+			((int*)counts->data)[i] = 0;
+	}
+
+	for (int k=0; k < min(solver->numActive, int(solver->contactCounts.size())); ++k)
+	{
+		const int i = solver->active[k];
+		const int count = solver->contactCounts[k];
+
+		if (counts && i < counts->count)
+			((int*)counts->data)[i] = count;
+
+		for (int c=0; c < count; ++c)
+		{
+			const Contact& contact = solver->contacts[k*maxContacts + c];
+			const int slot = i*maxContacts + c;
+
+			if (planes && slot < planes->count)
+				((Vec4*)planes->data)[slot] = contact.plane;
+
+			if (velocities && slot < velocities->count)
+				((Vec4*)velocities->data)[slot] = Vec4(contact.velocity, float(contact.shape));
+		}
+	}
+}
+
+void NvFlexGetNeighbors(NvFlexSolver* solver, NvFlexBuffer* neighbors, NvFlexBuffer* counts, NvFlexBuffer* apiToInternal, NvFlexBuffer* internalToApi)
+{
+	const int numParticles = int(solver->positions.size());
+	const int stride = numParticles;
+	const int maxNeighbors = solver->desc.maxNeighborsPerParticle;
+
+	// internal order is the api order
+	for (int i=0; i < numParticles; ++i)
+	{
+		if (apiToInternal && i < apiToInternal->count)
+			((int*)apiToInternal->data)[i] = i;
+		if (internalToApi && i < internalToApi->count)
+			((int*)internalToApi->data)[i] = i;
+		if (counts && i < counts->count)
+			((int*)counts->data)[i] = 0;
+	}
+
+	for (int k=0; k < min(solver->numActive, int(solver->neighborCounts.size())); ++k)
+	{
+		const int i = solver->active[k];
+		const int count = solver->neighborCounts[k];
+
+		if (counts && i < counts->count)
+			((int*)counts->data)[i] = count;
+
+		for (int c=0; c < count; ++c)
+		{
+			if (neighbors && c*stride + i < neighbors->count)
+				((int*)neighbors->data)[c*stride + i] = solver->neighbors[k*maxNeighbors + c];
+		}
+	}
+}
+
+void NvFlexGetBounds(NvFlexSolver* solver, NvFlexBuffer* lower, NvFlexBuffer* upper)
+{
+	if (lower)
+		*(Vec3*)lower->data = solver->lower;
+	if (upper)
+		*(Vec3*)upper->data = solver->upper;
+}
+
+float NvFlexGetDeviceLatency(NvFlexSolver* solver, unsigned long long* begin, unsigned long long* end, unsigned long long* frequency)
+{
+	if (begin)
+		*begin = 0;
+	if (end)
+		*end = (unsigned long long)(solver->latency*1.e6f);
+	if (frequency)
+		*frequency = 1000000;
+
+	return solver->latency;
+}
+
+void NvFlexGetTimers(NvFlexSolver* solver, NvFlexTimers* timers)
+{
+	*timers = solver->timers;
+}
+
+int NvFlexGetDetailTimers(NvFlexSolver* solver, NvFlexDetailTimer** timers)
+{
+	*timers = NULL;
+	return 0;
+}
+
+void NvFlexSetDebug(NvFlexSolver* solver, bool enable) {}
+void NvFlexGetShapeBVH(NvFlexSolver* solver, void* bvh) {}
+
+void NvFlexCopySolver(NvFlexSolver* dst, NvFlexSolver* src)
+{
+	NvFlexLibrary* lib = dst->lib;
+	*dst = *src;
+	dst->lib = lib;
+}
+
+void NvFlexCopyDeviceToHost(NvFlexSolver* solver, NvFlexBuffer* pDevice, void* pHost, int size, int stride)
+{
+	CopyElements(pHost, stride, pDevice->data, pDevice->stride, size);
+}
+
+//-----------------------------------------------------------------------------
+// collision geometry
+
+NvFlexTriangleMeshId NvFlexCreateTriangleMesh(NvFlexLibrary* lib)
+{
+	const unsigned int id = lib->nextId++;
+	lib->triangleMeshes[id] = new TriangleMesh();
+
+	return id;
+}
+
+void NvFlexDestroyTriangleMesh(NvFlexLibrary* lib, NvFlexTriangleMeshId mesh)
+{
+	DestroyObject(lib->triangleMeshes, mesh);
+}
+
+int NvFlexGetTriangleMeshes(NvFlexLibrary* lib, NvFlexTriangleMeshId* meshes, int n)
+{
+	return GetIds(lib->triangleMeshes, meshes, n);
+}
+
+void NvFlexUpdateTriangleMesh(NvFlexLibrary* lib, NvFlexTriangleMeshId mesh, NvFlexBuffer* vertices, NvFlexBuffer* indices, int numVertices, int numTriangles, const float* lower, const float* upper)
+{
+	if (!lib->triangleMeshes.count(mesh))
+		return;
+
+	TriangleMesh& m = *lib->triangleMeshes[mesh];
+
+	// vertices may be given as float3 or float4
+	CopyArray(m.vertices, vertices, numVertices);
+	CopyArray(m.indices, indices, numTriangles*3);
+
+	GetBounds(m.vertices, m.lower, m.upper);
+
+	BuildTriangleBvh(m.vertices.empty() ? NULL : &m.vertices[0], m.indices.empty() ? NULL : &m.indices[0], numTriangles, m.bvh);
+}
+
+void NvFlexGetTriangleMeshBounds(NvFlexLibrary* lib, const NvFlexTriangleMeshId mesh, float* lower, float* upper)
+{
+	if (!lib->triangleMeshes.count(mesh))
+		return;
+
+	const TriangleMesh& m = *lib->triangleMeshes[mesh];
+
+	*(Vec3*)lower = m.lower;
+	*(Vec3*)upper = m.upper;
+}
+
+NvFlexDistanceFieldId NvFlexCreateDistanceField(NvFlexLibrary* lib)
+{
+	const unsigned int id = lib->nextId++;
+	lib->distanceFields[id] = new DistanceField();
+
+	return id;
+}
+
+void NvFlexDestroyDistanceField(NvFlexLibrary* lib, NvFlexDistanceFieldId sdf)
+{
+	DestroyObject(lib->distanceFields, sdf);
+}
+
+int NvFlexGetDistanceFields(NvFlexLibrary* lib, NvFlexDistanceFieldId* sdfs, int n)
+{
+	return GetIds(lib->distanceFields, sdfs, n);
+}
+
+void NvFlexUpdateDistanceField(NvFlexLibrary* lib, NvFlexDistanceFieldId sdf, int dimx, int dimy, int dimz, NvFlexBuffer* field)
+{
+	if (!lib->distanceFields.count(sdf))
+		return;
+
+	DistanceField& f = *lib->distanceFields[sdf];
+	f.dim[0] = dimx;
+	f.dim[1] = dimy;
+	f.dim[2] = dimz;
+
+	CopyArray(f.values, field, dimx*dimy*dimz);
+}
+
+NvFlexConvexMeshId NvFlexCreateConvexMesh(NvFlexLibrary* lib)
+{
+	const unsigned int id = lib->nextId++;
+	lib->convexMeshes[id] = new ConvexMesh();
+
+	return id;
+}
+
+void NvFlexDestroyConvexMesh(NvFlexLibrary* lib, NvFlexConvexMeshId convex)
+{
+	DestroyObject(lib->convexMeshes, convex);
+}
+
+int NvFlexGetConvexMeshes(NvFlexLibrary* lib, NvFlexConvexMeshId* meshes, int n)
+{
+	return GetIds(lib->convexMeshes, meshes, n);
+}
+
+void NvFlexUpdateConvexMesh(NvFlexLibrary* lib, NvFlexConvexMeshId convex, NvFlexBuffer* planes, int numPlanes, const float* lower, const float* upper)
+{
+	if (!lib->convexMeshes.count(convex))
+		return;
+
+	ConvexMesh& m = *lib->convexMeshes[convex];
+
+	CopyArray(m.planes, planes, numPlanes);
+
+	m.lower = Vec3(lower);
+	m.upper = Vec3(upper);
+}
+
+void NvFlexGetConvexMeshBounds(NvFlexLibrary* lib, NvFlexConvexMeshId mesh, float* lower, float* upper)
+{
+	if (!lib->convexMeshes.count(mesh))
+		return;
+
+	const ConvexMesh& m = *lib->convexMeshes[mesh];
+
+	*(Vec3*)lower = m.lower;
+	*(Vec3*)upper = m.upper;
+}
@@ -0,0 +1,686 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#include "solver.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+namespace NvFlexCpu
+{
+
+namespace
+{
+
+const int kGrain = 256;
+
+// adds the time spent in func to timer in milliseconds when enabled
+template <typename Func>
+void Time(bool enabled, float& timer, Func func)
+{
+	if (!enabled)
+	{
+		func();
+		return;
+	}
+
+	const chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+	func();
+
+	timer += chrono::duration<float, milli>(chrono::high_resolution_clock::now()-start).count();
+}
+
+bool CollidePhases(const NvFlexSolver* s, int i, int j)
+{
+	const int pi = s->phases[i];
+	const int pj = s->phases[j];
+
+	if ((pi & eNvFlexPhaseGroupMask) != (pj & eNvFlexPhaseGroupMask))
+		return true;
+
+	if (!(pi & pj & eNvFlexPhaseSelfCollide))
+		return false;
+
+	// particles that start close together in the rest pose (e.g.: mesh neighbors) are not collided
+	if ((pi | pj) & eNvFlexPhaseSelfCollideFilter)
+	{
+		const float r = s->params.radius;
+		if (LengthSq(Vec3(s->restPositions[i])-Vec3(s->restPositions[j])) < r*r)
+			return false;
+	}
+
+	return true;
+}
+
+// pushes p out of a plane n.p + d = distance and applies Coulomb friction to the tangential 
+// motion over the step relative to the surface, which moved by velocity*dt
+void ProjectContact(const Vec4& plane, const Vec3& velocity, float distance, float staticFriction, float dynamicFriction, const Vec3& start, float dt, Vec3& p)
+{
+	const Vec3 n = Vec3(plane);
+	const float penetration = distance - (Dot(n, p) + plane.w);
+
+	if (penetration <= 0.0f)
+		return;
+
+	p += n*penetration;
+
+	const Vec3 dx = (p-start) - velocity*dt;
+	const Vec3 t = dx - n*Dot(dx, n);
+	const float l = Length(t);
+
+	if (l == 0.0f)
+		return;
+
+	if (l < staticFriction*penetration)
+		p -= t;
+	else
+		p -= t*Min(dynamicFriction*penetration/l, 1.0f);
+}
+
+void InvokeCallback(NvFlexSolver* s, NvFlexSolverCallbackStage stage, float dt)
+{
+	const NvFlexSolverCallback& callback = s->callbacks[stage];
+
+	if (!callback.function)
+		return;
+
+	const int numActive = s->numActive;
+
+	s->callbackParticles.resize(numActive);
+	s->callbackVelocities.resize(numActive);
+	s->callbackPhases.resize(numActive);
+	s->originalToSorted.assign(s->positions.size(), -1);
+
+	for (int k=0; k < numActive; ++k)
+	{
+		const int i = s->active[k];
+
+		s->callbackParticles[k] = s->positions[i];
+		s->callbackVelocities[k] = Vec4(s->velocities[i], 0.0f);
+		s->callbackPhases[k] = s->phases[i];
+		s->originalToSorted[i] = k;
+	}
+
+	NvFlexSolverCallbackParams params;
+	params.solver = s;
+	params.userData = callback.userData;
+	params.particles = numActive ? (float*)&s->callbackParticles[0] : NULL;
+	params.velocities = numActive ? (float*)&s->callbackVelocities[0] : NULL;
+	params.phases = numActive ? &s->callbackPhases[0] : NULL;
+	params.numActive = numActive;
+	params.dt = dt;
+	params.originalToSortedMap = s->originalToSorted.empty() ? NULL : &s->originalToSorted[0];
+	params.sortedToOriginalMap = numActive ? &s->active[0] : NULL;
+
+	callback.function(params);
+
+	for (int k=0; k < numActive; ++k)
+	{
+		const int i = s->active[k];
+
+		s->positions[i] = s->callbackParticles[k];
+		s->velocities[i] = Vec3(s->callbackVelocities[k]);
+	}
+}
+
+// closest rotation to A, iterates from the current estimate q, see Müller et al. 2016, 
+// "A Robust Method to Extract the Rotational Part of Deformations"
+Quat ExtractRotation(const Matrix33& A, Quat q, int maxIterations)
+{
+	for (int iter=0; iter < maxIterations; ++iter)
+	{
+		const Matrix33 R(q);
+
+		const Vec3 omega = (Cross(R.cols[0], A.cols[0]) + Cross(R.cols[1], A.cols[1]) + Cross(R.cols[2], A.cols[2]))*
+			(1.0f/(fabsf(Dot(R.cols[0], A.cols[0]) + Dot(R.cols[1], A.cols[1]) + Dot(R.cols[2], A.cols[2])) + 1.e-9f));
+
+		const float w = Length(omega);
+		if (w < 1.e-9f)
+			break;
+
+		q = Normalize(QuatFromAxisAngle(omega/w, w)*q);
+	}
+
+	return q;
+}
+
+void Predict(NvFlexSolver* s, float dt)
+{
+	const NvFlexParams& params = s->params;
+	const Vec3 gravity(params.gravity);
+	const float damping = Max(0.0f, 1.0f - params.damping*dt);
+
+	// drag and lift act on the velocity at the start of the step
+	const int numTriangles = int(s->triangles.size())/3;
+
+	if (numTriangles && (params.drag > 0.0f || params.lift > 0.0f))
+	{
+		s->aeroForces.assign(s->positions.size(), Vec3(0.0f));
+
+		ComputeAerodynamicForces(&s->triangleColoring, &s->triangles[0], numTriangles, &s->positions[0], &s->velocities[0], Vec3(params.wind), NULL, params.drag, params.lift, &s->aeroForces[0]);
+		ApplyAerodynamicForces(&s->aeroForces[0], &s->positions[0], &s->velocities[0], int(s->positions.size()), dt);
+	}
+
+	ParallelFor(s->numActive, [&](int begin, int end)
+	{
+		for (int k=begin; k < end; ++k)
+		{
+			const int i = s->active[k];
+
+			Vec4& p = s->positions[i];
+			Vec3& v = s->velocities[i];
+
+			s->startPositions[i] = p;
+
+			if (p.w > 0.0f)
+			{
+				v = (v + gravity*dt)*damping;
+
+				p.x += v.x*dt;
+				p.y += v.y*dt;
+				p.z += v.z*dt;
+			}
+			else
+			{
+				v = Vec3(0.0f);
+			}
+
+			s->predictedVelocities[i] = v;
+		}
+	}, kGrain);
+}
+
+void FindNeighbors(NvFlexSolver* s)
+{
+	const NvFlexParams& params = s->params;
+	const int numActive = s->numActive;
+	const int maxNeighbors = s->desc.maxNeighborsPerParticle;
+
+	const float radius = params.radius + params.particleCollisionMargin;
+
+	s->gridPoints.resize(numActive);
+
+	for (int k=0; k < numActive; ++k)
+		s->gridPoints[k] = Vec3(s->positions[s->active[k]]);
+
+	s->grid.Build(numActive ? &s->gridPoints[0] : NULL, numActive, radius);
+
+	ParallelFor(numActive, [&](int begin, int end)
+	{
+		vector<int> candidates;
+
+		for (int k=begin; k < end; ++k)
+		{
+			const int i = s->active[k];
+
+			int count = 0;
+
+			candidates.clear();
+			s->grid.QuerySphere(s->gridPoints[k], radius, candidates, false);
+
+			for (size_t c=0; c < candidates.size() && count < maxNeighbors; ++c)
+			{
+				const int j = s->active[candidates[c]];
+
+				if (i == j || (s->positions[i].w == 0.0f && s->positions[j].w == 0.0f) || !CollidePhases(s, i, j))
+					continue;
+
+				s->neighbors[k*maxNeighbors + count++] = j;
+			}
+
+			s->neighborCounts[k] = count;
+		}
+	}, kGrain);
+}
+
+void FindContacts(NvFlexSolver* s, float dt)
+{
+	const int maxContacts = s->desc.maxContactsPerParticle;
+
+	ParallelFor(s->numActive, [&](int begin, int end)
+	{
+		for (int k=begin; k < end; ++k)
+		{
+			const int i = s->active[k];
+
+			s->contactCounts[k] = CollideShapes(s, Vec3(s->positions[i]), Vec3(s->startPositions[i]), s->phases[i], dt, &s->contacts[k*maxContacts], maxContacts);
+		}
+	}, kGrain);
+}
+
+// position deltas from particle contacts and springs, each particle gathers its own share so no writes are shared
+void SolveParticleConstraints(NvFlexSolver* s)
+{
+	const NvFlexParams& params = s->params;
+	const int maxNeighbors = s->desc.maxNeighborsPerParticle;
+	const float restDistance = params.solidRestDistance;
+	const float friction = params.particleFriction;
+
+	ParallelFor(s->numActive, [&](int begin, int end)
+	{
+		for (int k=begin; k < end; ++k)
+		{
+			const int i = s->active[k];
+			const Vec4& pi = s->positions[i];
+
+			Vec3 delta(0.0f);
+			int count = 0;
+
+			if (pi.w > 0.0f)
+			{
+				const Vec3 xi = Vec3(pi);
+				const Vec3 si = Vec3(s->startPositions[i]);
+
+				for (int c=0; c < s->neighborCounts[k]; ++c)
+				{
+					const int j = s->neighbors[k*maxNeighbors + c];
+					const Vec4& pj = s->positions[j];
+
+					const Vec3 d = xi-Vec3(pj);
+					const float l = Length(d);
+
+					if (l >= restDistance || l == 0.0f)
+						continue;
+
+					const float w = pi.w/(pi.w + pj.w);
+					const Vec3 n = d/l;
+					const float penetration = restDistance-l;
+
+					Vec3 correction = n*(penetration*w);
+
+					// friction on the relative tangential motion over the step
+					if (friction > 0.0f)
+					{
+						const Vec3 dx = (xi-si) - (Vec3(pj)-Vec3(s->startPositions[j]));
+						const Vec3 t = dx - n*Dot(dx, n);
+						const float tl = Length(t);
+
+						if (tl > 0.0f)
+							correction -= t*(w*Min(friction*penetration/tl, 1.0f));
+					}
+
+					delta += correction;
+					count++;
+				}
+
+				for (int c=s->particleSpringStarts[i]; c < s->particleSpringStarts[i+1]; ++c)
+				{
+					const int spring = s->particleSprings[c];
+
+					const int a = s->springIndices[spring*2+0];
+					const int b = s->springIndices[spring*2+1];
+					const int j = (a == i) ? b : a;
+
+					const Vec4& pj = s->positions[j];
+
+					const Vec3 d = xi-Vec3(pj);
+					const float l = Length(d);
+
+					if (l == 0.0f)
+						continue;
+
+					const float error = l - s->springLengths[spring];
+					const float stiffness = s->springStiffness[spring];
+
+					// negative stiffness marks tethers that only resist stretching
+					if (stiffness < 0.0f && error < 0.0f)
+						continue;
+
+					delta -= d*(fabsf(stiffness)*error*pi.w/((pi.w + pj.w)*l));
+					count++;
+				}
+			}
+
+			s->deltas[i] = delta;
+			s->deltaCounts[i] = count;
+		}
+	}, kGrain);
+}
+
+// shape matching, particles are assumed to belong to at most one rigid so rigids can run in parallel
+void SolveRigids(NvFlexSolver* s)
+{
+	const int numRigids = int(s->rigidOffsets.size()) - 1;
+
+	if (numRigids <= 0)
+		return;
+
+	ParallelFor(numRigids, [&](int begin, int end)
+	{
+		for (int r=begin; r < end; ++r)
+		{
+			const int start = s->rigidOffsets[r];
+			const int finish = s->rigidOffsets[r+1];
+
+			// mass weighted center, kinematic particles count as heavy
+			Vec3 com(0.0f);
+			float mass = 0.0f;
+
+			for (int c=start; c < finish; ++c)
+			{
+				const Vec4& p = s->positions[s->rigidIndices[c]];
+				const float m = p.w > 0.0f ? 1.0f/p.w : 1.e6f;
+
+				com += Vec3(p)*m;
+				mass += m;
+			}
+
+			if (mass == 0.0f)
+				continue;
+
+			com /= mass;
+
+			Matrix33 A(Vec3(0.0f), Vec3(0.0f), Vec3(0.0f));
+
+			for (int c=start; c < finish; ++c)
+			{
+				const Vec4& p = s->positions[s->rigidIndices[c]];
+				const float m = p.w > 0.0f ? 1.0f/p.w : 1.e6f;
+
+				A += Outer((Vec3(p)-com)*m, s->rigidRestPositions[c]);
+			}
+
+			const Quat q = ExtractRotation(A, s->rigidRotations[r], 20);
+
+			s->rigidRotations[r] = q;
+			s->rigidTranslations[r] = com;
+
+			const float stiffness = s->rigidStiffness[r];
+
+			for (int c=start; c < finish; ++c)
+			{
+				const int i = s->rigidIndices[c];
+				const Vec4& p = s->positions[i];
+
+				if (p.w == 0.0f)
+					continue;
+
+				const Vec3 goal = com + Rotate(q, s->rigidRestPositions[c]);
+
+				s->deltas[i] += (goal-Vec3(p))*stiffness;
+				s->deltaCounts[i]++;
+			}
+		}
+	}, 16);
+}
+
+// averages the gathered deltas then resolves shapes and planes directly
+void ApplyDeltas(NvFlexSolver* s, float dt)
+{
+	const NvFlexParams& params = s->params;
+	const int maxContacts = s->desc.maxContactsPerParticle;
+	const bool local = params.relaxationMode == eNvFlexRelaxationLocal;
+
+	ParallelFor(s->numActive, [&](int begin, int end)
+	{
+		for (int k=begin; k < end; ++k)
+		{
+			const int i = s->active[k];
+			Vec4& p = s->positions[i];
+
+			if (p.w == 0.0f)
+				continue;
+
+			Vec3 x = Vec3(p);
+
+			const int count = s->deltaCounts[i];
+			if (count)
+				x += s->deltas[i]*(params.relaxationFactor/(local ? float(count) : 1.0f));
+
+			const Vec3 start = Vec3(s->startPositions[i]);
+
+			for (int c=0; c < s->contactCounts[k]; ++c)
+			{
+				const Contact& contact = s->contacts[k*maxContacts + c];
+				ProjectContact(contact.plane, contact.velocity, params.collisionDistance, params.staticFriction, params.dynamicFriction, start, dt, x);
+			}
+
+			for (int c=0; c < params.numPlanes; ++c)
+				ProjectContact(Vec4(params.planes[c]), Vec3(0.0f), params.collisionDistance, params.staticFriction, params.dynamicFriction, start, dt, x);
+
+			p.x = x.x;
+			p.y = x.y;
+			p.z = x.z;
+		}
+	}, kGrain);
+}
+
+void Finalize(NvFlexSolver* s, float dt)
+{
+	const NvFlexParams& params = s->params;
+	const int maxContacts = s->desc.maxContactsPerParticle;
+	const float maxDeltaV = params.maxAcceleration*dt;
+
+	ParallelFor(s->numActive, [&](int begin, int end)
+	{
+		for (int k=begin; k < end; ++k)
+		{
+			const int i = s->active[k];
+			Vec4& p = s->positions[i];
+
+			if (p.w == 0.0f)
+				continue;
+
+			const Vec3 start = Vec3(s->startPositions[i]);
+			const Vec3 predicted = s->predictedVelocities[i];
+
+			Vec3 v = (Vec3(p)-start)/dt;
+
+			int numContacts = s->contactCounts[k];
+
+			// reflect the approach velocity of shapes still in contact
+			for (int c=0; c < s->contactCounts[k]; ++c)
+			{
+				const Contact& contact = s->contacts[k*maxContacts + c];
+				const Vec3 n = Vec3(contact.plane);
+
+				if (Dot(n, Vec3(p)) + contact.plane.w > params.collisionDistance*1.01f)
+				{
+					numContacts--;
+					continue;
+				}
+
+				const float vn = Dot(predicted-contact.velocity, n);
+				if (params.restitution > 0.0f && vn < 0.0f)
+					v += n*(-params.restitution*vn - Dot(v-contact.velocity, n));
+			}
+
+			if (params.dissipation > 0.0f)
+				v *= Max(0.0f, 1.0f - params.dissipation*float(numContacts + s->neighborCounts[k])*dt);
+
+			const Vec3 dv = v-predicted;
+			const float dvl = Length(dv);
+
+			if (dvl > maxDeltaV)
+				v = predicted + dv*(maxDeltaV/dvl);
+
+			const float speed = Length(v);
+
+			if (speed > params.maxSpeed)
+				v *= params.maxSpeed/speed;
+
+			if (speed < params.sleepThreshold)
+			{
+				v = Vec3(0.0f);
+				p = Vec4(start, p.w);
+			}
+
+			s->velocities[i] = v;
+		}
+	}, kGrain);
+}
+
+void UpdateNormals(NvFlexSolver* s)
+{
+	const int numTriangles = int(s->triangles.size())/3;
+
+	if (!numTriangles)
+		return;
+
+	ParallelFor(numTriangles, [&](int begin, int end)
+	{
+		for (int t=begin; t < end; ++t)
+		{
+			const Vec3 a = Vec3(s->positions[s->triangles[t*3+0]]);
+			const Vec3 b = Vec3(s->positions[s->triangles[t*3+1]]);
+			const Vec3 c = Vec3(s->positions[s->triangles[t*3+2]]);
+
+			s->triangleNormals[t] = SafeNormalize(Cross(b-a, c-a));
+		}
+	}, kGrain);
+
+	// area weighted vertex normals gathered through the particle to triangle adjacency
+	ParallelFor(int(s->positions.size()), [&](int begin, int end)
+	{
+		for (int i=begin; i < end; ++i)
+		{
+			const int first = s->particleTriangleStarts[i];
+			const int last = s->particleTriangleStarts[i+1];
+
+			if (first == last)
+				continue;
+
+			Vec3 n(0.0f);
+
+			for (int c=first; c < last; ++c)
+			{
+				const int t = s->particleTriangles[c];
+
+				const Vec3 a = Vec3(s->positions[s->triangles[t*3+0]]);
+				const Vec3 b = Vec3(s->positions[s->triangles[t*3+1]]);
+				const Vec3 c2 = Vec3(s->positions[s->triangles[t*3+2]]);
+
+				n += Cross(b-a, c2-a);
+			}
+
+			s->normals[i] = Vec4(SafeNormalize(n), s->normals[i].w);
+		}
+	}, kGrain);
+}
+
+void UpdateBounds(NvFlexSolver* s)
+{
+	Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+
+	for (int k=0; k < s->numActive; ++k)
+	{
+		const Vec3 p = Vec3(s->positions[s->active[k]]);
+
+		lower = Min(lower, p);
+		upper = Max(upper, p);
+	}
+
+	if (s->numActive == 0)
+		lower = upper = Vec3(0.0f);
+
+	s->lower = lower;
+	s->upper = upper;
+}
+
+} // anonymous namespace
+
+void UpdateSolver(NvFlexSolver* s, float dt, int substeps, bool enableTimers)
+{
+	const chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+	memset(&s->timers, 0, sizeof(s->timers));
+
+	const int numParticles = int(s->positions.size());
+	s->numActive = Clamp(s->numActive, 0, int(s->active.size()));
+
+	// drop indices outside the particle range rather than reading out of bounds
+	for (int k=0; k < s->numActive; ++k)
+	{
+		if (s->active[k] < 0 || s->active[k] >= numParticles)
+		{
+			ReportError(s->lib, eNvFlexLogError, "Active particle index out of range", __FILE__, __LINE__);
+			s->numActive = k;
+			break;
+		}
+	}
+
+	const int numActive = s->numActive;
+
+	s->startPositions.resize(numParticles);
+	s->predictedVelocities.resize(numParticles);
+	s->deltas.resize(numParticles);
+	s->deltaCounts.resize(numParticles);
+
+	s->neighbors.resize(size_t(numActive)*s->desc.maxNeighborsPerParticle);
+	s->neighborCounts.resize(numActive);
+	s->contacts.resize(size_t(numActive)*s->desc.maxContactsPerParticle);
+	s->contactCounts.resize(numActive);
+
+	substeps = Max(substeps, 1);
+
+	const float stepDt = dt/substeps;
+
+	if (stepDt > 0.0f)
+	{
+		for (int step=0; step < substeps; ++step)
+		{
+			Time(enableTimers, s->timers.predict, [&]() { Predict(s, stepDt); });
+
+			InvokeCallback(s, eNvFlexStageSubstepBegin, stepDt);
+
+			Time(enableTimers, s->timers.collideParticles, [&]() { FindNeighbors(s); });
+			Time(enableTimers, s->timers.collideShapes, [&]() { FindContacts(s, stepDt); });
+
+			for (int iter=0; iter < s->params.numIterations; ++iter)
+			{
+				InvokeCallback(s, eNvFlexStageIterationStart, stepDt);
+
+				Time(enableTimers, s->timers.solveSprings, [&]() { SolveParticleConstraints(s); });
+				Time(enableTimers, s->timers.solveShapes, [&]() { SolveRigids(s); });
+				Time(enableTimers, s->timers.applyDeltas, [&]() { ApplyDeltas(s, stepDt); });
+
+				InvokeCallback(s, eNvFlexStageIterationEnd, stepDt);
+			}
+
+			Time(enableTimers, s->timers.finalize, [&]() { Finalize(s, stepDt); });
+
+			InvokeCallback(s, eNvFlexStageSubstepEnd, stepDt);
+		}
+	}
+
+	Time(enableTimers, s->timers.updateNormals, [&]() { UpdateNormals(s); });
+	Time(enableTimers, s->timers.updateBounds, [&]() { UpdateBounds(s); });
+
+	InvokeCallback(s, eNvFlexStageUpdateEnd, dt);
+
+	s->latency = chrono::duration<float, milli>(chrono::high_resolution_clock::now()-start).count();
+
+	if (enableTimers)
+		s->timers.total = s->latency;
+}
+
+} // namespace NvFlexCpu
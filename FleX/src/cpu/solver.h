@@ -0,0 +1,223 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2016 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "../../core/maths.h"
+#include "../../core/hashgrid.h"
+#include "../../core/aerodynamics.h"
+#include "../../core/parallel.h"
+
+#include "../../include/NvFlex.h"
+
+#include <map>
+#include <vector>
+
+// host implementation of the subset of the Flex API used by the demos, particle state is kept 
+// as one array per attribute and every pass is a Jacobi style gather so particles can be 
+// processed in parallel without atomics
+
+struct NvFlexBuffer
+{
+	NvFlexLibrary* lib;
+
+	void* data;
+	int count;
+	int stride;
+
+	NvFlexBufferType type;
+};
+
+namespace NvFlexCpu
+{
+
+// bounding volume hierarchy over triangles for overlap queries, leaves hold a few triangles
+struct TriangleBvh
+{
+	struct Node
+	{
+		Vec3 lower;
+		Vec3 upper;
+
+		int left;	// child index for inner nodes, -1 for leaves
+		int start;	// first item of a leaf
+		int count;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<int> items;
+};
+
+void BuildTriangleBvh(const Vec3* vertices, const int* indices, int numTriangles, TriangleBvh& bvh);
+
+struct TriangleMesh
+{
+	std::vector<Vec3> vertices;
+	std::vector<int> indices;
+
+	Vec3 lower;
+	Vec3 upper;
+
+	TriangleBvh bvh;
+};
+
+struct ConvexMesh
+{
+	std::vector<Vec4> planes;
+
+	Vec3 lower;
+	Vec3 upper;
+};
+
+struct DistanceField
+{
+	int dim[3];
+	std::vector<float> values;
+};
+
+// contact plane against a collision shape in world space, n.x + d >= collisionDistance when resolved
+struct Contact
+{
+	Vec4 plane;
+	Vec3 velocity;	// velocity of the shape at the contact point
+	int shape;
+};
+
+// constraint solve and collision passes, see solver.cpp
+void UpdateSolver(NvFlexSolver* solver, float dt, int substeps, bool enableTimers);
+
+// contact generation against the solver's shapes for the particle at p, whose start of step position is x, returns the contact count
+int CollideShapes(const NvFlexSolver* solver, const Vec3& p, const Vec3& x, int phase, float dt, Contact* contacts, int maxContacts);
+
+void ReportError(NvFlexLibrary* lib, NvFlexErrorSeverity severity, const char* msg, const char* file, int line);
+
+} // namespace NvFlexCpu
+
+struct NvFlexLibrary
+{
+	NvFlexErrorCallback errorFunc;
+
+	unsigned int nextId;
+
+	std::map<unsigned int, NvFlexCpu::TriangleMesh*> triangleMeshes;
+	std::map<unsigned int, NvFlexCpu::ConvexMesh*> convexMeshes;
+	std::map<unsigned int, NvFlexCpu::DistanceField*> distanceFields;
+
+	std::vector<NvFlexSolver*> solvers;
+
+	char deviceName[64];
+};
+
+struct NvFlexSolver
+{
+	NvFlexLibrary* lib;
+
+	NvFlexSolverDesc desc;
+	NvFlexParams params;
+
+	// particle state indexed by api particle index
+	std::vector<Vec4> positions;
+	std::vector<Vec4> restPositions;
+	std::vector<Vec3> velocities;
+	std::vector<int> phases;
+	std::vector<Vec4> normals;
+
+	std::vector<int> active;
+	int numActive;
+
+	// distance constraints and the springs touching each particle
+	std::vector<int> springIndices;
+	std::vector<float> springLengths;
+	std::vector<float> springStiffness;
+
+	std::vector<int> particleSpringStarts;
+	std::vector<int> particleSprings;
+
+	// shape matching constraints
+	std::vector<int> rigidOffsets;
+	std::vector<int> rigidIndices;
+	std::vector<Vec3> rigidRestPositions;
+	std::vector<Vec4> rigidRestNormals;
+	std::vector<float> rigidStiffness;
+	std::vector<float> rigidThresholds;
+	std::vector<float> rigidCreeps;
+	std::vector<Quat> rigidRotations;
+	std::vector<Vec3> rigidTranslations;
+
+	// cloth triangles and the triangles touching each particle
+	std::vector<int> triangles;
+	std::vector<Vec3> triangleNormals;
+	TriangleColoring triangleColoring;
+
+	std::vector<int> particleTriangleStarts;
+	std::vector<int> particleTriangles;
+
+	// inflatables are stored for read back only
+	std::vector<int> inflatableStarts;
+	std::vector<int> inflatableCounts;
+	std::vector<float> inflatableRestVolumes;
+	std::vector<float> inflatablePressures;
+	std::vector<float> inflatableScales;
+
+	// collision shapes
+	std::vector<NvFlexCollisionGeometry> geometry;
+	std::vector<Vec4> shapePositions;
+	std::vector<Quat> shapeRotations;
+	std::vector<Vec4> shapePrevPositions;
+	std::vector<Quat> shapePrevRotations;
+	std::vector<int> shapeFlags;
+
+	// per step scratch, indexed by api particle index
+	std::vector<Vec4> startPositions;
+	std::vector<Vec3> predictedVelocities;
+	std::vector<Vec3> deltas;
+	std::vector<int> deltaCounts;
+	std::vector<Vec3> aeroForces;
+
+	// per active particle neighbors (api indices) and shape contacts, from the last substep
+	std::vector<int> neighbors;
+	std::vector<int> neighborCounts;
+	std::vector<NvFlexCpu::Contact> contacts;
+	std::vector<int> contactCounts;
+
+	HashGrid grid;
+	std::vector<Vec3> gridPoints;
+
+	NvFlexSolverCallback callbacks[eNvFlexStageCount];
+
+	// active particle data handed to callbacks, written back when they return
+	std::vector<Vec4> callbackParticles;
+	std::vector<Vec4> callbackVelocities;
+	std::vector<int> callbackPhases;
+	std::vector<int> originalToSorted;
+
+	NvFlexTimers timers;
+	float latency;
+
+	Vec3 lower;
+	Vec3 upper;
+};
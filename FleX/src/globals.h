@@ -119,8 +119,20 @@ Mesh* g_mesh;
 vector<int> g_meshSkinIndices;
 vector<float> g_meshSkinWeights;
 vector<Point3> g_meshRestPositions;
+MeshSkinning g_meshSkinning;
 const int g_numSkinWeights = 4;
 
+// space filling curve reordering of particles after scene creation (0: off, 1: Morton, 2: Hilbert)
+int g_reorderParticles = 0;
+vector<int> g_particleOrder;	// original index of each particle after reordering
+vector<int> g_triangleOrder;	// original index of each triangle after reordering
+
+// geodesic long range attachments for pinned cloth, replaces the scenes' corner tethers
+bool g_lraTethers = false;
+int g_lraMaxAnchors = 2;
+float g_lraStiffness = 1.0f;
+float g_lraGive = 0.0f;		// fraction of the geodesic rest length
+
 // -------- FleX -------- //
 
 #include "physics.h"
@@ -137,6 +149,13 @@ NvFlexParams g_params = {0};
 int g_device = -1;
 char g_deviceName[256];
 
+// builds linked against the host solver (FLEX_COMPUTE=CPU) run without a GPU
+#if NV_FLEX_CPU
+NvFlexComputeType g_computeType = eNvFlexCPU;
+#else
+NvFlexComputeType g_computeType = eNvFlexCUDA;
+#endif
+
 // ------- Profiling ------- //
 
 float g_waitTime;		// the CPU time spent waiting for the GPU
@@ -183,10 +202,34 @@ int g_randomClothMinRes = 145;
 int g_randomClothMaxRes = 215;
 
 
+// Obstacle collision representation (triangle mesh by default, or an approximate convex decomposition)
+bool g_convexObstacles = false;
+int g_convexMaxHulls = 16;
+float g_convexConcavity = 0.01f;	// fraction of the obstacle bounds diagonal
+int g_convexMaxPlanes = 32;
+
+// Terrain collision representation (0: obstacle mesh, 1: height field triangle mesh, 2: height field SDF slab)
+int g_terrainHeightField = 0;
+float g_terrainSpacing = 0.02f;		// height field sample spacing
+float g_terrainTolerance = 0.001f;	// planarity tolerance used to merge height field cells
+int g_terrainSDFDim = 128;
+
 float g_windTime = 0.0f;
 float g_windFrequency = 0.1f;
 float g_windStrength = 0.0f;
 
+// spatially varying wind applied to particle velocities on top of the global wind
+WindField g_windField;
+bool g_useWindField = false;
+float g_windFieldDrag = 2.0f;	// rate at which particle velocities relax towards the wind field
+
+// drag and lift on cloth triangles evaluated on the host, the solver's coefficients are moved here when enabled
+bool g_hostAerodynamics = false;
+float g_aeroDrag = 0.0f;
+float g_aeroLift = 0.0f;
+TriangleColoring g_aeroColoring;
+std::vector<Vec3> g_aeroForces;
+
 bool g_wavePool = false;
 float g_waveTime = 0.0f;
 float g_wavePlane;
@@ -207,7 +250,7 @@ bool g_vsync = true;
 bool g_benchmark = false;
 bool g_extensions = true; // Enable or disable NVIDIA/AMD extensions in DirectX
 bool g_teamCity = false;
-bool g_interop = true;
+bool g_interop = (g_computeType != eNvFlexCPU);	// the host solver has no graphics buffers to share
 bool g_useAsyncCompute = true;		
 bool g_increaseGfxLoadForAsyncComputeTesting = false;
 
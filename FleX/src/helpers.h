@@ -29,39 +29,13 @@
 
 #include <stdarg.h>
 
+#include "particleorder.h"
+
 // disable some warnings
 #if _WIN32
 #pragma warning(disable: 4267)  // conversion from 'size_t' to 'int', possible loss of data
 #endif
 
-float SampleSDF(const float* sdf, int dim, int x, int y, int z)
-{
-	assert(x < dim && x >= 0);
-	assert(y < dim && y >= 0);
-	assert(z < dim && z >= 0);
-
-	return sdf[z*dim*dim + y*dim + x];
-}
-
-// return normal of signed distance field
-Vec3 SampleSDFGrad(const float* sdf, int dim, int x, int y, int z)
-{
-	int x0 = max(x-1, 0);
-	int x1 = min(x+1, dim-1);
-
-	int y0 = max(y-1, 0);
-	int y1 = min(y+1, dim-1);
-
-	int z0 = max(z-1, 0);
-	int z1 = min(z+1, dim-1);
-
-	float dx = (SampleSDF(sdf, dim, x1, y, z) - SampleSDF(sdf, dim, x0, y, z))*(dim*0.5f);
-	float dy = (SampleSDF(sdf, dim, x, y1, z) - SampleSDF(sdf, dim, x, y0, z))*(dim*0.5f);
-	float dz = (SampleSDF(sdf, dim, x, y, z1) - SampleSDF(sdf, dim, x, y, z0))*(dim*0.5f);
-
-	return Vec3(dx, dy, dz);
-}
-
 void GetParticleBounds(Vec3& lower, Vec3& upper)
 {
 	lower = Vec3(FLT_MAX);
@@ -448,42 +422,34 @@ void CreateParticleShape(const char* filename, Vec3 lower, Vec3 scale, float rot
 	delete mesh;
 }
 
-void SkinMesh()
+// precomputes the skinning of g_mesh to the rigids, called after the scene has been created
+void BuildMeshSkinning()
 {
-	if (g_mesh)
-	{
-		int startVertex = 0;
-
-		for (int r=0; r < g_buffers->rigidRotations.size(); ++r)
-		{
-			const Matrix33 rotation = g_buffers->rigidRotations[r];
-			const int numVertices = g_buffers->rigidMeshSize[r];
-
-			for (int i=startVertex; i < numVertices+startVertex; ++i)
-			{
-				Vec3 skinPos;
+	g_meshSkinning = MeshSkinning();
 
-				for (int w=0; w < 4; ++w)
-				{
-					// small shapes can have < 4 particles
-					if (g_meshSkinIndices[i*4+w] > -1)
-					{
-						assert(g_meshSkinWeights[i*4+w] < FLT_MAX);
+	if (g_mesh && g_meshSkinIndices.size())
+	{
+		const int numRigids = min(int(g_buffers->rigidMeshSize.size()), int(g_buffers->rigidOffsets.size()) - 1);
 
-						int index = g_meshSkinIndices[i*4+w];
-						float weight = g_meshSkinWeights[i*4+w];
+		CreateMeshSkinning((const Vec3*)&g_meshRestPositions[0], &g_meshSkinIndices[0], &g_meshSkinWeights[0], &g_buffers->rigidMeshSize[0], max(numRigids, 0), int(g_mesh->m_positions.size()), &g_mesh->m_indices[0], int(g_mesh->m_indices.size()), g_meshSkinning);
+	}
+}
 
-						skinPos += (rotation*(g_meshRestPositions[i]-Point3(g_buffers->restPositions[index])) + Vec3(g_buffers->positions[index]))*weight;
-					}
-				}
+void SkinMesh()
+{
+	if (g_mesh)
+	{
+		const int numRigids = int(g_buffers->rigidRotations.size());
 
-				g_mesh->m_positions[i] = Point3(skinPos);
-			}
+		// rotations of the rigids, skinned vertices gather them by index
+		vector<Matrix33> rotations(numRigids);
+		for (int r=0; r < numRigids; ++r)
+			rotations[r] = Matrix33(g_buffers->rigidRotations[r]);
 
-			startVertex += numVertices;
-		}
+		g_mesh->m_normals.resize(g_mesh->m_positions.size());
 
-		g_mesh->CalculateNormals();
+		if (g_mesh->m_positions.size())
+			ApplyMeshSkinning(g_meshSkinning, rotations.size() ? &rotations[0] : NULL, &g_buffers->positions[0], &g_buffers->restPositions[0], &g_mesh->m_indices[0], (Vec3*)&g_mesh->m_positions[0], &g_mesh->m_normals[0]);
 	}
 }
 
@@ -578,6 +544,38 @@ void CreateSDF(const Mesh* mesh, uint32_t dim, Vec3 lower, Vec3 upper, float* sd
 }
 
 
+// create render mesh for a convex
+GpuMesh* CreateConvexGpuMesh(const ConvexMeshBuilder& builder)
+{
+	Mesh renderMesh;
+
+	for (uint32_t j = 0; j < builder.mIndices.size(); j += 3)
+	{
+		uint32_t a = builder.mIndices[j + 0];
+		uint32_t b = builder.mIndices[j + 1];
+		uint32_t c = builder.mIndices[j + 2];
+
+		Vec3 n = Normalize(Cross(builder.mVertices[b] - builder.mVertices[a], builder.mVertices[c] - builder.mVertices[a]));
+		
+		int startIndex = renderMesh.m_positions.size();
+
+		renderMesh.m_positions.push_back(Point3(builder.mVertices[a]));
+		renderMesh.m_normals.push_back(n);
+
+		renderMesh.m_positions.push_back(Point3(builder.mVertices[b]));
+		renderMesh.m_normals.push_back(n);
+
+		renderMesh.m_positions.push_back(Point3(builder.mVertices[c]));
+		renderMesh.m_normals.push_back(n);
+
+		renderMesh.m_indices.push_back(startIndex+0);
+		renderMesh.m_indices.push_back(startIndex+1);
+		renderMesh.m_indices.push_back(startIndex+2);
+	}
+
+	return CreateGpuMesh(&renderMesh);
+}
+
 void AddRandomConvex(int numPlanes, Vec3 position, float minDist, float maxDist, Vec3 axis, float angle)
 {
 	const int maxPlanes = 12;
@@ -647,37 +645,51 @@ void AddRandomConvex(int numPlanes, Vec3 position, float minDist, float maxDist,
 	int flags = NvFlexMakeShapeFlags(eNvFlexShapeConvexMesh, false);
 	g_buffers->shapeFlags.push_back(flags);
 
+	// insert into the global mesh list
+	g_convexes[mesh] = CreateConvexGpuMesh(builder);
+}
 
-	// create render mesh for convex
-	Mesh renderMesh;
-
-	for (uint32_t j = 0; j < builder.mIndices.size(); j += 3)
+// adds the hulls of a convex decomposition as static convex mesh shapes, returns the number of shapes added
+int AddConvexHulls(const std::vector<ConvexHull>& hulls, Vec3 translation, Quat rotation, bool render=true)
+{
+	for (size_t i=0; i < hulls.size(); ++i)
 	{
-		uint32_t a = builder.mIndices[j + 0];
-		uint32_t b = builder.mIndices[j + 1];
-		uint32_t c = builder.mIndices[j + 2];
+		const ConvexHull& hull = hulls[i];
 
-		Vec3 n = Normalize(Cross(builder.mVertices[b] - builder.mVertices[a], builder.mVertices[c] - builder.mVertices[a]));
-		
-		int startIndex = renderMesh.m_positions.size();
+		NvFlexVector<Vec4> planes(g_flexLib);
+		planes.assign(&hull.planes[0], hull.planes.size());
+		planes.unmap();
 
-		renderMesh.m_positions.push_back(Point3(builder.mVertices[a]));
-		renderMesh.m_normals.push_back(n);
+		NvFlexConvexMeshId mesh = NvFlexCreateConvexMesh(g_flexLib);
+		NvFlexUpdateConvexMesh(g_flexLib, mesh, planes.buffer, planes.size(), hull.lower, hull.upper);
 
-		renderMesh.m_positions.push_back(Point3(builder.mVertices[b]));
-		renderMesh.m_normals.push_back(n);
+		NvFlexCollisionGeometry geo;
+		geo.convexMesh.mesh = mesh;
+		geo.convexMesh.scale[0] = 1.0f;
+		geo.convexMesh.scale[1] = 1.0f;
+		geo.convexMesh.scale[2] = 1.0f;
 
-		renderMesh.m_positions.push_back(Point3(builder.mVertices[c]));
-		renderMesh.m_normals.push_back(n);
+		g_buffers->shapePositions.push_back(Vec4(translation, 0.0f));
+		g_buffers->shapeRotations.push_back(Quat(rotation));
+		g_buffers->shapePrevPositions.push_back(Vec4(translation, 0.0f));
+		g_buffers->shapePrevRotations.push_back(Quat(rotation));
+		g_buffers->shapeGeometry.push_back(geo);
+		g_buffers->shapeFlags.push_back(NvFlexMakeShapeFlags(eNvFlexShapeConvexMesh, false));
 
-		renderMesh.m_indices.push_back(startIndex+0);
-		renderMesh.m_indices.push_back(startIndex+1);
-		renderMesh.m_indices.push_back(startIndex+2);
+		if (render)
+		{
+			ConvexMeshBuilder builder(&hull.planes[0]);
+			builder(uint32_t(hull.planes.size()));
+
+			g_convexes[mesh] = CreateConvexGpuMesh(builder);
+		}
+		else
+		{
+			g_convexes[mesh] = nullptr;
+		}
 	}
 
-	// insert into the global mesh list
-	GpuMesh* gpuMesh = CreateGpuMesh(&renderMesh);
-	g_convexes[mesh] = gpuMesh;
+	return int(hulls.size());
 }
 
 void CreateRandomBody(int numPlanes, Vec3 position, float minDist, float maxDist, Vec3 axis, float angle, float invMass, int phase, float stiffness)
@@ -811,6 +823,45 @@ void AddTriangleMesh(NvFlexTriangleMeshId mesh, Vec3 translation, Quat rotation,
 }
 
 
+// adds a static obstacle mesh, by default as a triangle mesh shape, or when g_convexObstacles
+// is set as the hulls of an approximate convex decomposition, decompositions are cached next
+// to meshFile keyed by the mesh data and decomposition parameters, returns the number of 
+// shapes added
+int AddObstacleMesh(Mesh* m, const char* meshFile, bool render=true)
+{
+	if (!g_convexObstacles)
+	{
+		NvFlexTriangleMeshId mesh = CreateTriangleMesh(m, render);
+		AddTriangleMesh(mesh, Vec3(), Quat(), 1.0f);
+
+		return 1;
+	}
+
+	const Vec3* vertices = (const Vec3*)&m->m_positions[0];
+	const int* indices = (const int*)&m->m_indices[0];
+
+	const uint64_t key = ConvexDecompositionKey(vertices, m->GetNumVertices(), indices, m->m_indices.size(), g_convexMaxHulls, g_convexConcavity, g_convexMaxPlanes);
+
+	char cacheFile[kMaxPathLength];
+	snprintf(cacheFile, kMaxPathLength, "%s_%016llx.hulls", StripExtension(meshFile).c_str(), (unsigned long long)key);
+
+	vector<ConvexHull> hulls;
+	if (!ConvexDecompositionLoad(cacheFile, key, hulls))
+	{
+		printf("Cooking convex decomposition: %s\n", cacheFile);
+
+		double start = GetSeconds();
+
+		CreateConvexDecomposition(vertices, m->GetNumVertices(), indices, m->m_indices.size(), g_convexMaxHulls, g_convexConcavity, g_convexMaxPlanes, hulls);
+
+		printf("Created %d hulls (%.2fs)\n", int(hulls.size()), GetSeconds()-start);
+
+		if (!ConvexDecompositionSave(cacheFile, key, hulls))
+			printf("Failed to write convex decomposition to %s\n", cacheFile);
+	}
+
+	return AddConvexHulls(hulls, Vec3(), Quat(), render);
+}
 
 NvFlexDistanceFieldId CreateSDF(const char* meshFile, int dim, float margin = 0.1f, float expand = 0.0f)
 {
@@ -880,95 +931,333 @@ void AddSDF(NvFlexDistanceFieldId sdf, Vec3 translation, Quat rotation, float wi
 	g_buffers->shapeFlags.push_back(NvFlexMakeShapeFlags(eNvFlexShapeSDF, false));
 }
 
+// adds a static terrain mesh, when g_terrainHeightField is set and the mesh is a height field
+// along +y it is resampled on a grid and added either as a simplified grid triangle mesh (1)
+// or as an SDF slab (2), otherwise falls back to AddObstacleMesh(), returns the number of shapes added
+int AddTerrainMesh(Mesh* m, const char* meshFile, bool render=true)
+{
+	const Vec3* vertices = (const Vec3*)&m->m_positions[0];
+	const int* indices = (const int*)&m->m_indices[0];
+
+	if (g_terrainHeightField == 0 || !IsHeightField(vertices, m->GetNumVertices(), indices, m->m_indices.size(), g_terrainTolerance))
+	{
+		if (g_terrainHeightField)
+			printf("Terrain is not a height field, using obstacle mesh: %s\n", meshFile);
+
+		return AddObstacleMesh(m, meshFile, render);
+	}
+
+	HeightField field;
+	CreateHeightField(vertices, m->GetNumVertices(), indices, m->m_indices.size(), g_terrainSpacing, field);
+
+	Mesh* surface = CreateHeightFieldMesh(field, g_terrainTolerance);
+
+	printf("Created height field %d x %d (%d triangles)\n", field.width, field.depth, surface->GetNumFaces());
+
+	if (g_terrainHeightField == 1)
+	{
+		NvFlexTriangleMeshId mesh = CreateTriangleMesh(surface, render);
+		AddTriangleMesh(mesh, Vec3(), Quat(), 1.0f);
+	}
+	else
+	{
+		const int dim = g_terrainSDFDim;
+
+		Vec3 lower;
+		float width;
+
+		NvFlexVector<float> values(g_flexLib, dim*dim*dim);
+		values.map();
+
+		CreateHeightFieldSDF(field, dim, &values[0], lower, width);
+
+		values.unmap();
+
+		NvFlexDistanceFieldId sdf = NvFlexCreateDistanceField(g_flexLib);
+		NvFlexUpdateDistanceField(g_flexLib, sdf, dim, dim, dim, values.buffer);
+
+		// render mesh in the unit space of the field
+		surface->Transform(ScaleMatrix(1.0f/width)*TranslationMatrix(Point3(-lower)));
+
+		g_fields[sdf] = render ? CreateGpuMesh(surface) : nullptr;
+
+		AddSDF(sdf, lower, Quat(), width);
+	}
+
+	delete surface;
+
+	return 1;
+}
+
 inline int GridIndex(int x, int y, int dx) { return y*dx + x; }
 
 void CreateSpringGrid(Vec3 lower, int dx, int dy, int dz, float radius, int phase, float stretchStiffness, float bendStiffness, float shearStiffness, Vec3 velocity, float invMass, float extra_spacing=0.0f, float extra_rad_mult=1.0f)
 {
-	int baseIndex = int(g_buffers->positions.size());
+	const int numParticles = dx*dy*dz;
+	if (numParticles == 0)
+		return;
 
-	for (int z=0; z < dz; ++z)
+	const int baseIndex = int(g_buffers->positions.size());
+	const int baseTriangle = int(g_buffers->triangles.size())/3;
+	const int baseNormal = int(g_buffers->triangleNormals.size());
+	const int baseSpring = int(g_buffers->springLengths.size());
+
+	// each layer emits the triangles of the first one
+	const int cellsPerLayer = Max(dx-1, 0)*Max(dy-1, 0);
+	const int numTris = 2*cellsPerLayer*dz;
+
+	// springs are emitted in a horizontal sweep over rows followed by a vertical sweep over columns, 
+	// every row has stretch and bend springs and all but the first have two shear springs per cell
+	const int rowSprings = Max(dx-1, 0) + Max(dx-2, 0);
+	const int rowShearSprings = 2*Max(dx-1, 0);
+	const int horizontalSprings = dy*rowSprings + Max(dy-1, 0)*rowShearSprings;
+	const int columnSprings = Max(dy-1, 0) + Max(dy-2, 0);
+	const int numSprings = horizontalSprings + dx*columnSprings;
+
+	// size everything once up front
+	g_buffers->positions.resize(baseIndex + numParticles);
+	g_buffers->velocities.resize(baseIndex + numParticles);
+	g_buffers->phases.resize(baseIndex + numParticles);
+	g_buffers->triangles.resize((baseTriangle + numTris)*3);
+	g_buffers->triangleNormals.resize(baseNormal + numTris);
+	g_buffers->springIndices.resize((baseSpring + numSprings)*2);
+	g_buffers->springLengths.resize(baseSpring + numSprings);
+	g_buffers->springStiffness.resize(baseSpring + numSprings);
+
+	Vec4* positions = &g_buffers->positions[0];
+	Vec3* velocities = &g_buffers->velocities[0];
+	int* phases = &g_buffers->phases[0];
+	int* triangles = numTris ? &g_buffers->triangles[baseTriangle*3] : NULL;
+	Vec3* triangleNormals = numTris ? &g_buffers->triangleNormals[baseNormal] : NULL;
+	int* springIndices = numSprings ? &g_buffers->springIndices[baseSpring*2] : NULL;
+	float* springLengths = numSprings ? &g_buffers->springLengths[baseSpring] : NULL;
+	float* springStiffness = numSprings ? &g_buffers->springStiffness[baseSpring] : NULL;
+
+	const float spacing = extra_rad_mult*radius + extra_spacing;
+
+	// roughly 16k particles per task
+	const int rowGrain = Max(1, 16384/Max(dx, 1));
+
+	// particles and triangles, one row of the grid at a time
+	ParallelFor(dy*dz, [&](int begin, int end)
 	{
-		for (int y=0; y < dy; ++y)
+		for (int row=begin; row < end; ++row)
 		{
+			const int z = row/dy;
+			const int y = row%dy;
+
 			for (int x=0; x < dx; ++x)
 			{
-				Vec3 position = lower + (extra_rad_mult*radius + extra_spacing)*Vec3(float(x), float(z), float(y));
+				const int index = baseIndex + row*dx + x;
 
-				g_buffers->positions.push_back(Vec4(position.x, position.y, position.z, invMass));
-				g_buffers->velocities.push_back(velocity);
-				g_buffers->phases.push_back(phase);
+				Vec3 position = lower + spacing*Vec3(float(x), float(z), float(y));
+
+				positions[index] = Vec4(position.x, position.y, position.z, invMass);
+				velocities[index] = velocity;
+				phases[index] = phase;
 
 				if (x > 0 && y > 0)
 				{
-					g_buffers->triangles.push_back(baseIndex + GridIndex(x-1, y-1, dx));
-					g_buffers->triangles.push_back(baseIndex + GridIndex(x, y-1, dx));
-					g_buffers->triangles.push_back(baseIndex + GridIndex(x, y, dx));
-					
-					g_buffers->triangles.push_back(baseIndex + GridIndex(x-1, y-1, dx));
-					g_buffers->triangles.push_back(baseIndex + GridIndex(x, y, dx));
-					g_buffers->triangles.push_back(baseIndex + GridIndex(x-1, y, dx));
+					const int tri = z*cellsPerLayer*2 + ((y-1)*(dx-1) + x-1)*2;
+
+					int* t = &triangles[tri*3];
+
+					t[0] = baseIndex + GridIndex(x-1, y-1, dx);
+					t[1] = baseIndex + GridIndex(x, y-1, dx);
+					t[2] = baseIndex + GridIndex(x, y, dx);
+
+					t[3] = baseIndex + GridIndex(x-1, y-1, dx);
+					t[4] = baseIndex + GridIndex(x, y, dx);
+					t[5] = baseIndex + GridIndex(x-1, y, dx);
 
-					g_buffers->triangleNormals.push_back(Vec3(0.0f, 1.0f, 0.0f));
-					g_buffers->triangleNormals.push_back(Vec3(0.0f, 1.0f, 0.0f));
+					triangleNormals[tri+0] = Vec3(0.0f, 1.0f, 0.0f);
+					triangleNormals[tri+1] = Vec3(0.0f, 1.0f, 0.0f);
 				}
 			}
 		}
-	}
+	}, rowGrain);
 
+	// same as CreateSpring() but written to a precomputed slot
+	auto spring = [&](int s, int i, int j, float stiffness)
+	{
+		springIndices[s*2+0] = i;
+		springIndices[s*2+1] = j;
+		springLengths[s] = Length(Vec3(positions[i])-Vec3(positions[j]));
+		springStiffness[s] = stiffness;
+	};
 
 	// horizontal
-	for (int y=0; y < dy; ++y)
+	ParallelFor(dy, [&](int begin, int end)
 	{
-		for (int x=0; x < dx; ++x)
+		for (int y=begin; y < end; ++y)
 		{
-			int index0 = y*dx + x;
+			int s = y*rowSprings + Max(y-1, 0)*rowShearSprings;
 
-			if (x > 0)
+			for (int x=0; x < dx; ++x)
 			{
-				int index1 = y*dx + x - 1;
-				CreateSpring(baseIndex + index0, baseIndex + index1, stretchStiffness);
-			}
+				int index0 = y*dx + x;
 
-			if (x > 1)
-			{
-				int index2 = y*dx + x - 2;
-				CreateSpring(baseIndex + index0, baseIndex + index2, bendStiffness);
-			}
+				if (x > 0)
+				{
+					int index1 = y*dx + x - 1;
+					spring(s++, baseIndex + index0, baseIndex + index1, stretchStiffness);
+				}
 
-			if (y > 0 && x < dx-1)
-			{
-				int indexDiag = (y-1)*dx + x + 1;
-				CreateSpring(baseIndex + index0, baseIndex + indexDiag, shearStiffness);
-			}
+				if (x > 1)
+				{
+					int index2 = y*dx + x - 2;
+					spring(s++, baseIndex + index0, baseIndex + index2, bendStiffness);
+				}
 
-			if (y > 0 && x > 0)
-			{
-				int indexDiag = (y-1)*dx + x - 1;
-				CreateSpring(baseIndex + index0, baseIndex + indexDiag, shearStiffness);
+				if (y > 0 && x < dx-1)
+				{
+					int indexDiag = (y-1)*dx + x + 1;
+					spring(s++, baseIndex + index0, baseIndex + indexDiag, shearStiffness);
+				}
+
+				if (y > 0 && x > 0)
+				{
+					int indexDiag = (y-1)*dx + x - 1;
+					spring(s++, baseIndex + index0, baseIndex + indexDiag, shearStiffness);
+				}
 			}
 		}
-	}
+	}, rowGrain);
 
 	// vertical
-	for (int x=0; x < dx; ++x)
+	ParallelFor(dx, [&](int begin, int end)
 	{
-		for (int y=0; y < dy; ++y)
+		for (int x=begin; x < end; ++x)
 		{
-			int index0 = y*dx + x;
+			int s = horizontalSprings + x*columnSprings;
 
-			if (y > 0)
+			for (int y=0; y < dy; ++y)
 			{
-				int index1 = (y-1)*dx + x;
-				CreateSpring(baseIndex + index0, baseIndex + index1, stretchStiffness);
-			}
+				int index0 = y*dx + x;
 
-			if (y > 1)
-			{
-				int index2 = (y-2)*dx + x;
-				CreateSpring(baseIndex + index0, baseIndex + index2, bendStiffness);
+				if (y > 0)
+				{
+					int index1 = (y-1)*dx + x;
+					spring(s++, baseIndex + index0, baseIndex + index1, stretchStiffness);
+				}
+
+				if (y > 1)
+				{
+					int index2 = (y-2)*dx + x;
+					spring(s++, baseIndex + index0, baseIndex + index2, bendStiffness);
+				}
 			}
 		}
-	}	
+	}, Max(1, 16384/Max(dy, 1)));
+}
+
+// adds long range attachments, unilateral tethers from every free particle to its maxAnchors
+// nearest anchors (zero inverse mass) measured over the existing springs, returns the number added
+int CreateLongRangeAttachments(float stiffness, float give, int maxAnchors=1)
+{
+	// existing tethers are not part of the cloth
+	std::vector<int> edges;
+	for (int i=0; i < g_buffers->springLengths.size(); ++i)
+	{
+		if (g_buffers->springStiffness[i] >= 0.0f)
+		{
+			edges.push_back(g_buffers->springIndices[i*2+0]);
+			edges.push_back(g_buffers->springIndices[i*2+1]);
+		}
+	}
+
+	if (edges.empty())
+		return 0;
+
+	std::vector<Tether> tethers;
+	CreateTethers(&g_buffers->positions[0], g_buffers->positions.size(), &edges[0], int(edges.size())/2, maxAnchors, tethers);
+
+	for (size_t i=0; i < tethers.size(); ++i)
+	{
+		g_buffers->springIndices.push_back(tethers[i].anchor);
+		g_buffers->springIndices.push_back(tethers[i].particle);
+		g_buffers->springLengths.push_back((1.0f+give)*tethers[i].restLength);
+
+		// negative stiffness indicates tether (unilateral constraint)
+		g_buffers->springStiffness.push_back(-stiffness);
+	}
+
+	return int(tethers.size());
+}
+
+// creates cloth from an arbitrary triangle mesh, the mesh is scaled, centered over center with its bottom at 
+// center.y, and remeshed to the same particle spacing as CreateSpringGrid so garments cost the same per-particle 
+// as grids, returns false without adding anything if the mesh can't be read or isn't manifold after remeshing
+bool CreateClothFromMesh(const char* meshFile, Vec3 center, float scale, float radius, int phase, float stretchStiffness, float bendStiffness, Vec3 velocity, float invMass, float extra_spacing=0.0f, float extra_rad_mult=1.0f, int iterations=5)
+{
+	Mesh* input = ImportMesh(meshFile);
+	if (!input)
+	{
+		printf("Failed to read cloth mesh %s\n", meshFile);
+		return false;
+	}
+
+	Vec3 meshLower, meshUpper;
+	input->GetBounds(meshLower, meshUpper);
+
+	const Vec3 offset = Vec3(0.5f*(meshLower.x + meshUpper.x), meshLower.y, 0.5f*(meshLower.z + meshUpper.z));
+
+	input->Transform(TranslationMatrix(Point3(center))*ScaleMatrix(scale)*TranslationMatrix(Point3(-offset)));
+
+	Mesh* mesh = CreateIsotropicRemesh(input, extra_rad_mult*radius + extra_spacing, iterations);
+	delete input;
+
+	const int numVertices = int(mesh->GetNumVertices());
+
+	std::vector<Vec4> vertices(numVertices);
+	for (int i=0; i < numVertices; ++i)
+		vertices[i] = Vec4(Vec3(mesh->m_positions[i]), invMass);
+
+	// stretch springs along edges, bending springs across edges
+	ClothMesh cloth(numVertices ? &vertices[0] : NULL, numVertices, (const int*)mesh->m_indices.data(), int(mesh->m_indices.size()), stretchStiffness, bendStiffness);
+
+	if (!cloth.mValid)
+	{
+		printf("Cloth mesh %s is not manifold after remeshing, no cloth created\n", meshFile);
+
+		delete mesh;
+		return false;
+	}
+
+	const int baseIndex = int(g_buffers->positions.size());
+
+	for (int i=0; i < numVertices; ++i)
+	{
+		g_buffers->positions.push_back(vertices[i]);
+		g_buffers->velocities.push_back(velocity);
+		g_buffers->phases.push_back(phase);
+	}
+
+	for (int i=0; i < int(mesh->GetNumFaces()); ++i)
+	{
+		g_buffers->triangles.push_back(baseIndex + mesh->m_indices[i*3+0]);
+		g_buffers->triangles.push_back(baseIndex + mesh->m_indices[i*3+1]);
+		g_buffers->triangles.push_back(baseIndex + mesh->m_indices[i*3+2]);
+
+		const Vec3 a = Vec3(vertices[mesh->m_indices[i*3+0]]);
+		const Vec3 b = Vec3(vertices[mesh->m_indices[i*3+1]]);
+		const Vec3 c = Vec3(vertices[mesh->m_indices[i*3+2]]);
+
+		g_buffers->triangleNormals.push_back(SafeNormalize(Cross(b-a, c-a)));
+	}
+
+	for (int i=0; i < int(cloth.mConstraintRestLengths.size()); ++i)
+	{
+		g_buffers->springIndices.push_back(baseIndex + cloth.mConstraintIndices[i*2+0]);
+		g_buffers->springIndices.push_back(baseIndex + cloth.mConstraintIndices[i*2+1]);
+		g_buffers->springLengths.push_back(cloth.mConstraintRestLengths[i]);
+		g_buffers->springStiffness.push_back(cloth.mConstraintCoefficients[i]);
+	}
+
+	printf("Cloth mesh %s: %d particles, %d triangles, %d springs\n", meshFile, numVertices, int(mesh->GetNumFaces()), int(cloth.mConstraintRestLengths.size()));
+
+	delete mesh;
+	return true;
 }
 
 
@@ -1284,6 +1573,24 @@ void CreateTetMesh(const char* filename, Vec3 lower, float scale, float stiffnes
 	}
 }
 
+// reorders the scene's particles, see particleorder.h, the original order is kept in g_particleOrder and g_triangleOrder
+void ReorderParticles(SpaceFillingCurve curve)
+{
+	ReorderParticles(g_buffers, curve, g_particleOrder, g_triangleOrder, g_meshSkinIndices);
+}
+
+// returns positions and triangles to the order the scene created them in, and back again, 
+// so exported meshes do not depend on g_reorderParticles
+void RestoreParticleOrder()
+{
+	RestoreParticleOrder(g_buffers, g_particleOrder, g_triangleOrder);
+}
+
+void ReapplyParticleOrder()
+{
+	ReapplyParticleOrder(g_buffers, g_particleOrder, g_triangleOrder);
+}
+
 // finds the closest particle to a view ray
 int PickParticle(Vec3 origin, Vec3 dir, Vec4* particles, int* phases, int n, float radius, float &outT)
 {
@@ -1506,6 +1813,9 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 
 	std::stable_sort(seeds.begin(), seeds.end());
 
+	HashGrid grid;
+	grid.Build(particles, numParticles, radius);
+
 	while (seeds.size())
 	{
 		// pick highest unused particle from the seeds list
@@ -1516,19 +1826,11 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 		{
 			Cluster c;
 
-			const float radiusSq = sqr(radius);
-
 			// push all neighbors within radius
-			for (int p = 0; p < numParticles; ++p)
-			{
-				float dSq = LengthSq(Vec3(particles[seed.index]) - Vec3(particles[p]));
-				if (dSq <= radiusSq)
-				{
-					c.indices.push_back(p);
+			grid.QuerySphere(Vec3(particles[seed.index]), radius, c.indices, true);
 
-					used[p] = true;
-				}
-			}
+			for (int i = 0; i < int(c.indices.size()); ++i)
+				used[c.indices[i]] = true;
 
 			c.mean = CalculateMean(particles, &c.indices[0], c.indices.size());
 
@@ -1538,26 +1840,22 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 
 	if (smoothing > 0.0f)
 	{
-		// expand clusters by smoothing radius
-		float radiusSmoothSq = sqr(smoothing);
-
-		for (int i = 0; i < int(clusters.size()); ++i)
+		// expand clusters by smoothing radius, clusters are independent once seeded
+		ParallelFor(int(clusters.size()), [&](int begin, int end)
 		{
-			Cluster& c = clusters[i];
+			for (int i = begin; i < end; ++i)
+			{
+				Cluster& c = clusters[i];
 
-			// clear cluster indices
-			c.indices.resize(0);
+				// clear cluster indices
+				c.indices.resize(0);
 
-			// push all neighbors within radius
-			for (int p = 0; p < numParticles; ++p)
-			{
-				float dSq = LengthSq(c.mean - Vec3(particles[p]));
-				if (dSq <= radiusSmoothSq)
-					c.indices.push_back(p);
-			}
+				// push all neighbors within radius
+				grid.QuerySphere(c.mean, smoothing, c.indices, true);
 
-			c.mean = CalculateMean(particles, &c.indices[0], c.indices.size());
-		}
+				c.mean = CalculateMean(particles, &c.indices[0], c.indices.size());
+			}
+		}, 64);
 	}
 
 	// write out cluster indices
@@ -1594,107 +1892,139 @@ int CreateClusters(Vec3* particles, const float* priority, int numParticles, std
 // creates distance constraints between particles within some distance
 int CreateLinks(const Vec3* particles, int numParticles, std::vector<int>& outSpringIndices, std::vector<float>& outSpringLengths, std::vector<float>& outSpringStiffness, float radius, float stiffness = 1.0f)
 {
-	const float radiusSq = sqr(radius);
+	HashGrid grid;
+	grid.Build(particles, numParticles, radius);
 
-	int count = 0;
+	// each block of particles writes links to its own buffers which are then concatenated in particle order
+	const int blockSize = 1024;
+	const int numBlocks = (numParticles + blockSize - 1)/blockSize;
 
-	for (int i = 0; i < numParticles; ++i)
+	std::vector<std::vector<int> > blockIndices(numBlocks);
+	std::vector<std::vector<float> > blockLengths(numBlocks);
+
+	ParallelFor(numBlocks, [&](int begin, int end)
 	{
-		for (int j = i + 1; j < numParticles; ++j)
-		{
-			float dSq = LengthSq(Vec3(particles[i]) - Vec3(particles[j]));
+		std::vector<int> neighbors;
 
-			if (dSq < radiusSq)
+		for (int b = begin; b < end; ++b)
+		{
+			for (int i = b*blockSize; i < Min((b+1)*blockSize, numParticles); ++i)
 			{
-				outSpringIndices.push_back(i);
-				outSpringIndices.push_back(j);
-				outSpringLengths.push_back(sqrtf(dSq));
-				outSpringStiffness.push_back(stiffness);
+				neighbors.resize(0);
+				grid.QuerySphere(particles[i], radius, neighbors);
 
-				++count;
+				// neighbors are in index order so links are ordered as in an all pairs loop
+				for (int n = 0; n < int(neighbors.size()); ++n)
+				{
+					const int j = neighbors[n];
+
+					if (j > i)
+					{
+						blockIndices[b].push_back(i);
+						blockIndices[b].push_back(j);
+						blockLengths[b].push_back(sqrtf(LengthSq(Vec3(particles[i]) - Vec3(particles[j]))));
+					}
+				}
 			}
 		}
-	}
+	}, 1);
 
-	return count;
+	// prefix sum of block sizes gives the output offset of each block
+	std::vector<int> offsets(numBlocks + 1, int(outSpringLengths.size()));
+
+	for (int b = 0; b < numBlocks; ++b)
+		offsets[b+1] = offsets[b] + int(blockLengths[b].size());
+
+	outSpringIndices.resize(offsets[numBlocks]*2);
+	outSpringLengths.resize(offsets[numBlocks]);
+	outSpringStiffness.resize(offsets[numBlocks], stiffness);
+
+	ParallelFor(numBlocks, [&](int begin, int end)
+	{
+		for (int b = begin; b < end; ++b)
+		{
+			std::copy(blockIndices[b].begin(), blockIndices[b].end(), outSpringIndices.begin() + offsets[b]*2);
+			std::copy(blockLengths[b].begin(), blockLengths[b].end(), outSpringLengths.begin() + offsets[b]);
+		}
+	}, 1);
+
+	return offsets[numBlocks] - offsets[0];
 }
 
 void CreateSkinning(const Vec3* vertices, int numVertices, const Vec3* clusters, int numClusters, float* outWeights, int* outIndices, float falloff, float maxdist)
 {
 	const int maxBones = 4;
 
-	// for each vertex, find the closest n clusters
-	for (int i = 0; i < numVertices; ++i)
+	if (numClusters == 0)
+		return;
+
+	// size cells so a few clusters fall in each
+	Vec3 lower(FLT_MAX), upper(-FLT_MAX);
+	for (int c = 0; c < numClusters; ++c)
 	{
-		int indices[4] = { -1, -1, -1, -1 };
-		float distances[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
-		float weights[maxBones];
+		lower = Min(lower, clusters[c]);
+		upper = Max(upper, clusters[c]);
+	}
+
+	const Vec3 edges = upper - lower;
+	const float spacing = Max(Max(edges.x, edges.y), edges.z)/Max(1.0f, cbrtf(float(numClusters)));
+
+	HashGrid grid;
+	grid.Build(clusters, numClusters, Max(spacing, 1e-4f));
 
-		for (int c = 0; c < numClusters; ++c)
+	// for each vertex, find the closest n clusters
+	ParallelFor(numVertices, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
 		{
-			float dSq = LengthSq(vertices[i] - clusters[c]);
+			int indices[maxBones] = { -1, -1, -1, -1 };
+			float distances[maxBones] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+			float weights[maxBones];
 
-			// insertion sort
-			int w = 0;
-			for (; w < maxBones; ++w)
-				if (dSq < distances[w])
-					break;
+			grid.QueryNearest(vertices[i], maxBones, indices, distances);
+
+			// weight particles according to distance
+			float wSum = 0.0f;
 
-			if (w < maxBones)
+			for (int w = 0; w < maxBones; ++w)
 			{
-				// shuffle down
-				for (int s = maxBones - 1; s > w; --s)
+				if (distances[w] > sqr(maxdist))
+				{
+					// clamp bones over a given distance to zero
+					weights[w] = 0.0f;
+				}
+				else
 				{
-					indices[s] = indices[s - 1];
-					distances[s] = distances[s - 1];
+					// weight falls off inversely with distance
+					weights[w] = 1.0f / (powf(distances[w], falloff) + 0.0001f);
 				}
 
-				distances[w] = dSq;
-				indices[w] = c;
+				wSum += weights[w];
 			}
-		}
-
-		// weight particles according to distance
-		float wSum = 0.0f;
 
-		for (int w = 0; w < maxBones; ++w)
-		{
-			if (distances[w] > sqr(maxdist))
+			if (wSum == 0.0f)
 			{
-				// clamp bones over a given distance to zero
-				weights[w] = 0.0f;
+				// if all weights are zero then just 
+				// rigidly skin to the closest bone
+				weights[0] = 1.0f;
 			}
 			else
 			{
-				// weight falls off inversely with distance
-				weights[w] = 1.0f / (powf(distances[w], falloff) + 0.0001f);
+				// normalize weights
+				for (int w = 0; w < maxBones; ++w)
+				{
+					weights[w] = weights[w] / wSum;
+				}
 			}
 
-			wSum += weights[w];
-		}
-
-		if (wSum == 0.0f)
-		{
-			// if all weights are zero then just 
-			// rigidly skin to the closest bone
-			weights[0] = 1.0f;
-		}
-		else
-		{
-			// normalize weights
-			for (int w = 0; w < maxBones; ++w)
+			// output
+			for (int j = 0; j < maxBones; ++j)
 			{
-				weights[w] = weights[w] / wSum;
+				outWeights[i*maxBones + j] = weights[j];
+				outIndices[i*maxBones + j] = indices[j];
 			}
 		}
-
-		// output
-		for (int j = 0; j < maxBones; ++j)
-		{
-			outWeights[i*maxBones + j] = weights[j];
-			outIndices[i*maxBones + j] = indices[j];
-		}
-	}
+	});
 }
 
 
@@ -1761,25 +2091,7 @@ void SampleMesh(Mesh* mesh, Vec3 lower, Vec3 scale, float rotation, float radius
 		Voxelize((const Vec3*)&mesh->m_positions[0], mesh->m_positions.size(), (const int*)&mesh->m_indices[0], mesh->m_indices.size(), maxDim, maxDim, maxDim, &voxels[0], meshLower, meshLower + Vec3(maxDim*spacing));
 
 		// sample interior
-		for (int x = 0; x < maxDim; ++x)
-		{
-			for (int y = 0; y < maxDim; ++y)
-			{
-				for (int z = 0; z < maxDim; ++z)
-				{
-					const int index = z*maxDim*maxDim + y*maxDim + x;
-
-					// if voxel is marked as occupied the add a particle
-					if (voxels[index])
-					{
-						Vec3 position = lower + meshLower + spacing*Vec3(float(x) + 0.5f, float(y) + 0.5f, float(z) + 0.5f);
-
-						// normalize the sdf value and transform to world scale
-						samples.push_back(position);
-					}
-				}
-			}
-		}
+		SampleVoxels(&voxels[0], maxDim, maxDim, maxDim, lower + meshLower, spacing, samples);
 	}
 
 	// move back
@@ -1792,26 +2104,8 @@ void SampleMesh(Mesh* mesh, Vec3 lower, Vec3 scale, float rotation, float radius
 		for (int i = 0; i < int(mesh->m_positions.size()); ++i)
 			samples.push_back(Vec3(mesh->m_positions[i]));
 
-		// random surface sampling
-		if (1)
-		{
-			for (int i = 0; i < 50000; ++i)
-			{
-				int t = Rand() % mesh->GetNumFaces();
-				float u = Randf();
-				float v = Randf()*(1.0f - u);
-				float w = 1.0f - u - v;
-
-				int a = mesh->m_indices[t * 3 + 0];
-				int b = mesh->m_indices[t * 3 + 1];
-				int c = mesh->m_indices[t * 3 + 2];
-				
-				Point3 pt = mesh->m_positions[a] * u + mesh->m_positions[b] * v + mesh->m_positions[c] * w;
-				Vec3 p(pt.x,pt.y,pt.z);
-
-				samples.push_back(p);
-			}
-		}
+		// blue noise surface sampling
+		SampleSurface((const Vec3*)&mesh->m_positions[0], (const int*)&mesh->m_indices[0], mesh->m_indices.size(), 50000, 0.5f*radius, samples);
 	}
 
 	std::vector<int> clusterIndices;
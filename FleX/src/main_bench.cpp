@@ -3,11 +3,23 @@
 #include "../core/platform.h"
 #include "../core/mesh.h"
 #include "../core/voxelize.h"
+#include "../core/sample.h"
+#include "../core/skinning.h"
+#include "../core/windfield.h"
+#include "../core/aerodynamics.h"
+#include "../core/springs.h"
 #include "../core/sdf.h"
 #include "../core/pfm.h"
 #include "../core/tga.h"
 #include "../core/perlin.h"
 #include "../core/convex.h"
+#include "../core/decompose.h"
+#include "../core/heightfield.h"
+#include "../core/reorder.h"
+#include "../core/parallel.h"
+#include "../core/hashgrid.h"
+#include "../core/tether.h"
+#include "../core/remesh.h"
 #include "../core/cloth.h"
 
 #include "../external/SDL2-2.0.4/include/SDL.h"
@@ -128,6 +140,27 @@ void ParseConfig(const char* path, int& n_iters, Bench::ClothParams& cp, Bench::
         printf("Ignoring \"coll_margin\" (same as \"shape_coll_friction\").\n");
     }
 
+    // obstacle collision representation
+    g_convexObstacles = config["convex_obstacles"].as<bool>(g_convexObstacles);
+    g_convexMaxHulls = config["convex_max_hulls"].as<int>(g_convexMaxHulls);
+    g_convexConcavity = config["convex_concavity"].as<float>(g_convexConcavity);
+    g_convexMaxPlanes = config["convex_max_planes"].as<int>(g_convexMaxPlanes);
+
+    // terrain collision representation
+    g_terrainHeightField = config["terrain_heightfield"].as<int>(g_terrainHeightField);
+    g_terrainSpacing = config["terrain_spacing"].as<float>(g_terrainSpacing);
+    g_terrainTolerance = config["terrain_tolerance"].as<float>(g_terrainTolerance);
+    g_terrainSDFDim = config["terrain_sdf_dim"].as<int>(g_terrainSDFDim);
+
+    // particle ordering
+    g_reorderParticles = config["reorder_particles"].as<int>(g_reorderParticles);
+
+    // long range attachments
+    g_lraTethers = config["lra_tethers"].as<bool>(g_lraTethers);
+    g_lraMaxAnchors = config["lra_max_anchors"].as<int>(g_lraMaxAnchors);
+    g_lraStiffness = config["lra_stiffness"].as<float>(g_lraStiffness);
+    g_lraGive = config["lra_give"].as<float>(g_lraGive);
+
     if (config["extra_cp_spacing"]) {
         cp.extra_cp_spacing = config["extra_cp_spacing"].as<float>(cp.extra_cp_spacing);
     }
@@ -264,7 +297,7 @@ void InitSim() {            // <---- [DON'T CHANGE] Initialize the solver. This
     desc.renderDevice = 0;
     desc.renderContext = 0;
     desc.computeContext = 0;
-    desc.computeType = eNvFlexCUDA;
+    desc.computeType = g_computeType;
 
     // Init Flex library, note that no CUDA methods should be called before this 
     // point to ensure we get the device context we want
@@ -529,6 +562,13 @@ void ResetSim() {     //<------ Called only once
     g_scenes[g_scene]->Initialize();
     EndGpuWork();
 
+    // optionally sort particles along a space filling curve for memory locality
+    g_particleOrder.resize(0);
+    g_triangleOrder.resize(0);
+
+    if (g_reorderParticles)
+        ReorderParticles(SpaceFillingCurve(g_reorderParticles-1));
+
     uint32_t numParticles = g_buffers->positions.size();    // <--- 44100
     uint32_t maxParticles = numParticles + g_numExtraParticles * g_numExtraMultiplier;
 
@@ -639,6 +679,9 @@ void ResetSim() {     //<------ Called only once
         g_meshRestPositions.resize(0);
     }
 
+    // precompute skinning of the render mesh to the rigids
+    BuildMeshSkinning();
+
     // give scene a chance to do some post solver initialization
     g_scenes[g_scene]->PostInitialize();
 
@@ -1372,7 +1415,9 @@ void UpdateSimMapped() {
 
     if (g_exportObjsFlag || g_saveClothPerSimStep) {
         printf("\n\nsaving cloth for frame %d\n", g_frame);
+        RestoreParticleOrder();
         g_scenes[g_scene]->Export(&g_exportBase[0]);
+        ReapplyParticleOrder();
         // ExportObjs(&g_clothObjPath[0], &g_transformedMeshPath[0]);
     }
 }
@@ -1788,6 +1833,22 @@ for (int i = 1; i < argc; ++i) {
         if (sscanf(argv[i], "-extensions=%d", &d))
             g_extensions = d != 0;
 
+        if (sscanf(argv[i], "-benchforcefields=%d", &d) == 1) {
+            return CheckForceFields(1<<20, d) ? 0 : 1;
+        }
+
+        if (sscanf(argv[i], "-benchaero=%d", &d) == 1) {
+            return CheckAerodynamics(d) ? 0 : 1;
+        }
+
+        if (sscanf(argv[i], "-benchsprings=%d", &d) == 1) {
+            return CheckSprings(d) ? 0 : 1;
+        }
+
+        if (sscanf(argv[i], "-benchjacobi=%d", &d) == 1) {
+            return CheckJacobiSprings(d) ? 0 : 1;
+        }
+
         if (string(argv[i]).find("-benchmark") != string::npos) {
             g_benchmark = true;
             g_profile = true;
@@ -0,0 +1,260 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2017 NVIDIA Corporation. All rights reserved.
+
+// headless driver for the host kernel checks, runs without a window or a CUDA device and returns 
+// non-zero when any check fails
+
+#include "../core/types.h"
+#include "../core/maths.h"
+#include "../core/platform.h"
+#include "../core/aerodynamics.h"
+#include "../core/springs.h"
+#include "../core/perlin.h"
+#include "../core/bending.h"
+#include "../core/sdf.h"
+#include "../core/heightfield.h"
+#include "../core/reorder.h"
+#include "../core/tether.h"
+#include "../core/skinning.h"
+#include "../core/windfield.h"
+#include "../core/parallel.h"
+
+#include "../include/NvFlex.h"
+#include "../include/NvFlexExt.h"
+
+#include <string>
+
+#include "physics.h"
+#include "particleorder.h"
+#include "hostchecks.h"
+
+using namespace std;
+
+namespace
+{
+
+// dim x dim unit square grid with alternating diagonals, flat in xz or rolled around the z axis with the given radius
+void CreateBendingCheckGrid(int dim, float radius, vector<Vec4>& particles, vector<int>& indices)
+{
+	particles.resize(0);
+	indices.resize(0);
+
+	for (int y=0; y < dim; ++y)
+	{
+		for (int x=0; x < dim; ++x)
+		{
+			const float u = float(x)/(dim-1);
+			const float v = float(y)/(dim-1);
+
+			if (radius > 0.0f)
+				particles.push_back(Vec4(radius*sinf(u/radius), radius*(1.0f-cosf(u/radius)), v, 1.0f));
+			else
+				particles.push_back(Vec4(u, 0.0f, v, 1.0f));
+		}
+	}
+
+	for (int y=0; y < dim-1; ++y)
+	{
+		for (int x=0; x < dim-1; ++x)
+		{
+			const int i = y*dim + x;
+			const int quad[2][6] = { { i, i+1, i+dim+1, i, i+dim+1, i+dim }, { i, i+1, i+dim, i+1, i+dim+1, i+dim } };
+
+			indices.insert(indices.end(), quad[(x+y)&1], quad[(x+y)&1]+6);
+		}
+	}
+}
+
+}
+
+// isometric bending precomputation, the check driver is the only target that links core/bending.cpp: 
+// a flat rest pose has no energy or dihedral angles, the gradients match finite differences and 
+// the energy of a rolled grid converges as the grid is refined
+bool CheckBending(int dim)
+{
+	vector<Vec4> particles;
+	vector<int> indices;
+	vector<BendingConstraint> constraints;
+
+	CreateBendingCheckGrid(dim, 0.0f, particles, indices);
+	CreateBendingConstraints(&particles[0], int(particles.size()), &indices[0], int(indices.size())/3, constraints);
+
+	// every interior edge of the grid is shared by exactly two triangles
+	const int numInteriorEdges = 3*(dim-1)*(dim-1) - 2*(dim-1);
+	const int numConstraints = int(constraints.size());
+
+	float flatAngle = 0.0f;
+	for (int i=0; i < numConstraints; ++i)
+		flatAngle = max(flatAngle, fabsf(GetDihedralAngle(constraints[i], &particles[0])));
+
+	const float flatEnergy = EvaluateBendingEnergy(&constraints[0], numConstraints, &particles[0], NULL);
+
+	// rest data from the flat grid, evaluated on the rolled one so k is not fitted to the bent pose
+	vector<Vec4> rolled;
+	CreateBendingCheckGrid(dim, 0.5f, rolled, indices);
+
+	vector<Vec3> gradients(rolled.size(), Vec3(0.0f));
+	EvaluateBendingEnergy(&constraints[0], numConstraints, &rolled[0], &gradients[0]);
+
+	// the energy is quadratic so central differences are exact up to rounding
+	const float h = 1.e-3f;
+	float maxGradient = 0.0f;
+	float maxGradientError = 0.0f;
+
+	for (int p=0; p < int(rolled.size()); p += max(int(rolled.size())/64, 1))
+	{
+		for (int a=0; a < 3; ++a)
+		{
+			vector<Vec4> plus = rolled;
+			vector<Vec4> minus = rolled;
+
+			plus[p][a] += h;
+			minus[p][a] -= h;
+
+			const float difference = (EvaluateBendingEnergy(&constraints[0], numConstraints, &plus[0], NULL) - EvaluateBendingEnergy(&constraints[0], numConstraints, &minus[0], NULL))/(2.0f*h);
+
+			maxGradient = max(maxGradient, fabsf(gradients[p][a]));
+			maxGradientError = max(maxGradientError, fabsf(difference - gradients[p][a]));
+		}
+	}
+
+	// refining the grid should move the rolled energy less each time
+	float energies[3];
+	for (int level=0; level < 3; ++level)
+	{
+		const int levelDim = (dim-1)*(1 << level) + 1;
+
+		vector<Vec4> flat;
+		vector<BendingConstraint> levelConstraints;
+
+		CreateBendingCheckGrid(levelDim, 0.0f, flat, indices);
+		CreateBendingConstraints(&flat[0], int(flat.size()), &indices[0], int(indices.size())/3, levelConstraints);
+
+		CreateBendingCheckGrid(levelDim, 0.5f, flat, indices);
+		energies[level] = EvaluateBendingEnergy(&levelConstraints[0], int(levelConstraints.size()), &flat[0], NULL);
+	}
+
+	const bool converges = fabsf(energies[2]-energies[1]) < fabsf(energies[1]-energies[0]);
+
+	const bool pass = numConstraints == numInteriorEdges && flatAngle < 1.e-5f && flatEnergy < 1.e-6f && maxGradientError <= 1.e-2f*max(maxGradient, 1.0f) && converges;
+
+	printf("Bending: %d constraints, flat energy %g angle %g, gradient error %g of %g, rolled energy %.3f %.3f %.3f %s\n", numConstraints, flatEnergy, flatAngle, maxGradientError, maxGradient, energies[0], energies[1], energies[2], pass ? "ok" : "FAILED");
+
+	return pass;
+}
+
+int main(int argc, char* argv[])
+{
+	int numForceFields = 64;
+	int aeroDim = 256;
+	int springDim = 210;
+	int perlinPoints = 1<<18;
+	int containerDim = 32;
+	int bendingDim = 21;
+	int sdfDim = 32;
+	int heightFieldDim = 64;
+	int reorderDim = 64;
+	int tetherDim = 48;
+	int skinningDim = 67;
+	int windPositions = 4099;
+	int clothDim = 32;
+	int clothFrames = 180;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		int d;
+
+		// size of the shared pool, defaults to the hardware concurrency
+		if (sscanf(argv[i], "-threads=%d", &d) == 1)
+			SetParallelThreadCount(d);
+
+		if (sscanf(argv[i], "-forcefields=%d", &d) == 1)
+			numForceFields = d;
+
+		if (sscanf(argv[i], "-aero=%d", &d) == 1)
+			aeroDim = d;
+
+		if (sscanf(argv[i], "-springs=%d", &d) == 1)
+			springDim = d;
+
+		if (sscanf(argv[i], "-perlin=%d", &d) == 1)
+			perlinPoints = d;
+
+		if (sscanf(argv[i], "-container=%d", &d) == 1)
+			containerDim = d;
+
+		if (sscanf(argv[i], "-bending=%d", &d) == 1)
+			bendingDim = d;
+
+		if (sscanf(argv[i], "-sdf=%d", &d) == 1)
+			sdfDim = d;
+
+		if (sscanf(argv[i], "-heightfield=%d", &d) == 1)
+			heightFieldDim = d;
+
+		if (sscanf(argv[i], "-reorder=%d", &d) == 1)
+			reorderDim = d;
+
+		if (sscanf(argv[i], "-tethers=%d", &d) == 1)
+			tetherDim = d;
+
+		if (sscanf(argv[i], "-skinning=%d", &d) == 1)
+			skinningDim = d;
+
+		if (sscanf(argv[i], "-windfield=%d", &d) == 1)
+			windPositions = d;
+
+		if (sscanf(argv[i], "-cloth=%d", &d) == 1)
+			clothDim = d;
+
+		if (sscanf(argv[i], "-clothframes=%d", &d) == 1)
+			clothFrames = d;
+	}
+
+	printf("%d threads\n", GetParallelThreadCount());
+
+	int failures = 0;
+
+	failures += !CheckForceFields(1<<20, numForceFields);
+	failures += !CheckAerodynamics(aeroDim);
+	failures += !CheckSprings(springDim);
+	failures += !CheckJacobiSprings(springDim);
+	failures += !CheckPerlin(perlinPoints);
+	failures += !CheckContainerReuse(containerDim);
+	failures += !CheckBending(bendingDim);
+	failures += !CheckSDF(sdfDim);
+	failures += !CheckHeightField(heightFieldDim);
+	failures += !CheckParticleReorder(reorderDim);
+	failures += !CheckTethers(tetherDim);
+	failures += !CheckSkinning(skinningDim);
+	failures += !CheckWindField(windPositions);
+	failures += !CheckClothScene(clothDim, clothFrames);
+
+	printf("%s\n", failures ? "checks FAILED" : "all checks passed");
+
+	return failures ? 1 : 0;
+}
@@ -3,11 +3,23 @@
 #include "../core/platform.h"
 #include "../core/mesh.h"
 #include "../core/voxelize.h"
+#include "../core/sample.h"
+#include "../core/skinning.h"
+#include "../core/windfield.h"
+#include "../core/aerodynamics.h"
+#include "../core/springs.h"
 #include "../core/sdf.h"
 #include "../core/pfm.h"
 #include "../core/tga.h"
 #include "../core/perlin.h"
 #include "../core/convex.h"
+#include "../core/decompose.h"
+#include "../core/heightfield.h"
+#include "../core/reorder.h"
+#include "../core/parallel.h"
+#include "../core/hashgrid.h"
+#include "../core/tether.h"
+#include "../core/remesh.h"
 #include "../core/cloth.h"
 
 #include "../external/SDL2-2.0.4/include/SDL.h"
@@ -130,6 +142,27 @@ void ParseConfig(const char* path, int& n_iters, Wind::ClothParams& cp, Wind::Ob
         printf("Ignoring \"coll_margin\" (same as \"shape_coll_friction\").\n");
     }
 
+    // obstacle collision representation
+    g_convexObstacles = config["convex_obstacles"].as<bool>(g_convexObstacles);
+    g_convexMaxHulls = config["convex_max_hulls"].as<int>(g_convexMaxHulls);
+    g_convexConcavity = config["convex_concavity"].as<float>(g_convexConcavity);
+    g_convexMaxPlanes = config["convex_max_planes"].as<int>(g_convexMaxPlanes);
+
+    // terrain collision representation
+    g_terrainHeightField = config["terrain_heightfield"].as<int>(g_terrainHeightField);
+    g_terrainSpacing = config["terrain_spacing"].as<float>(g_terrainSpacing);
+    g_terrainTolerance = config["terrain_tolerance"].as<float>(g_terrainTolerance);
+    g_terrainSDFDim = config["terrain_sdf_dim"].as<int>(g_terrainSDFDim);
+
+    // particle ordering
+    g_reorderParticles = config["reorder_particles"].as<int>(g_reorderParticles);
+
+    // long range attachments
+    g_lraTethers = config["lra_tethers"].as<bool>(g_lraTethers);
+    g_lraMaxAnchors = config["lra_max_anchors"].as<int>(g_lraMaxAnchors);
+    g_lraStiffness = config["lra_stiffness"].as<float>(g_lraStiffness);
+    g_lraGive = config["lra_give"].as<float>(g_lraGive);
+
     if (config["extra_cp_spacing"]) {
         cp.extra_cp_spacing = config["extra_cp_spacing"].as<float>(cp.extra_cp_spacing);
     }
@@ -269,7 +302,7 @@ void InitSim() {            // <---- [DON'T CHANGE] Initialize the solver. This
     desc.renderDevice = 0;
     desc.renderContext = 0;
     desc.computeContext = 0;
-    desc.computeType = eNvFlexCUDA;
+    desc.computeType = g_computeType;
 
     // Init Flex library, note that no CUDA methods should be called before this 
     // point to ensure we get the device context we want
@@ -361,6 +394,7 @@ void ResetSimGlobals() {   // <----- IMPORTANT!!!!  (run once: step 3)
     g_dt = 1.0f / 60.0f;
     g_waveTime = 0.0f;
     g_windTime = 0.0f;
+    g_aeroColoring = TriangleColoring();
     g_windStrength = 0.5f;    // <--- will replace -windstrength
     g_windFrequency = 0.1*(1.0f/g_dt);  //wind by wbi
 
@@ -527,6 +561,13 @@ void ResetSim() {       // <----- IMPORTANT!!!! (run once: step 6)
     g_scenes[g_scene]->Initialize();
     EndGpuWork();
 
+    // optionally sort particles along a space filling curve for memory locality
+    g_particleOrder.resize(0);
+    g_triangleOrder.resize(0);
+
+    if (g_reorderParticles)
+        ReorderParticles(SpaceFillingCurve(g_reorderParticles-1));
+
     uint32_t numParticles = g_buffers->positions.size();
     uint32_t maxParticles = numParticles + g_numExtraParticles * g_numExtraMultiplier;
 
@@ -634,6 +675,9 @@ void ResetSim() {       // <----- IMPORTANT!!!! (run once: step 6)
         g_meshRestPositions.resize(0);
     }
 
+    // precompute skinning of the render mesh to the rigids
+    BuildMeshSkinning();
+
     // give scene a chance to do some post solver initialization
     g_scenes[g_scene]->PostInitialize();
 
@@ -877,6 +921,35 @@ void UpdateWind() {  // <----- (Loop: step 3)
     g_params.wind[1] = wind.y;
     g_params.wind[2] = wind.z;
 
+    if (g_useWindField && g_buffers->positions.size()) {
+        // built once, the field loops every 8 seconds and tiles space every 8m x 4m x 8m
+        if (g_windField.samples.empty())
+            CreateWindField(32, 16, 32, 16, 0.25f, 8.0f, 3, g_windField);
+
+        ApplyWindField(g_windField, g_windTime, g_windStrength*Length(kWindDir), g_windFieldDrag, g_dt, &g_buffers->positions[0], &g_buffers->velocities[0], g_buffers->positions.size());
+    }
+
+    if (g_hostAerodynamics && g_buffers->triangles.size()) {
+        // take over the solver's coefficients so the load is not applied twice
+        if (g_params.drag != 0.0f || g_params.lift != 0.0f) {
+            g_aeroDrag = g_params.drag;
+            g_aeroLift = g_params.lift;
+            g_params.drag = 0.0f;
+            g_params.lift = 0.0f;
+        }
+
+        const int numParticles = g_buffers->positions.size();
+        const int numTriangles = g_buffers->triangles.size()/3;
+
+        if (int(g_aeroColoring.triangles.size()) != numTriangles)
+            CreateTriangleColoring(&g_buffers->triangles[0], numTriangles, numParticles, g_aeroColoring);
+
+        g_aeroForces.assign(numParticles, Vec3(0.0f));
+
+        ComputeAerodynamicForces(&g_aeroColoring, &g_buffers->triangles[0], numTriangles, &g_buffers->positions[0], &g_buffers->velocities[0], wind, NULL, g_aeroDrag, g_aeroLift, &g_aeroForces[0]);
+        ApplyAerodynamicForces(&g_aeroForces[0], &g_buffers->positions[0], &g_buffers->velocities[0], numParticles, g_dt);
+    }
+
     if (g_wavePool) {
         g_waveTime += g_dt;
         // g_waveplane=0.672589
@@ -1341,7 +1414,9 @@ void UpdateSimMapped() {    //<--- (Loop: step 2)
 
     if (g_exportObjsFlag || g_saveClothPerSimStep) {
         //printf("\n\nsaving cloth for frame %d\n", g_frame);
+        RestoreParticleOrder();
         g_scenes[g_scene]->Export(&g_exportBase[0]);
+        ReapplyParticleOrder();
         // ExportObjs(&g_clothObjPath[0], &g_transformedMeshPath[0]);
     }
 }
@@ -1789,6 +1864,18 @@ int main(int argc, char* argv[]) {
             g_windStrength = f;
         }
 
+        if (string(argv[i]) == "-windfield") {
+            g_useWindField = true;
+        }
+
+        if (sscanf(argv[i], "-windfielddrag=%f", &f) == 1) {
+            g_windFieldDrag = f;
+        }
+
+        if (string(argv[i]) == "-hostaero") {
+            g_hostAerodynamics = true;
+        }
+
         // for occlusion sims
         if (sscanf(argv[i], "-obj=%s", objpath) == 1) {
             if (!exists(&objpath[0])) {
@@ -0,0 +1,194 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2013-2017 NVIDIA Corporation. All rights reserved.
+
+
+#pragma once
+
+// space filling curve reordering of the particles in a set of SimBuffers, shared by the demos through 
+// helpers.h and by the headless check driver
+
+#include <vector>
+#include <algorithm>
+
+// moves element i of the first n entries of buffer to slot remap[i]
+template <typename T>
+void PermuteBuffer(NvFlexVector<T>& buffer, const std::vector<int>& remap, int n)
+{
+	if (buffer.size() < n)
+		return;
+
+	std::vector<T> copy(&buffer[0], &buffer[0] + n);
+
+	for (int i=0; i < n; ++i)
+		buffer[remap[i]] = copy[i];
+}
+
+// moves triangle i to slot remap[i] and maps its vertices through particleRemap
+void PermuteTriangles(SimBuffers* buffers, const std::vector<int>& remap, const std::vector<int>& particleRemap)
+{
+	const int numTris = buffers->triangles.size()/3;
+
+	std::vector<int> copy(&buffers->triangles[0], &buffers->triangles[0] + numTris*3);
+
+	for (int i=0; i < numTris; ++i)
+	{
+		for (int v=0; v < 3; ++v)
+			buffers->triangles[remap[i]*3 + v] = particleRemap[copy[i*3 + v]];
+	}
+
+	PermuteBuffer(buffers->triangleNormals, remap, numTris);
+}
+
+std::vector<int> InvertOrder(const std::vector<int>& order)
+{
+	std::vector<int> remap(order.size());
+	for (int i=0; i < int(order.size()); ++i)
+		remap[order[i]] = i;
+
+	return remap;
+}
+
+// sorts the particles in buffers along a space filling curve so that particles that are close in
+// space are also close in memory, constraints and skinIndices are remapped and springs and triangles 
+// are sorted by their first particle, the original order is kept in particleOrder and triangleOrder
+void ReorderParticles(SimBuffers* buffers, SpaceFillingCurve curve, std::vector<int>& particleOrder, std::vector<int>& triangleOrder, std::vector<int>& skinIndices)
+{
+	const int numParticles = buffers->positions.size();
+	const int numTris = buffers->triangles.size()/3;
+
+	if (numParticles == 0)
+		return;
+
+	particleOrder.resize(numParticles);
+	CreateSpaceFillingCurveOrder(&buffers->positions[0], numParticles, curve, &particleOrder[0]);
+
+	// old index -> new index
+	const std::vector<int> remap = InvertOrder(particleOrder);
+
+	PermuteBuffer(buffers->positions, remap, numParticles);
+	PermuteBuffer(buffers->restPositions, remap, numParticles);
+	PermuteBuffer(buffers->velocities, remap, numParticles);
+	PermuteBuffer(buffers->phases, remap, numParticles);
+	PermuteBuffer(buffers->normals, remap, numParticles);
+	PermuteBuffer(buffers->uvs, remap, numParticles);
+
+	// springs are symmetric so store the lower index first
+	const int numSprings = buffers->springLengths.size();
+
+	std::vector<std::pair<std::pair<int, int>, int> > springs(numSprings);
+	for (int i=0; i < numSprings; ++i)
+	{
+		const int a = remap[buffers->springIndices[i*2+0]];
+		const int b = remap[buffers->springIndices[i*2+1]];
+
+		springs[i] = std::make_pair(std::make_pair(Min(a, b), Max(a, b)), i);
+	}
+
+	std::sort(springs.begin(), springs.end());
+
+	std::vector<int> springRemap(numSprings);
+	for (int i=0; i < numSprings; ++i)
+	{
+		buffers->springIndices[i*2+0] = springs[i].first.first;
+		buffers->springIndices[i*2+1] = springs[i].first.second;
+
+		springRemap[springs[i].second] = i;
+	}
+
+	PermuteBuffer(buffers->springLengths, springRemap, numSprings);
+	PermuteBuffer(buffers->springStiffness, springRemap, numSprings);
+
+	// triangles keep their winding, inflatables address them by range so only remap those
+	std::vector<std::pair<int, int> > tris(numTris);
+	for (int i=0; i < numTris; ++i)
+		tris[i] = std::make_pair(remap[buffers->triangles[i*3]], i);
+
+	if (buffers->inflatableTriOffsets.empty())
+		std::sort(tris.begin(), tris.end());
+
+	triangleOrder.resize(numTris);
+	for (int i=0; i < numTris; ++i)
+		triangleOrder[i] = tris[i].second;
+
+	PermuteTriangles(buffers, InvertOrder(triangleOrder), remap);
+
+	// rigid indices are sorted within each rigid together with any local positions already computed
+	const int numRigidIndices = buffers->rigidIndices.size();
+
+	std::vector<int> rigidRemap(numRigidIndices);
+
+	for (int r=0; r+1 < buffers->rigidOffsets.size(); ++r)
+	{
+		const int start = buffers->rigidOffsets[r];
+		const int end = buffers->rigidOffsets[r+1];
+
+		std::vector<std::pair<int, int> > indices;
+		for (int i=start; i < end; ++i)
+			indices.push_back(std::make_pair(remap[buffers->rigidIndices[i]], i));
+
+		std::sort(indices.begin(), indices.end());
+
+		for (int i=start; i < end; ++i)
+		{
+			buffers->rigidIndices[i] = indices[i-start].first;
+			rigidRemap[indices[i-start].second] = i;
+		}
+	}
+
+	if (buffers->rigidLocalPositions.size() == numRigidIndices)
+		PermuteBuffer(buffers->rigidLocalPositions, rigidRemap, numRigidIndices);
+	if (buffers->rigidLocalNormals.size() == numRigidIndices)
+		PermuteBuffer(buffers->rigidLocalNormals, rigidRemap, numRigidIndices);
+
+	for (int i=0; i < int(skinIndices.size()); ++i)
+	{
+		if (skinIndices[i] > -1)
+			skinIndices[i] = remap[skinIndices[i]];
+	}
+}
+
+// returns positions and triangles to the order they were created in, and back again, so exported 
+// meshes do not depend on the reordering, springs and the other particle data stay reordered
+void RestoreParticleOrder(SimBuffers* buffers, const std::vector<int>& particleOrder, const std::vector<int>& triangleOrder)
+{
+	if (particleOrder.empty())
+		return;
+
+	PermuteBuffer(buffers->positions, particleOrder, int(particleOrder.size()));
+	PermuteTriangles(buffers, triangleOrder, particleOrder);
+}
+
+void ReapplyParticleOrder(SimBuffers* buffers, const std::vector<int>& particleOrder, const std::vector<int>& triangleOrder)
+{
+	if (particleOrder.empty())
+		return;
+
+	const std::vector<int> remap = InvertOrder(particleOrder);
+
+	PermuteBuffer(buffers->positions, remap, int(remap.size()));
+	PermuteTriangles(buffers, InvertOrder(triangleOrder), remap);
+}
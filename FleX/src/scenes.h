@@ -47,4 +47,4 @@ public:
 #include "scenes/rotate.h"
 #include "scenes/drape.h"
 #include "scenes/ball.h"
-//#include "scenes/bench.h"
\ No newline at end of file
+#include "scenes/bench.h"
\ No newline at end of file
@@ -54,9 +54,10 @@ public:
     void Initialize() {
         int group = 0;
 
-        slope = ImportMesh(GetFilePathByPlatform("/home/wbi/Code/Cloth_Project/flex_cloth/crossdomain_cloth_perception/dataset/trialObjs/ball/land.obj").c_str());
-        NvFlexTriangleMeshId mesh = CreateTriangleMesh(slope, !g_renderOff);
-        AddTriangleMesh(mesh, Vec3(), Quat(), 1.0f);
+        std::string slopePath = GetFilePathByPlatform("/home/wbi/Code/Cloth_Project/flex_cloth/crossdomain_cloth_perception/dataset/trialObjs/ball/land.obj");
+
+        slope = ImportMesh(slopePath.c_str());
+        AddTerrainMesh(slope, slopePath.c_str(), !g_renderOff);
 
 
         // Import object Mesh //
@@ -122,7 +123,7 @@ public:
 
             float minSqrDist = FLT_MAX;
 
-            if (i != c1 && i != c2)
+            if (!g_lraTethers && i != c1 && i != c2)
             {
                 float stiffness = 0.8f;   //-0.8f
                 float give = 0.1f;    //0.1
@@ -139,6 +140,10 @@ public:
             }
         }
 
+        // geodesic tethers to the pinned corners
+        if (g_lraTethers)
+            CreateLongRangeAttachments(g_lraStiffness, g_lraGive, g_lraMaxAnchors);
+
 
 
         // // // add object // 
@@ -403,7 +403,6 @@ public:
 		float startTime = 1.0f;
 
 		float time = Max(0.0f, mTime-startTime);
-		float lastTime = Max(0.0f, time-g_dt);
 
 
 		const float rotationSpeed = 0.0f;
@@ -413,7 +412,6 @@ public:
 		//const float translationSpeed_z = 2.0f;
 
 		Vec3 pos = Vec3(obj_center.x+0.3f, Max(0.3f, initalHeight-translationSpeed*time), obj_center.y);   //<--- This is in (x, z, y)
-		Vec3 prevPos = Vec3(obj_center.x+0.3f, Max(0.3f, initalHeight-translationSpeed*lastTime), obj_center.y);
 
 		// cout << pos.x << endl;
 		// cout << pos.y << endl;
@@ -423,7 +421,6 @@ public:
 		//Vec3 prevPos = Vec3(obj_center.x, obj_center.z-translationSpeed_z*(1.0f-cosf(lastTime)), translationSpeed*(1.0f-cosf(lastTime)));
 
 		Quat rot = QuatFromAxisAngle(Vec3(0.0f, 1.0f, 0.0f), kPi*(1.0f-cosf(rotationSpeed*time)));
-		Quat prevRot = QuatFromAxisAngle(Vec3(0.0f, 1.0f, 0.0f), kPi*(1.0f-cosf(rotationSpeed*lastTime)));
 
 		if (time>0.0f){
 			AddSphere(0.15f, pos, rot);
@@ -432,7 +429,6 @@ public:
 		// 	//AddCapsule(0.25f, 0.5f, pos, rot);
 
 		//  g_buffers->shapePositions[0] = Vec4(pos, 0.0f);
-		//  g_buffers->shapePrevPositions[0] = Vec4(prevPos, 0.0f);
 
 		 UpdateShapes();
 
@@ -66,8 +66,8 @@ public:
 		cout << endl;
 	}
 
-	Drape(const char* name, const char* objpath, ClothParams cp, ObjParams op, float contact_eps=0.05f):
-		Scene(name), objpath(objpath), cp(cp), op(op), contact_eps(contact_eps) {}
+	Drape(const char* name, const char* objpath, ClothParams cp, ObjParams op, float contact_eps=0.05f, const char* clothpath=NULL, float clothscale=1.0f):
+		Scene(name), objpath(objpath), clothpath(clothpath), clothscale(clothscale), cp(cp), op(op), contact_eps(contact_eps) {}
 
 	virtual void Initialize()
 	{
@@ -110,12 +110,7 @@ public:
 		printf("mesh upper: %f %f %f\n", obj_upper.x, obj_upper.y, obj_upper.z);
 		printf("mesh lower: %f %f %f\n", obj_lower.x, obj_lower.y, obj_lower.z);
 
-		NvFlexTriangleMeshId mesh = CreateTriangleMesh(obj, !g_renderOff);
-		AddTriangleMesh(mesh, Vec3(), Quat(), 1.0f);
-            // ^ the final parameter performs scaling from "local" to "world" space
-			// the scaling factor was not reflected in upper/lower bounds below
-			// since the scaling happens in "world space" but NvFlexGetTriangleMeshBounds
-			// reflects "local space" coordinates
+		AddObstacleMesh(obj, objpath, !g_renderOff);
 
 		/// Add cloth ///
 
@@ -156,10 +151,20 @@ public:
 
 		// make cloth
 		cloth_base_idx = int(g_buffers->positions.size());
-		
-		CreateSpringGrid(position_offset, nx, ny, 1, cp.particle_radius, phase,
-			cp.stretch_stiffness, cp.bend_stiffness, cp.shear_stiffness, velocity, cp.invMass,
-            cp.extra_cp_spacing, cp.extra_cp_rad_mult);
+
+		// a garment remeshed to the grid spacing replaces the grid, it has no grid dimensions
+		if (clothpath && CreateClothFromMesh(GetFilePathByPlatform(clothpath).c_str(), Vec3(obj_center.x, obj_upper.y + fall_height, obj_center.z), clothscale, 
+			cp.particle_radius, phase, cp.stretch_stiffness, cp.bend_stiffness, velocity, cp.invMass, cp.extra_cp_spacing, cp.extra_cp_rad_mult))
+		{
+			nx = 0;
+			ny = 0;
+		}
+		else
+		{
+			CreateSpringGrid(position_offset, nx, ny, 1, cp.particle_radius, phase,
+				cp.stretch_stiffness, cp.bend_stiffness, cp.shear_stiffness, velocity, cp.invMass,
+	            cp.extra_cp_spacing, cp.extra_cp_rad_mult);
+		}
 
 		Vec3 cloth_upper, cloth_lower;
 		GetParticleBounds(cloth_lower, cloth_upper);
@@ -428,6 +433,10 @@ private:
 
 	const char* objpath;
 
+	// optional garment mesh draped instead of the square grid, and its scale
+	const char* clothpath;
+	float clothscale;
+
 	ClothParams cp;
 	ObjParams op;
 
@@ -102,12 +102,7 @@ public:
         printf("mesh upper: %f %f %f\n", obj_upper.x, obj_upper.y, obj_upper.z);
         printf("mesh lower: %f %f %f\n", obj_lower.x, obj_lower.y, obj_lower.z);
 
-        NvFlexTriangleMeshId mesh = CreateTriangleMesh(obj, !g_renderOff);
-        AddTriangleMesh(mesh, Vec3(), Quat(), 1.0f);
-            // ^ the final parameter performs scaling from "local" to "world" space
-            // the scaling factor was not reflected in upper/lower bounds below
-            // since the scaling happens in "world space" but NvFlexGetTriangleMeshBounds
-            // reflects "local space" coordinates
+        obj_num_shapes = AddObstacleMesh(obj, objpath, !g_renderOff);
 
         /// Add cloth ///
 
@@ -330,10 +325,13 @@ public:
         //AddSphere(0.5f, pos, rot);
             //AddCapsule(0.25f, 0.5f, pos, rot);
 
-        // g_buffers->shapePositions[0] = Vec4(pos, 0.0f);
-         g_buffers->shapeRotations[0] = rot;        
-        // g_buffers->shapePrevPositions[0] = Vec4(prevPos, 0.0f);
-         g_buffers->shapePrevRotations[0] = prevRot;
+        // the obstacle may be made of several convex shapes, all stored in the object frame
+        for (int i = 0; i < obj_num_shapes; i++) {
+            // g_buffers->shapePositions[i] = Vec4(pos, 0.0f);
+            g_buffers->shapeRotations[i] = rot;
+            // g_buffers->shapePrevPositions[i] = Vec4(prevPos, 0.0f);
+            g_buffers->shapePrevRotations[i] = prevRot;
+        }
 
         // //UpdateShapes();
 
@@ -444,6 +442,7 @@ private:
     ObjParams op;
 
     int cloth_base_idx;       // <---- 0
+    int obj_num_shapes;       // <---- collision shapes making up the object
     int nx, ny;
 
     float contact_eps; // max distance for cloth-mesh "contact"
@@ -100,12 +100,7 @@ public:
         printf("mesh upper: %f %f %f\n", obj_upper.x, obj_upper.y, obj_upper.z);
         printf("mesh lower: %f %f %f\n", obj_lower.x, obj_lower.y, obj_lower.z);
 
-        NvFlexTriangleMeshId mesh = CreateTriangleMesh(obj, !g_renderOff);
-        AddTriangleMesh(mesh, Vec3(), Quat(), 1.0f);
-            // ^ the final parameter performs scaling from "local" to "world" space
-            // the scaling factor was not reflected in upper/lower bounds below
-            // since the scaling happens in "world space" but NvFlexGetTriangleMeshBounds
-            // reflects "local space" coordinates
+        AddObstacleMesh(obj, objpath, !g_renderOff);
 
         /// Add cloth ///cloth_size: 160 # default 210
 
@@ -189,7 +184,7 @@ public:
 
             float minSqrDist = FLT_MAX;
 
-            if (i != c1 && i != c2)
+            if (!g_lraTethers && i != c1 && i != c2)
             {
                 float stiffness = 0.8f;   //-0.8f
                 float give = 0.1f;    //0.1
@@ -210,6 +205,10 @@ public:
             }
         }
 
+        // geodesic tethers to the pinned corners
+        if (g_lraTethers)
+            CreateLongRangeAttachments(g_lraStiffness, g_lraGive, g_lraMaxAnchors);
+
         
         if (!g_params.drag) {
             //cout << "@@@@@@@@@@@@@@ Warning! g_params.drag is not defined... " <<endl;